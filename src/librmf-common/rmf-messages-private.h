@@ -67,7 +67,6 @@ void rmf_message_builder_free (RmfMessageBuilder *builder);
 /******************************************************************************/
 /* Message reader */
 
-uint32_t rmf_message_get_status (const uint8_t *buffer);
 uint32_t rmf_message_read_uint32 (const uint8_t *buffer,
                                   uint32_t      *relative_fixed_offset);
 int32_t  rmf_message_read_int32  (const uint8_t *buffer,
@@ -63,6 +63,58 @@ rmf_message_request_and_response_match (const uint8_t *request,
     return 1;
 }
 
+static const char *command_strings[] = {
+    [RMF_MESSAGE_COMMAND_UNKNOWN]                  = "unknown",
+    [RMF_MESSAGE_COMMAND_GET_MANUFACTURER]         = "get-manufacturer",
+    [RMF_MESSAGE_COMMAND_GET_MODEL]                = "get-model",
+    [RMF_MESSAGE_COMMAND_GET_SOFTWARE_REVISION]    = "get-software-revision",
+    [RMF_MESSAGE_COMMAND_GET_HARDWARE_REVISION]    = "get-hardware-revision",
+    [RMF_MESSAGE_COMMAND_GET_IMEI]                 = "get-imei",
+    [RMF_MESSAGE_COMMAND_GET_IMSI]                 = "get-imsi",
+    [RMF_MESSAGE_COMMAND_GET_ICCID]                = "get-iccid",
+    [RMF_MESSAGE_COMMAND_UNLOCK]                   = "unlock",
+    [RMF_MESSAGE_COMMAND_ENABLE_PIN]               = "enable-pin",
+    [RMF_MESSAGE_COMMAND_CHANGE_PIN]               = "change-pin",
+    [RMF_MESSAGE_COMMAND_GET_POWER_STATUS]         = "get-power-status",
+    [RMF_MESSAGE_COMMAND_SET_POWER_STATUS]         = "set-power-status",
+    [RMF_MESSAGE_COMMAND_GET_POWER_INFO]           = "get-power-info",
+    [RMF_MESSAGE_COMMAND_GET_SIGNAL_INFO]          = "get-signal-info",
+    [RMF_MESSAGE_COMMAND_GET_REGISTRATION_STATUS]  = "get-registration-status",
+    [RMF_MESSAGE_COMMAND_GET_CONNECTION_STATUS]    = "get-connection-status",
+    [RMF_MESSAGE_COMMAND_GET_CONNECTION_STATS]     = "get-connection-stats",
+    [RMF_MESSAGE_COMMAND_CONNECT]                  = "connect",
+    [RMF_MESSAGE_COMMAND_DISCONNECT]               = "disconnect",
+    [RMF_MESSAGE_COMMAND_IS_SIM_LOCKED]            = "is-sim-locked",
+    [RMF_MESSAGE_COMMAND_IS_MODEM_AVAILABLE]       = "is-modem-available",
+    [RMF_MESSAGE_COMMAND_GET_SIM_INFO]             = "get-sim-info",
+    [RMF_MESSAGE_COMMAND_GET_REGISTRATION_TIMEOUT] = "get-registration-timeout",
+    [RMF_MESSAGE_COMMAND_SET_REGISTRATION_TIMEOUT] = "set-registration-timeout",
+    [RMF_MESSAGE_COMMAND_POWER_CYCLE]              = "power-cycle",
+    [RMF_MESSAGE_COMMAND_GET_DATA_PORT]            = "get-data-port",
+    [RMF_MESSAGE_COMMAND_GET_SIM_SLOT]             = "get-sim-slot",
+    [RMF_MESSAGE_COMMAND_SET_SIM_SLOT]             = "set-sim-slot",
+    [RMF_MESSAGE_COMMAND_GET_DAEMON_METRICS]       = "get-daemon-metrics",
+    [RMF_MESSAGE_COMMAND_GET_AUTO_RECONNECT]       = "get-auto-reconnect",
+    [RMF_MESSAGE_COMMAND_SET_AUTO_RECONNECT]       = "set-auto-reconnect",
+    [RMF_MESSAGE_COMMAND_GET_AVAILABLE_NETWORKS]   = "get-available-networks",
+    [RMF_MESSAGE_COMMAND_SCAN_NETWORKS]            = "scan-networks",
+    [RMF_MESSAGE_COMMAND_CANCEL_NETWORK_SCAN]      = "cancel-network-scan",
+    [RMF_MESSAGE_COMMAND_IS_MESSAGING_READY]       = "is-messaging-ready",
+    [RMF_MESSAGE_COMMAND_CONNECT_SESSION]          = "connect-session",
+    [RMF_MESSAGE_COMMAND_DISCONNECT_SESSION]       = "disconnect-session",
+    [RMF_MESSAGE_COMMAND_GET_SESSION_STATUS]       = "get-session-status",
+    [RMF_MESSAGE_COMMAND_GET_SESSION_STATS]        = "get-session-stats",
+    [RMF_MESSAGE_COMMAND_GET_DATA_FORMAT]          = "get-data-format",
+};
+
+const char *
+rmf_message_command_get_string (uint32_t command)
+{
+    if (command >= sizeof (command_strings) / sizeof (command_strings[0]) || !command_strings[command])
+        return command_strings[RMF_MESSAGE_COMMAND_UNKNOWN];
+    return command_strings[command];
+}
+
 /******************************************************************************/
 /* Generic error response */
 
@@ -981,18 +1033,39 @@ rmf_message_set_power_status_response_parse (const uint8_t *message,
 /* Get Power Info */
 
 uint8_t *
-rmf_message_get_power_info_request_new (void)
+rmf_message_get_power_info_request_new (uint32_t radio_interfaces)
 {
     RmfMessageBuilder *builder;
     uint8_t *message;
 
     builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_GET_POWER_INFO, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_uint32 (builder, radio_interfaces);
     message = rmf_message_builder_serialize (builder);
     rmf_message_builder_free (builder);
 
     return message;
 }
 
+void
+rmf_message_get_power_info_request_parse (const uint8_t *message,
+                                          uint32_t      *radio_interfaces)
+{
+    uint32_t offset = 0;
+
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_REQUEST);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_GET_POWER_INFO);
+
+    if (!radio_interfaces)
+        return;
+
+    /* Requests from older clients come without payload, and query all
+     * radio interfaces */
+    if (rmf_message_get_length (message) <= sizeof (struct RmfMessageHeader))
+        *radio_interfaces = RMF_RADIO_INTERFACE_MASK_ALL;
+    else
+        *radio_interfaces = rmf_message_read_uint32 (message, &offset);
+}
+
 uint8_t *
 rmf_message_get_power_info_response_new (uint32_t gsm_in_traffic,
                                          int32_t  gsm_tx_power,
@@ -1159,7 +1232,8 @@ rmf_message_get_signal_info_response_new (uint32_t gsm_available,
                                           uint32_t umts_quality,
                                           uint32_t lte_available,
                                           int32_t  lte_rssi,
-                                          uint32_t lte_quality)
+                                          uint32_t lte_quality,
+                                          uint32_t age)
 {
     RmfMessageBuilder *builder;
     uint8_t *message;
@@ -1174,6 +1248,7 @@ rmf_message_get_signal_info_response_new (uint32_t gsm_available,
     rmf_message_builder_add_uint32 (builder, lte_available);
     rmf_message_builder_add_int32 (builder, lte_rssi);
     rmf_message_builder_add_uint32 (builder, lte_quality);
+    rmf_message_builder_add_uint32 (builder, age);
     message = rmf_message_builder_serialize (builder);
     rmf_message_builder_free (builder);
 
@@ -1191,7 +1266,8 @@ rmf_message_get_signal_info_response_parse (const uint8_t *message,
                                             uint32_t      *umts_quality,
                                             uint32_t      *lte_available,
                                             int32_t       *lte_rssi,
-                                            uint32_t      *lte_quality)
+                                            uint32_t      *lte_quality,
+                                            uint32_t      *age)
 {
     uint32_t offset = 0;
     uint32_t uvalue;
@@ -1235,6 +1311,13 @@ rmf_message_get_signal_info_response_parse (const uint8_t *message,
     uvalue = rmf_message_read_uint32 (message, &offset);
     if (lte_quality)
         *lte_quality = uvalue;
+
+    /* Responses from older daemons come without age */
+    uvalue = 0;
+    if (rmf_message_get_length (message) > sizeof (struct RmfMessageHeader) + offset)
+        uvalue = rmf_message_read_uint32 (message, &offset);
+    if (age)
+        *age = uvalue;
 }
 
 /******************************************************************************/
@@ -1574,29 +1657,71 @@ rmf_message_disconnect_response_parse (const uint8_t *message,
 }
 
 /******************************************************************************/
-/* Modem Is Available */
+/* Connect Session
+ *
+ *  Request:
+ *    - uint32 session
+ *    - string apn
+ *    - string user
+ *    - string password
+ *  Response:
+ *    - string interface
+ */
 
 uint8_t *
-rmf_message_is_modem_available_request_new (void)
+rmf_message_connect_session_request_new (uint32_t    session,
+                                         const char *apn,
+                                         const char *user,
+                                         const char *password)
 {
     RmfMessageBuilder *builder;
     uint8_t *message;
 
-    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_IS_MODEM_AVAILABLE, RMF_RESPONSE_STATUS_OK);
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_CONNECT_SESSION, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_uint32 (builder, session);
+    rmf_message_builder_add_string (builder, apn);
+    rmf_message_builder_add_string (builder, user);
+    rmf_message_builder_add_string (builder, password);
     message = rmf_message_builder_serialize (builder);
     rmf_message_builder_free (builder);
 
     return message;
 }
 
+void
+rmf_message_connect_session_request_parse (const uint8_t  *message,
+                                           uint32_t       *session,
+                                           const char    **apn,
+                                           const char    **user,
+                                           const char    **password)
+{
+    uint32_t offset = 0;
+    uint32_t value;
+    const char *val;
+
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_REQUEST);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_CONNECT_SESSION);
+    value = rmf_message_read_uint32 (message, &offset);
+    if (session)
+        *session = value;
+    val = rmf_message_read_string (message, &offset);
+    if (apn)
+        *apn = val;
+    val = rmf_message_read_string (message, &offset);
+    if (user)
+        *user = val;
+    if (password)
+        *password = rmf_message_read_string (message, &offset);
+}
+
 uint8_t *
-rmf_message_is_modem_available_response_new (uint8_t available)
+rmf_message_connect_session_response_new (const char *interface)
 {
     RmfMessageBuilder *builder;
     uint8_t *message;
 
-    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_IS_MODEM_AVAILABLE, RMF_RESPONSE_STATUS_OK);
-    rmf_message_builder_add_uint32 (builder, (uint32_t) available);
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_CONNECT_SESSION, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_string (builder, interface);
     message = rmf_message_builder_serialize (builder);
     rmf_message_builder_free (builder);
 
@@ -1604,46 +1729,134 @@ rmf_message_is_modem_available_response_new (uint8_t available)
 }
 
 void
-rmf_message_is_modem_available_response_parse (const uint8_t *message,
-                                               uint32_t      *status,
-                                               uint8_t       *available)
+rmf_message_connect_session_response_parse (const uint8_t  *message,
+                                            uint32_t       *status,
+                                            const char    **interface)
 {
     uint32_t offset = 0;
 
     assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
-    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_IS_MODEM_AVAILABLE);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_CONNECT_SESSION);
 
     if (status)
         *status = rmf_message_get_status (message);
 
-    if (available)
-        *available = (uint8_t) rmf_message_read_uint32 (message, &offset);
+    if (rmf_message_get_status (message) != RMF_RESPONSE_STATUS_OK)
+        return;
+
+    if (interface)
+        *interface = rmf_message_read_string (message, &offset);
 }
 
 /******************************************************************************/
-/* Modem Get Registration Timeout */
+/* Disconnect Session
+ *
+ *  Request:
+ *    - uint32 session
+ *  Response:
+ *    - no arguments
+ */
 
 uint8_t *
-rmf_message_get_registration_timeout_request_new (void)
+rmf_message_disconnect_session_request_new (uint32_t session)
 {
     RmfMessageBuilder *builder;
     uint8_t *message;
 
-    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_GET_REGISTRATION_TIMEOUT, RMF_RESPONSE_STATUS_OK);
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_DISCONNECT_SESSION, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_uint32 (builder, session);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+void
+rmf_message_disconnect_session_request_parse (const uint8_t *message,
+                                              uint32_t      *session)
+{
+    uint32_t offset = 0;
+    uint32_t value;
+
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_REQUEST);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_DISCONNECT_SESSION);
+    value = rmf_message_read_uint32 (message, &offset);
+    if (session)
+        *session = value;
+}
+
+uint8_t *
+rmf_message_disconnect_session_response_new (void)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_DISCONNECT_SESSION, RMF_RESPONSE_STATUS_OK);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+void
+rmf_message_disconnect_session_response_parse (const uint8_t *message,
+                                               uint32_t      *status)
+{
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_DISCONNECT_SESSION);
+
+    if (status)
+        *status = rmf_message_get_status (message);
+}
+
+/******************************************************************************/
+/* Get Session Status
+ *
+ *  Request:
+ *    - uint32 session
+ *  Response:
+ *    - uint32 connection status
+ *    - string interface, empty if not connected
+ */
+
+uint8_t *
+rmf_message_get_session_status_request_new (uint32_t session)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_GET_SESSION_STATUS, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_uint32 (builder, session);
     message = rmf_message_builder_serialize (builder);
     rmf_message_builder_free (builder);
 
     return message;
 }
 
+void
+rmf_message_get_session_status_request_parse (const uint8_t *message,
+                                              uint32_t      *session)
+{
+    uint32_t offset = 0;
+    uint32_t value;
+
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_REQUEST);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_GET_SESSION_STATUS);
+    value = rmf_message_read_uint32 (message, &offset);
+    if (session)
+        *session = value;
+}
+
 uint8_t *
-rmf_message_get_registration_timeout_response_new (uint32_t timeout)
+rmf_message_get_session_status_response_new (uint32_t    connection_status,
+                                             const char *interface)
 {
     RmfMessageBuilder *builder;
     uint8_t *message;
 
-    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_GET_REGISTRATION_TIMEOUT, RMF_RESPONSE_STATUS_OK);
-    rmf_message_builder_add_uint32 (builder, timeout);
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_GET_SESSION_STATUS, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_uint32 (builder, connection_status);
+    rmf_message_builder_add_string (builder, interface);
     message = rmf_message_builder_serialize (builder);
     rmf_message_builder_free (builder);
 
@@ -1651,33 +1864,47 @@ rmf_message_get_registration_timeout_response_new (uint32_t timeout)
 }
 
 void
-rmf_message_get_registration_timeout_response_parse (const uint8_t *message,
-                                                     uint32_t      *status,
-                                                     uint32_t      *timeout)
+rmf_message_get_session_status_response_parse (const uint8_t  *message,
+                                               uint32_t       *status,
+                                               uint32_t       *connection_status,
+                                               const char    **interface)
 {
     uint32_t offset = 0;
+    uint32_t value;
 
     assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
-    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_GET_REGISTRATION_TIMEOUT);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_GET_SESSION_STATUS);
 
     if (status)
         *status = rmf_message_get_status (message);
 
-    if (timeout)
-        *timeout = rmf_message_read_uint32 (message, &offset);
+    if (rmf_message_get_status (message) != RMF_RESPONSE_STATUS_OK)
+        return;
+
+    value = rmf_message_read_uint32 (message, &offset);
+    if (connection_status)
+        *connection_status = value;
+    if (interface)
+        *interface = rmf_message_read_string (message, &offset);
 }
 
 /******************************************************************************/
-/* Modem Set Registration Timeout */
+/* Get Session Stats
+ *
+ *  Request:
+ *    - uint32 session
+ *  Response:
+ *    - same as Get Connection Stats
+ */
 
 uint8_t *
-rmf_message_set_registration_timeout_request_new (uint32_t timeout)
+rmf_message_get_session_stats_request_new (uint32_t session)
 {
     RmfMessageBuilder *builder;
     uint8_t *message;
 
-    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_SET_REGISTRATION_TIMEOUT, RMF_RESPONSE_STATUS_OK);
-    rmf_message_builder_add_uint32 (builder, timeout);
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_GET_SESSION_STATS, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_uint32 (builder, session);
     message = rmf_message_builder_serialize (builder);
     rmf_message_builder_free (builder);
 
@@ -1685,25 +1912,41 @@ rmf_message_set_registration_timeout_request_new (uint32_t timeout)
 }
 
 void
-rmf_message_set_registration_timeout_request_parse (const uint8_t *message,
-                                                    uint32_t      *timeout)
+rmf_message_get_session_stats_request_parse (const uint8_t *message,
+                                             uint32_t      *session)
 {
     uint32_t offset = 0;
+    uint32_t value;
 
     assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_REQUEST);
-    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_SET_REGISTRATION_TIMEOUT);
-
-    if (timeout)
-        *timeout = rmf_message_read_uint32 (message, &offset);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_GET_SESSION_STATS);
+    value = rmf_message_read_uint32 (message, &offset);
+    if (session)
+        *session = value;
 }
 
 uint8_t *
-rmf_message_set_registration_timeout_response_new (void)
+rmf_message_get_session_stats_response_new (uint32_t tx_packets_ok,
+                                            uint32_t rx_packets_ok,
+                                            uint32_t tx_packets_error,
+                                            uint32_t rx_packets_error,
+                                            uint32_t tx_packets_overflow,
+                                            uint32_t rx_packets_overflow,
+                                            uint64_t tx_bytes_ok,
+                                            uint64_t rx_bytes_ok)
 {
     RmfMessageBuilder *builder;
     uint8_t *message;
 
-    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_SET_REGISTRATION_TIMEOUT, RMF_RESPONSE_STATUS_OK);
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_GET_SESSION_STATS, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_uint32 (builder, tx_packets_ok);
+    rmf_message_builder_add_uint32 (builder, rx_packets_ok);
+    rmf_message_builder_add_uint32 (builder, tx_packets_error);
+    rmf_message_builder_add_uint32 (builder, rx_packets_error);
+    rmf_message_builder_add_uint32 (builder, tx_packets_overflow);
+    rmf_message_builder_add_uint32 (builder, rx_packets_overflow);
+    rmf_message_builder_add_uint64 (builder, tx_bytes_ok);
+    rmf_message_builder_add_uint64 (builder, rx_bytes_ok);
     message = rmf_message_builder_serialize (builder);
     rmf_message_builder_free (builder);
 
@@ -1711,26 +1954,66 @@ rmf_message_set_registration_timeout_response_new (void)
 }
 
 void
-rmf_message_set_registration_timeout_response_parse (const uint8_t *message,
-                                                     uint32_t      *status)
+rmf_message_get_session_stats_response_parse (const uint8_t *message,
+                                              uint32_t      *status,
+                                              uint32_t      *tx_packets_ok,
+                                              uint32_t      *rx_packets_ok,
+                                              uint32_t      *tx_packets_error,
+                                              uint32_t      *rx_packets_error,
+                                              uint32_t      *tx_packets_overflow,
+                                              uint32_t      *rx_packets_overflow,
+                                              uint64_t      *tx_bytes_ok,
+                                              uint64_t      *rx_bytes_ok)
 {
+    uint32_t offset = 0;
+    uint32_t value;
+    uint64_t value64;
+
     assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
-    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_SET_REGISTRATION_TIMEOUT);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_GET_SESSION_STATS);
 
     if (status)
         *status = rmf_message_get_status (message);
+
+    if (rmf_message_get_status (message) != RMF_RESPONSE_STATUS_OK)
+        return;
+
+    value = rmf_message_read_uint32 (message, &offset);
+    if (tx_packets_ok)
+        *tx_packets_ok = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (rx_packets_ok)
+        *rx_packets_ok = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (tx_packets_error)
+        *tx_packets_error = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (rx_packets_error)
+        *rx_packets_error = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (tx_packets_overflow)
+        *tx_packets_overflow = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (rx_packets_overflow)
+        *rx_packets_overflow = value;
+    value64 = rmf_message_read_uint64 (message, &offset);
+    if (tx_bytes_ok)
+        *tx_bytes_ok = value64;
+    value64 = rmf_message_read_uint64 (message, &offset);
+    if (rx_bytes_ok)
+        *rx_bytes_ok = value64;
 }
 
 /******************************************************************************/
-/* Modem power cycle */
+/* Modem Is Available */
 
 uint8_t *
-rmf_message_power_cycle_request_new (void)
+rmf_message_is_modem_available_request_new (void)
 {
     RmfMessageBuilder *builder;
     uint8_t *message;
 
-    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_POWER_CYCLE, RMF_RESPONSE_STATUS_OK);
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_IS_MODEM_AVAILABLE, RMF_RESPONSE_STATUS_OK);
     message = rmf_message_builder_serialize (builder);
     rmf_message_builder_free (builder);
 
@@ -1738,12 +2021,13 @@ rmf_message_power_cycle_request_new (void)
 }
 
 uint8_t *
-rmf_message_power_cycle_response_new (void)
+rmf_message_is_modem_available_response_new (uint8_t available)
 {
     RmfMessageBuilder *builder;
     uint8_t *message;
 
-    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_POWER_CYCLE, RMF_RESPONSE_STATUS_OK);
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_IS_MODEM_AVAILABLE, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_uint32 (builder, (uint32_t) available);
     message = rmf_message_builder_serialize (builder);
     rmf_message_builder_free (builder);
 
@@ -1751,26 +2035,32 @@ rmf_message_power_cycle_response_new (void)
 }
 
 void
-rmf_message_power_cycle_response_parse (const uint8_t *message,
-                                        uint32_t      *status)
+rmf_message_is_modem_available_response_parse (const uint8_t *message,
+                                               uint32_t      *status,
+                                               uint8_t       *available)
 {
+    uint32_t offset = 0;
+
     assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
-    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_POWER_CYCLE);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_IS_MODEM_AVAILABLE);
 
     if (status)
         *status = rmf_message_get_status (message);
+
+    if (available)
+        *available = (uint8_t) rmf_message_read_uint32 (message, &offset);
 }
 
 /******************************************************************************/
-/* Get Data Port */
+/* Modem Get Registration Timeout */
 
 uint8_t *
-rmf_message_get_data_port_request_new (void)
+rmf_message_get_registration_timeout_request_new (void)
 {
     RmfMessageBuilder *builder;
     uint8_t *message;
 
-    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_GET_DATA_PORT, RMF_RESPONSE_STATUS_OK);
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_GET_REGISTRATION_TIMEOUT, RMF_RESPONSE_STATUS_OK);
     message = rmf_message_builder_serialize (builder);
     rmf_message_builder_free (builder);
 
@@ -1778,13 +2068,13 @@ rmf_message_get_data_port_request_new (void)
 }
 
 uint8_t *
-rmf_message_get_data_port_response_new (const char *data_port)
+rmf_message_get_registration_timeout_response_new (uint32_t timeout)
 {
     RmfMessageBuilder *builder;
     uint8_t *message;
 
-    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_GET_DATA_PORT, RMF_RESPONSE_STATUS_OK);
-    rmf_message_builder_add_string (builder, data_port);
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_GET_REGISTRATION_TIMEOUT, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_uint32 (builder, timeout);
     message = rmf_message_builder_serialize (builder);
     rmf_message_builder_free (builder);
 
@@ -1792,21 +2082,838 @@ rmf_message_get_data_port_response_new (const char *data_port)
 }
 
 void
-rmf_message_get_data_port_response_parse (const uint8_t  *message,
-                                          uint32_t       *status,
-                                          const char    **data_port)
+rmf_message_get_registration_timeout_response_parse (const uint8_t *message,
+                                                     uint32_t      *status,
+                                                     uint32_t      *timeout)
 {
     uint32_t offset = 0;
 
     assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
-    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_GET_DATA_PORT);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_GET_REGISTRATION_TIMEOUT);
 
     if (status)
         *status = rmf_message_get_status (message);
 
-    if (rmf_message_get_status (message) != RMF_RESPONSE_STATUS_OK)
-        return;
+    if (timeout)
+        *timeout = rmf_message_read_uint32 (message, &offset);
+}
 
-    if (data_port)
-        *data_port = rmf_message_read_string (message, &offset);
+/******************************************************************************/
+/* Modem Set Registration Timeout */
+
+uint8_t *
+rmf_message_set_registration_timeout_request_new (uint32_t timeout)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_SET_REGISTRATION_TIMEOUT, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_uint32 (builder, timeout);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+void
+rmf_message_set_registration_timeout_request_parse (const uint8_t *message,
+                                                    uint32_t      *timeout)
+{
+    uint32_t offset = 0;
+
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_REQUEST);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_SET_REGISTRATION_TIMEOUT);
+
+    if (timeout)
+        *timeout = rmf_message_read_uint32 (message, &offset);
+}
+
+uint8_t *
+rmf_message_set_registration_timeout_response_new (void)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_SET_REGISTRATION_TIMEOUT, RMF_RESPONSE_STATUS_OK);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+void
+rmf_message_set_registration_timeout_response_parse (const uint8_t *message,
+                                                     uint32_t      *status)
+{
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_SET_REGISTRATION_TIMEOUT);
+
+    if (status)
+        *status = rmf_message_get_status (message);
+}
+
+/******************************************************************************/
+/* Modem power cycle */
+
+uint8_t *
+rmf_message_power_cycle_request_new (void)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_POWER_CYCLE, RMF_RESPONSE_STATUS_OK);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+uint8_t *
+rmf_message_power_cycle_response_new (void)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_POWER_CYCLE, RMF_RESPONSE_STATUS_OK);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+void
+rmf_message_power_cycle_response_parse (const uint8_t *message,
+                                        uint32_t      *status)
+{
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_POWER_CYCLE);
+
+    if (status)
+        *status = rmf_message_get_status (message);
+}
+
+/******************************************************************************/
+/* Get Data Port */
+
+uint8_t *
+rmf_message_get_data_port_request_new (void)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_GET_DATA_PORT, RMF_RESPONSE_STATUS_OK);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+uint8_t *
+rmf_message_get_data_port_response_new (const char *data_port)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_GET_DATA_PORT, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_string (builder, data_port);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+void
+rmf_message_get_data_port_response_parse (const uint8_t  *message,
+                                          uint32_t       *status,
+                                          const char    **data_port)
+{
+    uint32_t offset = 0;
+
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_GET_DATA_PORT);
+
+    if (status)
+        *status = rmf_message_get_status (message);
+
+    if (rmf_message_get_status (message) != RMF_RESPONSE_STATUS_OK)
+        return;
+
+    if (data_port)
+        *data_port = rmf_message_read_string (message, &offset);
+}
+
+/******************************************************************************/
+/* Get Data Format
+ *
+ *  Request:
+ *  Response:
+ *    - uint32 raw_ip
+ *    - uint32 ul_max_datagrams
+ *    - uint32 ul_max_size
+ *    - uint32 dl_max_datagrams
+ *    - uint32 dl_max_size
+ */
+
+uint8_t *
+rmf_message_get_data_format_request_new (void)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_GET_DATA_FORMAT, RMF_RESPONSE_STATUS_OK);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+uint8_t *
+rmf_message_get_data_format_response_new (uint32_t raw_ip,
+                                          uint32_t ul_max_datagrams,
+                                          uint32_t ul_max_size,
+                                          uint32_t dl_max_datagrams,
+                                          uint32_t dl_max_size)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_GET_DATA_FORMAT, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_uint32 (builder, raw_ip);
+    rmf_message_builder_add_uint32 (builder, ul_max_datagrams);
+    rmf_message_builder_add_uint32 (builder, ul_max_size);
+    rmf_message_builder_add_uint32 (builder, dl_max_datagrams);
+    rmf_message_builder_add_uint32 (builder, dl_max_size);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+void
+rmf_message_get_data_format_response_parse (const uint8_t *message,
+                                            uint32_t      *status,
+                                            uint32_t      *raw_ip,
+                                            uint32_t      *ul_max_datagrams,
+                                            uint32_t      *ul_max_size,
+                                            uint32_t      *dl_max_datagrams,
+                                            uint32_t      *dl_max_size)
+{
+    uint32_t offset = 0;
+    uint32_t value;
+
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_GET_DATA_FORMAT);
+
+    if (status)
+        *status = rmf_message_get_status (message);
+
+    if (rmf_message_get_status (message) != RMF_RESPONSE_STATUS_OK)
+        return;
+
+    value = rmf_message_read_uint32 (message, &offset);
+    if (raw_ip)
+        *raw_ip = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (ul_max_datagrams)
+        *ul_max_datagrams = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (ul_max_size)
+        *ul_max_size = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (dl_max_datagrams)
+        *dl_max_datagrams = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (dl_max_size)
+        *dl_max_size = value;
+}
+
+/******************************************************************************/
+/* Get Auto Reconnect */
+
+uint8_t *
+rmf_message_get_auto_reconnect_request_new (void)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_GET_AUTO_RECONNECT, RMF_RESPONSE_STATUS_OK);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+uint8_t *
+rmf_message_get_auto_reconnect_response_new (uint32_t enabled,
+                                             uint32_t max_attempts,
+                                             uint32_t max_delay,
+                                             uint32_t state,
+                                             uint32_t attempt,
+                                             uint32_t drops,
+                                             uint32_t reconnects,
+                                             uint32_t failures,
+                                             uint32_t last_recovery_time_ms)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_GET_AUTO_RECONNECT, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_uint32 (builder, enabled);
+    rmf_message_builder_add_uint32 (builder, max_attempts);
+    rmf_message_builder_add_uint32 (builder, max_delay);
+    rmf_message_builder_add_uint32 (builder, state);
+    rmf_message_builder_add_uint32 (builder, attempt);
+    rmf_message_builder_add_uint32 (builder, drops);
+    rmf_message_builder_add_uint32 (builder, reconnects);
+    rmf_message_builder_add_uint32 (builder, failures);
+    rmf_message_builder_add_uint32 (builder, last_recovery_time_ms);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+void
+rmf_message_get_auto_reconnect_response_parse (const uint8_t *message,
+                                               uint32_t      *status,
+                                               uint32_t      *enabled,
+                                               uint32_t      *max_attempts,
+                                               uint32_t      *max_delay,
+                                               uint32_t      *state,
+                                               uint32_t      *attempt,
+                                               uint32_t      *drops,
+                                               uint32_t      *reconnects,
+                                               uint32_t      *failures,
+                                               uint32_t      *last_recovery_time_ms)
+{
+    uint32_t offset = 0;
+    uint32_t value;
+
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_GET_AUTO_RECONNECT);
+
+    if (status)
+        *status = rmf_message_get_status (message);
+
+    if (rmf_message_get_status (message) != RMF_RESPONSE_STATUS_OK)
+        return;
+
+    value = rmf_message_read_uint32 (message, &offset);
+    if (enabled)
+        *enabled = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (max_attempts)
+        *max_attempts = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (max_delay)
+        *max_delay = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (state)
+        *state = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (attempt)
+        *attempt = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (drops)
+        *drops = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (reconnects)
+        *reconnects = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (failures)
+        *failures = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (last_recovery_time_ms)
+        *last_recovery_time_ms = value;
+}
+
+/******************************************************************************/
+/* Set Auto Reconnect */
+
+uint8_t *
+rmf_message_set_auto_reconnect_request_new (uint32_t enabled,
+                                            uint32_t max_attempts,
+                                            uint32_t max_delay)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_SET_AUTO_RECONNECT, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_uint32 (builder, enabled);
+    rmf_message_builder_add_uint32 (builder, max_attempts);
+    rmf_message_builder_add_uint32 (builder, max_delay);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+void
+rmf_message_set_auto_reconnect_request_parse (const uint8_t *message,
+                                              uint32_t      *enabled,
+                                              uint32_t      *max_attempts,
+                                              uint32_t      *max_delay)
+{
+    uint32_t offset = 0;
+    uint32_t value;
+
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_REQUEST);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_SET_AUTO_RECONNECT);
+
+    value = rmf_message_read_uint32 (message, &offset);
+    if (enabled)
+        *enabled = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (max_attempts)
+        *max_attempts = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (max_delay)
+        *max_delay = value;
+}
+
+uint8_t *
+rmf_message_set_auto_reconnect_response_new (void)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_SET_AUTO_RECONNECT, RMF_RESPONSE_STATUS_OK);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+void
+rmf_message_set_auto_reconnect_response_parse (const uint8_t *message,
+                                               uint32_t      *status)
+{
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_SET_AUTO_RECONNECT);
+
+    if (status)
+        *status = rmf_message_get_status (message);
+}
+
+/******************************************************************************/
+/* Get Available Networks / Scan Networks
+ *
+ *  Request:
+ *    - no arguments
+ *  Response:
+ *    - uint32 scan ongoing (always 0 in the Scan Networks response)
+ *    - uint32 scan time
+ *    - uint32 number of networks (N)
+ *    - N times:
+ *      - uint32 mcc
+ *      - uint32 mnc
+ *      - uint32 radio interface
+ *      - uint32 status
+ *      - string description
+ */
+
+#define AVAILABLE_NETWORKS_HEADER_SIZE  (3 * 4)
+#define AVAILABLE_NETWORKS_NETWORK_SIZE ((4 * 4) + 8)
+
+uint8_t *
+rmf_message_get_available_networks_request_new (void)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_GET_AVAILABLE_NETWORKS, RMF_RESPONSE_STATUS_OK);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+static uint8_t *
+available_networks_response_new (uint32_t              command,
+                                 uint32_t              scan_ongoing,
+                                 uint32_t              scan_time,
+                                 uint32_t              n_networks,
+                                 const RmfNetworkInfo *networks)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+    uint32_t i;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, command, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_uint32 (builder, scan_ongoing);
+    rmf_message_builder_add_uint32 (builder, scan_time);
+    rmf_message_builder_add_uint32 (builder, n_networks);
+    for (i = 0; i < n_networks; i++) {
+        rmf_message_builder_add_uint32 (builder, networks[i].mcc);
+        rmf_message_builder_add_uint32 (builder, networks[i].mnc);
+        rmf_message_builder_add_uint32 (builder, networks[i].radio_interface);
+        rmf_message_builder_add_uint32 (builder, networks[i].status);
+        rmf_message_builder_add_string (builder, networks[i].description);
+    }
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+uint8_t *
+rmf_message_get_available_networks_response_new (uint32_t              scan_ongoing,
+                                                 uint32_t              scan_time,
+                                                 uint32_t              n_networks,
+                                                 const RmfNetworkInfo *networks)
+{
+    return available_networks_response_new (RMF_MESSAGE_COMMAND_GET_AVAILABLE_NETWORKS,
+                                            scan_ongoing, scan_time, n_networks, networks);
+}
+
+void
+rmf_message_get_available_networks_response_parse (const uint8_t *message,
+                                                   uint32_t      *status,
+                                                   uint32_t      *scan_ongoing,
+                                                   uint32_t      *scan_time,
+                                                   uint32_t      *n_networks)
+{
+    uint32_t offset = 0;
+    uint32_t value;
+
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_GET_AVAILABLE_NETWORKS ||
+            rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_SCAN_NETWORKS);
+
+    if (status)
+        *status = rmf_message_get_status (message);
+
+    if (rmf_message_get_status (message) != RMF_RESPONSE_STATUS_OK)
+        return;
+
+    value = rmf_message_read_uint32 (message, &offset);
+    if (scan_ongoing)
+        *scan_ongoing = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (scan_time)
+        *scan_time = value;
+    value = rmf_message_read_uint32 (message, &offset);
+    if (n_networks)
+        *n_networks = value;
+}
+
+void
+rmf_message_get_available_networks_response_parse_network (const uint8_t  *message,
+                                                           uint32_t        i,
+                                                           RmfNetworkInfo *network)
+{
+    uint32_t offset;
+
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_GET_AVAILABLE_NETWORKS ||
+            rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_SCAN_NETWORKS);
+    assert (rmf_message_get_status (message) == RMF_RESPONSE_STATUS_OK);
+
+    offset = AVAILABLE_NETWORKS_HEADER_SIZE + (i * AVAILABLE_NETWORKS_NETWORK_SIZE);
+    network->mcc             = rmf_message_read_uint32 (message, &offset);
+    network->mnc             = rmf_message_read_uint32 (message, &offset);
+    network->radio_interface = rmf_message_read_uint32 (message, &offset);
+    network->status          = rmf_message_read_uint32 (message, &offset);
+    network->description     = rmf_message_read_string (message, &offset);
+}
+
+uint8_t *
+rmf_message_scan_networks_request_new (void)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_SCAN_NETWORKS, RMF_RESPONSE_STATUS_OK);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+uint8_t *
+rmf_message_scan_networks_response_new (uint32_t              scan_time,
+                                        uint32_t              n_networks,
+                                        const RmfNetworkInfo *networks)
+{
+    return available_networks_response_new (RMF_MESSAGE_COMMAND_SCAN_NETWORKS,
+                                            0, scan_time, n_networks, networks);
+}
+
+/******************************************************************************/
+/* Cancel Network Scan */
+
+uint8_t *
+rmf_message_cancel_network_scan_request_new (void)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_CANCEL_NETWORK_SCAN, RMF_RESPONSE_STATUS_OK);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+uint8_t *
+rmf_message_cancel_network_scan_response_new (void)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_CANCEL_NETWORK_SCAN, RMF_RESPONSE_STATUS_OK);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+void
+rmf_message_cancel_network_scan_response_parse (const uint8_t *message,
+                                                uint32_t      *status)
+{
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_CANCEL_NETWORK_SCAN);
+
+    if (status)
+        *status = rmf_message_get_status (message);
+}
+
+/******************************************************************************/
+/* Is Messaging Ready */
+
+uint8_t *
+rmf_message_is_messaging_ready_request_new (void)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_IS_MESSAGING_READY, RMF_RESPONSE_STATUS_OK);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+uint8_t *
+rmf_message_is_messaging_ready_response_new (uint8_t ready)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_IS_MESSAGING_READY, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_uint32 (builder, (uint32_t) ready);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+void
+rmf_message_is_messaging_ready_response_parse (const uint8_t *message,
+                                               uint32_t      *status,
+                                               uint8_t       *ready)
+{
+    uint32_t offset = 0;
+
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_IS_MESSAGING_READY);
+
+    if (status)
+        *status = rmf_message_get_status (message);
+
+    if (ready)
+        *ready = (uint8_t) rmf_message_read_uint32 (message, &offset);
+}
+
+/******************************************************************************/
+/* Get Daemon Metrics
+ *
+ *  Request:
+ *    - no arguments
+ *  Response:
+ *    - uint32 queued requests
+ *    - uint32 clients
+ *    - uint32 main loop lag (ms)
+ *    - uint32 max main loop lag (ms)
+ *    - uint32 number of commands (N)
+ *    - uint32 number of QMI services (M)
+ *    - N times:
+ *      - uint32 command
+ *      - uint32 count
+ *      - uint32 errors
+ *      - uint32 x RMF_METRICS_HISTOGRAM_N_BUCKETS queue wait histogram
+ *      - uint32 x RMF_METRICS_HISTOGRAM_N_BUCKETS processing histogram
+ *      - uint32 x RMF_METRICS_HISTOGRAM_N_BUCKETS total histogram
+ *    - M times:
+ *      - string service
+ *      - uint32 transactions
+ *      - uint32 timeouts
+ *      - uint32 x RMF_METRICS_HISTOGRAM_N_BUCKETS round trip histogram
+ */
+
+const uint32_t rmf_metrics_histogram_limits_ms[RMF_METRICS_HISTOGRAM_N_BUCKETS - 1] = {
+    10, 100, 500, 1000, 5000
+};
+
+#define DAEMON_METRICS_HEADER_SIZE  (6 * 4)
+#define DAEMON_METRICS_COMMAND_SIZE ((3 + 3 * RMF_METRICS_HISTOGRAM_N_BUCKETS) * 4)
+#define DAEMON_METRICS_SERVICE_SIZE (8 + (2 + RMF_METRICS_HISTOGRAM_N_BUCKETS) * 4)
+
+static void
+add_histogram (RmfMessageBuilder *builder,
+               const uint32_t    *histogram)
+{
+    uint32_t i;
+
+    for (i = 0; i < RMF_METRICS_HISTOGRAM_N_BUCKETS; i++)
+        rmf_message_builder_add_uint32 (builder, histogram[i]);
+}
+
+static void
+read_histogram (const uint8_t *message,
+                uint32_t      *offset,
+                uint32_t      *histogram)
+{
+    uint32_t i;
+
+    for (i = 0; i < RMF_METRICS_HISTOGRAM_N_BUCKETS; i++)
+        histogram[i] = rmf_message_read_uint32 (message, offset);
+}
+
+uint8_t *
+rmf_message_get_daemon_metrics_request_new (void)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_REQUEST, RMF_MESSAGE_COMMAND_GET_DAEMON_METRICS, RMF_RESPONSE_STATUS_OK);
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+uint8_t *
+rmf_message_get_daemon_metrics_response_new (uint32_t                    queued_requests,
+                                             uint32_t                    clients,
+                                             uint32_t                    main_loop_lag_ms,
+                                             uint32_t                    main_loop_lag_max_ms,
+                                             uint32_t                    n_commands,
+                                             const RmfCommandMetrics    *commands,
+                                             uint32_t                    n_services,
+                                             const RmfQmiServiceMetrics *services)
+{
+    RmfMessageBuilder *builder;
+    uint8_t *message;
+    uint32_t i;
+
+    builder = rmf_message_builder_new (RMF_MESSAGE_TYPE_RESPONSE, RMF_MESSAGE_COMMAND_GET_DAEMON_METRICS, RMF_RESPONSE_STATUS_OK);
+    rmf_message_builder_add_uint32 (builder, queued_requests);
+    rmf_message_builder_add_uint32 (builder, clients);
+    rmf_message_builder_add_uint32 (builder, main_loop_lag_ms);
+    rmf_message_builder_add_uint32 (builder, main_loop_lag_max_ms);
+    rmf_message_builder_add_uint32 (builder, n_commands);
+    rmf_message_builder_add_uint32 (builder, n_services);
+    for (i = 0; i < n_commands; i++) {
+        rmf_message_builder_add_uint32 (builder, commands[i].command);
+        rmf_message_builder_add_uint32 (builder, commands[i].count);
+        rmf_message_builder_add_uint32 (builder, commands[i].errors);
+        add_histogram (builder, commands[i].queue_wait);
+        add_histogram (builder, commands[i].processing);
+        add_histogram (builder, commands[i].total);
+    }
+    for (i = 0; i < n_services; i++) {
+        rmf_message_builder_add_string (builder, services[i].service);
+        rmf_message_builder_add_uint32 (builder, services[i].transactions);
+        rmf_message_builder_add_uint32 (builder, services[i].timeouts);
+        add_histogram (builder, services[i].round_trip);
+    }
+    message = rmf_message_builder_serialize (builder);
+    rmf_message_builder_free (builder);
+
+    return message;
+}
+
+void
+rmf_message_get_daemon_metrics_response_parse (const uint8_t *message,
+                                               uint32_t      *status,
+                                               uint32_t      *queued_requests,
+                                               uint32_t      *clients,
+                                               uint32_t      *main_loop_lag_ms,
+                                               uint32_t      *main_loop_lag_max_ms,
+                                               uint32_t      *n_commands,
+                                               uint32_t      *n_services)
+{
+    uint32_t offset = 0;
+    uint32_t aux;
+
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_GET_DAEMON_METRICS);
+
+    if (status)
+        *status = rmf_message_get_status (message);
+
+    if (rmf_message_get_status (message) != RMF_RESPONSE_STATUS_OK)
+        return;
+
+    aux = rmf_message_read_uint32 (message, &offset);
+    if (queued_requests)
+        *queued_requests = aux;
+    aux = rmf_message_read_uint32 (message, &offset);
+    if (clients)
+        *clients = aux;
+    aux = rmf_message_read_uint32 (message, &offset);
+    if (main_loop_lag_ms)
+        *main_loop_lag_ms = aux;
+    aux = rmf_message_read_uint32 (message, &offset);
+    if (main_loop_lag_max_ms)
+        *main_loop_lag_max_ms = aux;
+    aux = rmf_message_read_uint32 (message, &offset);
+    if (n_commands)
+        *n_commands = aux;
+    aux = rmf_message_read_uint32 (message, &offset);
+    if (n_services)
+        *n_services = aux;
+}
+
+void
+rmf_message_get_daemon_metrics_response_parse_command (const uint8_t     *message,
+                                                       uint32_t           i,
+                                                       RmfCommandMetrics *command)
+{
+    uint32_t offset;
+
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_GET_DAEMON_METRICS);
+    assert (rmf_message_get_status (message) == RMF_RESPONSE_STATUS_OK);
+
+    offset = DAEMON_METRICS_HEADER_SIZE + (i * DAEMON_METRICS_COMMAND_SIZE);
+    command->command = rmf_message_read_uint32 (message, &offset);
+    command->count   = rmf_message_read_uint32 (message, &offset);
+    command->errors  = rmf_message_read_uint32 (message, &offset);
+    read_histogram (message, &offset, command->queue_wait);
+    read_histogram (message, &offset, command->processing);
+    read_histogram (message, &offset, command->total);
+}
+
+void
+rmf_message_get_daemon_metrics_response_parse_service (const uint8_t        *message,
+                                                       uint32_t              i,
+                                                       RmfQmiServiceMetrics *service)
+{
+    uint32_t offset = 16;
+    uint32_t n_commands;
+
+    assert (rmf_message_get_type (message) == RMF_MESSAGE_TYPE_RESPONSE);
+    assert (rmf_message_get_command (message) == RMF_MESSAGE_COMMAND_GET_DAEMON_METRICS);
+    assert (rmf_message_get_status (message) == RMF_RESPONSE_STATUS_OK);
+
+    /* Services go after all command entries */
+    n_commands = rmf_message_read_uint32 (message, &offset);
+    offset = DAEMON_METRICS_HEADER_SIZE + (n_commands * DAEMON_METRICS_COMMAND_SIZE) + (i * DAEMON_METRICS_SERVICE_SIZE);
+    service->service      = rmf_message_read_string (message, &offset);
+    service->transactions = rmf_message_read_uint32 (message, &offset);
+    service->timeouts     = rmf_message_read_uint32 (message, &offset);
+    read_histogram (message, &offset, service->round_trip);
 }
@@ -40,6 +40,7 @@
 uint32_t rmf_message_get_length                 (const uint8_t *message);
 uint32_t rmf_message_get_type                   (const uint8_t *buffer);
 uint32_t rmf_message_get_command                (const uint8_t *buffer);
+uint32_t rmf_message_get_status                 (const uint8_t *buffer); /* responses only */
 uint32_t rmf_message_request_and_response_match (const uint8_t *request,
                                                  const uint8_t *response);
 
@@ -206,8 +207,22 @@ enum RmfMessageCommand {
     RMF_MESSAGE_COMMAND_GET_DATA_PORT            = 26,
     RMF_MESSAGE_COMMAND_GET_SIM_SLOT             = 27,
     RMF_MESSAGE_COMMAND_SET_SIM_SLOT             = 28,
+    RMF_MESSAGE_COMMAND_GET_DAEMON_METRICS       = 29,
+    RMF_MESSAGE_COMMAND_GET_AUTO_RECONNECT       = 30,
+    RMF_MESSAGE_COMMAND_SET_AUTO_RECONNECT       = 31,
+    RMF_MESSAGE_COMMAND_GET_AVAILABLE_NETWORKS   = 32,
+    RMF_MESSAGE_COMMAND_SCAN_NETWORKS            = 33,
+    RMF_MESSAGE_COMMAND_CANCEL_NETWORK_SCAN      = 34,
+    RMF_MESSAGE_COMMAND_IS_MESSAGING_READY       = 35,
+    RMF_MESSAGE_COMMAND_CONNECT_SESSION          = 36,
+    RMF_MESSAGE_COMMAND_DISCONNECT_SESSION       = 37,
+    RMF_MESSAGE_COMMAND_GET_SESSION_STATUS       = 38,
+    RMF_MESSAGE_COMMAND_GET_SESSION_STATS        = 39,
+    RMF_MESSAGE_COMMAND_GET_DATA_FORMAT          = 40,
 };
 
+const char *rmf_message_command_get_string (uint32_t command);
+
 /******************************************************************************/
 /* Additional enums, same as the ones in the librmf interface */
 
@@ -226,6 +241,19 @@ typedef enum {
     RMF_CONNECTION_STATUS_CONNECTED,
 } RmfConnectionStatus;
 
+typedef enum {
+    RMF_AUTO_RECONNECT_STATE_IDLE,
+    RMF_AUTO_RECONNECT_STATE_WAITING,
+    RMF_AUTO_RECONNECT_STATE_RECONNECTING,
+} RmfAutoReconnectState;
+
+typedef enum {
+    RMF_NETWORK_STATUS_UNKNOWN,
+    RMF_NETWORK_STATUS_AVAILABLE,
+    RMF_NETWORK_STATUS_CURRENT,
+    RMF_NETWORK_STATUS_FORBIDDEN,
+} RmfNetworkStatus;
+
 typedef enum {
     RMF_POWER_STATUS_FULL,
     RMF_POWER_STATUS_LOW,
@@ -237,6 +265,13 @@ typedef enum {
     RMF_RADIO_INTERFACE_LTE
 } RmfRadioInterface;
 
+/* Bitmask of RmfRadioInterface values */
+#define RMF_RADIO_INTERFACE_MASK(interface) (1 << (interface))
+#define RMF_RADIO_INTERFACE_MASK_ALL                 \
+    (RMF_RADIO_INTERFACE_MASK (RMF_RADIO_INTERFACE_GSM)  | \
+     RMF_RADIO_INTERFACE_MASK (RMF_RADIO_INTERFACE_UMTS) | \
+     RMF_RADIO_INTERFACE_MASK (RMF_RADIO_INTERFACE_LTE))
+
 /******************************************************************************/
 /* Generic error response */
 
@@ -417,7 +452,9 @@ void     rmf_message_set_power_status_response_parse (const uint8_t *message,
 /******************************************************************************/
 /* Get Power Info */
 
-uint8_t *rmf_message_get_power_info_request_new    (void);
+uint8_t *rmf_message_get_power_info_request_new    (uint32_t       radio_interfaces);
+void     rmf_message_get_power_info_request_parse  (const uint8_t *message,
+                                                    uint32_t      *radio_interfaces);
 uint8_t *rmf_message_get_power_info_response_new   (uint32_t       gsm_in_traffic,
                                                     int32_t        gsm_tx_power,
                                                     uint32_t       gsm_rx0_radio_tuned,
@@ -469,7 +506,8 @@ uint8_t *rmf_message_get_signal_info_response_new   (uint32_t       gsm_availabl
                                                      uint32_t       umts_quality,
                                                      uint32_t       lte_available,
                                                      int32_t        lte_rssi,
-                                                     uint32_t       lte_quality);
+                                                     uint32_t       lte_quality,
+                                                     uint32_t       age);
 void     rmf_message_get_signal_info_response_parse (const uint8_t *message,
                                                      uint32_t      *status,
                                                      uint32_t      *gsm_available,
@@ -480,7 +518,8 @@ void     rmf_message_get_signal_info_response_parse (const uint8_t *message,
                                                      uint32_t      *umts_quality,
                                                      uint32_t      *lte_available,
                                                      int32_t      *lte_rssi,
-                                                     uint32_t      *lte_quality);
+                                                     uint32_t      *lte_quality,
+                                                     uint32_t      *age);
 
 /******************************************************************************/
 /* Get Registration Status */
@@ -555,6 +594,65 @@ uint8_t *rmf_message_disconnect_response_new   (void);
 void     rmf_message_disconnect_response_parse (const uint8_t *message,
                                                 uint32_t      *status);
 
+/******************************************************************************/
+/* Multiplexed data sessions
+ *
+ * When the daemon runs with QMAP multiplexing enabled, each session (1..N) is
+ * an independent PDN with its own network interface. */
+
+uint8_t *rmf_message_connect_session_request_new     (uint32_t        session,
+                                                      const char     *apn,
+                                                      const char     *user,
+                                                      const char     *password);
+void     rmf_message_connect_session_request_parse   (const uint8_t  *message,
+                                                      uint32_t       *session,
+                                                      const char    **apn,
+                                                      const char    **user,
+                                                      const char    **password);
+uint8_t *rmf_message_connect_session_response_new    (const char     *interface);
+void     rmf_message_connect_session_response_parse  (const uint8_t  *message,
+                                                      uint32_t       *status,
+                                                      const char    **interface);
+
+uint8_t *rmf_message_disconnect_session_request_new    (uint32_t       session);
+void     rmf_message_disconnect_session_request_parse  (const uint8_t *message,
+                                                        uint32_t      *session);
+uint8_t *rmf_message_disconnect_session_response_new   (void);
+void     rmf_message_disconnect_session_response_parse (const uint8_t *message,
+                                                        uint32_t      *status);
+
+uint8_t *rmf_message_get_session_status_request_new    (uint32_t        session);
+void     rmf_message_get_session_status_request_parse  (const uint8_t  *message,
+                                                        uint32_t       *session);
+uint8_t *rmf_message_get_session_status_response_new   (uint32_t        connection_status,
+                                                        const char     *interface);
+void     rmf_message_get_session_status_response_parse (const uint8_t  *message,
+                                                        uint32_t       *status,
+                                                        uint32_t       *connection_status,
+                                                        const char    **interface);
+
+uint8_t *rmf_message_get_session_stats_request_new    (uint32_t       session);
+void     rmf_message_get_session_stats_request_parse  (const uint8_t *message,
+                                                       uint32_t      *session);
+uint8_t *rmf_message_get_session_stats_response_new   (uint32_t       tx_packets_ok,
+                                                       uint32_t       rx_packets_ok,
+                                                       uint32_t       tx_packets_error,
+                                                       uint32_t       rx_packets_error,
+                                                       uint32_t       tx_packets_overflow,
+                                                       uint32_t       rx_packets_overflow,
+                                                       uint64_t       tx_bytes_ok,
+                                                       uint64_t       rx_bytes_ok);
+void     rmf_message_get_session_stats_response_parse (const uint8_t *message,
+                                                       uint32_t      *status,
+                                                       uint32_t      *tx_packets_ok,
+                                                       uint32_t      *rx_packets_ok,
+                                                       uint32_t      *tx_packets_error,
+                                                       uint32_t      *rx_packets_error,
+                                                       uint32_t      *tx_packets_overflow,
+                                                       uint32_t      *rx_packets_overflow,
+                                                       uint64_t      *tx_bytes_ok,
+                                                       uint64_t      *rx_bytes_ok);
+
 /******************************************************************************/
 /* Modem Is Available */
 
@@ -600,5 +698,167 @@ void     rmf_message_get_data_port_response_parse (const uint8_t  *message,
                                                    uint32_t       *status,
                                                    const char    **data_port);
 
+/******************************************************************************/
+/* Get Data Format
+ *
+ * Aggregation limits are the ones negotiated with the modem, 0 if data
+ * aggregation isn't enabled or if the modem didn't report them. */
+
+uint8_t *rmf_message_get_data_format_request_new    (void);
+uint8_t *rmf_message_get_data_format_response_new   (uint32_t       raw_ip,
+                                                     uint32_t       ul_max_datagrams,
+                                                     uint32_t       ul_max_size,
+                                                     uint32_t       dl_max_datagrams,
+                                                     uint32_t       dl_max_size);
+void     rmf_message_get_data_format_response_parse (const uint8_t *message,
+                                                     uint32_t      *status,
+                                                     uint32_t      *raw_ip,
+                                                     uint32_t      *ul_max_datagrams,
+                                                     uint32_t      *ul_max_size,
+                                                     uint32_t      *dl_max_datagrams,
+                                                     uint32_t      *dl_max_size);
+
+/******************************************************************************/
+/* Get Auto Reconnect */
+
+uint8_t *rmf_message_get_auto_reconnect_request_new    (void);
+uint8_t *rmf_message_get_auto_reconnect_response_new   (uint32_t       enabled,
+                                                        uint32_t       max_attempts,
+                                                        uint32_t       max_delay,
+                                                        uint32_t       state,
+                                                        uint32_t       attempt,
+                                                        uint32_t       drops,
+                                                        uint32_t       reconnects,
+                                                        uint32_t       failures,
+                                                        uint32_t       last_recovery_time_ms);
+void     rmf_message_get_auto_reconnect_response_parse (const uint8_t *message,
+                                                        uint32_t      *status,
+                                                        uint32_t      *enabled,
+                                                        uint32_t      *max_attempts,
+                                                        uint32_t      *max_delay,
+                                                        uint32_t      *state,
+                                                        uint32_t      *attempt,
+                                                        uint32_t      *drops,
+                                                        uint32_t      *reconnects,
+                                                        uint32_t      *failures,
+                                                        uint32_t      *last_recovery_time_ms);
+
+/******************************************************************************/
+/* Set Auto Reconnect */
+
+/* max_attempts set to 0 means unlimited; max_delay given in seconds */
+uint8_t *rmf_message_set_auto_reconnect_request_new    (uint32_t       enabled,
+                                                        uint32_t       max_attempts,
+                                                        uint32_t       max_delay);
+void     rmf_message_set_auto_reconnect_request_parse  (const uint8_t *message,
+                                                        uint32_t      *enabled,
+                                                        uint32_t      *max_attempts,
+                                                        uint32_t      *max_delay);
+uint8_t *rmf_message_set_auto_reconnect_response_new   (void);
+void     rmf_message_set_auto_reconnect_response_parse (const uint8_t *message,
+                                                        uint32_t      *status);
+
+/******************************************************************************/
+/* Get Available Networks */
+
+typedef struct {
+    uint32_t    mcc;
+    uint32_t    mnc;
+    uint32_t    radio_interface; /* RmfRadioInterface */
+    uint32_t    status;          /* RmfNetworkStatus */
+    const char *description;
+} RmfNetworkInfo;
+
+/* Results of the last network scan; scan_time is given as unix timestamp, or
+ * 0 if no scan has been completed yet */
+uint8_t *rmf_message_get_available_networks_request_new            (void);
+uint8_t *rmf_message_get_available_networks_response_new           (uint32_t              scan_ongoing,
+                                                                    uint32_t              scan_time,
+                                                                    uint32_t              n_networks,
+                                                                    const RmfNetworkInfo *networks);
+void     rmf_message_get_available_networks_response_parse         (const uint8_t        *message,
+                                                                    uint32_t             *status,
+                                                                    uint32_t             *scan_ongoing,
+                                                                    uint32_t             *scan_time,
+                                                                    uint32_t             *n_networks);
+void     rmf_message_get_available_networks_response_parse_network (const uint8_t        *message,
+                                                                    uint32_t              i,
+                                                                    RmfNetworkInfo       *network);
+
+/******************************************************************************/
+/* Scan Networks */
+
+/* Launches a new network scan, or waits for the one already ongoing. The
+ * response has the same contents as the Get Available Networks one, and is
+ * parsed with the same methods. */
+uint8_t *rmf_message_scan_networks_request_new    (void);
+uint8_t *rmf_message_scan_networks_response_new   (uint32_t              scan_time,
+                                                   uint32_t              n_networks,
+                                                   const RmfNetworkInfo *networks);
+
+/******************************************************************************/
+/* Cancel Network Scan */
+
+uint8_t *rmf_message_cancel_network_scan_request_new    (void);
+uint8_t *rmf_message_cancel_network_scan_response_new   (void);
+void     rmf_message_cancel_network_scan_response_parse (const uint8_t *message,
+                                                         uint32_t      *status);
+
+/******************************************************************************/
+/* Is Messaging Ready */
+
+uint8_t *rmf_message_is_messaging_ready_request_new    (void);
+uint8_t *rmf_message_is_messaging_ready_response_new   (uint8_t        ready);
+void     rmf_message_is_messaging_ready_response_parse (const uint8_t *message,
+                                                        uint32_t      *status,
+                                                        uint8_t       *ready);
+
+/******************************************************************************/
+/* Get Daemon Metrics */
+
+/* Latency histograms have one bucket per limit (value <= limit), plus a last
+ * one for all values above the last limit */
+#define RMF_METRICS_HISTOGRAM_N_BUCKETS 6
+extern const uint32_t rmf_metrics_histogram_limits_ms[RMF_METRICS_HISTOGRAM_N_BUCKETS - 1];
+
+typedef struct {
+    uint32_t command;
+    uint32_t count;
+    uint32_t errors;
+    uint32_t queue_wait[RMF_METRICS_HISTOGRAM_N_BUCKETS];
+    uint32_t processing[RMF_METRICS_HISTOGRAM_N_BUCKETS];
+    uint32_t total[RMF_METRICS_HISTOGRAM_N_BUCKETS];
+} RmfCommandMetrics;
+
+typedef struct {
+    const char *service;
+    uint32_t    transactions;
+    uint32_t    timeouts;
+    uint32_t    round_trip[RMF_METRICS_HISTOGRAM_N_BUCKETS];
+} RmfQmiServiceMetrics;
+
+uint8_t *rmf_message_get_daemon_metrics_request_new            (void);
+uint8_t *rmf_message_get_daemon_metrics_response_new           (uint32_t                    queued_requests,
+                                                                uint32_t                    clients,
+                                                                uint32_t                    main_loop_lag_ms,
+                                                                uint32_t                    main_loop_lag_max_ms,
+                                                                uint32_t                    n_commands,
+                                                                const RmfCommandMetrics    *commands,
+                                                                uint32_t                    n_services,
+                                                                const RmfQmiServiceMetrics *services);
+void     rmf_message_get_daemon_metrics_response_parse         (const uint8_t              *message,
+                                                                uint32_t                   *status,
+                                                                uint32_t                   *queued_requests,
+                                                                uint32_t                   *clients,
+                                                                uint32_t                   *main_loop_lag_ms,
+                                                                uint32_t                   *main_loop_lag_max_ms,
+                                                                uint32_t                   *n_commands,
+                                                                uint32_t                   *n_services);
+void     rmf_message_get_daemon_metrics_response_parse_command (const uint8_t              *message,
+                                                                uint32_t                    i,
+                                                                RmfCommandMetrics          *command);
+void     rmf_message_get_daemon_metrics_response_parse_service (const uint8_t              *message,
+                                                                uint32_t                    i,
+                                                                RmfQmiServiceMetrics       *service);
 
 #endif /* _RMF_MESSAGES_H_ */
@@ -47,11 +47,220 @@ test_get_manufacturer (void)
     g_free (message);
 }
 
+static void
+test_get_power_info (void)
+{
+    uint8_t *message;
+    uint32_t radio_interfaces;
+
+    message = rmf_message_get_power_info_request_new (RMF_RADIO_INTERFACE_MASK (RMF_RADIO_INTERFACE_LTE));
+    g_assert (message != NULL);
+    rmf_message_get_power_info_request_parse (message, &radio_interfaces);
+    g_assert_cmpuint (radio_interfaces, ==, RMF_RADIO_INTERFACE_MASK (RMF_RADIO_INTERFACE_LTE));
+
+    g_free (message);
+}
+
+static void
+test_get_daemon_metrics (void)
+{
+    uint8_t *message;
+    uint32_t status;
+    uint32_t queued_requests;
+    uint32_t clients;
+    uint32_t lag;
+    uint32_t lag_max;
+    uint32_t n_commands;
+    uint32_t n_services;
+    RmfCommandMetrics commands[2] = {
+        { RMF_MESSAGE_COMMAND_GET_IMEI,    3, 0, { 3 },    { 0, 3 },    { 0, 3 }    },
+        { RMF_MESSAGE_COMMAND_GET_SIM_INFO, 1, 1, { 0, 1 }, { 0, 0, 1 }, { 0, 0, 0, 1 } },
+    };
+    RmfQmiServiceMetrics services[2] = {
+        { "dms", 3, 0, { 3 } },
+        { "uim", 7, 2, { 0, 5, 0, 0, 0, 2 } },
+    };
+    RmfCommandMetrics command;
+    RmfQmiServiceMetrics service;
+
+    message = rmf_message_get_daemon_metrics_response_new (1, 2, 3, 40, 2, commands, 2, services);
+    g_assert (message != NULL);
+    rmf_message_get_daemon_metrics_response_parse (message, &status, &queued_requests, &clients, &lag, &lag_max, &n_commands, &n_services);
+    g_assert_cmpuint (status, ==, RMF_RESPONSE_STATUS_OK);
+    g_assert_cmpuint (queued_requests, ==, 1);
+    g_assert_cmpuint (clients, ==, 2);
+    g_assert_cmpuint (lag, ==, 3);
+    g_assert_cmpuint (lag_max, ==, 40);
+    g_assert_cmpuint (n_commands, ==, 2);
+    g_assert_cmpuint (n_services, ==, 2);
+
+    rmf_message_get_daemon_metrics_response_parse_command (message, 1, &command);
+    g_assert_cmpuint (command.command, ==, RMF_MESSAGE_COMMAND_GET_SIM_INFO);
+    g_assert_cmpuint (command.errors, ==, 1);
+    g_assert_cmpuint (command.total[3], ==, 1);
+
+    rmf_message_get_daemon_metrics_response_parse_service (message, 1, &service);
+    g_assert_cmpstr (service.service, ==, "uim");
+    g_assert_cmpuint (service.transactions, ==, 7);
+    g_assert_cmpuint (service.timeouts, ==, 2);
+    g_assert_cmpuint (service.round_trip[5], ==, 2);
+
+    g_free (message);
+}
+
+static void
+test_connect_session (void)
+{
+    uint8_t *message;
+    uint32_t session;
+    uint32_t status;
+    const char *apn;
+    const char *user;
+    const char *password;
+    const char *interface;
+
+    message = rmf_message_connect_session_request_new (2, "internet", "user", "");
+    g_assert (message != NULL);
+    rmf_message_connect_session_request_parse (message, &session, &apn, &user, &password);
+    g_assert_cmpuint (session, ==, 2);
+    g_assert_cmpstr (apn, ==, "internet");
+    g_assert_cmpstr (user, ==, "user");
+    g_assert_cmpstr (password, ==, "");
+    g_free (message);
+
+    message = rmf_message_connect_session_response_new ("qmimux1");
+    g_assert (message != NULL);
+    rmf_message_connect_session_response_parse (message, &status, &interface);
+    g_assert_cmpuint (status, ==, RMF_RESPONSE_STATUS_OK);
+    g_assert_cmpstr (interface, ==, "qmimux1");
+    g_free (message);
+}
+
+static void
+test_disconnect_session (void)
+{
+    uint8_t *message;
+    uint32_t session;
+    uint32_t status;
+
+    message = rmf_message_disconnect_session_request_new (3);
+    g_assert (message != NULL);
+    rmf_message_disconnect_session_request_parse (message, &session);
+    g_assert_cmpuint (session, ==, 3);
+    g_free (message);
+
+    message = rmf_message_disconnect_session_response_new ();
+    g_assert (message != NULL);
+    rmf_message_disconnect_session_response_parse (message, &status);
+    g_assert_cmpuint (status, ==, RMF_RESPONSE_STATUS_OK);
+    g_free (message);
+}
+
+static void
+test_get_session_status (void)
+{
+    uint8_t *message;
+    uint32_t session;
+    uint32_t status;
+    uint32_t connection_status;
+    const char *interface;
+
+    message = rmf_message_get_session_status_request_new (1);
+    g_assert (message != NULL);
+    rmf_message_get_session_status_request_parse (message, &session);
+    g_assert_cmpuint (session, ==, 1);
+    g_free (message);
+
+    message = rmf_message_get_session_status_response_new (RMF_CONNECTION_STATUS_CONNECTED, "qmimux0");
+    g_assert (message != NULL);
+    rmf_message_get_session_status_response_parse (message, &status, &connection_status, &interface);
+    g_assert_cmpuint (status, ==, RMF_RESPONSE_STATUS_OK);
+    g_assert_cmpuint (connection_status, ==, RMF_CONNECTION_STATUS_CONNECTED);
+    g_assert_cmpstr (interface, ==, "qmimux0");
+    g_free (message);
+}
+
+static void
+test_get_session_stats (void)
+{
+    uint8_t *message;
+    uint32_t session;
+    uint32_t status;
+    uint32_t tx_packets_ok;
+    uint32_t rx_packets_ok;
+    uint32_t tx_packets_error;
+    uint32_t rx_packets_error;
+    uint32_t tx_packets_overflow;
+    uint32_t rx_packets_overflow;
+    uint64_t tx_bytes_ok;
+    uint64_t rx_bytes_ok;
+
+    message = rmf_message_get_session_stats_request_new (4);
+    g_assert (message != NULL);
+    rmf_message_get_session_stats_request_parse (message, &session);
+    g_assert_cmpuint (session, ==, 4);
+    g_free (message);
+
+    message = rmf_message_get_session_stats_response_new (1, 2, 3, 4, 5, 6, G_GUINT64_CONSTANT (0x100000007), 8);
+    g_assert (message != NULL);
+    rmf_message_get_session_stats_response_parse (message, &status,
+                                                  &tx_packets_ok, &rx_packets_ok,
+                                                  &tx_packets_error, &rx_packets_error,
+                                                  &tx_packets_overflow, &rx_packets_overflow,
+                                                  &tx_bytes_ok, &rx_bytes_ok);
+    g_assert_cmpuint (status, ==, RMF_RESPONSE_STATUS_OK);
+    g_assert_cmpuint (tx_packets_ok, ==, 1);
+    g_assert_cmpuint (rx_packets_ok, ==, 2);
+    g_assert_cmpuint (tx_packets_error, ==, 3);
+    g_assert_cmpuint (rx_packets_error, ==, 4);
+    g_assert_cmpuint (tx_packets_overflow, ==, 5);
+    g_assert_cmpuint (rx_packets_overflow, ==, 6);
+    g_assert_cmpuint (tx_bytes_ok, ==, G_GUINT64_CONSTANT (0x100000007));
+    g_assert_cmpuint (rx_bytes_ok, ==, 8);
+    g_free (message);
+}
+
+static void
+test_get_data_format (void)
+{
+    uint8_t *message;
+    uint32_t status;
+    uint32_t raw_ip;
+    uint32_t ul_max_datagrams;
+    uint32_t ul_max_size;
+    uint32_t dl_max_datagrams;
+    uint32_t dl_max_size;
+
+    message = rmf_message_get_data_format_request_new ();
+    g_assert (message != NULL);
+    g_free (message);
+
+    message = rmf_message_get_data_format_response_new (1, 16, 8192, 32, 0);
+    g_assert (message != NULL);
+    rmf_message_get_data_format_response_parse (message, &status, &raw_ip,
+                                                &ul_max_datagrams, &ul_max_size,
+                                                &dl_max_datagrams, &dl_max_size);
+    g_assert_cmpuint (status, ==, RMF_RESPONSE_STATUS_OK);
+    g_assert_cmpuint (raw_ip, ==, 1);
+    g_assert_cmpuint (ul_max_datagrams, ==, 16);
+    g_assert_cmpuint (ul_max_size, ==, 8192);
+    g_assert_cmpuint (dl_max_datagrams, ==, 32);
+    g_assert_cmpuint (dl_max_size, ==, 0);
+    g_free (message);
+}
+
 int main (int argc, char **argv)
 {
     g_test_init (&argc, &argv, NULL);
 
     g_test_add_func ("/librmf-common/message/get-manufacturer", test_get_manufacturer);
+    g_test_add_func ("/librmf-common/message/get-power-info", test_get_power_info);
+    g_test_add_func ("/librmf-common/message/get-daemon-metrics", test_get_daemon_metrics);
+    g_test_add_func ("/librmf-common/message/connect-session", test_connect_session);
+    g_test_add_func ("/librmf-common/message/disconnect-session", test_disconnect_session);
+    g_test_add_func ("/librmf-common/message/get-session-status", test_get_session_status);
+    g_test_add_func ("/librmf-common/message/get-session-stats", test_get_session_stats);
+    g_test_add_func ("/librmf-common/message/get-data-format", test_get_data_format);
 
     return g_test_run ();
 }
@@ -989,6 +989,17 @@ Modem::PowerCycle (void)
 
 vector<RadioPowerInfo>
 Modem::GetPowerInfo (void)
+{
+    std::vector<RadioInterface> radioInterfaces;
+
+    radioInterfaces.push_back (Gsm);
+    radioInterfaces.push_back (Umts);
+    radioInterfaces.push_back (Lte);
+    return GetPowerInfo (radioInterfaces);
+}
+
+vector<RadioPowerInfo>
+Modem::GetPowerInfo (const std::vector<RadioInterface> &radioInterfaces)
 {
     uint8_t *request;
     uint8_t *response;
@@ -1013,9 +1024,27 @@ Modem::GetPowerInfo (void)
     int32_t lte_rx0_power;
     uint32_t lte_rx1_radio_tuned;
     int32_t lte_rx1_power;
+    uint32_t radio_interfaces = 0;
     int ret;
 
-    request = rmf_message_get_power_info_request_new ();
+    for (std::vector<RadioInterface>::const_iterator it = radioInterfaces.begin (); it != radioInterfaces.end (); ++it) {
+        switch (*it) {
+        case Gsm:
+            radio_interfaces |= RMF_RADIO_INTERFACE_MASK (RMF_RADIO_INTERFACE_GSM);
+            break;
+        case Umts:
+            radio_interfaces |= RMF_RADIO_INTERFACE_MASK (RMF_RADIO_INTERFACE_UMTS);
+            break;
+        case Lte:
+            radio_interfaces |= RMF_RADIO_INTERFACE_MASK (RMF_RADIO_INTERFACE_LTE);
+            break;
+        }
+    }
+
+    if (!radio_interfaces)
+        throw std::invalid_argument ("no radio interface given");
+
+    request = rmf_message_get_power_info_request_new (radio_interfaces);
     ret = send_and_receive (request, 10, &response);
     free (request);
 
@@ -1108,6 +1137,7 @@ Modem::GetSignalInfo (void)
     uint32_t lte_available;
     int32_t lte_rssi;
     uint32_t lte_quality;
+    uint32_t age;
     int ret;
 
     request = rmf_message_get_signal_info_request_new ();
@@ -1128,7 +1158,8 @@ Modem::GetSignalInfo (void)
         &umts_quality,
         &lte_available,
         &lte_rssi,
-        &lte_quality);
+        &lte_quality,
+        &age);
     free (response);
 
     if (status != RMF_RESPONSE_STATUS_OK)
@@ -1139,6 +1170,7 @@ Modem::GetSignalInfo (void)
         info.radioInterface = Gsm;
         info.rssi = gsm_rssi;
         info.quality = gsm_quality;
+        info.age = age;
         info_vector.push_back (info);
     }
 
@@ -1147,6 +1179,7 @@ Modem::GetSignalInfo (void)
         info.radioInterface = Umts;
         info.rssi = umts_rssi;
         info.quality = umts_quality;
+        info.age = age;
         info_vector.push_back (info);
     }
 
@@ -1155,6 +1188,7 @@ Modem::GetSignalInfo (void)
         info.radioInterface = Lte;
         info.rssi = lte_rssi;
         info.quality = lte_quality;
+        info.age = age;
         info_vector.push_back (info);
     }
 
@@ -1367,6 +1401,171 @@ Modem::Disconnect (void)
 
 /*****************************************************************************/
 
+std::string
+Modem::ConnectSession (uint32_t     session,
+                       const string apn,
+                       const string user,
+                       const string password)
+{
+    uint8_t *request;
+    uint8_t *response;
+    const char *str;
+    uint32_t status;
+    int ret;
+    string result;
+
+    request = rmf_message_connect_session_request_new (session,
+                                                       apn.c_str(),
+                                                       user.c_str(),
+                                                       password.c_str());
+    ret = send_and_receive (request, 200, &response);
+    free (request);
+
+    if (ret != ERROR_NONE)
+        throw std::runtime_error (error_strings[ret]);
+
+    rmf_message_connect_session_response_parse (response, &status, &str);
+
+    if (status != RMF_RESPONSE_STATUS_OK) {
+        const char *error_str;
+        string extended_error_string = "";
+
+        rmf_message_error_response_parse (response, NULL, &error_str);
+        extended_error_string.append (error_str);
+        free (response);
+        throw_verbose_response_error (status, extended_error_string);
+    }
+
+    result = str;
+    free (response);
+
+    return result;
+}
+
+/*****************************************************************************/
+
+void
+Modem::DisconnectSession (uint32_t session)
+{
+    uint8_t *request;
+    uint8_t *response;
+    uint32_t status;
+    int ret;
+
+    request = rmf_message_disconnect_session_request_new (session);
+    ret = send_and_receive (request, 120, &response);
+    free (request);
+
+    if (ret != ERROR_NONE)
+        throw std::runtime_error (error_strings[ret]);
+
+    rmf_message_disconnect_session_response_parse (response, &status);
+    free (response);
+
+    if (status != RMF_RESPONSE_STATUS_OK)
+        throw_response_error (status);
+}
+
+/*****************************************************************************/
+
+ConnectionStatus
+Modem::GetSessionStatus (uint32_t  session,
+                         string   &interface)
+{
+    uint8_t *request;
+    uint8_t *response;
+    const char *str;
+    uint32_t status;
+    uint32_t connection_status;
+    int ret;
+
+    request = rmf_message_get_session_status_request_new (session);
+    ret = send_and_receive (request, 10, &response);
+    free (request);
+
+    if (ret != ERROR_NONE)
+        throw std::runtime_error (error_strings[ret]);
+
+    rmf_message_get_session_status_response_parse (
+        response,
+        &status,
+        &connection_status,
+        &str);
+
+    if (status != RMF_RESPONSE_STATUS_OK) {
+        free (response);
+        throw_response_error (status);
+    }
+
+    interface = str;
+    free (response);
+
+    return (ConnectionStatus) connection_status;
+}
+
+/*****************************************************************************/
+
+bool
+Modem::GetSessionStats (uint32_t  session,
+                        uint32_t &txPacketsOk,
+                        uint32_t &rxPacketsOk,
+                        uint32_t &txPacketsError,
+                        uint32_t &rxPacketsError,
+                        uint32_t &txPacketsOverflow,
+                        uint32_t &rxPacketsOverflow,
+                        uint64_t &txBytesOk,
+                        uint64_t &rxBytesOk)
+{
+    uint8_t *request;
+    uint8_t *response;
+    uint32_t status;
+    uint32_t tx_packets_ok;
+    uint32_t rx_packets_ok;
+    uint32_t tx_packets_error;
+    uint32_t rx_packets_error;
+    uint32_t tx_packets_overflow;
+    uint32_t rx_packets_overflow;
+    uint64_t tx_bytes_ok;
+    uint64_t rx_bytes_ok;
+    int ret;
+
+    request = rmf_message_get_session_stats_request_new (session);
+    ret = send_and_receive (request, 10, &response);
+    free (request);
+
+    if (ret != ERROR_NONE)
+        throw std::runtime_error (error_strings[ret]);
+
+    rmf_message_get_session_stats_response_parse (
+        response,
+        &status,
+        &tx_packets_ok,
+        &rx_packets_ok,
+        &tx_packets_error,
+        &rx_packets_error,
+        &tx_packets_overflow,
+        &rx_packets_overflow,
+        &tx_bytes_ok,
+        &rx_bytes_ok);
+    free (response);
+
+    if (status != RMF_RESPONSE_STATUS_OK)
+        throw_response_error (status);
+
+    txPacketsOk = tx_packets_ok;
+    rxPacketsOk = rx_packets_ok;
+    txPacketsError = tx_packets_error;
+    rxPacketsError = rx_packets_error;
+    txPacketsOverflow = tx_packets_overflow;
+    rxPacketsOverflow = rx_packets_overflow;
+    txBytesOk = tx_bytes_ok;
+    rxBytesOk = rx_bytes_ok;
+
+    return true;
+}
+
+/*****************************************************************************/
+
 std::string
 Modem::GetDataPort (void)
 {
@@ -1398,6 +1597,51 @@ Modem::GetDataPort (void)
 
 /*****************************************************************************/
 
+void
+Modem::GetDataFormat (bool     &rawIp,
+                      uint32_t &ulMaxDatagrams,
+                      uint32_t &ulMaxSize,
+                      uint32_t &dlMaxDatagrams,
+                      uint32_t &dlMaxSize)
+{
+    uint8_t *request;
+    uint8_t *response;
+    uint32_t status;
+    uint32_t raw_ip;
+    uint32_t ul_max_datagrams;
+    uint32_t ul_max_size;
+    uint32_t dl_max_datagrams;
+    uint32_t dl_max_size;
+    int ret;
+
+    request = rmf_message_get_data_format_request_new ();
+    ret = send_and_receive (request, 10, &response);
+    free (request);
+
+    if (ret != ERROR_NONE)
+        throw std::runtime_error (error_strings[ret]);
+
+    rmf_message_get_data_format_response_parse (response,
+                                                &status,
+                                                &raw_ip,
+                                                &ul_max_datagrams,
+                                                &ul_max_size,
+                                                &dl_max_datagrams,
+                                                &dl_max_size);
+    free (response);
+
+    if (status != RMF_RESPONSE_STATUS_OK)
+        throw_response_error (status);
+
+    rawIp          = (bool)raw_ip;
+    ulMaxDatagrams = ul_max_datagrams;
+    ulMaxSize      = ul_max_size;
+    dlMaxDatagrams = dl_max_datagrams;
+    dlMaxSize      = dl_max_size;
+}
+
+/*****************************************************************************/
+
 bool
 Modem::IsModemAvailable (void)
 {
@@ -1425,6 +1669,277 @@ Modem::IsModemAvailable (void)
 
 /*****************************************************************************/
 
+bool
+Modem::IsMessagingReady (void)
+{
+    uint8_t *request;
+    uint8_t *response;
+    uint32_t status;
+    uint8_t ready;
+    int ret;
+
+    request = rmf_message_is_messaging_ready_request_new ();
+    ret = send_and_receive (request, 10, &response);
+    free (request);
+
+    if (ret != ERROR_NONE)
+        throw std::runtime_error (error_strings[ret]);
+
+    rmf_message_is_messaging_ready_response_parse (response, &status, &ready);
+    free (response);
+
+    if (status != RMF_RESPONSE_STATUS_OK)
+        throw_response_error (status);
+
+    return (bool)ready;
+}
+
+/*****************************************************************************/
+
+/* Same response contents in Get Available Networks and Scan Networks */
+static uint32_t
+parse_available_networks (const uint8_t     *response,
+                          AvailableNetworks &available)
+{
+    uint32_t status;
+    uint32_t scan_ongoing;
+    uint32_t n_networks;
+    uint32_t i;
+
+    rmf_message_get_available_networks_response_parse (response,
+                                                       &status,
+                                                       &scan_ongoing,
+                                                       &available.scanTime,
+                                                       &n_networks);
+    if (status != RMF_RESPONSE_STATUS_OK)
+        return status;
+
+    available.scanOngoing = (bool)scan_ongoing;
+    for (i = 0; i < n_networks; i++) {
+        RmfNetworkInfo aux;
+        NetworkInfo network;
+
+        rmf_message_get_available_networks_response_parse_network (response, i, &aux);
+        network.mcc = aux.mcc;
+        network.mnc = aux.mnc;
+        network.radioInterface = (RadioInterface)aux.radio_interface;
+        network.status = (NetworkStatus)aux.status;
+        network.description = aux.description;
+        available.networks.push_back (network);
+    }
+
+    return status;
+}
+
+AvailableNetworks
+Modem::GetAvailableNetworks (void)
+{
+    uint8_t *request;
+    uint8_t *response;
+    uint32_t status;
+    AvailableNetworks available;
+    int ret;
+
+    request = rmf_message_get_available_networks_request_new ();
+    ret = send_and_receive (request, 10, &response);
+    free (request);
+
+    if (ret != ERROR_NONE)
+        throw std::runtime_error (error_strings[ret]);
+
+    status = parse_available_networks (response, available);
+    free (response);
+
+    if (status != RMF_RESPONSE_STATUS_OK)
+        throw_response_error (status);
+
+    return available;
+}
+
+AvailableNetworks
+Modem::ScanNetworks (void)
+{
+    uint8_t *request;
+    uint8_t *response;
+    uint32_t status;
+    AvailableNetworks available;
+    int ret;
+
+    request = rmf_message_scan_networks_request_new ();
+    ret = send_and_receive (request, 130, &response);
+    free (request);
+
+    if (ret != ERROR_NONE)
+        throw std::runtime_error (error_strings[ret]);
+
+    status = parse_available_networks (response, available);
+    free (response);
+
+    if (status != RMF_RESPONSE_STATUS_OK)
+        throw_response_error (status);
+
+    return available;
+}
+
+void
+Modem::CancelNetworkScan (void)
+{
+    uint8_t *request;
+    uint8_t *response;
+    uint32_t status;
+    int ret;
+
+    request = rmf_message_cancel_network_scan_request_new ();
+    ret = send_and_receive (request, 10, &response);
+    free (request);
+
+    if (ret != ERROR_NONE)
+        throw std::runtime_error (error_strings[ret]);
+
+    rmf_message_cancel_network_scan_response_parse (response, &status);
+    free (response);
+
+    if (status != RMF_RESPONSE_STATUS_OK)
+        throw_response_error (status);
+}
+
+/*****************************************************************************/
+
+AutoReconnectInfo
+Modem::GetAutoReconnect (void)
+{
+    uint8_t *request;
+    uint8_t *response;
+    uint32_t status;
+    uint32_t enabled;
+    uint32_t state;
+    AutoReconnectInfo info;
+    int ret;
+
+    request = rmf_message_get_auto_reconnect_request_new ();
+    ret = send_and_receive (request, 10, &response);
+    free (request);
+
+    if (ret != ERROR_NONE)
+        throw std::runtime_error (error_strings[ret]);
+
+    rmf_message_get_auto_reconnect_response_parse (response,
+                                                   &status,
+                                                   &enabled,
+                                                   &info.maxAttempts,
+                                                   &info.maxDelay,
+                                                   &state,
+                                                   &info.attempt,
+                                                   &info.drops,
+                                                   &info.reconnects,
+                                                   &info.failures,
+                                                   &info.lastRecoveryTime);
+    free (response);
+
+    if (status != RMF_RESPONSE_STATUS_OK)
+        throw_response_error (status);
+
+    info.enabled = (bool)enabled;
+    info.state = (AutoReconnectState)state;
+    return info;
+}
+
+/*****************************************************************************/
+
+void
+Modem::SetAutoReconnect (bool     enabled,
+                         uint32_t maxAttempts,
+                         uint32_t maxDelay)
+{
+    uint8_t *request;
+    uint8_t *response;
+    uint32_t status;
+    int ret;
+
+    request = rmf_message_set_auto_reconnect_request_new ((uint32_t)enabled, maxAttempts, maxDelay);
+    ret = send_and_receive (request, 10, &response);
+    free (request);
+
+    if (ret != ERROR_NONE)
+        throw std::runtime_error (error_strings[ret]);
+
+    rmf_message_set_auto_reconnect_response_parse (response, &status);
+    free (response);
+
+    if (status != RMF_RESPONSE_STATUS_OK)
+        throw_response_error (status);
+}
+
+/*****************************************************************************/
+
+DaemonMetrics
+Modem::GetDaemonMetrics (void)
+{
+    uint8_t *request;
+    uint8_t *response;
+    uint32_t status;
+    uint32_t n_commands;
+    uint32_t n_services;
+    uint32_t i;
+    DaemonMetrics metrics;
+    int ret;
+
+    request = rmf_message_get_daemon_metrics_request_new ();
+    ret = send_and_receive (request, 10, &response);
+    free (request);
+
+    if (ret != ERROR_NONE)
+        throw std::runtime_error (error_strings[ret]);
+
+    rmf_message_get_daemon_metrics_response_parse (response,
+                                                   &status,
+                                                   &metrics.queuedRequests,
+                                                   &metrics.clients,
+                                                   &metrics.mainLoopLag,
+                                                   &metrics.mainLoopLagMax,
+                                                   &n_commands,
+                                                   &n_services);
+    if (status != RMF_RESPONSE_STATUS_OK) {
+        free (response);
+        throw_response_error (status);
+    }
+
+    metrics.histogramLimits.assign (rmf_metrics_histogram_limits_ms,
+                                    rmf_metrics_histogram_limits_ms + RMF_METRICS_HISTOGRAM_N_BUCKETS - 1);
+
+    for (i = 0; i < n_commands; i++) {
+        RmfCommandMetrics aux;
+        CommandMetrics command;
+
+        rmf_message_get_daemon_metrics_response_parse_command (response, i, &aux);
+        command.command = rmf_message_command_get_string (aux.command);
+        command.count = aux.count;
+        command.errors = aux.errors;
+        command.queueWait.assign (aux.queue_wait, aux.queue_wait + RMF_METRICS_HISTOGRAM_N_BUCKETS);
+        command.processing.assign (aux.processing, aux.processing + RMF_METRICS_HISTOGRAM_N_BUCKETS);
+        command.total.assign (aux.total, aux.total + RMF_METRICS_HISTOGRAM_N_BUCKETS);
+        metrics.commands.push_back (command);
+    }
+
+    for (i = 0; i < n_services; i++) {
+        RmfQmiServiceMetrics aux;
+        QmiServiceMetrics service;
+
+        rmf_message_get_daemon_metrics_response_parse_service (response, i, &aux);
+        service.service = aux.service;
+        service.transactions = aux.transactions;
+        service.timeouts = aux.timeouts;
+        service.roundTrip.assign (aux.round_trip, aux.round_trip + RMF_METRICS_HISTOGRAM_N_BUCKETS);
+        metrics.services.push_back (service);
+    }
+
+    free (response);
+
+    return metrics;
+}
+
+/*****************************************************************************/
+
 uint32_t
 Modem::GetRegistrationTimeout (void)
 {
@@ -210,6 +210,17 @@ namespace Modem {
      */
     std::vector<RadioPowerInfo> GetPowerInfo (void);
 
+    /**
+     * GetPowerInfo:
+     * @radioInterfaces: the radio interfaces to query.
+     *
+     * Get the radio power information, only for the given radio access
+     * technologies.
+     *
+     * Returns: a vector of #RadioPowerInfo structs.
+     */
+    std::vector<RadioPowerInfo> GetPowerInfo (const std::vector<RadioInterface> &radioInterfaces);
+
     /**
      * GetSignalInfo:
      * @signalInfo: (out)
@@ -260,6 +271,35 @@ namespace Modem {
      */
     void SetRegistrationTimeout (uint32_t timeout);
 
+    /**
+     * GetAvailableNetworks:
+     *
+     * Get the results of the last network scan, either launched explicitly
+     * with ScanNetworks() or automatically after a registration timeout.
+     * This doesn't trigger a new scan.
+     *
+     * Returns: a #AvailableNetworks struct.
+     */
+    AvailableNetworks GetAvailableNetworks (void);
+
+    /**
+     * ScanNetworks:
+     *
+     * Scan the available networks, which may take up to 2 minutes. If a scan
+     * is already ongoing, its results are reported instead of launching a new
+     * one.
+     *
+     * Returns: a #AvailableNetworks struct.
+     */
+    AvailableNetworks ScanNetworks (void);
+
+    /**
+     * CancelNetworkScan:
+     *
+     * Cancel the ongoing network scan, if any.
+     */
+    void CancelNetworkScan (void);
+
     /**
      * GetConnectionStatus:
      *
@@ -314,6 +354,85 @@ namespace Modem {
      */
     void Disconnect (void);
 
+    /**
+     * ConnectSession:
+     * @session: (in) session number, starting at 1.
+     * @apn: (in) Access Point Name.
+     * @user: (in) username to use when authenticating in the access point, if needed.
+     * @password: (in) password to use when authenticating in the access point, if needed.
+     *
+     * Request connection of a multiplexed data session using IPv4. Each session
+     * is an independent PDN with its own network interface. Only available if
+     * the daemon runs with multiplexing enabled.
+     *
+     * Returns: the name of the network interface of the session.
+     */
+    std::string ConnectSession (uint32_t          session,
+                                const std::string apn,
+                                const std::string user,
+                                const std::string password);
+
+    /**
+     * DisconnectSession:
+     * @session: (in) session number, starting at 1.
+     *
+     * Request disconnection of a multiplexed data session.
+     */
+    void DisconnectSession (uint32_t session);
+
+    /**
+     * GetSessionStatus:
+     * @session: (in) session number, starting at 1.
+     * @interface: (out) name of the network interface, empty if not connected.
+     *
+     * Get the connection status of a multiplexed data session.
+     *
+     * Returns: the status of the session.
+     */
+    ConnectionStatus GetSessionStatus (uint32_t     session,
+                                       std::string &interface);
+
+    /**
+     * GetSessionStats:
+     * @session: (in) session number, starting at 1.
+     *
+     * Get the stats of a multiplexed data session; same output arguments as
+     * in GetConnectionStats().
+     *
+     * Returns: %true if the session stats are valid, %false otherwise.
+     */
+    bool GetSessionStats (uint32_t  session,
+                          uint32_t &txPacketsOk,
+                          uint32_t &rxPacketsOk,
+                          uint32_t &txPacketsError,
+                          uint32_t &rxPacketsError,
+                          uint32_t &txPacketsOverflow,
+                          uint32_t &rxPacketsOverflow,
+                          uint64_t &txBytesOk,
+                          uint64_t &rxBytesOk);
+
+    /**
+     * GetAutoReconnect:
+     *
+     * Get the automatic reconnection settings and statistics.
+     *
+     * Returns: a #AutoReconnectInfo struct.
+     */
+    AutoReconnectInfo GetAutoReconnect (void);
+
+    /**
+     * SetAutoReconnect:
+     * @enabled: (in) whether to reconnect automatically after a network-initiated
+     *           disconnection, reusing the settings of the last Connect().
+     * @maxAttempts: (in) maximum number of reconnection attempts, 0 if unlimited.
+     * @maxDelay: (in) maximum delay between reconnection attempts, in seconds.
+     *
+     * Configure the automatic reconnection.
+     */
+    void SetAutoReconnect (bool     enabled,
+                           uint32_t maxAttempts,
+                           uint32_t maxDelay);
+
     /**
      * GetDataPort:
      *
@@ -323,6 +442,23 @@ namespace Modem {
      */
     std::string GetDataPort (void);
 
+    /**
+     * GetDataFormat:
+     * @rawIp: (out) whether the data port runs in raw-ip mode, or 802.3 otherwise.
+     * @ulMaxDatagrams: (out) maximum datagrams aggregated per uplink transfer.
+     * @ulMaxSize: (out) maximum size of an uplink transfer, in bytes.
+     * @dlMaxDatagrams: (out) maximum datagrams aggregated per downlink transfer.
+     * @dlMaxSize: (out) maximum size of a downlink transfer, in bytes.
+     *
+     * Get the data format negotiated with the modem. Aggregation limits are 0
+     * if data aggregation isn't enabled or if the modem didn't report them.
+     */
+    void GetDataFormat (bool     &rawIp,
+                        uint32_t &ulMaxDatagrams,
+                        uint32_t &ulMaxSize,
+                        uint32_t &dlMaxDatagrams,
+                        uint32_t &dlMaxSize);
+
     /**
      * IsModemAvailable:
      *
@@ -330,6 +466,24 @@ namespace Modem {
      */
     bool IsModemAvailable (void);
 
+    /**
+     * IsMessagingReady:
+     *
+     * Gets whether SMS messaging support is initialized. Messaging setup runs
+     * in the background once the modem is available, so this may be false
+     * for a while after IsModemAvailable() reports true.
+     */
+    bool IsMessagingReady (void);
+
+    /**
+     * GetDaemonMetrics:
+     *
+     * Get the request processing metrics of the daemon.
+     *
+     * Returns: a #DaemonMetrics struct.
+     */
+    DaemonMetrics GetDaemonMetrics (void);
+
     /**
      * SetTargetRemote:
      *
@@ -27,6 +27,8 @@
 #define _RMF_TYPES_H_
 
 #include <stdint.h>
+#include <string>
+#include <vector>
 
 /**
  * Modem:
@@ -69,6 +71,21 @@ namespace Modem {
         Connected
     };
 
+    /**
+     * AutoReconnectState:
+     * @AutoReconnectIdle: No reconnection in progress.
+     * @AutoReconnectWaiting: Waiting before the next reconnection attempt.
+     * @AutoReconnectReconnecting: Reconnection attempt in progress.
+     *
+     * State of the automatic reconnection after a network-initiated
+     * disconnection.
+     */
+    enum AutoReconnectState {
+        AutoReconnectIdle,
+        AutoReconnectWaiting,
+        AutoReconnectReconnecting
+    };
+
     /**
      * PowerStatus:
      * @Full: Full power.
@@ -124,6 +141,7 @@ namespace Modem {
      * @radioInterface: Radio interface to which this value applies.
      * @rssi: RSSI, in dBm (-125 dBm or lower indicates no signal)
      * @quality: quality in percentage [0,100].
+     * @age: time since the modem last reported the signal info, in seconds.
      *
      * Radio signal information.
      */
@@ -131,6 +149,7 @@ namespace Modem {
         RadioInterface radioInterface;
         int32_t        rssi;
         uint32_t       quality;
+        uint32_t       age;
     };
 
     /**
@@ -150,6 +169,143 @@ namespace Modem {
         bool     umts;
         bool     lte;
     };
+
+    /**
+     * NetworkStatus:
+     * @NetworkStatusUnknown: Status of the network is unknown.
+     * @NetworkStatusAvailable: Network is available.
+     * @NetworkStatusCurrent: Network is the one currently serving.
+     * @NetworkStatusForbidden: Network is forbidden.
+     *
+     * Status of a network found in a scan.
+     */
+    enum NetworkStatus {
+        NetworkStatusUnknown,
+        NetworkStatusAvailable,
+        NetworkStatusCurrent,
+        NetworkStatusForbidden
+    };
+
+    /**
+     * NetworkInfo:
+     * @mcc: Mobile Country Code of the network.
+     * @mnc: Mobile Network Code of the network.
+     * @radioInterface: Radio interface in which the network was found.
+     * @status: Status of the network.
+     * @description: Description of the network, or empty string if unknown.
+     *
+     * Network found in a scan.
+     */
+    struct NetworkInfo {
+        uint16_t       mcc;
+        uint16_t       mnc;
+        RadioInterface radioInterface;
+        NetworkStatus  status;
+        std::string    description;
+    };
+
+    /**
+     * AvailableNetworks:
+     * @scanOngoing: Whether a network scan is ongoing.
+     * @scanTime: Time when the last scan finished, as unix timestamp, or 0 if
+     *            no scan has finished yet.
+     * @networks: Networks found in the last scan.
+     *
+     * Results of the last network scan.
+     */
+    struct AvailableNetworks {
+        bool                     scanOngoing;
+        uint32_t                 scanTime;
+        std::vector<NetworkInfo> networks;
+    };
+
+    /**
+     * AutoReconnectInfo:
+     * @enabled: Whether automatic reconnection is enabled.
+     * @maxAttempts: Maximum number of reconnection attempts, 0 if unlimited.
+     * @maxDelay: Maximum delay between reconnection attempts, in seconds.
+     * @state: Current state of the automatic reconnection.
+     * @attempt: Number of the ongoing reconnection attempt, 0 if none.
+     * @drops: Number of network-initiated disconnections.
+     * @reconnects: Number of successful automatic reconnections.
+     * @failures: Number of times all reconnection attempts were exhausted.
+     * @lastRecoveryTime: Time from the last disconnection to the successful
+     *                    reconnection, in ms.
+     *
+     * Automatic reconnection settings and statistics.
+     */
+    struct AutoReconnectInfo {
+        bool               enabled;
+        uint32_t           maxAttempts;
+        uint32_t           maxDelay;
+        AutoReconnectState state;
+        uint32_t           attempt;
+        uint32_t           drops;
+        uint32_t           reconnects;
+        uint32_t           failures;
+        uint32_t           lastRecoveryTime;
+    };
+
+    /**
+     * CommandMetrics:
+     * @command: Name of the command.
+     * @count: Number of times the command was processed.
+     * @errors: Number of times the command returned an error.
+     * @queueWait: histogram of the time spent waiting to be dispatched.
+     * @processing: histogram of the time spent processing the command,
+     *              including all QMI round trips.
+     * @total: histogram of the time from reception to response.
+     *
+     * Per-command metrics of the daemon. Each histogram has one bucket per
+     * limit in #DaemonMetrics:histogramLimits, plus one last bucket for all
+     * values above the last limit.
+     */
+    struct CommandMetrics {
+        std::string           command;
+        uint32_t              count;
+        uint32_t              errors;
+        std::vector<uint32_t> queueWait;
+        std::vector<uint32_t> processing;
+        std::vector<uint32_t> total;
+    };
+
+    /**
+     * QmiServiceMetrics:
+     * @service: Name of the QMI service.
+     * @transactions: Number of transactions run.
+     * @timeouts: Number of transactions which timed out.
+     * @roundTrip: histogram of the transaction round trip times.
+     *
+     * Per-QMI service metrics of the daemon.
+     */
+    struct QmiServiceMetrics {
+        std::string           service;
+        uint32_t              transactions;
+        uint32_t              timeouts;
+        std::vector<uint32_t> roundTrip;
+    };
+
+    /**
+     * DaemonMetrics:
+     * @queuedRequests: Number of requests waiting to be dispatched.
+     * @clients: Number of connected clients.
+     * @mainLoopLag: Last measured main loop iteration lag, in ms.
+     * @mainLoopLagMax: Maximum measured main loop iteration lag, in ms.
+     * @histogramLimits: Upper limits of the histogram buckets, in ms.
+     * @commands: Per-command metrics.
+     * @services: Per-QMI service metrics.
+     *
+     * Metrics of the daemon.
+     */
+    struct DaemonMetrics {
+        uint32_t                       queuedRequests;
+        uint32_t                       clients;
+        uint32_t                       mainLoopLag;
+        uint32_t                       mainLoopLagMax;
+        std::vector<uint32_t>          histogramLimits;
+        std::vector<CommandMetrics>    commands;
+        std::vector<QmiServiceMetrics> services;
+    };
 }
 
 #endif /* _RMF_TYPES_H_ */
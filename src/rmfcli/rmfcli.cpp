@@ -67,17 +67,26 @@ printHelp (void)
     std::cout << "\t-p, --get-power-status" << std::endl;
     std::cout << "\t-P, --set-power-status=\"[Full|Low]\"" << std::endl;
     std::cout << "\t-Z, --power-cycle" << std::endl;
-    std::cout << "\t-a, --get-power-info" << std::endl;
+    std::cout << "\t-a, --get-power-info[=\"[Gsm|Umts|Lte],...\"]" << std::endl;
     std::cout << "\t-s, --get-signal-info" << std::endl;
     std::cout << "\t-r, --get-registration-status" << std::endl;
     std::cout << "\t-t, --get-registration-timeout" << std::endl;
     std::cout << "\t-T, --set-registration-timeout=\"timeout\"" << std::endl;
+    std::cout << "\t-n, --get-available-networks" << std::endl;
+    std::cout << "\t-N, --scan-networks" << std::endl;
+    std::cout << "\t-X, --cancel-network-scan" << std::endl;
     std::cout << "\t-c, --get-connection-status" << std::endl;
     std::cout << "\t-x, --get-connection-stats" << std::endl;
     std::cout << "\t-C, --connect=\"apn user password\"" << std::endl;
     std::cout << "\t-D, --disconnect" << std::endl;
+    std::cout << "\t-S, --session=\"session\" (with -c, -x, -C or -D)" << std::endl;
+    std::cout << "\t-w, --get-auto-reconnect" << std::endl;
+    std::cout << "\t-W, --set-auto-reconnect=\"[On|Off] [max-attempts] [max-delay]\"" << std::endl;
     std::cout << "\t-b, --get-data-port" << std::endl;
+    std::cout << "\t-B, --get-data-format" << std::endl;
     std::cout << "\t-A, --is-available" << std::endl;
+    std::cout << "\t-m, --is-messaging-ready" << std::endl;
+    std::cout << "\t-M, --metrics" << std::endl;
     std::cout << std::endl;
     std::cout << "Common actions:" << std::endl;
     std::cout << "\t-h, --help" << std::endl;
@@ -442,12 +451,34 @@ powerCycle (void)
 }
 
 static int
-getPowerInfo (void)
+getPowerInfo (const char *interfaces)
 {
     std::vector<Modem::RadioPowerInfo> infoVector;
+    std::vector<Modem::RadioInterface> radioInterfaces;
+
+    if (interfaces) {
+        std::stringstream ss (interfaces);
+        std::string str;
+
+        while (std::getline (ss, str, ',')) {
+            if (str.compare ("Gsm") == 0 || str.compare ("gsm") == 0)
+                radioInterfaces.push_back (Modem::Gsm);
+            else if (str.compare ("Umts") == 0 || str.compare ("umts") == 0)
+                radioInterfaces.push_back (Modem::Umts);
+            else if (str.compare ("Lte") == 0 || str.compare ("lte") == 0)
+                radioInterfaces.push_back (Modem::Lte);
+            else {
+                std::cout << "Unknown radio interface given: " << str << std::endl;
+                return -1;
+            }
+        }
+    }
 
     try {
-        infoVector = Modem::GetPowerInfo ();
+        if (radioInterfaces.empty ())
+            infoVector = Modem::GetPowerInfo ();
+        else
+            infoVector = Modem::GetPowerInfo (radioInterfaces);
     } catch (std::exception const& e) {
         std::cout << "Exception: " << e.what() << std::endl;
         return -1;
@@ -523,6 +554,7 @@ getSignalInfo (void)
 
         std::cout << "\tRSSI: " << it->rssi << " dBm" << std::endl;
         std::cout << "\tQuality: " << it->quality << "%" << std::endl;
+        std::cout << "\tAge: " << it->age << " s" << std::endl;
     }
 
     return 0;
@@ -619,13 +651,116 @@ setRegistrationTimeout (const std::string str)
     return 0;
 }
 
+static void
+printAvailableNetworks (const Modem::AvailableNetworks &available)
+{
+    if (available.scanOngoing)
+        std::cout << "Network scan ongoing" << std::endl;
+
+    if (!available.scanTime) {
+        std::cout << "No network scan results available" << std::endl;
+        return;
+    }
+
+    std::cout << "Scan time: " << available.scanTime << std::endl;
+    if (available.networks.size () == 0) {
+        std::cout << "No networks found" << std::endl;
+        return;
+    }
+
+    for (std::vector<Modem::NetworkInfo>::const_iterator it = available.networks.begin (); it != available.networks.end (); ++it) {
+        std::cout << it->mcc << "-" << it->mnc << ":" << std::endl;
+        std::cout << "\tOperator: " << it->description << std::endl;
+
+        switch (it->radioInterface) {
+        case Modem::Gsm:
+            std::cout << "\tRadio interface: GSM" << std::endl;
+            break;
+        case Modem::Umts:
+            std::cout << "\tRadio interface: UMTS" << std::endl;
+            break;
+        case Modem::Lte:
+            std::cout << "\tRadio interface: LTE" << std::endl;
+            break;
+        default:
+            std::cout << "\tRadio interface: Unknown" << std::endl;
+            break;
+        }
+
+        switch (it->status) {
+        case Modem::NetworkStatusAvailable:
+            std::cout << "\tStatus: Available" << std::endl;
+            break;
+        case Modem::NetworkStatusCurrent:
+            std::cout << "\tStatus: Current" << std::endl;
+            break;
+        case Modem::NetworkStatusForbidden:
+            std::cout << "\tStatus: Forbidden" << std::endl;
+            break;
+        default:
+            std::cout << "\tStatus: Unknown" << std::endl;
+            break;
+        }
+    }
+}
+
+static int
+getAvailableNetworks (void)
+{
+    Modem::AvailableNetworks available;
+
+    try {
+        available = Modem::GetAvailableNetworks ();
+    } catch (std::exception const& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return -1;
+    }
+
+    printAvailableNetworks (available);
+    return 0;
+}
+
+static int
+scanNetworks (void)
+{
+    Modem::AvailableNetworks available;
+
+    try {
+        available = Modem::ScanNetworks ();
+    } catch (std::exception const& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return -1;
+    }
+
+    printAvailableNetworks (available);
+    return 0;
+}
+
+static int
+cancelNetworkScan (void)
+{
+    try {
+        Modem::CancelNetworkScan ();
+    } catch (std::exception const& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return -1;
+    }
+
+    std::cout << "Network scan cancelled" << std::endl;
+    return 0;
+}
+
 static int
-getConnectionStatus (void)
+getConnectionStatus (unsigned int session)
 {
     Modem::ConnectionStatus connectionStatus;
+    std::string interface;
 
     try {
-        connectionStatus = Modem::GetConnectionStatus ();
+        if (session)
+            connectionStatus = Modem::GetSessionStatus (session, interface);
+        else
+            connectionStatus = Modem::GetConnectionStatus ();
     } catch (std::exception const& e) {
         std::cout << "Exception: " << e.what() << std::endl;
         return -1;
@@ -649,11 +784,14 @@ getConnectionStatus (void)
         break;
     }
 
+    if (!interface.empty ())
+        std::cout << "Interface: " << interface << std::endl;
+
     return 0;
 }
 
 static int
-getConnectionStats (void)
+getConnectionStats (unsigned int session)
 {
     uint32_t txPacketsOk;
     uint32_t rxPacketsOk;
@@ -665,14 +803,25 @@ getConnectionStats (void)
     uint64_t rxBytesOk;
 
     try {
-        Modem::GetConnectionStats (txPacketsOk,
-                                   rxPacketsOk,
-                                   txPacketsError,
-                                   rxPacketsError,
-                                   txPacketsOverflow,
-                                   rxPacketsOverflow,
-                                   txBytesOk,
-                                   rxBytesOk);
+        if (session)
+            Modem::GetSessionStats (session,
+                                    txPacketsOk,
+                                    rxPacketsOk,
+                                    txPacketsError,
+                                    rxPacketsError,
+                                    txPacketsOverflow,
+                                    rxPacketsOverflow,
+                                    txBytesOk,
+                                    rxBytesOk);
+        else
+            Modem::GetConnectionStats (txPacketsOk,
+                                       rxPacketsOk,
+                                       txPacketsError,
+                                       rxPacketsError,
+                                       txPacketsOverflow,
+                                       rxPacketsOverflow,
+                                       txBytesOk,
+                                       rxBytesOk);
     } catch (std::exception const& e) {
         std::cout << "Exception: " << e.what() << std::endl;
         return -1;
@@ -698,7 +847,8 @@ getConnectionStats (void)
 }
 
 static int
-connect (const std::string str)
+connect (const std::string str,
+         unsigned int      session)
 {
     std::istringstream iss (str);
     std::string apn;
@@ -723,6 +873,13 @@ connect (const std::string str)
     }
 
     try {
+        if (session) {
+            std::string interface;
+
+            interface = Modem::ConnectSession (session, apn, user, password);
+            std::cout << "Session " << session << " successfully connected at " << interface << std::endl;
+            return 0;
+        }
         Modem::Connect (apn, user, password);
     } catch (std::exception const& e) {
         std::cout << "Exception: " << e.what() << std::endl;
@@ -734,9 +891,14 @@ connect (const std::string str)
 }
 
 static int
-disconnect (void)
+disconnect (unsigned int session)
 {
     try {
+        if (session) {
+            Modem::DisconnectSession (session);
+            std::cout << "Session " << session << " successfully disconnected" << std::endl;
+            return 0;
+        }
         Modem::Disconnect ();
     } catch (std::exception const& e) {
         std::cout << "Exception: " << e.what() << std::endl;
@@ -747,6 +909,102 @@ disconnect (void)
     return 0;
 }
 
+static int
+getAutoReconnect (void)
+{
+    Modem::AutoReconnectInfo info;
+
+    try {
+        info = Modem::GetAutoReconnect ();
+    } catch (std::exception const& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return -1;
+    }
+
+    std::cout << "Auto reconnect: " << (info.enabled ? "On" : "Off") << std::endl;
+    std::cout << "Max attempts: ";
+    if (info.maxAttempts)
+        std::cout << info.maxAttempts << std::endl;
+    else
+        std::cout << "unlimited" << std::endl;
+    std::cout << "Max delay: " << info.maxDelay << " s" << std::endl;
+
+    switch (info.state) {
+    case Modem::AutoReconnectIdle:
+        std::cout << "State: Idle" << std::endl;
+        break;
+    case Modem::AutoReconnectWaiting:
+        std::cout << "State: Waiting (attempt " << info.attempt << ")" << std::endl;
+        break;
+    case Modem::AutoReconnectReconnecting:
+        std::cout << "State: Reconnecting (attempt " << info.attempt << ")" << std::endl;
+        break;
+    default:
+        std::cout << "State: Unknown" << std::endl;
+        break;
+    }
+
+    std::cout << "Network drops: " << info.drops << std::endl;
+    std::cout << "Reconnections: " << info.reconnects << std::endl;
+    std::cout << "Failures: " << info.failures << std::endl;
+    if (info.reconnects)
+        std::cout << "Last recovery time: " << info.lastRecoveryTime << " ms" << std::endl;
+    return 0;
+}
+
+static int
+setAutoReconnect (const std::string str)
+{
+    std::istringstream iss (str);
+    std::string enabledStr;
+    std::string rest;
+    bool enabled;
+    int32_t maxAttempts = 0;
+    int32_t maxDelay = 60;
+
+    iss >> enabledStr;
+    if (enabledStr.compare ("On") == 0 || enabledStr.compare ("on") == 0)
+        enabled = true;
+    else if (enabledStr.compare ("Off") == 0 || enabledStr.compare ("off") == 0)
+        enabled = false;
+    else {
+        std::cout << "Unknown auto reconnect setting given: " << enabledStr << std::endl;
+        return -1;
+    }
+
+    if (iss >> maxAttempts) {
+        if (!(iss >> maxDelay) && !iss.eof ()) {
+            std::cout << "Invalid max delay given" << std::endl;
+            return -1;
+        }
+    } else if (!iss.eof ()) {
+        std::cout << "Invalid max attempts given" << std::endl;
+        return -1;
+    }
+
+    iss.clear ();
+    iss >> rest;
+    if (rest != "") {
+        std::cout << "Too many arguments given" << std::endl;
+        return -1;
+    }
+
+    if (maxAttempts < 0 || maxDelay <= 0) {
+        std::cout << "Invalid auto reconnect limits given" << std::endl;
+        return -1;
+    }
+
+    try {
+        Modem::SetAutoReconnect (enabled, (uint32_t)maxAttempts, (uint32_t)maxDelay);
+    } catch (std::exception const& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return -1;
+    }
+
+    std::cout << "Auto reconnect correctly updated" << std::endl;
+    return 0;
+}
+
 static int
 getDataPort (void)
 {
@@ -763,6 +1021,33 @@ getDataPort (void)
     return 0;
 }
 
+static int
+getDataFormat (void)
+{
+    bool rawIp;
+    uint32_t ulMaxDatagrams;
+    uint32_t ulMaxSize;
+    uint32_t dlMaxDatagrams;
+    uint32_t dlMaxSize;
+
+    try {
+        Modem::GetDataFormat (rawIp, ulMaxDatagrams, ulMaxSize, dlMaxDatagrams, dlMaxSize);
+    } catch (std::exception const& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return -1;
+    }
+
+    std::cout << "Link layer protocol:  " << (rawIp ? "raw-ip" : "802.3") << std::endl;
+    if (!dlMaxDatagrams && !ulMaxDatagrams) {
+        std::cout << "Data aggregation:     disabled" << std::endl;
+        return 0;
+    }
+
+    std::cout << "Uplink aggregation:   " << ulMaxDatagrams << " datagrams, " << ulMaxSize << " bytes" << std::endl;
+    std::cout << "Downlink aggregation: " << dlMaxDatagrams << " datagrams, " << dlMaxSize << " bytes" << std::endl;
+    return 0;
+}
+
 static int
 isAvailable (void)
 {
@@ -783,6 +1068,74 @@ isAvailable (void)
     return 0;
 }
 
+static int
+isMessagingReady (void)
+{
+    bool ready;
+
+    try {
+        ready = Modem::IsMessagingReady ();
+    } catch (std::exception const& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return -1;
+    }
+
+    if (!ready)
+        std::cout << "Messaging is not ready" << std::endl;
+    else
+        std::cout << "Messaging is ready" << std::endl;
+
+    return 0;
+}
+
+static void
+printHistogram (const char                  *name,
+                const std::vector<uint32_t> &limits,
+                const std::vector<uint32_t> &histogram)
+{
+    std::cout << "\t\t" << name << ":";
+    for (unsigned int i = 0; i < histogram.size (); i++) {
+        if (i < limits.size ())
+            std::cout << " <=" << limits[i] << "ms: " << histogram[i];
+        else
+            std::cout << " >" << limits.back () << "ms: " << histogram[i];
+    }
+    std::cout << std::endl;
+}
+
+static int
+getMetrics (void)
+{
+    Modem::DaemonMetrics metrics;
+
+    try {
+        metrics = Modem::GetDaemonMetrics ();
+    } catch (std::exception const& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return -1;
+    }
+
+    std::cout << "Queued requests: " << metrics.queuedRequests << std::endl;
+    std::cout << "Clients: " << metrics.clients << std::endl;
+    std::cout << "Main loop lag: " << metrics.mainLoopLag << " ms (max " << metrics.mainLoopLagMax << " ms)" << std::endl;
+
+    std::cout << "Commands:" << std::endl;
+    for (std::vector<Modem::CommandMetrics>::iterator it = metrics.commands.begin (); it != metrics.commands.end (); ++it) {
+        std::cout << "\t" << it->command << ": " << it->count << " requests, " << it->errors << " errors" << std::endl;
+        printHistogram ("Queue wait", metrics.histogramLimits, it->queueWait);
+        printHistogram ("Processing", metrics.histogramLimits, it->processing);
+        printHistogram ("Total", metrics.histogramLimits, it->total);
+    }
+
+    std::cout << "QMI services:" << std::endl;
+    for (std::vector<Modem::QmiServiceMetrics>::iterator it = metrics.services.begin (); it != metrics.services.end (); ++it) {
+        std::cout << "\t" << it->service << ": " << it->transactions << " transactions, " << it->timeouts << " timeouts" << std::endl;
+        printHistogram ("Round trip", metrics.histogramLimits, it->roundTrip);
+    }
+
+    return 0;
+}
+
 //-----------------------------------------------------------------------------
 
 static const struct option longopts[] = {
@@ -808,17 +1161,26 @@ static const struct option longopts[] = {
     { "get-power-status",         no_argument,       0, 'p' },
     { "set-power-status",         required_argument, 0, 'P' },
     { "power-cycle",              no_argument,       0, 'Z' },
-    { "get-power-info",           no_argument,       0, 'a' },
+    { "get-power-info",           optional_argument, 0, 'a' },
     { "get-signal-info",          no_argument,       0, 's' },
     { "get-registration-status",  no_argument,       0, 'r' },
     { "get-registration-timeout", no_argument,       0, 't' },
     { "set-registration-timeout", required_argument, 0, 'T' },
+    { "get-available-networks",   no_argument,       0, 'n' },
+    { "scan-networks",            no_argument,       0, 'N' },
+    { "cancel-network-scan",      no_argument,       0, 'X' },
     { "get-connection-status",    no_argument,       0, 'c' },
     { "get-connection-stats",     no_argument,       0, 'x' },
     { "connect",                  required_argument, 0, 'C' },
     { "disconnect",               no_argument,       0, 'D' },
+    { "session",                  required_argument, 0, 'S' },
+    { "get-auto-reconnect",       no_argument,       0, 'w' },
+    { "set-auto-reconnect",       required_argument, 0, 'W' },
     { "get-data-port",            no_argument,       0, 'b' },
+    { "get-data-format",          no_argument,       0, 'B' },
     { "is-available",             no_argument,       0, 'A' },
+    { "is-messaging-ready",       no_argument,       0, 'm' },
+    { "metrics",                  no_argument,       0, 'M' },
     { 0,                          0,                 0, 0   },
 };
 
@@ -867,6 +1229,8 @@ main (int argc, char **argv)
     int iarg = 0;
     char *option_target_address = NULL;
     char *option_target_port = NULL;
+    char *option_session = NULL;
+    unsigned int session = 0;
     unsigned int action_get_manufacturer = 0;
     unsigned int action_get_model = 0;
     unsigned int action_get_software_revision = 0;
@@ -886,16 +1250,25 @@ main (int argc, char **argv)
     char *action_set_power_status = NULL;
     unsigned int action_power_cycle = 0;
     unsigned int action_get_power_info = 0;
+    char *option_power_info_interfaces = NULL;
     unsigned int action_get_signal_info = 0;
     unsigned int action_get_registration_status = 0;
     unsigned int action_get_registration_timeout = 0;
     char *action_set_registration_timeout = NULL;
+    unsigned int action_get_available_networks = 0;
+    unsigned int action_scan_networks = 0;
+    unsigned int action_cancel_network_scan = 0;
     unsigned int action_get_connection_status = 0;
     unsigned int action_get_connection_stats = 0;
     char *action_connect = NULL;
     unsigned int action_disconnect = 0;
+    unsigned int action_get_auto_reconnect = 0;
+    char *action_set_auto_reconnect = NULL;
     unsigned int action_get_data_port = 0;
+    unsigned int action_get_data_format = 0;
     unsigned int action_is_available = 0;
+    unsigned int action_is_messaging_ready = 0;
+    unsigned int action_metrics = 0;
     unsigned int n_actions;
     int result;
 
@@ -903,7 +1276,7 @@ main (int argc, char **argv)
     opterr = 1;
 
     while (iarg != -1) {
-        iarg = getopt_long (argc, argv, "vhy:Y:fdjkeiqQ:ozLU:E:G:F:C:pP:ZasrtT:cxC:DbA", longopts, &i);
+        iarg = getopt_long (argc, argv, "vhy:Y:fdjkeiqQ:ozLU:E:G:F:C:pP:Za::srtT:nNXcxC:DS:wW:bBAmM", longopts, &i);
 
         switch (iarg) {
         case 'h':
@@ -974,6 +1347,8 @@ main (int argc, char **argv)
             break;
         case 'a':
             enable_arg_int (action_get_power_info, iarg);
+            if (optarg)
+                option_power_info_interfaces = strdup (optarg);
             break;
         case 's':
             enable_arg_int (action_get_signal_info, iarg);
@@ -987,6 +1362,15 @@ main (int argc, char **argv)
         case 'T':
             enable_arg_str (action_set_registration_timeout, optarg, iarg);
             break;
+        case 'n':
+            enable_arg_int (action_get_available_networks, iarg);
+            break;
+        case 'N':
+            enable_arg_int (action_scan_networks, iarg);
+            break;
+        case 'X':
+            enable_arg_int (action_cancel_network_scan, iarg);
+            break;
         case 'c':
             enable_arg_int (action_get_connection_status, iarg);
             break;
@@ -999,12 +1383,30 @@ main (int argc, char **argv)
         case 'D':
             enable_arg_int (action_disconnect, iarg);
             break;
+        case 'S':
+            enable_arg_str (option_session, optarg, iarg);
+            break;
+        case 'w':
+            enable_arg_int (action_get_auto_reconnect, iarg);
+            break;
+        case 'W':
+            enable_arg_str (action_set_auto_reconnect, optarg, iarg);
+            break;
         case 'b':
             enable_arg_int (action_get_data_port, iarg);
             break;
+        case 'B':
+            enable_arg_int (action_get_data_format, iarg);
+            break;
         case 'A':
             enable_arg_int (action_is_available, iarg);
             break;
+        case 'm':
+            enable_arg_int (action_is_messaging_ready, iarg);
+            break;
+        case 'M':
+            enable_arg_int (action_metrics, iarg);
+            break;
         }
     }
 
@@ -1041,12 +1443,20 @@ main (int argc, char **argv)
         action_get_registration_status +
         action_get_registration_timeout +
         !!action_set_registration_timeout +
+        action_get_available_networks +
+        action_scan_networks +
+        action_cancel_network_scan +
         action_get_connection_status +
         action_get_connection_stats +
         !!action_connect +
         action_disconnect +
+        action_get_auto_reconnect +
+        !!action_set_auto_reconnect +
         action_get_data_port +
-        action_is_available);
+        action_get_data_format +
+        action_is_available +
+        action_is_messaging_ready +
+        action_metrics);
 
     if (n_actions == 0) {
         std::cerr << "error: no actions specified" << std::endl;
@@ -1058,6 +1468,18 @@ main (int argc, char **argv)
         return -1;
     }
 
+    if (option_session) {
+        if (!action_get_connection_status && !action_get_connection_stats && !action_connect && !action_disconnect) {
+            std::cerr << "error: session only applies to connection actions" << std::endl;
+            return -1;
+        }
+        session = atoi (option_session);
+        if (session == 0) {
+            std::cerr << "error: invalid session: " << option_session << std::endl;
+            return -1;
+        }
+    }
+
     if (action_get_manufacturer)
         result = getManufacturer ();
     else if (action_get_model)
@@ -1095,7 +1517,7 @@ main (int argc, char **argv)
     else if (action_power_cycle)
         result = powerCycle ();
     else if (action_get_power_info)
-        result = getPowerInfo ();
+        result = getPowerInfo (option_power_info_interfaces);
     else if (action_get_signal_info)
         result = getSignalInfo ();
     else if (action_get_registration_status)
@@ -1104,18 +1526,34 @@ main (int argc, char **argv)
         result = getRegistrationTimeout ();
     else if (action_set_registration_timeout)
         result = setRegistrationTimeout (action_set_registration_timeout);
+    else if (action_get_available_networks)
+        result = getAvailableNetworks ();
+    else if (action_scan_networks)
+        result = scanNetworks ();
+    else if (action_cancel_network_scan)
+        result = cancelNetworkScan ();
     else if (action_get_connection_status)
-        result = getConnectionStatus ();
+        result = getConnectionStatus (session);
     else if (action_get_connection_stats)
-        result = getConnectionStats ();
+        result = getConnectionStats (session);
     else if (action_connect)
-        result = connect (action_connect);
+        result = connect (action_connect, session);
     else if (action_disconnect)
-        result = disconnect ();
+        result = disconnect (session);
+    else if (action_get_auto_reconnect)
+        result = getAutoReconnect ();
+    else if (action_set_auto_reconnect)
+        result = setAutoReconnect (action_set_auto_reconnect);
     else if (action_get_data_port)
         result = getDataPort ();
+    else if (action_get_data_format)
+        result = getDataFormat ();
     else if (action_is_available)
         result = isAvailable ();
+    else if (action_is_messaging_ready)
+        result = isMessagingReady ();
+    else if (action_metrics)
+        result = getMetrics ();
     else
         assert (0);
 
@@ -1126,7 +1564,10 @@ main (int argc, char **argv)
     free (action_disable_pin);
     free (action_change_pin);
     free (action_set_power_status);
+    free (option_power_info_interfaces);
     free (action_set_registration_timeout);
     free (action_connect);
+    free (option_session);
+    free (action_set_auto_reconnect);
     return 0;
 }
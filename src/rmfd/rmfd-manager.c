@@ -39,6 +39,9 @@
 #include "rmfd-error.h"
 #include "rmfd-error-types.h"
 #include "rmfd-utils.h"
+#include "rmfd-probe-cache.h"
+#include "rmfd-metrics.h"
+#include "rmfd-tracing.h"
 
 G_DEFINE_TYPE (RmfdManager, rmfd_manager, G_TYPE_OBJECT)
 
@@ -67,6 +70,9 @@ struct _RmfdManagerPrivate {
     gchar *ip_address;
     guint16 tcp_port;
 
+    /* Settings for the processor */
+    RmfdPortProcessorQmiSettings processor_settings;
+
     /* Unix socket service */
     GSocketService *socket_service;
     GByteArray *socket_buffer;
@@ -74,6 +80,7 @@ struct _RmfdManagerPrivate {
     /* Pending requests to process */
     GList *requests;
     guint requests_idle_id;
+    guint next_request_id;
 };
 
 /*****************************************************************************/
@@ -148,9 +155,149 @@ untrack_port (GList **list,
     *list = g_list_delete_link (*list, l);
 }
 
+/*****************************************************************************/
+/* Probe cache */
+
+static gboolean
+get_probe_cache_key (GUdevDevice  *physdev,
+                     const gchar **sysfs_path,
+                     guint16      *vid,
+                     guint16      *pid,
+                     guint        *devnum)
+{
+    const gchar *vid_str;
+    const gchar *pid_str;
+
+    vid_str = g_udev_device_get_sysfs_attr (physdev, "idVendor");
+    pid_str = g_udev_device_get_sysfs_attr (physdev, "idProduct");
+    if (!vid_str || !pid_str)
+        return FALSE;
+
+    *sysfs_path = g_udev_device_get_sysfs_path (physdev);
+    *vid = (guint16) g_ascii_strtoull (vid_str, NULL, 16);
+    *pid = (guint16) g_ascii_strtoull (pid_str, NULL, 16);
+    *devnum = (guint) g_udev_device_get_sysfs_attr_as_int (physdev, "devnum");
+    return TRUE;
+}
+
+static RmfdProbeCacheEntry *
+lookup_probe_cache (GUdevDevice *physdev)
+{
+    const gchar *sysfs_path;
+    guint16      vid;
+    guint16      pid;
+    guint        devnum;
+
+    if (!get_probe_cache_key (physdev, &sysfs_path, &vid, &pid, &devnum))
+        return NULL;
+    return rmfd_probe_cache_lookup (sysfs_path, vid, pid, devnum);
+}
+
+/* Returns the cached entry only if the given port was the control port */
+static RmfdProbeCacheEntry *
+lookup_probe_cache_for_control_port (GUdevDevice *physdev,
+                                     GUdevDevice *device)
+{
+    RmfdProbeCacheEntry *entry;
+
+    entry = lookup_probe_cache (physdev);
+    if (entry && !g_str_equal (entry->control_port, g_udev_device_get_name (device)))
+        g_clear_pointer (&entry, (GDestroyNotify) rmfd_probe_cache_entry_free);
+    return entry;
+}
+
+static void
+store_probe_cache (RmfdManager *self,
+                   GUdevDevice *control,
+                   GUdevDevice *data)
+{
+    RmfdProbeCacheEntry *entry;
+    const gchar         *sysfs_path;
+    guint16              vid;
+    guint16              pid;
+    guint                devnum;
+
+    if (!get_probe_cache_key (self->priv->parent, &sysfs_path, &vid, &pid, &devnum))
+        return;
+
+    entry = rmfd_probe_cache_entry_new ();
+    entry->control_port  = g_strdup (g_udev_device_get_name (control));
+    entry->data_port     = g_strdup (g_udev_device_get_name (data));
+    entry->llp_is_raw_ip = rmfd_port_processor_qmi_get_llp_is_raw_ip (RMFD_PORT_PROCESSOR_QMI (self->priv->processor));
+    entry->llp_on_open   = rmfd_port_processor_qmi_get_llp_on_open (RMFD_PORT_PROCESSOR_QMI (self->priv->processor));
+    entry->qmap          = rmfd_port_processor_qmi_get_qmap (RMFD_PORT_PROCESSOR_QMI (self->priv->processor));
+    g_array_unref (entry->service_versions);
+    entry->service_versions = rmfd_port_processor_qmi_get_service_versions (RMFD_PORT_PROCESSOR_QMI (self->priv->processor));
+    rmfd_probe_cache_store (sysfs_path, vid, pid, devnum, entry);
+    rmfd_probe_cache_entry_free (entry);
+}
+
+static void
+invalidate_probe_cache (RmfdManager *self)
+{
+    const gchar *sysfs_path;
+    guint16      vid;
+    guint16      pid;
+    guint        devnum;
+
+    if (get_probe_cache_key (self->priv->parent, &sysfs_path, &vid, &pid, &devnum))
+        rmfd_probe_cache_invalidate (sysfs_path);
+}
+
+static gboolean
+is_cached_control_port (GUdevDevice *device)
+{
+    GUdevDevice         *physdev;
+    RmfdProbeCacheEntry *entry = NULL;
+
+    if (rmfd_utils_get_modem_type (device) != RMFD_MODEM_TYPE_QMI ||
+        !g_str_has_prefix (g_udev_device_get_subsystem (device), "usb"))
+        return FALSE;
+
+    physdev = rmfd_utils_get_physical_device (device);
+    if (physdev) {
+        entry = lookup_probe_cache_for_control_port (physdev, device);
+        g_object_unref (physdev);
+    }
+
+    if (!entry)
+        return FALSE;
+
+    rmfd_probe_cache_entry_free (entry);
+    return TRUE;
+}
+
+/* Move the control port found in a previous run to the head of the list, so
+ * that it is the first one probed */
+static GList *
+prefer_cached_control_port (GList *devices)
+{
+    GList *l;
+
+    for (l = devices; l; l = g_list_next (l)) {
+        if (is_cached_control_port (G_UDEV_DEVICE (l->data))) {
+            g_debug ("port '%s' found in probe cache", g_udev_device_get_name (G_UDEV_DEVICE (l->data)));
+            devices = g_list_remove_link (devices, l);
+            return g_list_concat (l, devices);
+        }
+    }
+
+    return devices;
+}
+
+/*****************************************************************************/
+
+static gint
+compare_port_name (GUdevDevice *device,
+                   const gchar *name)
+{
+    return g_strcmp0 (g_udev_device_get_name (device), name);
+}
+
 static GUdevDevice *
 peek_data_for_qmi (RmfdManager *self,
-                   GUdevDevice *device)
+                   GUdevDevice *device,
+                   const gchar *cached_data_port)
 {
     GUdevDevice *qmi_device_parent;
     GUdevDevice *found;
@@ -163,6 +310,15 @@ peek_data_for_qmi (RmfdManager *self,
         return NULL;
     }
 
+    /* If we know which port was used before, try it first */
+    if (cached_data_port) {
+        l = g_list_find_custom (self->priv->data_ports, cached_data_port, (GCompareFunc) compare_port_name);
+        if (l) {
+            self->priv->data_ports = g_list_remove_link (self->priv->data_ports, l);
+            self->priv->data_ports = g_list_concat (l, self->priv->data_ports);
+        }
+    }
+
     /* Now walk the list of net ports looking for a match */
     found = NULL;
     for (l = self->priv->data_ports; l && !found; l = g_list_next (l)) {
@@ -194,16 +350,42 @@ peek_data_for_qmi (RmfdManager *self,
 typedef struct {
     RmfdManager *self;
     GUdevDevice *device;
+    RmfdProbeCacheEntry *probe_hint;
 } ProbingPortContext;
 
 static void
 probing_port_context_free (ProbingPortContext *ctx)
 {
+    if (ctx->probe_hint)
+        rmfd_probe_cache_entry_free (ctx->probe_hint);
     g_object_unref (ctx->self);
     g_object_unref (ctx->device);
     g_slice_free (ProbingPortContext, ctx);
 }
 
+static void processor_qmi_new_ready (GObject            *source,
+                                     GAsyncResult       *res,
+                                     ProbingPortContext *ctx);
+
+static void
+probing_port_context_run (ProbingPortContext *ctx)
+{
+    gchar *interface;
+
+    if (ctx->probe_hint)
+        g_debug ("    reusing cached probing results for port '%s'", g_udev_device_get_name (ctx->device));
+
+    /* Build interface name */
+    interface = rmfd_utils_build_interface_name (ctx->device);
+    ctx->self->priv->processor_probing = TRUE;
+    rmfd_port_processor_qmi_new (interface,
+                                 ctx->probe_hint,
+                                 &ctx->self->priv->processor_settings,
+                                 (GAsyncReadyCallback) processor_qmi_new_ready,
+                                 ctx);
+    g_free (interface);
+}
+
 static void
 processor_qmi_new_ready (GObject      *source,
                          GAsyncResult *res,
@@ -218,7 +400,7 @@ processor_qmi_new_ready (GObject      *source,
         GUdevDevice *data;
 
         /* Processor correctly created for a QMI port, now look for corresponding WWAN */
-        data = peek_data_for_qmi (ctx->self, ctx->device);
+        data = peek_data_for_qmi (ctx->self, ctx->device, ctx->probe_hint ? ctx->probe_hint->data_port : NULL);
         if (data) {
             gchar *interface;
 
@@ -227,11 +409,19 @@ processor_qmi_new_ready (GObject      *source,
             ctx->self->priv->data = rmfd_port_data_wwan_new (interface);
             g_free (interface);
 
+            /* Bind the WWAN to the data session left up by a previous run, if any */
+            rmfd_port_processor_qmi_resume_session (RMFD_PORT_PROCESSOR_QMI (ctx->self->priv->processor),
+                                                    ctx->self->priv->data);
+
             /* All ready! */
             g_message ("modem ready at QMI (%s) and WWAN (%s)",
                        rmfd_port_get_interface (RMFD_PORT (ctx->self->priv->processor)),
                        rmfd_port_get_interface (RMFD_PORT (ctx->self->priv->data)));
 
+            /* Remember the probing results for the next run */
+            if (ctx->self->priv->parent)
+                store_probe_cache (ctx->self, ctx->device, data);
+
             g_list_free_full (ctx->self->priv->processor_ports, g_object_unref);
             ctx->self->priv->processor_ports = NULL;
             g_list_free_full (ctx->self->priv->data_ports, g_object_unref);
@@ -249,22 +439,25 @@ processor_qmi_new_ready (GObject      *source,
         g_error_free (error);
     }
 
+    /* If the cached probing results were wrong, forget them and fully probe
+     * the same port again */
+    if (ctx->probe_hint) {
+        g_debug ("    discarding cached probing results for port '%s'", g_udev_device_get_name (ctx->device));
+        g_clear_pointer (&ctx->probe_hint, (GDestroyNotify) rmfd_probe_cache_entry_free);
+        if (ctx->self->priv->parent) {
+            invalidate_probe_cache (ctx->self);
+            probing_port_context_run (ctx);
+            return;
+        }
+    }
+
     /* Retry with another port in the same device */
     if (ctx->self->priv->processor_ports) {
-        gchar *interface = NULL;
-
         g_object_unref (ctx->device);
         ctx->device = ctx->self->priv->processor_ports->data;
         ctx->self->priv->processor_ports = g_list_delete_link (ctx->self->priv->processor_ports,
                                                                ctx->self->priv->processor_ports);
-
-        /* Build interface name */
-        interface = rmfd_utils_build_interface_name (ctx->device);
-        ctx->self->priv->processor_probing = TRUE;
-        rmfd_port_processor_qmi_new (interface,
-                                     (GAsyncReadyCallback) processor_qmi_new_ready,
-                                     ctx);
-        g_free (interface);
+        probing_port_context_run (ctx);
         return;
     }
 
@@ -329,15 +522,13 @@ port_added (RmfdManager *self,
             if (!self->priv->processor_probing) {
                 ProbingPortContext *ctx;
 
-                ctx = g_slice_new (ProbingPortContext);
+                ctx = g_slice_new0 (ProbingPortContext);
                 ctx->self = g_object_ref (self);
                 ctx->device = g_object_ref (device);
+                ctx->probe_hint = lookup_probe_cache_for_control_port (self->priv->parent, device);
 
-                self->priv->processor_probing = TRUE;
                 track_port (&self->priv->processor_ports, device);
-                rmfd_port_processor_qmi_new (interface,
-                                             (GAsyncReadyCallback) processor_qmi_new_ready,
-                                             ctx);
+                probing_port_context_run (ctx);
             } else {
                 /* Probing of a port already ongoing, just add it to our tmp list */
                 track_port (&self->priv->processor_ports, device);
@@ -408,6 +599,10 @@ typedef struct {
     GSocketConnection *connection;
     GByteArray *message;
     GByteArray *response;
+    guint id;
+    gint64 received_time;
+    gint64 queued_time;
+    gint64 dispatched_time;
 } Request;
 
 static void
@@ -426,8 +621,11 @@ static void
 request_complete (const Request *request)
 {
     GError *error = NULL;
+    gint64 write_time;
+    gint64 now;
 
     g_assert (request->response != NULL);
+    write_time = g_get_monotonic_time ();
     if (!g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (request->connection)),
                                     request->response->data,
                                     request->response->len,
@@ -437,6 +635,18 @@ request_complete (const Request *request)
         g_warning ("error writing to output stream: %s", error->message);
         g_error_free (error);
     }
+
+    now = g_get_monotonic_time ();
+    rmfd_tracing_add_span ("rmf", "reply", NULL,
+                           request->id, rmf_message_get_command (request->message->data),
+                           write_time, now);
+
+    /* Only the status in the header is needed, not the whole response */
+    rmfd_metrics_record_command (rmf_message_get_command (request->message->data),
+                                 rmf_message_get_status (request->response->data) != RMF_RESPONSE_STATUS_OK,
+                                 request->dispatched_time - request->received_time,
+                                 now - request->dispatched_time,
+                                 now - request->received_time);
 }
 
 static void
@@ -446,6 +656,10 @@ processor_run_ready (RmfdPortProcessor *processor,
 {
     GError *error = NULL;
 
+    rmfd_tracing_add_span ("rmf", "process", NULL,
+                           request->id, rmf_message_get_command (request->message->data),
+                           request->dispatched_time, g_get_monotonic_time ());
+
     request->response = rmfd_port_processor_run_finish (processor, result, &error);
     if (!request->response) {
         g_message ("couldn't process the request: %s", error->message);
@@ -461,6 +675,22 @@ static void
 request_process (RmfdManager *self,
                  Request     *request)
 {
+    request->dispatched_time = g_get_monotonic_time ();
+    rmfd_metrics_command_dispatched ();
+    rmfd_tracing_add_span ("rmf", "queue", NULL,
+                           request->id, rmf_message_get_command (request->message->data),
+                           request->queued_time, request->dispatched_time);
+
+    if (rmf_message_get_command (request->message->data) == RMF_MESSAGE_COMMAND_GET_DAEMON_METRICS) {
+        uint8_t *response_buffer;
+
+        response_buffer = rmfd_metrics_build_response (g_list_length (self->priv->requests));
+        request->response = g_byte_array_new_take (response_buffer, rmf_message_get_length (response_buffer));
+        request_complete (request);
+        request_free (request);
+        return;
+    }
+
     if (rmf_message_get_command (request->message->data) == RMF_MESSAGE_COMMAND_IS_MODEM_AVAILABLE) {
         uint8_t modem_available;
         uint8_t *response_buffer;
@@ -480,11 +710,14 @@ request_process (RmfdManager *self,
         return;
     }
 
+    /* Spans recorded by the processor while running are linked to this request */
+    rmfd_tracing_set_current (request->id, rmf_message_get_command (request->message->data));
     rmfd_port_processor_run (self->priv->processor,
                              request->message,
                              self->priv->data,
                              (GAsyncReadyCallback)processor_run_ready,
                              request);
+    rmfd_tracing_set_current (0, RMF_MESSAGE_COMMAND_UNKNOWN);
 }
 
 static void requests_schedule (RmfdManager *self);
@@ -550,6 +783,8 @@ incoming_cb (GSocketService    *service,
     /* Create request */
     request = g_slice_new0 (Request);
     request->connection = g_object_ref (connection);
+    request->id = ++self->priv->next_request_id;
+    request->received_time = g_get_monotonic_time ();
 
     buffer = g_malloc (message_size);
     memcpy (buffer, &message_size, 4);
@@ -570,6 +805,10 @@ incoming_cb (GSocketService    *service,
 
     /* Store the request message */
     request->message = g_byte_array_new_take (buffer, message_size);
+    request->queued_time = g_get_monotonic_time ();
+    rmfd_tracing_add_span ("rmf", "receive", NULL,
+                           request->id, rmf_message_get_command (request->message->data),
+                           request->received_time, request->queued_time);
 
     /* Push request */
     self->priv->requests = g_list_append (self->priv->requests, request);
@@ -631,6 +870,7 @@ initial_scan_cb (RmfdManager *self)
     g_debug ("scanning usb subsystems...");
 
     devices = g_udev_client_query_by_subsystem (self->priv->udev_client, "usb");
+    devices = prefer_cached_control_port (devices);
     for (iter = devices; iter; iter = g_list_next (iter)) {
         port_added (self, G_UDEV_DEVICE (iter->data));
         g_object_unref (G_OBJECT (iter->data));
@@ -638,6 +878,7 @@ initial_scan_cb (RmfdManager *self)
     g_list_free (devices);
 
     devices = g_udev_client_query_by_subsystem (self->priv->udev_client, "usbmisc");
+    devices = prefer_cached_control_port (devices);
     for (iter = devices; iter; iter = g_list_next (iter)) {
         port_added (self, G_UDEV_DEVICE (iter->data));
         g_object_unref (G_OBJECT (iter->data));
@@ -660,22 +901,34 @@ initial_scan_cb (RmfdManager *self)
 /*****************************************************************************/
 
 RmfdManager *
-rmfd_manager_new_tcp (const gchar *address,
-                      guint16      port)
+rmfd_manager_new_tcp (const gchar                        *address,
+                      guint16                             port,
+                      const RmfdPortProcessorQmiSettings *settings)
 {
-    g_return_val_if_fail (address != NULL, NULL);
-    g_return_val_if_fail (port != 0,       NULL);
+    RmfdManager *self;
 
-    return g_object_new (RMFD_TYPE_MANAGER,
+    g_return_val_if_fail (address != NULL,  NULL);
+    g_return_val_if_fail (port != 0,        NULL);
+    g_return_val_if_fail (settings != NULL, NULL);
+
+    self = g_object_new (RMFD_TYPE_MANAGER,
                          "ip-address", address,
                          "tcp-port",   port,
                          NULL);
+    self->priv->processor_settings = *settings;
+    return self;
 }
 
 RmfdManager *
-rmfd_manager_new_unix (void)
+rmfd_manager_new_unix (const RmfdPortProcessorQmiSettings *settings)
 {
-    return g_object_new (RMFD_TYPE_MANAGER, NULL);
+    RmfdManager *self;
+
+    g_return_val_if_fail (settings != NULL, NULL);
+
+    self = g_object_new (RMFD_TYPE_MANAGER, NULL);
+    self->priv->processor_settings = *settings;
+    return self;
 }
 
 static void
@@ -781,6 +1034,10 @@ dispose (GObject *object)
         priv->ip_address = NULL;
     }
 
+    /* Daemon shutdown: leave the data session up for the next run */
+    if (priv->processor)
+        rmfd_port_processor_qmi_keep_session (RMFD_PORT_PROCESSOR_QMI (priv->processor));
+
     g_clear_object (&priv->socket_service);
     g_clear_object (&priv->processor);
     g_clear_object (&priv->data);
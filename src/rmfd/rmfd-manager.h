@@ -29,6 +29,8 @@
 #include <glib-object.h>
 #include <gio/gio.h>
 
+#include "rmfd-port-processor-qmi.h"
+
 #define RMFD_TYPE_MANAGER            (rmfd_manager_get_type ())
 #define RMFD_MANAGER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), RMFD_TYPE_MANAGER, RmfdManager))
 #define RMFD_MANAGER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), RMFD_TYPE_MANAGER, RmfdManagerClass))
@@ -51,8 +53,9 @@ struct _RmfdManagerClass {
 
 GType rmfd_manager_get_type (void);
 
-RmfdManager *rmfd_manager_new_unix (void);
-RmfdManager *rmfd_manager_new_tcp  (const gchar *address,
-                                    guint16      port);
+RmfdManager *rmfd_manager_new_unix (const RmfdPortProcessorQmiSettings *settings);
+RmfdManager *rmfd_manager_new_tcp  (const gchar                        *address,
+                                    guint16                             port,
+                                    const RmfdPortProcessorQmiSettings *settings);
 
 #endif /* RMFD_MANAGER_H */
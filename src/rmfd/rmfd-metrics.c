@@ -0,0 +1,247 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#include <string.h>
+
+#include <rmf-messages.h>
+
+#include "rmfd-metrics.h"
+
+/* How often the main loop lag is sampled */
+#define LAG_CHECK_INTERVAL_MS 1000
+
+typedef struct {
+    guint32 transactions;
+    guint32 timeouts;
+    guint32 round_trip[RMF_METRICS_HISTOGRAM_N_BUCKETS];
+} ServiceMetrics;
+
+typedef struct {
+    GHashTable *commands; /* command -> RmfCommandMetrics */
+    GHashTable *services; /* QmiService -> ServiceMetrics */
+    guint       in_flight;
+    guint       lag_timeout_id;
+    gint64      lag_expected_time;
+    guint32     lag_ms;
+    guint32     lag_max_ms;
+} Metrics;
+
+static Metrics *metrics;
+
+/*****************************************************************************/
+
+static void
+histogram_add (guint32 *histogram,
+               gint64   value)
+{
+    gint64 value_ms;
+    guint  i;
+
+    value_ms = value / 1000;
+    for (i = 0; i < RMF_METRICS_HISTOGRAM_N_BUCKETS - 1; i++) {
+        if (value_ms <= rmf_metrics_histogram_limits_ms[i])
+            break;
+    }
+    histogram[i]++;
+}
+
+/*****************************************************************************/
+/* Main loop lag
+ *
+ * A periodic timeout which, when dispatched, checks how late it was with
+ * respect to the time it was expected to run. */
+
+static gboolean
+lag_timeout_cb (void)
+{
+    gint64 now;
+
+    now = g_get_monotonic_time ();
+    metrics->lag_ms = (guint32) (MAX (now - metrics->lag_expected_time, 0) / 1000);
+    if (metrics->lag_ms > metrics->lag_max_ms)
+        metrics->lag_max_ms = metrics->lag_ms;
+    metrics->lag_expected_time = now + (LAG_CHECK_INTERVAL_MS * 1000);
+    return G_SOURCE_CONTINUE;
+}
+
+/*****************************************************************************/
+
+void
+rmfd_metrics_command_dispatched (void)
+{
+    if (!metrics)
+        return;
+
+    metrics->in_flight++;
+}
+
+void
+rmfd_metrics_record_command (guint32  command,
+                             gboolean error,
+                             gint64   queue_wait,
+                             gint64   processing,
+                             gint64   total)
+{
+    RmfCommandMetrics *item;
+
+    if (!metrics)
+        return;
+
+    if (metrics->in_flight > 0)
+        metrics->in_flight--;
+
+    item = g_hash_table_lookup (metrics->commands, GUINT_TO_POINTER (command));
+    if (!item) {
+        item = g_slice_new0 (RmfCommandMetrics);
+        item->command = command;
+        g_hash_table_insert (metrics->commands, GUINT_TO_POINTER (command), item);
+    }
+
+    item->count++;
+    if (error)
+        item->errors++;
+    histogram_add (item->queue_wait, queue_wait);
+    histogram_add (item->processing, processing);
+    histogram_add (item->total,      total);
+}
+
+void
+rmfd_metrics_record_qmi_transaction (QmiService service,
+                                     gboolean   timed_out,
+                                     gint64     round_trip)
+{
+    ServiceMetrics *item;
+
+    if (!metrics)
+        return;
+
+    item = g_hash_table_lookup (metrics->services, GUINT_TO_POINTER (service));
+    if (!item) {
+        item = g_slice_new0 (ServiceMetrics);
+        g_hash_table_insert (metrics->services, GUINT_TO_POINTER (service), item);
+    }
+
+    item->transactions++;
+    if (timed_out)
+        item->timeouts++;
+    histogram_add (item->round_trip, round_trip);
+}
+
+/*****************************************************************************/
+
+static gint
+compare_keys (gconstpointer a,
+              gconstpointer b)
+{
+    return (gint) GPOINTER_TO_UINT (a) - (gint) GPOINTER_TO_UINT (b);
+}
+
+guint8 *
+rmfd_metrics_build_response (guint queued_requests)
+{
+    RmfCommandMetrics    *commands;
+    RmfQmiServiceMetrics *services;
+    GList                *keys;
+    GList                *l;
+    guint                 n_commands = 0;
+    guint                 n_services = 0;
+    guint8               *response;
+
+    g_assert (metrics);
+
+    /* Report entries sorted by command/service id */
+    commands = g_new0 (RmfCommandMetrics, g_hash_table_size (metrics->commands));
+    keys = g_list_sort (g_hash_table_get_keys (metrics->commands), compare_keys);
+    for (l = keys; l; l = g_list_next (l))
+        commands[n_commands++] = *((RmfCommandMetrics *) g_hash_table_lookup (metrics->commands, l->data));
+    g_list_free (keys);
+
+    services = g_new0 (RmfQmiServiceMetrics, g_hash_table_size (metrics->services));
+    keys = g_list_sort (g_hash_table_get_keys (metrics->services), compare_keys);
+    for (l = keys; l; l = g_list_next (l)) {
+        ServiceMetrics *item;
+
+        item = g_hash_table_lookup (metrics->services, l->data);
+        services[n_services].service      = qmi_service_get_string ((QmiService) GPOINTER_TO_UINT (l->data));
+        services[n_services].transactions = item->transactions;
+        services[n_services].timeouts     = item->timeouts;
+        memcpy (services[n_services].round_trip, item->round_trip, sizeof (item->round_trip));
+        n_services++;
+    }
+    g_list_free (keys);
+
+    /* Every open connection is a client request either waiting in the queue
+     * or being processed */
+    response = rmf_message_get_daemon_metrics_response_new (queued_requests,
+                                                            queued_requests + metrics->in_flight,
+                                                            metrics->lag_ms,
+                                                            metrics->lag_max_ms,
+                                                            n_commands,
+                                                            commands,
+                                                            n_services,
+                                                            services);
+    g_free (commands);
+    g_free (services);
+    return response;
+}
+
+/*****************************************************************************/
+
+static void
+command_metrics_free (RmfCommandMetrics *item)
+{
+    g_slice_free (RmfCommandMetrics, item);
+}
+
+static void
+service_metrics_free (ServiceMetrics *item)
+{
+    g_slice_free (ServiceMetrics, item);
+}
+
+void
+rmfd_metrics_setup (void)
+{
+    g_assert (!metrics);
+
+    metrics = g_slice_new0 (Metrics);
+    metrics->commands = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) command_metrics_free);
+    metrics->services = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) service_metrics_free);
+    metrics->lag_expected_time = g_get_monotonic_time () + (LAG_CHECK_INTERVAL_MS * 1000);
+    metrics->lag_timeout_id = g_timeout_add (LAG_CHECK_INTERVAL_MS, (GSourceFunc) lag_timeout_cb, NULL);
+}
+
+void
+rmfd_metrics_teardown (void)
+{
+    if (!metrics)
+        return;
+
+    g_source_remove (metrics->lag_timeout_id);
+    g_hash_table_unref (metrics->commands);
+    g_hash_table_unref (metrics->services);
+    g_slice_free (Metrics, metrics);
+    metrics = NULL;
+}
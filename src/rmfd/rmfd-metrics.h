@@ -0,0 +1,50 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#ifndef RMFD_METRICS_H
+#define RMFD_METRICS_H
+
+#include <glib.h>
+#include <libqmi-glib.h>
+
+void     rmfd_metrics_setup                  (void);
+void     rmfd_metrics_teardown               (void);
+
+/* RMF command processing, times in microseconds */
+void     rmfd_metrics_command_dispatched     (void);
+void     rmfd_metrics_record_command         (guint32     command,
+                                              gboolean    error,
+                                              gint64      queue_wait,
+                                              gint64      processing,
+                                              gint64      total);
+
+/* QMI transactions, time in microseconds */
+void     rmfd_metrics_record_qmi_transaction (QmiService  service,
+                                              gboolean    timed_out,
+                                              gint64      round_trip);
+
+guint8  *rmfd_metrics_build_response         (guint       queued_requests);
+
+#endif /* RMFD_METRICS_H */
@@ -0,0 +1,352 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#include <glib.h>
+
+#include "rmfd-netlink.h"
+#include "rmfd-error.h"
+#include "rmfd-error-types.h"
+
+#define NETLINK_BUFFER_SIZE 8192
+
+struct _RmfdNetlink {
+    gint    fd;
+    guint32 seq;
+};
+
+typedef struct {
+    struct nlmsghdr hdr;
+    union {
+        struct ifinfomsg ifi;
+        struct ifaddrmsg ifa;
+        struct rtmsg     rtm;
+    };
+    gchar attrs[128];
+} NetlinkRequest;
+
+/*****************************************************************************/
+
+static void
+request_init (NetlinkRequest *req,
+              guint16         type,
+              guint16         flags,
+              gsize           payload_len)
+{
+    memset (req, 0, sizeof (NetlinkRequest));
+    req->hdr.nlmsg_len   = NLMSG_LENGTH (payload_len);
+    req->hdr.nlmsg_type  = type;
+    req->hdr.nlmsg_flags = NLM_F_REQUEST | flags;
+}
+
+static void
+request_add_attr (NetlinkRequest *req,
+                  guint16         type,
+                  gconstpointer   data,
+                  gsize           len)
+{
+    struct rtattr *rta;
+
+    g_assert (NLMSG_ALIGN (req->hdr.nlmsg_len) + RTA_SPACE (len) <= sizeof (NetlinkRequest));
+
+    rta = (struct rtattr *) (((gchar *) &req->hdr) + NLMSG_ALIGN (req->hdr.nlmsg_len));
+    rta->rta_type = type;
+    rta->rta_len  = RTA_LENGTH (len);
+    memcpy (RTA_DATA (rta), data, len);
+    req->hdr.nlmsg_len = NLMSG_ALIGN (req->hdr.nlmsg_len) + RTA_SPACE (len);
+}
+
+static gboolean
+request_send (RmfdNetlink     *self,
+              NetlinkRequest  *req,
+              GError         **error)
+{
+    req->hdr.nlmsg_seq = ++self->seq;
+    if (send (self->fd, &req->hdr, req->hdr.nlmsg_len, 0) < 0) {
+        g_set_error (error, RMFD_ERROR, RMFD_ERROR_UNKNOWN,
+                     "couldn't send netlink request: %s", g_strerror (errno));
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Process replies to the last request until the ack or the end of the dump;
+ * each dumped message is given to the callback */
+static gboolean
+request_wait (RmfdNetlink      *self,
+              void            (*callback) (struct nlmsghdr *hdr, gpointer user_data),
+              gpointer          user_data,
+              GError          **error)
+{
+    gchar buffer[NETLINK_BUFFER_SIZE];
+
+    while (TRUE) {
+        struct nlmsghdr *hdr;
+        gssize           len;
+
+        len = recv (self->fd, buffer, sizeof (buffer), 0);
+        if (len < 0) {
+            if (errno == EINTR)
+                continue;
+            g_set_error (error, RMFD_ERROR, RMFD_ERROR_UNKNOWN,
+                         "couldn't receive netlink reply: %s", g_strerror (errno));
+            return FALSE;
+        }
+
+        for (hdr = (struct nlmsghdr *) buffer; NLMSG_OK (hdr, (guint) len); hdr = NLMSG_NEXT (hdr, len)) {
+            if (hdr->nlmsg_seq != self->seq)
+                continue;
+
+            if (hdr->nlmsg_type == NLMSG_DONE)
+                return TRUE;
+
+            if (hdr->nlmsg_type == NLMSG_ERROR) {
+                struct nlmsgerr *err = NLMSG_DATA (hdr);
+
+                if (err->error == 0)
+                    return TRUE;
+                g_set_error (error, RMFD_ERROR, RMFD_ERROR_UNKNOWN, "%s", g_strerror (-err->error));
+                errno = -err->error;
+                return FALSE;
+            }
+
+            if (callback)
+                callback (hdr, user_data);
+        }
+    }
+}
+
+static gboolean
+request_run (RmfdNetlink     *self,
+             NetlinkRequest  *req,
+             GError         **error)
+{
+    req->hdr.nlmsg_flags |= NLM_F_ACK;
+    return (request_send (self, req, error) && request_wait (self, NULL, NULL, error));
+}
+
+/*****************************************************************************/
+
+gboolean
+rmfd_netlink_link_set (RmfdNetlink  *self,
+                       guint         ifindex,
+                       gboolean      up,
+                       guint32       mtu,
+                       GError      **error)
+{
+    NetlinkRequest req;
+
+    request_init (&req, RTM_NEWLINK, 0, sizeof (struct ifinfomsg));
+    req.ifi.ifi_family = AF_UNSPEC;
+    req.ifi.ifi_index  = ifindex;
+    req.ifi.ifi_flags  = up ? IFF_UP : 0;
+    req.ifi.ifi_change = IFF_UP;
+    if (mtu)
+        request_add_attr (&req, IFLA_MTU, &mtu, sizeof (mtu));
+
+    if (!request_run (self, &req, error)) {
+        g_prefix_error (error, "couldn't set link %s: ", up ? "up" : "down");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+gboolean
+rmfd_netlink_address_add (RmfdNetlink  *self,
+                          guint         ifindex,
+                          guint32       address,
+                          guint         prefix,
+                          guint32       broadcast,
+                          GError      **error)
+{
+    NetlinkRequest req;
+
+    request_init (&req, RTM_NEWADDR, NLM_F_CREATE | NLM_F_REPLACE, sizeof (struct ifaddrmsg));
+    req.ifa.ifa_family    = AF_INET;
+    req.ifa.ifa_prefixlen = prefix;
+    req.ifa.ifa_scope     = RT_SCOPE_UNIVERSE;
+    req.ifa.ifa_index     = ifindex;
+    request_add_attr (&req, IFA_LOCAL, &address, sizeof (address));
+    request_add_attr (&req, IFA_ADDRESS, &address, sizeof (address));
+    request_add_attr (&req, IFA_BROADCAST, &broadcast, sizeof (broadcast));
+
+    if (!request_run (self, &req, error)) {
+        g_prefix_error (error, "couldn't add address: ");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+typedef struct {
+    guint   ifindex;
+    GArray *addresses; /* struct ifaddrmsg + local address */
+} FlushContext;
+
+typedef struct {
+    struct ifaddrmsg ifa;
+    guint32          local;
+} FlushAddress;
+
+static void
+address_dump_cb (struct nlmsghdr *hdr,
+                 FlushContext    *ctx)
+{
+    struct ifaddrmsg *ifa;
+    struct rtattr    *rta;
+    gint              len;
+    FlushAddress      address;
+
+    if (hdr->nlmsg_type != RTM_NEWADDR)
+        return;
+
+    ifa = NLMSG_DATA (hdr);
+    if (ifa->ifa_index != ctx->ifindex || ifa->ifa_family != AF_INET)
+        return;
+
+    memset (&address, 0, sizeof (address));
+    address.ifa = *ifa;
+    len = IFA_PAYLOAD (hdr);
+    for (rta = IFA_RTA (ifa); RTA_OK (rta, len); rta = RTA_NEXT (rta, len)) {
+        if (rta->rta_type == IFA_LOCAL && RTA_PAYLOAD (rta) == sizeof (guint32)) {
+            memcpy (&address.local, RTA_DATA (rta), sizeof (guint32));
+            g_array_append_val (ctx->addresses, address);
+            return;
+        }
+    }
+}
+
+gboolean
+rmfd_netlink_address_flush (RmfdNetlink  *self,
+                            guint         ifindex,
+                            GError      **error)
+{
+    NetlinkRequest req;
+    FlushContext   ctx;
+    gboolean       success = FALSE;
+    guint          i;
+
+    ctx.ifindex   = ifindex;
+    ctx.addresses = g_array_new (FALSE, FALSE, sizeof (FlushAddress));
+
+    /* Dump all IPv4 addresses, only the ones in the interface are kept */
+    request_init (&req, RTM_GETADDR, NLM_F_DUMP, sizeof (struct ifaddrmsg));
+    req.ifa.ifa_family = AF_INET;
+    if (!request_send (self, &req, error) ||
+        !request_wait (self, (void (*) (struct nlmsghdr *, gpointer)) address_dump_cb, &ctx, error)) {
+        g_prefix_error (error, "couldn't list addresses: ");
+        goto out;
+    }
+
+    for (i = 0; i < ctx.addresses->len; i++) {
+        FlushAddress *address;
+
+        address = &g_array_index (ctx.addresses, FlushAddress, i);
+        request_init (&req, RTM_DELADDR, 0, sizeof (struct ifaddrmsg));
+        req.ifa = address->ifa;
+        request_add_attr (&req, IFA_LOCAL, &address->local, sizeof (address->local));
+        if (!request_run (self, &req, error)) {
+            g_prefix_error (error, "couldn't remove address: ");
+            goto out;
+        }
+    }
+
+    success = TRUE;
+
+out:
+    g_array_unref (ctx.addresses);
+    return success;
+}
+
+gboolean
+rmfd_netlink_default_route_add (RmfdNetlink  *self,
+                                guint         ifindex,
+                                guint32       gateway,
+                                guint32       metric,
+                                GError      **error)
+{
+    NetlinkRequest req;
+    guint32        oif = ifindex;
+
+    request_init (&req, RTM_NEWROUTE, NLM_F_CREATE | NLM_F_EXCL, sizeof (struct rtmsg));
+    req.rtm.rtm_family   = AF_INET;
+    req.rtm.rtm_table    = RT_TABLE_MAIN;
+    req.rtm.rtm_protocol = RTPROT_BOOT;
+    req.rtm.rtm_scope    = RT_SCOPE_UNIVERSE;
+    req.rtm.rtm_type     = RTN_UNICAST;
+    request_add_attr (&req, RTA_GATEWAY, &gateway, sizeof (gateway));
+    request_add_attr (&req, RTA_OIF, &oif, sizeof (oif));
+    if (metric)
+        request_add_attr (&req, RTA_PRIORITY, &metric, sizeof (metric));
+
+    if (!request_run (self, &req, error)) {
+        g_prefix_error (error, "couldn't add default route: ");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+RmfdNetlink *
+rmfd_netlink_new (GError **error)
+{
+    RmfdNetlink        *self;
+    struct sockaddr_nl  addr;
+    gint                fd;
+
+    fd = socket (AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) {
+        g_set_error (error, RMFD_ERROR, RMFD_ERROR_UNKNOWN,
+                     "couldn't open netlink socket: %s", g_strerror (errno));
+        return NULL;
+    }
+
+    memset (&addr, 0, sizeof (addr));
+    addr.nl_family = AF_NETLINK;
+    if (bind (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0) {
+        g_set_error (error, RMFD_ERROR, RMFD_ERROR_UNKNOWN,
+                     "couldn't bind netlink socket: %s", g_strerror (errno));
+        close (fd);
+        return NULL;
+    }
+
+    self = g_slice_new0 (RmfdNetlink);
+    self->fd = fd;
+    return self;
+}
+
+void
+rmfd_netlink_free (RmfdNetlink *self)
+{
+    close (self->fd);
+    g_slice_free (RmfdNetlink, self);
+}
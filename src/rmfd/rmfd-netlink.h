@@ -0,0 +1,63 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#ifndef RMFD_NETLINK_H
+#define RMFD_NETLINK_H
+
+#include <glib.h>
+
+/* Minimal rtnetlink support to configure network interfaces without spawning
+ * external tools. All operations are synchronous, the kernel replies right
+ * away. */
+
+typedef struct _RmfdNetlink RmfdNetlink;
+
+RmfdNetlink *rmfd_netlink_new                (GError      **error);
+void         rmfd_netlink_free               (RmfdNetlink  *self);
+
+gboolean     rmfd_netlink_link_set           (RmfdNetlink  *self,
+                                              guint         ifindex,
+                                              gboolean      up,
+                                              guint32       mtu, /* 0 to leave it untouched */
+                                              GError      **error);
+
+gboolean     rmfd_netlink_address_add        (RmfdNetlink  *self,
+                                              guint         ifindex,
+                                              guint32       address,   /* network byte order */
+                                              guint         prefix,
+                                              guint32       broadcast, /* network byte order */
+                                              GError      **error);
+gboolean     rmfd_netlink_address_flush      (RmfdNetlink  *self,
+                                              guint         ifindex,
+                                              GError      **error);
+
+/* Fails with EEXIST if there is already a default route with the same metric */
+gboolean     rmfd_netlink_default_route_add  (RmfdNetlink  *self,
+                                              guint         ifindex,
+                                              guint32       gateway,   /* network byte order */
+                                              guint32       metric,
+                                              GError      **error);
+
+#endif /* RMFD_NETLINK_H */
@@ -24,13 +24,41 @@
  */
 
 #include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+
+#include <glib/gstdio.h>
 
 #include "rmfd-port-data-wwan.h"
+#include "rmfd-netlink.h"
 #include "rmfd-error.h"
 #include "rmfd-error-types.h"
 
 G_DEFINE_TYPE (RmfdPortDataWwan, rmfd_port_data_wwan, RMFD_TYPE_PORT_DATA)
 
+#define SERVICE_SCRIPT        "rmfd-port-data-wwan-service"
+#define RESOLV_CONF           "/etc/resolv.conf"
+#define RESOLV_CONF_BACKUP    "/var/run/rmfd-port-data-wwan-service-%s.resolv.conf.backup"
+#define DHCLIENT_PID_FILE     "/var/run/rmfd-port-data-wwan-service-%s.pid"
+#define FALLBACK_ROUTE_METRIC 123
+
+struct _RmfdPortDataWwanPrivate {
+    /* Whether the interface was started with DHCP, which is always run by
+     * the service script, so that the stop goes through it as well */
+    gboolean dynamic;
+};
+
+/* When set, the service script is used for every setup, not only for DHCP */
+static gboolean use_script;
+
+void
+rmfd_port_data_wwan_set_use_script (gboolean enabled)
+{
+    use_script = enabled;
+}
+
 /*****************************************************************************/
 /* Setup */
 
@@ -57,6 +85,264 @@ setup_finish (RmfdPortData  *self,
     return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
 }
 
+/*****************************************************************************/
+/* Native setup, over rtnetlink */
+
+/* Write in place, so that a symlinked resolv.conf is kept */
+static gboolean
+write_file (const gchar  *path,
+            const gchar  *contents,
+            gsize         length,
+            GError      **error)
+{
+    FILE     *f;
+    gboolean  success;
+
+    f = fopen (path, "w");
+    if (!f) {
+        g_set_error (error, RMFD_ERROR, RMFD_ERROR_UNKNOWN,
+                     "couldn't open '%s': %s", path, g_strerror (errno));
+        return FALSE;
+    }
+
+    success = (fwrite (contents, 1, length, f) == length);
+    if (fclose (f) != 0)
+        success = FALSE;
+    if (!success)
+        g_set_error (error, RMFD_ERROR, RMFD_ERROR_UNKNOWN,
+                     "couldn't write '%s': %s", path, g_strerror (errno));
+    return success;
+}
+
+static gboolean
+resolv_conf_update (const gchar  *interface,
+                    const gchar  *dns1_address,
+                    const gchar  *dns2_address,
+                    GError      **error)
+{
+    gchar    *backup;
+    gchar    *contents = NULL;
+    gsize     length = 0;
+    GString  *str;
+    gboolean  success = FALSE;
+
+    /* As in the service script, the backup is replaced on every start */
+    backup = g_strdup_printf (RESOLV_CONF_BACKUP, interface);
+    g_unlink (backup);
+    if (g_file_get_contents (RESOLV_CONF, &contents, &length, NULL) &&
+        !write_file (backup, contents, length, error))
+        goto out;
+
+    str = g_string_new (NULL);
+    if (dns1_address)
+        g_string_append_printf (str, "nameserver %s\n", dns1_address);
+    if (dns2_address)
+        g_string_append_printf (str, "nameserver %s\n", dns2_address);
+    success = write_file (RESOLV_CONF, str->str, str->len, error);
+    g_string_free (str, TRUE);
+
+out:
+    g_free (contents);
+    g_free (backup);
+    return success;
+}
+
+static void
+resolv_conf_restore (const gchar *interface)
+{
+    gchar  *backup;
+    gchar  *contents;
+    gsize   length;
+    GError *error = NULL;
+
+    backup = g_strdup_printf (RESOLV_CONF_BACKUP, interface);
+    if (g_file_get_contents (backup, &contents, &length, NULL)) {
+        if (!write_file (RESOLV_CONF, contents, length, &error)) {
+            g_warning ("couldn't restore resolv.conf: %s", error->message);
+            g_error_free (error);
+        } else
+            g_unlink (backup);
+        g_free (contents);
+    }
+    g_free (backup);
+}
+
+static gboolean
+parse_ipv4 (const gchar  *str,
+            guint32      *out,
+            GError      **error)
+{
+    struct in_addr addr;
+
+    if (inet_pton (AF_INET, str, &addr) != 1) {
+        g_set_error (error, RMFD_ERROR, RMFD_ERROR_INVALID_REQUEST,
+                     "invalid IPv4 address: '%s'", str);
+        return FALSE;
+    }
+    *out = addr.s_addr;
+    return TRUE;
+}
+
+static gboolean
+native_stop (const gchar  *interface,
+             GError      **error)
+{
+    RmfdNetlink *netlink;
+    guint        ifindex;
+    gboolean     success;
+
+    /* Nothing to clean up if the interface is already gone */
+    ifindex = if_nametoindex (interface);
+    if (ifindex) {
+        netlink = rmfd_netlink_new (error);
+        if (!netlink)
+            return FALSE;
+
+        /* Routes through the interface are removed along with the addresses */
+        success = (rmfd_netlink_address_flush (netlink, ifindex, error) &&
+                   rmfd_netlink_link_set (netlink, ifindex, FALSE, 0, error));
+        rmfd_netlink_free (netlink);
+        if (!success)
+            return FALSE;
+    }
+
+    resolv_conf_restore (interface);
+    return TRUE;
+}
+
+static gboolean
+native_start (const gchar  *interface,
+              const gchar  *ip_address,
+              const gchar  *netmask_address,
+              const gchar  *gateway_address,
+              const gchar  *dns1_address,
+              const gchar  *dns2_address,
+              guint32       mtu,
+              GError      **error)
+{
+    RmfdNetlink *netlink = NULL;
+    guint        ifindex;
+    guint32      ip;
+    guint32      netmask = 0;
+    guint32      gateway = 0;
+    guint        prefix;
+    gboolean     success = FALSE;
+    GError      *inner_error = NULL;
+
+    if (!netmask_address) {
+        g_set_error (error, RMFD_ERROR, RMFD_ERROR_INVALID_REQUEST,
+                     "netmask address not given");
+        return FALSE;
+    }
+
+    if (!parse_ipv4 (ip_address, &ip, error) ||
+        !parse_ipv4 (netmask_address, &netmask, error) ||
+        (gateway_address && !parse_ipv4 (gateway_address, &gateway, error)))
+        return FALSE;
+
+    prefix = __builtin_popcount (netmask);
+
+    ifindex = if_nametoindex (interface);
+    if (!ifindex) {
+        g_set_error (error, RMFD_ERROR, RMFD_ERROR_UNKNOWN,
+                     "unknown interface");
+        return FALSE;
+    }
+
+    netlink = rmfd_netlink_new (error);
+    if (!netlink)
+        return FALSE;
+
+    if (!rmfd_netlink_link_set (netlink, ifindex, TRUE, 0, error))
+        goto out;
+
+    /* As in the service script, a MTU the interface doesn't accept isn't
+     * fatal */
+    if (mtu && !rmfd_netlink_link_set (netlink, ifindex, TRUE, mtu, &inner_error)) {
+        g_warning ("couldn't set MTU %u in WWAN interface '%s': %s", mtu, interface, inner_error->message);
+        g_clear_error (&inner_error);
+    }
+
+    if (!rmfd_netlink_address_add (netlink, ifindex, ip, prefix, ip | ~netmask, error))
+        goto out;
+
+    /* If there is already a default route in another interface, add ours
+     * with a higher metric */
+    if (gateway &&
+        !rmfd_netlink_default_route_add (netlink, ifindex, gateway, 0, NULL) &&
+        !rmfd_netlink_default_route_add (netlink, ifindex, gateway, FALLBACK_ROUTE_METRIC, error))
+        goto out;
+
+    /* As in the service script, DNS setup errors aren't fatal */
+    if ((dns1_address || dns2_address) &&
+        !resolv_conf_update (interface, dns1_address, dns2_address, &inner_error)) {
+        g_warning ("couldn't setup DNS servers in WWAN interface '%s': %s", interface, inner_error->message);
+        g_error_free (inner_error);
+    }
+
+    success = TRUE;
+
+out:
+    rmfd_netlink_free (netlink);
+
+    /* Don't leave the interface half configured */
+    if (!success)
+        native_stop (interface, NULL);
+    return success;
+}
+
+static void
+native_setup (SetupContext *ctx,
+              const gchar  *ip_address,
+              const gchar  *netmask_address,
+              const gchar  *gateway_address,
+              const gchar  *dns1_address,
+              const gchar  *dns2_address,
+              guint32       mtu)
+{
+    const gchar *interface;
+    GError      *error = NULL;
+    gint64       start_time;
+    gboolean     success;
+
+    interface = rmfd_port_get_interface (RMFD_PORT (ctx->self));
+    start_time = g_get_monotonic_time ();
+
+    if (ctx->start)
+        success = native_start (interface,
+                                ip_address,
+                                netmask_address,
+                                gateway_address,
+                                dns1_address,
+                                dns2_address,
+                                mtu,
+                                &error);
+    else
+        success = native_stop (interface, &error);
+
+    if (!success) {
+        g_prefix_error (&error,
+                        "couldn't %s WWAN interface '%s': ",
+                        ctx->start ? "start" : "stop",
+                        interface);
+        g_debug ("error: %s", error->message);
+        g_simple_async_result_take_error (ctx->result, error);
+        setup_context_complete_and_free (ctx);
+        return;
+    }
+
+    /* Done */
+    g_debug ("WWAN interface '%s' is now %s (%" G_GINT64_FORMAT " us)",
+             interface,
+             ctx->start ? "started" : "stopped",
+             g_get_monotonic_time () - start_time);
+    g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+    setup_context_complete_and_free (ctx);
+}
+
+/*****************************************************************************/
+/* Setup with the service script */
+
 static void
 command_ready (GPid          pid,
                gint          status,
@@ -84,32 +370,23 @@ command_ready (GPid          pid,
 }
 
 static void
-setup (RmfdPortData        *self,
-       gboolean             start,
-       const gchar         *ip_address,
-       const gchar         *netmask_address,
-       const gchar         *gateway_address,
-       const gchar         *dns1_address,
-       const gchar         *dns2_address,
-       guint32              mtu,
-       GAsyncReadyCallback  callback,
-       gpointer             user_port_data)
+script_setup (SetupContext *ctx,
+              const gchar  *ip_address,
+              const gchar  *netmask_address,
+              const gchar  *gateway_address,
+              const gchar  *dns1_address,
+              const gchar  *dns2_address,
+              guint32       mtu)
 {
 #define MAX_ARGS 10 /* 0-8 + 1 last NULL */
 
-    SetupContext *ctx;
     gchar *command_split[MAX_ARGS];
     GError *error = NULL;
     GPid pid;
 
-    ctx = g_slice_new (SetupContext);
-    ctx->self = RMFD_PORT_DATA_WWAN (g_object_ref (self));
-    ctx->result = g_simple_async_result_new (G_OBJECT (self), callback, user_port_data, setup);
-    ctx->start = start;
-
     /* Build command */
     memset (command_split, 0, sizeof (command_split));
-    command_split[0] = "rmfd-port-data-wwan-service";
+    command_split[0] = SERVICE_SCRIPT;
     command_split[1] = (gchar *) rmfd_port_get_interface (RMFD_PORT (ctx->self));
     if (!ip_address) {
         command_split[2] = ctx->start ? "start-dynamic" : "stop";
@@ -117,7 +394,7 @@ setup (RmfdPortData        *self,
                  ctx->start ? "starting" : "stopping",
                  rmfd_port_get_interface (RMFD_PORT (ctx->self)));
     } else {
-        g_assert (start);
+        g_assert (ctx->start);
         command_split[2] = "start-static";
         command_split[3] = (gchar *) (ip_address);
         command_split[4] = (gchar *) (netmask_address ? netmask_address : "-");
@@ -164,6 +441,60 @@ setup (RmfdPortData        *self,
 
 /*****************************************************************************/
 
+/* The dynamic mode isn't known after a daemon restart, but the DHCP client
+ * started by the service script is still around */
+static gboolean
+dhclient_running (const gchar *interface)
+{
+    gchar    *pid_file;
+    gboolean  running;
+
+    pid_file = g_strdup_printf (DHCLIENT_PID_FILE, interface);
+    running = g_file_test (pid_file, G_FILE_TEST_EXISTS);
+    g_free (pid_file);
+    return running;
+}
+
+static void
+setup (RmfdPortData        *_self,
+       gboolean             start,
+       const gchar         *ip_address,
+       const gchar         *netmask_address,
+       const gchar         *gateway_address,
+       const gchar         *dns1_address,
+       const gchar         *dns2_address,
+       guint32              mtu,
+       GAsyncReadyCallback  callback,
+       gpointer             user_port_data)
+{
+    RmfdPortDataWwan *self = RMFD_PORT_DATA_WWAN (_self);
+    SetupContext *ctx;
+    gboolean dynamic;
+
+    ctx = g_slice_new (SetupContext);
+    ctx->self = g_object_ref (self);
+    ctx->result = g_simple_async_result_new (G_OBJECT (self), callback, user_port_data, setup);
+    ctx->start = start;
+
+    /* DHCP needs an external client, so dynamic setups (and their stop) are
+     * always run by the service script; static setups are applied natively
+     * unless the script was explicitly requested. */
+    if (start) {
+        dynamic = !ip_address;
+        self->priv->dynamic = dynamic;
+    } else {
+        dynamic = self->priv->dynamic || dhclient_running (rmfd_port_get_interface (RMFD_PORT (self)));
+        self->priv->dynamic = FALSE;
+    }
+
+    if (use_script || dynamic)
+        script_setup (ctx, ip_address, netmask_address, gateway_address, dns1_address, dns2_address, mtu);
+    else
+        native_setup (ctx, ip_address, netmask_address, gateway_address, dns1_address, dns2_address, mtu);
+}
+
+/*****************************************************************************/
+
 RmfdPortData *
 rmfd_port_data_wwan_new (const gchar *interface)
 {
@@ -177,13 +508,18 @@ rmfd_port_data_wwan_new (const gchar *interface)
 static void
 rmfd_port_data_wwan_init (RmfdPortDataWwan *self)
 {
+    /* Setup private data */
+    self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, RMFD_TYPE_PORT_DATA_WWAN, RmfdPortDataWwanPrivate);
 }
 
 static void
 rmfd_port_data_wwan_class_init (RmfdPortDataWwanClass *wwan_class)
 {
+    GObjectClass      *object_class = G_OBJECT_CLASS (wwan_class);
     RmfdPortDataClass *data_class = RMFD_PORT_DATA_CLASS (wwan_class);
 
+    g_type_class_add_private (object_class, sizeof (RmfdPortDataWwanPrivate));
+
     /* Virtual methods */
     data_class->setup = setup;
     data_class->setup_finish = setup_finish;
@@ -39,9 +39,11 @@
 
 typedef struct _RmfdPortDataWwan RmfdPortDataWwan;
 typedef struct _RmfdPortDataWwanClass RmfdPortDataWwanClass;
+typedef struct _RmfdPortDataWwanPrivate RmfdPortDataWwanPrivate;
 
 struct _RmfdPortDataWwan {
     RmfdPortData parent;
+    RmfdPortDataWwanPrivate *priv;
 };
 
 struct _RmfdPortDataWwanClass {
@@ -53,4 +55,8 @@ GType rmfd_port_data_wwan_get_type (void);
 /* Create a wwan data interface */
 RmfdPortData *rmfd_port_data_wwan_new (const gchar *interface);
 
+/* Static setups are applied natively over rtnetlink by default; this forces
+ * the rmfd-port-data-wwan-service script to be used for all of them */
+void rmfd_port_data_wwan_set_use_script (gboolean enabled);
+
 #endif /* RMFD_PORT_DATA_WWAN_H */
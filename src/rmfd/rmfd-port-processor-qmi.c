@@ -33,12 +33,19 @@
 #include "rmfd-syslog.h"
 #include "rmfd-utils.h"
 #include "rmfd-stats.h"
+#include "rmfd-metrics.h"
+#include "rmfd-tracing.h"
+#include "rmfd-session-state.h"
+#include "rmfd-registration-state.h"
+#include "rmfd-sim-cache.h"
 #include "rmfd-port-processor-qmi.h"
 #include "rmfd-error.h"
 #include "rmfd-error-types.h"
 #include "rmfd-sms-part.h"
 #include "rmfd-sms-part-3gpp.h"
 #include "rmfd-sms-list.h"
+#include "rmfd-qmimux.h"
+#include "rmfd-port-data-wwan.h"
 
 static void async_initable_iface_init (GAsyncInitableIface *iface);
 
@@ -48,15 +55,60 @@ G_DEFINE_TYPE_EXTENDED (RmfdPortProcessorQmi, rmfd_port_processor_qmi, RMFD_TYPE
 
 #define GLOBAL_PACKET_DATA_HANDLE 0xFFFFFFFF
 
+/* Downlink QMAP aggregation limits requested to the modem; the uplink limits
+ * are given by the modem */
+#define QMAP_DL_MAX_DATAGRAMS 32
+#define QMAP_DL_MAX_SIZE      16384
+
 #define DEFAULT_REGISTRATION_TIMEOUT_SECS 60
 #define DEFAULT_REGISTRATION_TIMEOUT_LOGGING_SECS 10
+#define TARGETED_REGISTRATION_TIMEOUT_SECS 20
 
 #define MESSAGING_LIST_MAX_RETRIES        3
 #define MESSAGING_LIST_RETRY_TIMEOUT_SECS 5
 
-#define DEFAULT_STATS_TIMEOUT_SECS 10
+#define MESSAGING_SETUP_MAX_ATTEMPTS          5
+#define MESSAGING_SETUP_RETRY_INITIAL_MSECS   1000
+#define MESSAGING_SETUP_RETRY_MAX_MSECS       60000
+
+#define CLOCK_RESYNC_INTERVAL_SECS 600
+#define CLOCK_DRIFT_THRESHOLD_SECS 2
+
+/* January 6th 1980 */
+#define GPS_EPOCH_UNIX_TIME G_GINT64_CONSTANT (315964800)
+
+/* 3GPP TS 24.008 session management causes (as reported in the 3GPP
+ * verbose call end reason) after which retrying the same connection request
+ * is pointless */
+static const QmiWdsVerboseCallEndReason3gpp permanent_3gpp_call_end_reasons[] = {
+    QMI_WDS_VERBOSE_CALL_END_REASON_3GPP_OPERATOR_DETERMINED_BARRING,
+    QMI_WDS_VERBOSE_CALL_END_REASON_3GPP_UNKNOWN_APN,
+    QMI_WDS_VERBOSE_CALL_END_REASON_3GPP_UNKNOWN_PDP,
+    QMI_WDS_VERBOSE_CALL_END_REASON_3GPP_AUTHENTICATION_FAILED,
+    QMI_WDS_VERBOSE_CALL_END_REASON_3GPP_SERVICE_OPTION_NOT_SUPPORTED,
+    QMI_WDS_VERBOSE_CALL_END_REASON_3GPP_SERVICE_OPTION_NOT_SUBSCRIBED,
+};
 
-#define MAX_CONNECT_ITERATIONS 3
+#define SIM_INFO_EFOPLMNWACT_GRACE_TIMEOUT_MS 2000
+
+#define AUTO_RECONNECT_DEFAULT_MAX_DELAY_SECS 60
+#define AUTO_RECONNECT_MAX_DELAY_LIMIT_SECS   3600
+
+#define SIGNAL_INFO_MAX_AGE_SECS 30
+
+enum {
+    PROP_0,
+    PROP_PROBE_HINT,
+    PROP_PACKET_STATS_PERIOD,
+    PROP_STATS_INTERVAL,
+    PROP_STATS_CHANGE_THRESHOLD,
+    PROP_STATS_MAX_INTERVAL,
+    PROP_CONNECT_MAX_ATTEMPTS,
+    PROP_CONNECT_RETRY_INITIAL_DELAY,
+    PROP_CONNECT_RETRY_MAX_DELAY,
+    PROP_MUX_SESSIONS,
+    LAST_PROP
+};
 
 const gchar *stats_file_paths[2] = {
     "/var/log/rmfd.stats",   /* SIM slot 1, original filename */
@@ -65,19 +117,115 @@ const gchar *stats_file_paths[2] = {
 
 static const gchar bcd_chars[] = "0123456789\0\0\0\0\0\0";
 
+typedef struct {
+    guint32 tx_packets_ok;
+    guint32 rx_packets_ok;
+    guint32 tx_packets_error;
+    guint32 rx_packets_error;
+    guint32 tx_overflows;
+    guint32 rx_overflows;
+    guint64 tx_bytes_ok;
+    guint64 rx_bytes_ok;
+} PacketStats;
+
+/* QMAP multiplexed data session, with its own WDS client bound to the mux id
+ * and its own qmimux link network interface */
+typedef struct {
+    RmfdPortProcessorQmi *self;
+    guint                 id;     /* 1-based, as given by the user */
+    guint8                mux_id;
+    RmfConnectionStatus   connection_status;
+    QmiClientWds         *wds;
+    guint32               packet_data_handle;
+    guint                 packet_service_status_indication_id;
+    gchar                *master;
+    gchar                *link;
+    RmfdPortData         *data;
+} MuxSession;
+
 struct _RmfdPortProcessorQmiPrivate {
     /* QMI device and clients */
     QmiDevice *qmi_device;
     GList     *services; /* ServiceInfo */
 
+    /* Device identity, loaded on first use; can't change while open */
+    gchar *manufacturer;
+    gchar *model;
+    gchar *revision;
+    gchar *hardware_revision;
+    gchar *imei;
+
+    /* SIM files of the current card (file name -> GArray), invalidated on UIM
+     * card or slot status changes and on SIM refresh */
+    GHashTable *sim_cache;
+    GArray *sim_cache_iccid;
+    guint sim_cache_generation;
+    gboolean sim_cache_identifying;
+    gboolean sim_cache_forget;
+    GList *sim_cache_waiting;
+    guint card_status_indication_id;
+    guint slot_status_indication_id;
+    guint refresh_indication_id;
+
+    /* Lock status of the current card, only cached while UIM card status
+     * indications are enabled to invalidate it */
+    gboolean card_status_indications_enabled;
+    gboolean card_status_valid;
+    gboolean card_status_unlocked;
+    guint card_status_generation;
+    GList *card_status_unlock_waiting; /* RunContext */
+
     /* Connection related info */
     RmfConnectionStatus connection_status;
     guint32 packet_data_handle;
     guint packet_service_status_indication_id;
+    guint event_report_indication_id;
+    guint packet_stats_period;
+    gboolean packet_stats_indications_enabled;
+    gboolean packet_stats_valid;
+    PacketStats packet_stats;
     guint stats_timeout_id;
     gboolean stats_enabled;
+    guint stats_interval;
+    guint64 stats_change_threshold;
+    guint stats_max_interval;
+    gint64 stats_last_record_time;
+    guint64 stats_last_record_rx_bytes;
+    guint64 stats_last_record_tx_bytes;
     RmfdPortData *connected_data;
     guint connected_sim_slot;
+    guint connect_max_attempts;
+    guint connect_retry_initial_delay;
+    guint connect_retry_max_delay;
+
+    /* QMAP multiplexed sessions; if enabled, the master wwan interface is
+     * only used as transport for the links of each session */
+    guint mux_sessions;
+    gboolean mux_enabled;
+    MuxSession mux_session_list[RMFD_PORT_PROCESSOR_QMI_MAX_MUX_SESSIONS];
+
+    /* QMAP aggregation limits negotiated with the modem, 0 if none or unknown */
+    guint32 ul_max_datagrams;
+    guint32 ul_max_size;
+    guint32 dl_max_datagrams;
+    guint32 dl_max_size;
+
+    /* Automatic reconnection after network-initiated disconnections, reusing
+     * the request of the last successful connection */
+    gboolean auto_reconnect_enabled;
+    guint auto_reconnect_max_attempts; /* 0 if unlimited */
+    guint auto_reconnect_max_delay;    /* seconds */
+    RmfAutoReconnectState auto_reconnect_state;
+    guint auto_reconnect_attempt;
+    guint auto_reconnect_timeout_id;
+    GByteArray *auto_reconnect_request;
+    RmfdPortData *auto_reconnect_data;
+    guint auto_reconnect_generation;
+    gint64 auto_reconnect_drop_time;
+    guint auto_reconnect_drops;
+    guint auto_reconnect_reconnects;
+    guint auto_reconnect_failures;
+    guint auto_reconnect_last_recovery_time; /* ms */
 
     /* Registration related info */
     guint32 registration_timeout;
@@ -86,11 +234,40 @@ struct _RmfdPortProcessorQmiPrivate {
     RmfRegistrationStatus registration_status;
     guint16 operator_mcc;
     guint16 operator_mnc;
+    gboolean operator_mnc_includes_pcs_digit;
     gchar *operator_description;
     guint16 lac;
     guint32 cid;
 
-    /* Messaging related info */
+    /* Last network successfully registered in, persisted across runs, and
+     * the card in use, which must be the one registered with to target it */
+    gboolean last_registration_valid;
+    RmfdRegistrationState last_registration;
+    gchar *card_iccid;
+    gboolean card_iccid_loading;
+    guint card_iccid_generation;
+
+    /* Network scan, single one at a time, and results of the last one */
+    GCancellable *network_scan_cancellable;
+    GList *network_scan_waiting; /* RunContext */
+    GArray *network_scan_results; /* NetworkScanResult */
+    gint64 network_scan_time;
+
+    /* Signal info, updated on NAS signal info indications; indexed by
+     * RmfRadioInterface */
+    guint signal_info_indication_id;
+    gboolean signal_available[RMF_RADIO_INTERFACE_LTE + 1];
+    gint8 signal_rssi[RMF_RADIO_INTERFACE_LTE + 1];
+    gint64 signal_info_time;
+    gboolean signal_info_refreshing;
+    GList *signal_info_waiting;
+
+    /* Messaging related info; setup runs in the background after init, and
+     * is retried on failure, and again on the next card status change once
+     * out of attempts */
+    guint messaging_setup_id;
+    guint messaging_setup_attempt;
+    gboolean messaging_ready;
     guint messaging_event_report_indication_id;
     RmfdSmsList *messaging_sms_list;
     GArray *messaging_sms_contexts;
@@ -98,12 +275,48 @@ struct _RmfdPortProcessorQmiPrivate {
     /* Stats */
     RmfdStatsContext *stats[2];
 
-    /* WWAN settings */
+    /* Modem system time, as an offset against the monotonic clock */
+    gboolean clock_offset_valid;
+    gint64 clock_offset;
+    gint64 clock_sync_time;
+    gint64 clock_sync_realtime_offset;
+
+    /* WWAN settings; if the data format cannot be negotiated, 802.3 is
+     * requested when opening the device */
     gboolean llp_is_raw_ip;
+    gboolean llp_on_open;
+
+    /* Result of a previous probing, if any */
+    RmfdProbeCacheEntry *probe_hint;
+
+    /* Data session from a previous run, if any */
+    RmfdSessionState *session;
+    gboolean session_resumed;
+
+    /* Whether the data session is kept up when disposed (daemon shutdown) */
+    gboolean keep_session;
 };
 
-static void initiate_registration (RmfdPortProcessorQmi *self, gboolean with_timeout);
-static void messaging_list        (RmfdPortProcessorQmi *self);
+static void initiate_registration  (RmfdPortProcessorQmi *self, gboolean with_timeout);
+static void messaging_list         (RmfdPortProcessorQmi *self);
+static void messaging_setup_rerun  (RmfdPortProcessorQmi *self);
+static void sim_cache_invalidate   (RmfdPortProcessorQmi *self,
+                                    gboolean              forget);
+static void card_status_invalidate (RmfdPortProcessorQmi *self);
+static void after_unlock_wake      (RmfdPortProcessorQmi *self);
+static void network_scan_start     (RmfdPortProcessorQmi *self);
+static void network_scan_release   (RmfdPortProcessorQmi *self);
+static void card_iccid_load        (RmfdPortProcessorQmi *self);
+
+static void    common_read_sim_file        (RmfdPortProcessorQmi  *self,
+                                            const gchar           *filename,
+                                            GAsyncReadyCallback    callback,
+                                            gpointer               user_data);
+static GArray *common_read_sim_file_finish (RmfdPortProcessorQmi  *self,
+                                            GAsyncResult          *res,
+                                            GError               **error);
+static gchar  *read_bcd_encoded_string     (const guint8          *bcd,
+                                            gsize                  bcd_len);
 
 /*****************************************************************************/
 /* QMI services */
@@ -144,7 +357,8 @@ find_qmi_service (RmfdPortProcessorQmi *self,
 
 static void
 untrack_qmi_service (RmfdPortProcessorQmi *self,
-                     QmiService            service)
+                     QmiService            service,
+                     gboolean              release_cid)
 {
     ServiceInfo *info;
 
@@ -157,11 +371,13 @@ untrack_qmi_service (RmfdPortProcessorQmi *self,
 
     /* Cleanup client */
     if (info->client) {
-        /* If device open, release client id */
+        /* If device open, release client (and its client id, if requested) */
         if (self->priv->qmi_device && qmi_device_is_open (self->priv->qmi_device))
             qmi_device_release_client (self->priv->qmi_device,
                                        info->client,
-                                       QMI_DEVICE_RELEASE_CLIENT_FLAGS_RELEASE_CID,
+                                       (release_cid ?
+                                        QMI_DEVICE_RELEASE_CLIENT_FLAGS_RELEASE_CID :
+                                        QMI_DEVICE_RELEASE_CLIENT_FLAGS_NONE),
                                        3, NULL, NULL, NULL);
         g_object_unref (info->client);
     }
@@ -198,18 +414,178 @@ peek_qmi_client (RmfdPortProcessorQmi *self,
     return NULL;
 }
 
+/*****************************************************************************/
+/* QMI transaction accounting */
+
+/* Every QMI request sent by the processor goes through this wrapper, so that
+ * the per-service transaction counts and round trip times are recorded in the
+ * daemon metrics. libqmi doesn't tell us explicitly whether a transaction
+ * timed out, so we assume so if the whole timeout elapsed.
+ *
+ * When tracing, the transaction is also recorded as a span, named after the
+ * function sending the request, and the request being traced when the
+ * transaction started is restored while running the original callback. */
+
+typedef struct {
+    QmiService          service;
+    guint               timeout;
+    gint64              start_time;
+    const gchar        *caller;
+    guint               trace_request_id;
+    guint32             trace_command;
+    GAsyncReadyCallback callback;
+    gpointer            user_data;
+} QmiTransaction;
+
+#define qmi_transaction_new(service, timeout, callback, user_data) \
+    qmi_transaction_new_full (service, timeout, callback, user_data, G_STRFUNC)
+
+static gpointer
+qmi_transaction_new_full (QmiService          service,
+                          guint               timeout,
+                          GAsyncReadyCallback callback,
+                          gpointer            user_data,
+                          const gchar        *caller)
+{
+    QmiTransaction *transaction;
+
+    transaction = g_slice_new (QmiTransaction);
+    transaction->service    = service;
+    transaction->timeout    = timeout;
+    transaction->start_time = g_get_monotonic_time ();
+    transaction->caller     = caller;
+    transaction->callback   = callback;
+    transaction->user_data  = user_data;
+    rmfd_tracing_get_current (&transaction->trace_request_id, &transaction->trace_command);
+    return transaction;
+}
+
+static void
+qmi_transaction_ready (GObject        *source,
+                       GAsyncResult   *res,
+                       QmiTransaction *transaction)
+{
+    gint64 now;
+    gint64 duration;
+
+    now = g_get_monotonic_time ();
+    duration = now - transaction->start_time;
+    rmfd_metrics_record_qmi_transaction (transaction->service,
+                                         (duration >= (gint64) transaction->timeout * G_USEC_PER_SEC),
+                                         duration);
+    rmfd_tracing_add_span ("qmi",
+                           transaction->caller,
+                           qmi_service_get_string (transaction->service),
+                           transaction->trace_request_id,
+                           transaction->trace_command,
+                           transaction->start_time,
+                           now);
+
+    if (transaction->callback) {
+        rmfd_tracing_set_current (transaction->trace_request_id, transaction->trace_command);
+        transaction->callback (source, res, transaction->user_data);
+        rmfd_tracing_set_current (0, RMF_MESSAGE_COMMAND_UNKNOWN);
+    }
+    g_slice_free (QmiTransaction, transaction);
+}
+
+/*****************************************************************************/
+/* Probing results */
+
+gboolean
+rmfd_port_processor_qmi_get_llp_is_raw_ip (RmfdPortProcessorQmi *self)
+{
+    return self->priv->llp_is_raw_ip;
+}
+
+gboolean
+rmfd_port_processor_qmi_get_llp_on_open (RmfdPortProcessorQmi *self)
+{
+    return self->priv->llp_on_open;
+}
+
+gboolean
+rmfd_port_processor_qmi_get_qmap (RmfdPortProcessorQmi *self)
+{
+    return self->priv->mux_enabled;
+}
+
+GArray *
+rmfd_port_processor_qmi_get_service_versions (RmfdPortProcessorQmi *self)
+{
+    GArray *versions;
+    GList  *l;
+
+    versions = g_array_new (FALSE, FALSE, sizeof (RmfdProbeCacheServiceVersion));
+    for (l = self->priv->services; l; l = g_list_next (l)) {
+        ServiceInfo                  *info = l->data;
+        RmfdProbeCacheServiceVersion  version;
+
+        version.service = info->service;
+        version.major   = qmi_client_get_version_major (info->client);
+        version.minor   = qmi_client_get_version_minor (info->client);
+        g_array_append_val (versions, version);
+    }
+    return versions;
+}
+
+static gboolean
+check_probe_hint_service_versions (RmfdPortProcessorQmi  *self,
+                                   GError               **error)
+{
+    guint i;
+
+    for (i = 0; i < self->priv->probe_hint->service_versions->len; i++) {
+        RmfdProbeCacheServiceVersion *version;
+        QmiClient                    *client;
+
+        version = &g_array_index (self->priv->probe_hint->service_versions, RmfdProbeCacheServiceVersion, i);
+        client = peek_qmi_client (self, (QmiService) version->service);
+        if (!client)
+            continue;
+
+        if (qmi_client_get_version_major (client) != version->major ||
+            qmi_client_get_version_minor (client) != version->minor) {
+            g_set_error (error, RMFD_ERROR, RMFD_ERROR_INVALID_STATE,
+                         "service '%s' version changed (%u.%u -> %u.%u)",
+                         qmi_service_get_string ((QmiService) version->service),
+                         version->major, version->minor,
+                         qmi_client_get_version_major (client),
+                         qmi_client_get_version_minor (client));
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
 /*****************************************************************************/
 /* Registration timeout handling */
 
+/* When the last registered network is known, and it was registered with the
+ * card in use, a manual registration to it is attempted first, and again when
+ * the automatic registration times out, before falling back to the full
+ * network scan. */
+
 typedef struct {
     guint timeout_secs;
     guint ongoing_secs;
     guint timeout_id;
-    GCancellable *scanning;
+    gboolean scanning;
+    guint targeted_timeout_secs; /* 0 if not ongoing */
+    gboolean targeted_tried;
 } RegistrationContext;
 
 static void registration_context_step (RmfdPortProcessorQmi *self);
 
+static gboolean
+last_registration_matches_card (RmfdPortProcessorQmi *self)
+{
+    return (self->priv->last_registration_valid &&
+            self->priv->card_iccid &&
+            g_str_equal (self->priv->last_registration.iccid, self->priv->card_iccid));
+}
+
 static void
 registration_context_cleanup (RmfdPortProcessorQmi *self)
 {
@@ -221,54 +597,75 @@ registration_context_cleanup (RmfdPortProcessorQmi *self)
     if (ctx->timeout_id)
         g_source_remove (ctx->timeout_id);
 
-    if (ctx->scanning) {
-        if (self->priv->registration_status == RMF_REGISTRATION_STATUS_SCANNING)
-            self->priv->registration_status = RMF_REGISTRATION_STATUS_IDLE;
-        g_object_unref (ctx->scanning);
-    }
+    if (ctx->scanning && self->priv->registration_status == RMF_REGISTRATION_STATUS_SCANNING)
+        self->priv->registration_status = RMF_REGISTRATION_STATUS_IDLE;
 
     g_slice_free (RegistrationContext, ctx);
     self->priv->registration_ctx = NULL;
 }
 
 static void
-registration_context_cancel (RmfdPortProcessorQmi *self)
+request_network_register (RmfdPortProcessorQmi *self,
+                          gboolean              targeted)
 {
-    RegistrationContext *ctx = (RegistrationContext *)self->priv->registration_ctx;
-
-    if (!ctx)
-        return;
+    QmiMessageNasInitiateNetworkRegisterInput *input;
 
-    if (ctx->scanning && !g_cancellable_is_cancelled (ctx->scanning))
-        g_cancellable_cancel (ctx->scanning);
+    input = qmi_message_nas_initiate_network_register_input_new ();
+    if (targeted) {
+        RmfdRegistrationState *last = &self->priv->last_registration;
 
-    registration_context_cleanup (self);
+        if (last->mnc_includes_pcs_digit)
+            g_debug ("Launching network registration in last known network (%03u-%03u)...",
+                     last->mcc, last->mnc);
+        else
+            g_debug ("Launching network registration in last known network (%03u-%02u)...",
+                     last->mcc, last->mnc);
+        qmi_message_nas_initiate_network_register_input_set_action (
+            input,
+            QMI_NAS_NETWORK_REGISTER_TYPE_MANUAL,
+            NULL);
+        qmi_message_nas_initiate_network_register_input_set_manual_registration_info_3gpp (
+            input,
+            last->mcc,
+            last->mnc,
+            (QmiNasRadioInterface) last->radio_interface,
+            NULL);
+        qmi_message_nas_initiate_network_register_input_set_mnc_pcs_digit_include_status (
+            input,
+            last->mnc_includes_pcs_digit,
+            NULL);
+        /* Never leave the modem in manual mode permanently */
+        qmi_message_nas_initiate_network_register_input_set_change_duration (
+            input,
+            QMI_NAS_CHANGE_DURATION_POWER_CYCLE,
+            NULL);
+    } else
+        qmi_message_nas_initiate_network_register_input_set_action (
+            input,
+            QMI_NAS_NETWORK_REGISTER_TYPE_AUTOMATIC,
+            NULL);
+    qmi_client_nas_initiate_network_register (
+        QMI_CLIENT_NAS (peek_qmi_client (self, QMI_SERVICE_NAS)),
+        input,
+        10,
+        NULL,
+        (GAsyncReadyCallback) qmi_transaction_ready,
+        qmi_transaction_new (QMI_SERVICE_NAS, 10, NULL, NULL));
+    qmi_message_nas_initiate_network_register_input_unref (input);
 }
 
 static void
-nas_network_scan_ready (QmiClientNas *client,
-                        GAsyncResult *res,
-                        RmfdPortProcessorQmi *self)
+registration_context_cancel (RmfdPortProcessorQmi *self)
 {
     RegistrationContext *ctx = (RegistrationContext *)self->priv->registration_ctx;
-    QmiMessageNasNetworkScanOutput *output;
-    gboolean needs_registration_again = TRUE;
 
-    /* Ignore the result of the scan */
-    output = qmi_client_nas_network_scan_finish (client, res, NULL);
-    if (output)
-        qmi_message_nas_network_scan_output_unref (output);
-    else if (g_cancellable_is_cancelled (ctx->scanning))
-        needs_registration_again = FALSE;
-
-    /* Stop registration context */
-    registration_context_cleanup (self);
+    if (!ctx)
+        return;
 
-    /* Relaunch automatic registration without timeout */
-    if (needs_registration_again)
-        initiate_registration (self, FALSE);
+    if (ctx->scanning)
+        network_scan_release (self);
 
-    g_object_unref (self);
+    registration_context_cleanup (self);
 }
 
 static gboolean
@@ -287,17 +684,21 @@ static void
 registration_context_step (RmfdPortProcessorQmi *self)
 {
     RegistrationContext *ctx = (RegistrationContext *)self->priv->registration_ctx;
+    guint                limit_secs;
 
     g_assert (ctx != NULL);
     g_assert (ctx->timeout_id == 0);
 
-    if (ctx->timeout_secs > ctx->ongoing_secs) {
+    limit_secs = ctx->targeted_timeout_secs ? ctx->targeted_timeout_secs : ctx->timeout_secs;
+    if (limit_secs > ctx->ongoing_secs) {
         guint next_timeout_secs;
 
-        g_debug ("Automatic network registration ongoing... (%u seconds elapsed)", ctx->ongoing_secs);
+        g_debug ("%s network registration ongoing... (%u seconds elapsed)",
+                 ctx->targeted_timeout_secs ? "Targeted" : "Automatic",
+                 ctx->ongoing_secs);
 
         next_timeout_secs = MIN (DEFAULT_REGISTRATION_TIMEOUT_LOGGING_SECS,
-                                 ctx->timeout_secs - ctx->ongoing_secs);
+                                 limit_secs - ctx->ongoing_secs);
         ctx->ongoing_secs += next_timeout_secs;
         ctx->timeout_id = g_timeout_add_seconds (next_timeout_secs,
                                                  (GSourceFunc)registration_context_timeout_cb,
@@ -305,20 +706,35 @@ registration_context_step (RmfdPortProcessorQmi *self)
         return;
     }
 
+    /* Targeted registration expired, go on with the automatic one */
+    if (ctx->targeted_timeout_secs) {
+        g_debug ("Targeted network registration timed out... launching automatic network registration");
+        ctx->targeted_timeout_secs = 0;
+        request_network_register (self, FALSE);
+        registration_context_step (self);
+        return;
+    }
+
+    /* Automatic registration expired, try the last known network before
+     * the scan if not done yet */
+    if (!ctx->targeted_tried && last_registration_matches_card (self)) {
+        g_debug ("Automatic network registration timed out... launching targeted network registration");
+        ctx->targeted_tried = TRUE;
+        ctx->targeted_timeout_secs = ctx->ongoing_secs + TARGETED_REGISTRATION_TIMEOUT_SECS;
+        request_network_register (self, TRUE);
+        registration_context_step (self);
+        return;
+    }
+
     /* Expired... */
     g_debug ("Automatic network registration timed out... launching network scan");
 
     /* Explicit network scan... */
     self->priv->registration_status = RMF_REGISTRATION_STATUS_SCANNING;
 
-    g_assert (ctx->scanning == NULL);
-    ctx->scanning = g_cancellable_new ();
-    qmi_client_nas_network_scan (QMI_CLIENT_NAS (peek_qmi_client (self, QMI_SERVICE_NAS)),
-                                 NULL,
-                                 120,
-                                 ctx->scanning,
-                                 (GAsyncReadyCallback)nas_network_scan_ready,
-                                 g_object_ref (self));
+    g_assert (!ctx->scanning);
+    ctx->scanning = TRUE;
+    network_scan_start (self);
 }
 
 static void
@@ -331,33 +747,109 @@ registration_context_start (RmfdPortProcessorQmi *self)
 
     ctx = g_slice_new0 (RegistrationContext);
     ctx->timeout_secs = self->priv->registration_timeout;
+    if (last_registration_matches_card (self)) {
+        /* The initial request will be the targeted one */
+        ctx->targeted_tried = TRUE;
+        ctx->targeted_timeout_secs = TARGETED_REGISTRATION_TIMEOUT_SECS;
+        ctx->timeout_secs += TARGETED_REGISTRATION_TIMEOUT_SECS;
+    } else if (self->priv->last_registration_valid && !self->priv->card_iccid) {
+        /* The targeted one will be requested once the card is identified */
+        card_iccid_load (self);
+    }
 
     self->priv->registration_ctx = (gpointer)ctx;
     registration_context_step (self);
 }
 
+/*****************************************************************************/
+/* Card identification, for the last registered network */
+
+static void
+card_iccid_invalidate (RmfdPortProcessorQmi *self)
+{
+    /* Reads in progress must not identify the new card */
+    self->priv->card_iccid_generation++;
+    self->priv->card_iccid_loading = FALSE;
+    g_clear_pointer (&self->priv->card_iccid, g_free);
+}
+
+static void
+card_iccid_ready (RmfdPortProcessorQmi *self,
+                  GAsyncResult         *res,
+                  gpointer              user_data)
+{
+    g_autoptr(GArray) read_result = NULL;
+    RegistrationContext *ctx;
+    RmfdRegistrationState *last;
+    GError *error = NULL;
+
+    read_result = common_read_sim_file_finish (self, res, &error);
+    if (GPOINTER_TO_UINT (user_data) != self->priv->card_iccid_generation) {
+        g_clear_error (&error);
+        return;
+    }
+
+    self->priv->card_iccid_loading = FALSE;
+    if (!read_result) {
+        g_debug ("couldn't identify card: %s", error->message);
+        g_error_free (error);
+        return;
+    }
+
+    self->priv->card_iccid = read_bcd_encoded_string ((const guint8 *) read_result->data, read_result->len);
+    g_assert (self->priv->card_iccid);
+    if (strlen (self->priv->card_iccid) >= RMFD_REGISTRATION_STATE_ICCID_SIZE) {
+        g_warning ("card identifier too long: %s", self->priv->card_iccid);
+        g_clear_pointer (&self->priv->card_iccid, g_free);
+        return;
+    }
+
+    last = &self->priv->last_registration;
+
+    /* Registered before the card was identified: persist it now */
+    if (self->priv->last_registration_valid && !last->iccid[0]) {
+        g_strlcpy (last->iccid, self->priv->card_iccid, sizeof (last->iccid));
+        rmfd_registration_state_save (last);
+        return;
+    }
+
+    /* Registration ongoing without having tried the last registered
+     * network: switch to the targeted one if registered with this card */
+    ctx = (RegistrationContext *)self->priv->registration_ctx;
+    if (ctx && !ctx->scanning && !ctx->targeted_tried &&
+        self->priv->registration_status != RMF_REGISTRATION_STATUS_HOME &&
+        self->priv->registration_status != RMF_REGISTRATION_STATUS_ROAMING &&
+        last_registration_matches_card (self)) {
+        g_debug ("Card identified... launching targeted network registration");
+        ctx->targeted_tried = TRUE;
+        ctx->targeted_timeout_secs = ctx->ongoing_secs + TARGETED_REGISTRATION_TIMEOUT_SECS;
+        ctx->timeout_secs += TARGETED_REGISTRATION_TIMEOUT_SECS;
+        request_network_register (self, TRUE);
+    }
+}
+
+static void
+card_iccid_load (RmfdPortProcessorQmi *self)
+{
+    if (self->priv->card_iccid || self->priv->card_iccid_loading)
+        return;
+
+    self->priv->card_iccid_loading = TRUE;
+    common_read_sim_file (self,
+                          "EFiccid",
+                          (GAsyncReadyCallback)card_iccid_ready,
+                          GUINT_TO_POINTER (self->priv->card_iccid_generation));
+}
+
 /*****************************************************************************/
 /* Explicit registration request */
 
 static gboolean
 initiate_registration_idle_cb (RmfdPortProcessorQmi *self)
 {
-    QmiMessageNasInitiateNetworkRegisterInput *input;
-
-    input = qmi_message_nas_initiate_network_register_input_new ();
-    qmi_message_nas_initiate_network_register_input_set_action (
-        input,
-        QMI_NAS_NETWORK_REGISTER_TYPE_AUTOMATIC,
-        NULL);
-    qmi_client_nas_initiate_network_register (
-        QMI_CLIENT_NAS (peek_qmi_client (self, QMI_SERVICE_NAS)),
-        input,
-        10,
-        NULL,
-        NULL,
-        NULL);
-    qmi_message_nas_initiate_network_register_input_unref (input);
+    RegistrationContext *ctx = (RegistrationContext *)self->priv->registration_ctx;
 
+    request_network_register (self, ctx && ctx->targeted_timeout_secs);
     g_object_unref (self);
     return FALSE;
 }
@@ -395,30 +887,40 @@ process_serving_system_info (RmfdPortProcessorQmi *self,
     QmiNasRegistrationState registration_state = QMI_NAS_REGISTRATION_STATE_UNKNOWN;
     QmiNasRoamingIndicatorStatus roaming = QMI_NAS_ROAMING_INDICATOR_STATUS_OFF;
 
+    GArray *radio_interfaces = NULL;
+
     g_assert ((response && !indication) || (!response && indication));
 
     /* Registration state */
     if (indication) {
         qmi_indication_nas_serving_system_output_get_serving_system (
-            indication, &registration_state, NULL, NULL, NULL, NULL, NULL);
+            indication, &registration_state, NULL, NULL, NULL, &radio_interfaces, NULL);
         qmi_indication_nas_serving_system_output_get_roaming_indicator (
             indication, &roaming, NULL);
     } else {
         qmi_message_nas_get_serving_system_output_get_serving_system (
-            response, &registration_state, NULL, NULL, NULL, NULL, NULL);
+            response, &registration_state, NULL, NULL, NULL, &radio_interfaces, NULL);
         qmi_message_nas_get_serving_system_output_get_roaming_indicator (
             response, &roaming, NULL);
     }
 
     switch (registration_state) {
-    case QMI_NAS_REGISTRATION_STATE_REGISTERED:
+    case QMI_NAS_REGISTRATION_STATE_REGISTERED: {
+        RegistrationContext *ctx = (RegistrationContext *)self->priv->registration_ctx;
+
         self->priv->registration_status = (roaming == QMI_NAS_ROAMING_INDICATOR_STATUS_ON ?
                                            RMF_REGISTRATION_STATUS_ROAMING :
                                            RMF_REGISTRATION_STATUS_HOME);
 
+        /* Registered in the targeted network, go back to automatic mode so
+         * that the modem is free to select another one later on */
+        if (ctx && ctx->targeted_timeout_secs)
+            request_network_register (self, FALSE);
+
         /* If we had a timeout waiting to get registered, remove it */
         registration_context_cancel (self);
         break;
+    }
     case QMI_NAS_REGISTRATION_STATE_NOT_REGISTERED_SEARCHING:
         /* Don't overwrite the 'scanning state' */
         if (self->priv->registration_status != RMF_REGISTRATION_STATUS_SCANNING)
@@ -439,16 +941,67 @@ process_serving_system_info (RmfdPortProcessorQmi *self,
         self->priv->registration_status == RMF_REGISTRATION_STATUS_ROAMING) {
         const gchar *description = NULL;
 
-        if (indication)
+        guint16 pcs_mcc = 0;
+        guint16 pcs_mnc = 0;
+        gboolean includes_pcs_digit = FALSE;
+
+        if (indication) {
             qmi_indication_nas_serving_system_output_get_current_plmn (
                 indication, &self->priv->operator_mcc, &self->priv->operator_mnc, &description, NULL);
-        else
+            qmi_indication_nas_serving_system_output_get_mnc_pcs_digit_include_status (
+                indication, &pcs_mcc, &pcs_mnc, &includes_pcs_digit, NULL);
+        } else {
             qmi_message_nas_get_serving_system_output_get_current_plmn (
                 response, &self->priv->operator_mcc, &self->priv->operator_mnc, &description, NULL);
+            qmi_message_nas_get_serving_system_output_get_mnc_pcs_digit_include_status (
+                response, &pcs_mcc, &pcs_mnc, &includes_pcs_digit, NULL);
+        }
+        /* 2-digit MNC unless reported otherwise for the same PLMN, as e.g.
+         * 7 and 007 are different networks */
+        self->priv->operator_mnc_includes_pcs_digit = (includes_pcs_digit &&
+                                                       pcs_mcc == self->priv->operator_mcc &&
+                                                       pcs_mnc == self->priv->operator_mnc);
         if (description) {
             g_free (self->priv->operator_description);
             self->priv->operator_description = g_strdup (description);
         }
+
+        /* Persist the network for the next registrations. The radio
+         * interface may flip on every indication while moving between
+         * cells, so it's only tracked in memory and written along with the
+         * next PLMN change. Nothing is written until the card is
+         * identified. */
+        if (self->priv->operator_mcc && radio_interfaces && radio_interfaces->len > 0) {
+            RmfdRegistrationState *last = &self->priv->last_registration;
+            QmiNasRadioInterface   radio_interface;
+
+            /* Only 3GPP networks may be targeted in a manual registration */
+            radio_interface = g_array_index (radio_interfaces, QmiNasRadioInterface, 0);
+            if (radio_interface == QMI_NAS_RADIO_INTERFACE_GSM ||
+                radio_interface == QMI_NAS_RADIO_INTERFACE_UMTS ||
+                radio_interface == QMI_NAS_RADIO_INTERFACE_LTE) {
+                gboolean changed;
+
+                changed = (!self->priv->last_registration_valid ||
+                           last->mcc != self->priv->operator_mcc ||
+                           last->mnc != self->priv->operator_mnc ||
+                           last->mnc_includes_pcs_digit != self->priv->operator_mnc_includes_pcs_digit ||
+                           !self->priv->card_iccid ||
+                           !g_str_equal (last->iccid, self->priv->card_iccid));
+                last->mcc                    = self->priv->operator_mcc;
+                last->mnc                    = self->priv->operator_mnc;
+                last->mnc_includes_pcs_digit = self->priv->operator_mnc_includes_pcs_digit;
+                last->radio_interface        = (guint) radio_interface;
+                self->priv->last_registration_valid = TRUE;
+                if (!self->priv->card_iccid) {
+                    last->iccid[0] = '\0';
+                    card_iccid_load (self);
+                } else if (changed) {
+                    g_strlcpy (last->iccid, self->priv->card_iccid, sizeof (last->iccid));
+                    rmfd_registration_state_save (last);
+                }
+            }
+        }
     } else {
         g_free (self->priv->operator_description);
         self->priv->operator_description = NULL;
@@ -492,6 +1045,53 @@ serving_system_response_cb (QmiClientNas *client,
     g_object_unref (self);
 }
 
+/* RSSI thresholds (dBm) for the signal info indications, so that the modem
+ * only reports signal changes between these bands */
+static const gint8 signal_info_rssi_thresholds[] = { -110, -105, -100, -95, -90, -85, -80, -75, -70, -65, -60, -55 };
+
+static void
+process_signal_info (RmfdPortProcessorQmi             *self,
+                     QmiMessageNasGetSignalInfoOutput *response,
+                     QmiIndicationNasSignalInfoOutput *indication)
+{
+    gboolean *available = self->priv->signal_available;
+    gint8    *rssi = self->priv->signal_rssi;
+
+    if (indication) {
+        available[RMF_RADIO_INTERFACE_GSM] =
+            qmi_indication_nas_signal_info_output_get_gsm_signal_strength (
+                indication, &rssi[RMF_RADIO_INTERFACE_GSM], NULL);
+        available[RMF_RADIO_INTERFACE_UMTS] =
+            qmi_indication_nas_signal_info_output_get_wcdma_signal_strength (
+                indication, &rssi[RMF_RADIO_INTERFACE_UMTS], NULL, NULL);
+        available[RMF_RADIO_INTERFACE_LTE] =
+            qmi_indication_nas_signal_info_output_get_lte_signal_strength (
+                indication, &rssi[RMF_RADIO_INTERFACE_LTE], NULL, NULL, NULL, NULL);
+    } else {
+        available[RMF_RADIO_INTERFACE_GSM] =
+            qmi_message_nas_get_signal_info_output_get_gsm_signal_strength (
+                response, &rssi[RMF_RADIO_INTERFACE_GSM], NULL);
+        available[RMF_RADIO_INTERFACE_UMTS] =
+            qmi_message_nas_get_signal_info_output_get_wcdma_signal_strength (
+                response, &rssi[RMF_RADIO_INTERFACE_UMTS], NULL, NULL);
+        available[RMF_RADIO_INTERFACE_LTE] =
+            qmi_message_nas_get_signal_info_output_get_lte_signal_strength (
+                response, &rssi[RMF_RADIO_INTERFACE_LTE], NULL, NULL, NULL, NULL);
+    }
+
+    self->priv->signal_info_time = g_get_monotonic_time ();
+}
+
+static void
+signal_info_indication_cb (QmiClientNas                     *client,
+                           QmiIndicationNasSignalInfoOutput *output,
+                           RmfdPortProcessorQmi             *self)
+{
+    process_signal_info (self, NULL, output);
+}
+
+static void signal_info_refresh (RmfdPortProcessorQmi *self);
+
 static void
 unregister_nas_indications (RmfdPortProcessorQmi *self)
 {
@@ -506,10 +1106,18 @@ unregister_nas_indications (RmfdPortProcessorQmi *self)
 
     g_signal_handler_disconnect (nas, self->priv->serving_system_indication_id);
     self->priv->serving_system_indication_id = 0;
+    g_signal_handler_disconnect (nas, self->priv->signal_info_indication_id);
+    self->priv->signal_info_indication_id = 0;
 
     input = qmi_message_nas_register_indications_input_new ();
     qmi_message_nas_register_indications_input_set_serving_system_events (input, FALSE, NULL);
-    qmi_client_nas_register_indications (nas, input, 5, NULL, NULL, NULL);
+    qmi_message_nas_register_indications_input_set_signal_info (input, FALSE, NULL);
+    qmi_client_nas_register_indications (nas,
+                                         input,
+                                         5,
+                                         NULL,
+                                         (GAsyncReadyCallback) qmi_transaction_ready,
+                                         qmi_transaction_new (QMI_SERVICE_NAS, 5, NULL, NULL));
     qmi_message_nas_register_indications_input_unref (input);
 }
 
@@ -517,7 +1125,9 @@ static void
 register_nas_indications (RmfdPortProcessorQmi *self)
 {
     QmiMessageNasRegisterIndicationsInput *input;
+    QmiMessageNasConfigSignalInfoInput    *config_input;
     QmiClientNas                          *nas;
+    GArray                                *thresholds;
 
     g_assert (self->priv->serving_system_indication_id == 0);
 
@@ -529,18 +1139,44 @@ register_nas_indications (RmfdPortProcessorQmi *self)
                           "serving-system",
                           G_CALLBACK (serving_system_indication_cb),
                           self);
+    self->priv->signal_info_indication_id =
+        g_signal_connect (nas,
+                          "signal-info",
+                          G_CALLBACK (signal_info_indication_cb),
+                          self);
+
+    thresholds = g_array_sized_new (FALSE, FALSE, sizeof (gint8), G_N_ELEMENTS (signal_info_rssi_thresholds));
+    g_array_append_vals (thresholds, signal_info_rssi_thresholds, G_N_ELEMENTS (signal_info_rssi_thresholds));
+    config_input = qmi_message_nas_config_signal_info_input_new ();
+    qmi_message_nas_config_signal_info_input_set_rssi_threshold (config_input, thresholds, NULL);
+    qmi_client_nas_config_signal_info (nas,
+                                       config_input,
+                                       5,
+                                       NULL,
+                                       (GAsyncReadyCallback) qmi_transaction_ready,
+                                       qmi_transaction_new (QMI_SERVICE_NAS, 5, NULL, NULL));
+    qmi_message_nas_config_signal_info_input_unref (config_input);
+    g_array_unref (thresholds);
 
     input = qmi_message_nas_register_indications_input_new ();
     qmi_message_nas_register_indications_input_set_serving_system_events (input, TRUE, NULL);
-    qmi_client_nas_register_indications (nas, input, 5, NULL, NULL, NULL);
+    qmi_message_nas_register_indications_input_set_signal_info (input, TRUE, NULL);
+    qmi_client_nas_register_indications (nas,
+                                         input,
+                                         5,
+                                         NULL,
+                                         (GAsyncReadyCallback) qmi_transaction_ready,
+                                         qmi_transaction_new (QMI_SERVICE_NAS, 5, NULL, NULL));
     qmi_message_nas_register_indications_input_unref (input);
 
     qmi_client_nas_get_serving_system (nas,
                                        NULL,
                                        10,
                                        NULL,
-                                       (GAsyncReadyCallback)serving_system_response_cb,
-                                       g_object_ref (self));
+                                       (GAsyncReadyCallback) qmi_transaction_ready,
+                                       qmi_transaction_new (QMI_SERVICE_NAS, 10, (GAsyncReadyCallback)serving_system_response_cb, g_object_ref (self)));
+
+    signal_info_refresh (self);
 }
 
 /*****************************************************************************/
@@ -553,6 +1189,8 @@ typedef struct {
     RmfdPortData *data;
     gpointer additional_context;
     GDestroyNotify additional_context_free;
+    guint trace_request_id;
+    guint32 trace_command;
 } RunContext;
 
 static void
@@ -568,6 +1206,16 @@ run_context_complete_and_free (RunContext *ctx)
     g_slice_free (RunContext, ctx);
 }
 
+static void
+run_context_complete_with_response (RunContext *ctx,
+                                    guint8     *response)
+{
+    g_simple_async_result_set_op_res_gpointer (ctx->result,
+                                               g_byte_array_new_take (response, rmf_message_get_length (response)),
+                                               (GDestroyNotify)g_byte_array_unref);
+    run_context_complete_and_free (ctx);
+}
+
 static void
 run_context_set_additional_context (RunContext     *ctx,
                                     gpointer        additional_context,
@@ -613,6 +1261,9 @@ dms_get_manufacturer_ready (QmiClientDms *client,
 
         qmi_message_dms_get_manufacturer_output_get_manufacturer (output, &str, NULL);
 
+        g_free (ctx->self->priv->manufacturer);
+        ctx->self->priv->manufacturer = g_strdup (str);
+
         response = rmf_message_get_manufacturer_response_new (str);
         g_simple_async_result_set_op_res_gpointer (ctx->result,
                                                    g_byte_array_new_take (response, rmf_message_get_length (response)),
@@ -628,12 +1279,17 @@ dms_get_manufacturer_ready (QmiClientDms *client,
 static void
 get_manufacturer (RunContext *ctx)
 {
+    if (ctx->self->priv->manufacturer) {
+        run_context_complete_with_response (ctx, rmf_message_get_manufacturer_response_new (ctx->self->priv->manufacturer));
+        return;
+    }
+
     qmi_client_dms_get_manufacturer (QMI_CLIENT_DMS (peek_qmi_client (ctx->self, QMI_SERVICE_DMS)),
                                      NULL,
                                      5,
                                      NULL,
-                                     (GAsyncReadyCallback) dms_get_manufacturer_ready,
-                                     ctx);
+                                     (GAsyncReadyCallback) qmi_transaction_ready,
+                                     qmi_transaction_new (QMI_SERVICE_DMS, 5, (GAsyncReadyCallback) dms_get_manufacturer_ready, ctx));
 }
 
 /**********************/
@@ -660,6 +1316,9 @@ dms_get_model_ready (QmiClientDms *client,
 
         qmi_message_dms_get_model_output_get_model (output, &str, NULL);
 
+        g_free (ctx->self->priv->model);
+        ctx->self->priv->model = g_strdup (str);
+
         response = rmf_message_get_model_response_new (str);
         g_simple_async_result_set_op_res_gpointer (ctx->result,
                                                    g_byte_array_new_take (response, rmf_message_get_length (response)),
@@ -675,12 +1334,17 @@ dms_get_model_ready (QmiClientDms *client,
 static void
 get_model (RunContext *ctx)
 {
+    if (ctx->self->priv->model) {
+        run_context_complete_with_response (ctx, rmf_message_get_model_response_new (ctx->self->priv->model));
+        return;
+    }
+
     qmi_client_dms_get_model (QMI_CLIENT_DMS (peek_qmi_client (ctx->self, QMI_SERVICE_DMS)),
                               NULL,
                               5,
                               NULL,
-                              (GAsyncReadyCallback) dms_get_model_ready,
-                              ctx);
+                              (GAsyncReadyCallback) qmi_transaction_ready,
+                              qmi_transaction_new (QMI_SERVICE_DMS, 5, (GAsyncReadyCallback) dms_get_model_ready, ctx));
 }
 
 /**********************/
@@ -707,6 +1371,9 @@ dms_get_revision_ready (QmiClientDms *client,
 
         qmi_message_dms_get_revision_output_get_revision (output, &str, NULL);
 
+        g_free (ctx->self->priv->revision);
+        ctx->self->priv->revision = g_strdup (str);
+
         response = rmf_message_get_software_revision_response_new (str);
         g_simple_async_result_set_op_res_gpointer (ctx->result,
                                                    g_byte_array_new_take (response, rmf_message_get_length (response)),
@@ -722,12 +1389,17 @@ dms_get_revision_ready (QmiClientDms *client,
 static void
 get_revision (RunContext *ctx)
 {
+    if (ctx->self->priv->revision) {
+        run_context_complete_with_response (ctx, rmf_message_get_software_revision_response_new (ctx->self->priv->revision));
+        return;
+    }
+
     qmi_client_dms_get_revision (QMI_CLIENT_DMS (peek_qmi_client (ctx->self, QMI_SERVICE_DMS)),
                                  NULL,
                                  5,
                                  NULL,
-                                 (GAsyncReadyCallback) dms_get_revision_ready,
-                                 ctx);
+                                 (GAsyncReadyCallback) qmi_transaction_ready,
+                                 qmi_transaction_new (QMI_SERVICE_DMS, 5, (GAsyncReadyCallback) dms_get_revision_ready, ctx));
 }
 
 /**********************/
@@ -754,6 +1426,9 @@ dms_get_hardware_revision_ready (QmiClientDms *client,
 
         qmi_message_dms_get_hardware_revision_output_get_revision (output, &str, NULL);
 
+        g_free (ctx->self->priv->hardware_revision);
+        ctx->self->priv->hardware_revision = g_strdup (str);
+
         response = rmf_message_get_hardware_revision_response_new (str);
         g_simple_async_result_set_op_res_gpointer (ctx->result,
                                                    g_byte_array_new_take (response, rmf_message_get_length (response)),
@@ -769,12 +1444,17 @@ dms_get_hardware_revision_ready (QmiClientDms *client,
 static void
 get_hardware_revision (RunContext *ctx)
 {
+    if (ctx->self->priv->hardware_revision) {
+        run_context_complete_with_response (ctx, rmf_message_get_hardware_revision_response_new (ctx->self->priv->hardware_revision));
+        return;
+    }
+
     qmi_client_dms_get_hardware_revision (QMI_CLIENT_DMS (peek_qmi_client (ctx->self, QMI_SERVICE_DMS)),
                                           NULL,
                                           5,
                                           NULL,
-                                          (GAsyncReadyCallback) dms_get_hardware_revision_ready,
-                                          ctx);
+                                          (GAsyncReadyCallback) qmi_transaction_ready,
+                                          qmi_transaction_new (QMI_SERVICE_DMS, 5, (GAsyncReadyCallback) dms_get_hardware_revision_ready, ctx));
 }
 
 /**********************/
@@ -801,6 +1481,9 @@ dms_get_ids_ready (QmiClientDms *client,
 
         qmi_message_dms_get_ids_output_get_imei (output, &str, NULL);
 
+        g_free (ctx->self->priv->imei);
+        ctx->self->priv->imei = g_strdup (str);
+
         response = rmf_message_get_imei_response_new (str);
         g_simple_async_result_set_op_res_gpointer (ctx->result,
                                                    g_byte_array_new_take (response, rmf_message_get_length (response)),
@@ -816,12 +1499,17 @@ dms_get_ids_ready (QmiClientDms *client,
 static void
 get_imei (RunContext *ctx)
 {
+    if (ctx->self->priv->imei) {
+        run_context_complete_with_response (ctx, rmf_message_get_imei_response_new (ctx->self->priv->imei));
+        return;
+    }
+
     qmi_client_dms_get_ids (QMI_CLIENT_DMS (peek_qmi_client (ctx->self, QMI_SERVICE_DMS)),
                             NULL,
                             5,
                             NULL,
-                            (GAsyncReadyCallback) dms_get_ids_ready,
-                            ctx);
+                            (GAsyncReadyCallback) qmi_transaction_ready,
+                            qmi_transaction_new (QMI_SERVICE_DMS, 5, (GAsyncReadyCallback) dms_get_ids_ready, ctx));
 }
 
 /**********************/
@@ -908,8 +1596,8 @@ common_sim_slot_query (RmfdPortProcessorQmi *self,
                                     NULL,
                                     10,
                                     NULL,
-                                    (GAsyncReadyCallback) uim_get_slot_status_ready,
-                                    task);
+                                    (GAsyncReadyCallback) qmi_transaction_ready,
+                                    qmi_transaction_new (QMI_SERVICE_UIM, 10, (GAsyncReadyCallback) uim_get_slot_status_ready, task));
 }
 
 static void
@@ -978,6 +1666,16 @@ uim_switch_slot_ready (QmiClientUim *client,
 
     g_message ("SIM slot switch operation successful");
 
+    /* Files read from now on come from a different card, the contents stored
+     * for the previous one are still valid */
+    sim_cache_invalidate (ctx->self, FALSE);
+    card_status_invalidate (ctx->self);
+
+    /* The last registered network was registered with the previous card */
+    card_iccid_invalidate (ctx->self);
+    ctx->self->priv->last_registration_valid = FALSE;
+    rmfd_registration_state_clear ();
+
     /* Launch automatic network registration explicitly */
     initiate_registration (ctx->self, TRUE);
 
@@ -1030,8 +1728,8 @@ common_sim_slot_query_in_set_ready (RmfdPortProcessorQmi  *self,
                                 input,
                                 10,
                                 NULL,
-                                (GAsyncReadyCallback) uim_switch_slot_ready,
-                                ctx);
+                                (GAsyncReadyCallback) qmi_transaction_ready,
+                                qmi_transaction_new (QMI_SERVICE_UIM, 10, (GAsyncReadyCallback) uim_switch_slot_ready, ctx));
 }
 
 static void
@@ -1090,6 +1788,61 @@ get_sim_file_id_and_path (const gchar  *file_name,
     }
 }
 
+/* SIM file contents are cached for the current card, and persisted keyed by
+ * its ICCID. When the cache isn't valid (e.g. on startup or after a card or
+ * slot status change), the card is identified first reading EFiccid, and then
+ * all files stored for it are loaded. */
+
+static void
+sim_cache_invalidate (RmfdPortProcessorQmi *self,
+                      gboolean              forget)
+{
+    /* Reads in progress must not store results in the new cache */
+    self->priv->sim_cache_generation++;
+    g_clear_pointer (&self->priv->sim_cache, g_hash_table_unref);
+
+    /* If the card contents may have changed, the stored ones must not be
+     * loaded again. If the card isn't identified yet, whatever is stored for
+     * the next one identified is dropped. */
+    if (forget) {
+        if (self->priv->sim_cache_iccid)
+            rmfd_sim_cache_remove (self->priv->sim_cache_iccid);
+        else
+            self->priv->sim_cache_forget = TRUE;
+    }
+    g_clear_pointer (&self->priv->sim_cache_iccid, g_array_unref);
+}
+
+static void
+sim_cache_add (RmfdPortProcessorQmi *self,
+               const gchar          *filename,
+               GArray               *contents)
+{
+    g_assert (self->priv->sim_cache);
+
+    g_hash_table_replace (self->priv->sim_cache, g_strdup (filename), g_array_ref (contents));
+    rmfd_sim_cache_store (self->priv->sim_cache_iccid, filename, contents);
+}
+
+typedef struct {
+    gchar    *filename;
+    gchar    *reading;
+    guint     generation;
+    gboolean  skip_cache;
+    gboolean  identifying;
+    GArray   *iccid;
+} ReadSimFileContext;
+
+static void
+read_sim_file_context_free (ReadSimFileContext *ctx)
+{
+    if (ctx->iccid)
+        g_array_unref (ctx->iccid);
+    g_free (ctx->filename);
+    g_free (ctx->reading);
+    g_slice_free (ReadSimFileContext, ctx);
+}
+
 static GArray *
 common_read_sim_file_finish (RmfdPortProcessorQmi  *self,
                              GAsyncResult          *res,
@@ -1098,40 +1851,195 @@ common_read_sim_file_finish (RmfdPortProcessorQmi  *self,
     return g_task_propagate_pointer (G_TASK (res), error);
 }
 
+static void common_read_sim_file_run (GTask *task);
+
 static void
-uim_read_transparent_ready (QmiClientUim *client,
-                            GAsyncResult *res,
-                            GTask        *task)
+sim_cache_identify_done (RmfdPortProcessorQmi *self,
+                         gboolean              identified)
 {
-    g_autoptr(QmiMessageUimReadTransparentOutput) output = NULL;
-    GError *error = NULL;
-    GArray *read_result = NULL;
+    GList *waiting;
+    GList *l;
 
-    output = qmi_client_uim_read_transparent_finish (client, res, &error);
-    if (!output ||
-        !qmi_message_uim_read_transparent_output_get_result (output, &error) ||
-        !qmi_message_uim_read_transparent_output_get_read_result (output, &read_result, &error))
+    g_assert (self->priv->sim_cache_identifying);
+    self->priv->sim_cache_identifying = FALSE;
+
+    /* Resume the reads that were waiting for the card to be identified,
+     * without caching if it couldn't be done */
+    waiting = self->priv->sim_cache_waiting;
+    self->priv->sim_cache_waiting = NULL;
+    for (l = waiting; l; l = g_list_next (l)) {
+        GTask *task = l->data;
+
+        if (!identified)
+            ((ReadSimFileContext *) g_task_get_task_data (task))->skip_cache = TRUE;
+        common_read_sim_file_run (task);
+    }
+    g_list_free (waiting);
+}
+
+static void
+read_sim_file_complete (GTask  *task,
+                        GArray *read_result,
+                        GError *error)
+{
+    RmfdPortProcessorQmi *self;
+    ReadSimFileContext   *ctx;
+
+    self = g_task_get_source_object (task);
+    ctx  = g_task_get_task_data (task);
+
+    if (ctx->identifying) {
+        ctx->identifying = FALSE;
+        sim_cache_identify_done (self, !error);
+    }
+
+    /* If we were identifying the card, go on reading the requested file;
+     * without caching if the card couldn't be identified */
+    if (!g_str_equal (ctx->reading, ctx->filename)) {
+        if (error) {
+            g_debug ("couldn't identify card for the SIM cache: %s", error->message);
+            g_error_free (error);
+            ctx->skip_cache = TRUE;
+        }
+        common_read_sim_file_run (task);
+        return;
+    }
+
+    if (error)
         g_task_return_error (task, error);
-    else if (!read_result)
-        g_task_return_new_error (task, RMFD_ERROR, RMFD_ERROR_UNKNOWN, "Read malformed data from UIM");
     else
         g_task_return_pointer (task, g_array_ref (read_result), (GDestroyNotify)g_array_unref);
     g_object_unref (task);
 }
 
 static void
-common_read_sim_file (RmfdPortProcessorQmi *self,
-                      const gchar          *filename,
-                      GAsyncReadyCallback   callback,
-                      gpointer              user_data)
+sim_cache_lookup_ready (GObject      *source,
+                        GAsyncResult *res,
+                        GTask        *task)
+{
+    RmfdPortProcessorQmi *self;
+    ReadSimFileContext   *ctx;
+    GHashTable           *files;
+
+    self = g_task_get_source_object (task);
+    ctx  = g_task_get_task_data (task);
+
+    files = rmfd_sim_cache_lookup_finish (res);
+
+    /* Loaded unless invalidated meanwhile */
+    if (ctx->generation == self->priv->sim_cache_generation) {
+        g_assert (!self->priv->sim_cache);
+        self->priv->sim_cache = (files ?
+                                 g_hash_table_ref (files) :
+                                 g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_array_unref));
+        g_hash_table_replace (self->priv->sim_cache, g_strdup ("EFiccid"), g_array_ref (ctx->iccid));
+        g_debug ("SIM cache loaded: %u files", g_hash_table_size (self->priv->sim_cache));
+    }
+    if (files)
+        g_hash_table_unref (files);
+
+    read_sim_file_complete (task, ctx->iccid, NULL);
+}
+
+/* Loading the files stored for the card is done in the writer, as it may
+ * take a while; the identification is complete once loaded */
+static void
+sim_cache_load (GTask  *task,
+                GArray *iccid)
+{
+    RmfdPortProcessorQmi *self;
+    ReadSimFileContext   *ctx;
+
+    self = g_task_get_source_object (task);
+    ctx  = g_task_get_task_data (task);
+
+    g_assert (!self->priv->sim_cache);
+    g_assert (!self->priv->sim_cache_iccid);
+
+    self->priv->sim_cache_iccid = g_array_ref (iccid);
+    ctx->iccid = g_array_ref (iccid);
+
+    if (self->priv->sim_cache_forget) {
+        self->priv->sim_cache_forget = FALSE;
+        rmfd_sim_cache_remove (iccid);
+    }
+
+    rmfd_sim_cache_lookup (iccid, (GAsyncReadyCallback) sim_cache_lookup_ready, task);
+}
+
+static void
+uim_read_transparent_ready (QmiClientUim *client,
+                            GAsyncResult *res,
+                            GTask        *task)
+{
+    RmfdPortProcessorQmi *self;
+    ReadSimFileContext   *ctx;
+    g_autoptr(QmiMessageUimReadTransparentOutput) output = NULL;
+    GError *error = NULL;
+    GArray *read_result = NULL;
+
+    self = g_task_get_source_object (task);
+    ctx  = g_task_get_task_data (task);
+
+    output = qmi_client_uim_read_transparent_finish (client, res, &error);
+    if (output &&
+        qmi_message_uim_read_transparent_output_get_result (output, &error) &&
+        qmi_message_uim_read_transparent_output_get_read_result (output, &read_result, &error) &&
+        !read_result)
+        error = g_error_new (RMFD_ERROR, RMFD_ERROR_UNKNOWN, "Read malformed data from UIM");
+
+    if (!error && !ctx->skip_cache && ctx->generation == self->priv->sim_cache_generation) {
+        if (self->priv->sim_cache)
+            sim_cache_add (self, ctx->reading, read_result);
+        else if (ctx->identifying) {
+            sim_cache_load (task, read_result);
+            return;
+        }
+    }
+
+    read_sim_file_complete (task, read_result, error);
+}
+
+static void
+common_read_sim_file_run (GTask *task)
 {
+    RmfdPortProcessorQmi *self;
+    ReadSimFileContext   *ctx;
     g_autoptr(QmiMessageUimReadTransparentInput) input = NULL;
     g_autoptr(GArray) file_path = NULL;
     guint16 file_id = 0;
-    GTask *task;
     g_autoptr(GArray) aid = NULL;
 
-    task = g_task_new (self, NULL, callback, user_data);
+    self = g_task_get_source_object (task);
+    ctx  = g_task_get_task_data (task);
+
+    if (!ctx->skip_cache && ctx->generation != self->priv->sim_cache_generation) {
+        /* Cache invalidated while identifying the card */
+        ctx->skip_cache = TRUE;
+    }
+
+    g_clear_pointer (&ctx->reading, g_free);
+    if (ctx->skip_cache)
+        ctx->reading = g_strdup (ctx->filename);
+    else if (self->priv->sim_cache) {
+        GArray *cached;
+
+        cached = g_hash_table_lookup (self->priv->sim_cache, ctx->filename);
+        if (cached) {
+            g_task_return_pointer (task, g_array_ref (cached), (GDestroyNotify)g_array_unref);
+            g_object_unref (task);
+            return;
+        }
+        ctx->reading = g_strdup (ctx->filename);
+    } else if (self->priv->sim_cache_identifying) {
+        /* Concurrent reads share a single card identification */
+        self->priv->sim_cache_waiting = g_list_append (self->priv->sim_cache_waiting, task);
+        return;
+    } else {
+        self->priv->sim_cache_identifying = TRUE;
+        ctx->identifying = TRUE;
+        ctx->reading = g_strdup ("EFiccid");
+    }
 
     input = qmi_message_uim_read_transparent_input_new ();
     aid = g_array_new (FALSE, FALSE, sizeof (guint8)); /* empty AID */
@@ -1139,15 +2047,198 @@ common_read_sim_file (RmfdPortProcessorQmi *self,
                                                         QMI_UIM_SESSION_TYPE_PRIMARY_GW_PROVISIONING,
                                                         aid,
                                                         NULL);
-    get_sim_file_id_and_path (filename, &file_id, &file_path);
+    get_sim_file_id_and_path (ctx->reading, &file_id, &file_path);
     qmi_message_uim_read_transparent_input_set_file (input, file_id, file_path, NULL);
     qmi_message_uim_read_transparent_input_set_read_information (input, 0, 0, NULL);
     qmi_client_uim_read_transparent (QMI_CLIENT_UIM (peek_qmi_client (self, QMI_SERVICE_UIM)),
                                      input,
                                      10,
                                      NULL,
-                                     (GAsyncReadyCallback)uim_read_transparent_ready,
-                                     task);
+                                     (GAsyncReadyCallback) qmi_transaction_ready,
+                                     qmi_transaction_new (QMI_SERVICE_UIM, 10, (GAsyncReadyCallback)uim_read_transparent_ready, task));
+}
+
+static void
+common_read_sim_file (RmfdPortProcessorQmi *self,
+                      const gchar          *filename,
+                      GAsyncReadyCallback   callback,
+                      gpointer              user_data)
+{
+    ReadSimFileContext *ctx;
+    GTask              *task;
+
+    ctx = g_slice_new0 (ReadSimFileContext);
+    ctx->filename   = g_strdup (filename);
+    ctx->generation = self->priv->sim_cache_generation;
+
+    task = g_task_new (self, NULL, callback, user_data);
+    g_task_set_task_data (task, ctx, (GDestroyNotify) read_sim_file_context_free);
+
+    common_read_sim_file_run (task);
+}
+
+/***************************/
+/* UIM indications */
+
+static void
+card_status_invalidate (RmfdPortProcessorQmi *self)
+{
+    /* Checks in progress must not store results in the cache */
+    self->priv->card_status_generation++;
+    self->priv->card_status_valid = FALSE;
+}
+
+static void
+uim_status_indication_cb (QmiClientUim         *client,
+                          gpointer              output,
+                          RmfdPortProcessorQmi *self)
+{
+    g_debug ("card or slot status changed: SIM and card status caches invalidated");
+    sim_cache_invalidate (self, TRUE);
+    card_status_invalidate (self);
+    card_iccid_invalidate (self);
+
+    /* Messaging setup may fail while the card isn't ready */
+    messaging_setup_rerun (self);
+
+    /* Don't wait for the next poll to complete pending unlocks */
+    after_unlock_wake (self);
+}
+
+#if QMI_CHECK_VERSION (1,30,0)
+
+static void
+uim_refresh_indication_cb (QmiClientUim                  *client,
+                           QmiIndicationUimRefreshOutput *output,
+                           RmfdPortProcessorQmi          *self)
+{
+    /* Reported both when the refresh starts and when it ends, so files read
+     * while the card is being refreshed don't stay in the cache either */
+    g_debug ("SIM refresh reported: SIM cache invalidated");
+    sim_cache_invalidate (self, TRUE);
+}
+
+static void
+uim_refresh_register (QmiClientUim *uim,
+                      gboolean      enable)
+{
+    g_autoptr(QmiMessageUimRefreshRegisterAllInput) input = NULL;
+    g_autoptr(GArray) aid = NULL;
+
+    input = qmi_message_uim_refresh_register_all_input_new ();
+    aid = g_array_new (FALSE, FALSE, sizeof (guint8)); /* empty AID */
+    qmi_message_uim_refresh_register_all_input_set_session (input,
+                                                            QMI_UIM_SESSION_TYPE_PRIMARY_GW_PROVISIONING,
+                                                            aid,
+                                                            NULL);
+    qmi_message_uim_refresh_register_all_input_set_info (input, enable, NULL);
+    qmi_client_uim_refresh_register_all (uim,
+                                         input,
+                                         5,
+                                         NULL,
+                                         (GAsyncReadyCallback) qmi_transaction_ready,
+                                         qmi_transaction_new (QMI_SERVICE_UIM, 5, NULL, NULL));
+}
+
+#endif
+
+static void
+uim_register_events_ready (QmiClientUim         *client,
+                           GAsyncResult         *res,
+                           RmfdPortProcessorQmi *self)
+{
+    QmiMessageUimRegisterEventsOutput *output;
+    GError *error = NULL;
+
+    output = qmi_client_uim_register_events_finish (client, res, &error);
+    if (!output || !qmi_message_uim_register_events_output_get_result (output, &error)) {
+        g_warning ("couldn't register UIM events: %s", error->message);
+        g_error_free (error);
+    } else if (self->priv->card_status_indication_id != 0)
+        self->priv->card_status_indications_enabled = TRUE;
+
+    if (output)
+        qmi_message_uim_register_events_output_unref (output);
+    g_object_unref (self);
+}
+
+static void
+unregister_uim_indications (RmfdPortProcessorQmi *self)
+{
+    g_autoptr(QmiMessageUimRegisterEventsInput) input = NULL;
+    QmiClientUim *uim;
+
+    if (self->priv->card_status_indication_id == 0)
+        return;
+
+    uim = QMI_CLIENT_UIM (peek_qmi_client (self, QMI_SERVICE_UIM));
+    g_assert (QMI_IS_CLIENT_UIM (uim));
+
+    g_signal_handler_disconnect (uim, self->priv->card_status_indication_id);
+    self->priv->card_status_indication_id = 0;
+    self->priv->card_status_indications_enabled = FALSE;
+    card_status_invalidate (self);
+    g_signal_handler_disconnect (uim, self->priv->slot_status_indication_id);
+    self->priv->slot_status_indication_id = 0;
+
+#if QMI_CHECK_VERSION (1,30,0)
+    g_signal_handler_disconnect (uim, self->priv->refresh_indication_id);
+    self->priv->refresh_indication_id = 0;
+    uim_refresh_register (uim, FALSE);
+#endif
+
+    input = qmi_message_uim_register_events_input_new ();
+    qmi_message_uim_register_events_input_set_event_registration_mask (input, 0, NULL);
+    qmi_client_uim_register_events (uim,
+                                    input,
+                                    5,
+                                    NULL,
+                                    (GAsyncReadyCallback) qmi_transaction_ready,
+                                    qmi_transaction_new (QMI_SERVICE_UIM, 5, NULL, NULL));
+}
+
+static void
+register_uim_indications (RmfdPortProcessorQmi *self)
+{
+    g_autoptr(QmiMessageUimRegisterEventsInput) input = NULL;
+    QmiClientUim *uim;
+
+    g_assert (self->priv->card_status_indication_id == 0);
+
+    uim = QMI_CLIENT_UIM (peek_qmi_client (self, QMI_SERVICE_UIM));
+    g_assert (QMI_IS_CLIENT_UIM (uim));
+
+    self->priv->card_status_indication_id =
+        g_signal_connect (uim,
+                          "card-status",
+                          G_CALLBACK (uim_status_indication_cb),
+                          self);
+    self->priv->slot_status_indication_id =
+        g_signal_connect (uim,
+                          "slot-status",
+                          G_CALLBACK (uim_status_indication_cb),
+                          self);
+#if QMI_CHECK_VERSION (1,30,0)
+    self->priv->refresh_indication_id =
+        g_signal_connect (uim,
+                          "refresh",
+                          G_CALLBACK (uim_refresh_indication_cb),
+                          self);
+    uim_refresh_register (uim, TRUE);
+#endif
+
+    input = qmi_message_uim_register_events_input_new ();
+    qmi_message_uim_register_events_input_set_event_registration_mask (
+        input,
+        (QMI_UIM_EVENT_REGISTRATION_FLAG_CARD_STATUS |
+         QMI_UIM_EVENT_REGISTRATION_FLAG_PHYSICAL_SLOT_STATUS),
+        NULL);
+    qmi_client_uim_register_events (uim,
+                                    input,
+                                    5,
+                                    NULL,
+                                    (GAsyncReadyCallback) qmi_transaction_ready,
+                                    qmi_transaction_new (QMI_SERVICE_UIM, 5, (GAsyncReadyCallback) uim_register_events_ready, g_object_ref (self)));
 }
 
 /**********************/
@@ -1253,32 +2344,46 @@ get_iccid (RunContext *ctx)
 /**********************/
 /* Get SIM info */
 
-typedef enum {
-    GET_SIM_INFO_STEP_FIRST,
-    GET_SIM_INFO_STEP_IMSI,
-    GET_SIM_INFO_STEP_EFAD,
-    GET_SIM_INFO_STEP_EFOPLMNWACT,
-    GET_SIM_INFO_STEP_LAST
-} GetSimInfoStep;
+/* EFimsi, EFad and EFoplmnwact are read at the same time, and parsed together
+ * once all reads are done. EFoplmnwact is optional, so if it's the only one
+ * left the response is sent after a short grace period without it; the late
+ * result is still stored in the SIM cache for the next request. */
 
 typedef struct {
-    gchar *imsi;
-    guint32 mcc;
-    guint32 mnc;
-    GArray *plmns;
-    GetSimInfoStep step;
+    guint ref_count;
+    RunContext *ctx; /* NULL once the response is sent */
+    GArray *efimsi;
+    GArray *efad;
+    GArray *efoplmnwact;
+    gboolean efimsi_done;
+    gboolean efad_done;
+    gboolean efoplmnwact_done;
+    guint efoplmnwact_timeout_id;
 } GetSimInfoContext;
 
-static void
-get_sim_info_context_free (GetSimInfoContext *ctx)
+static GetSimInfoContext *
+get_sim_info_context_ref (GetSimInfoContext *ctx)
 {
-    if (ctx->plmns)
-        g_array_unref (ctx->plmns);
-    g_free (ctx->imsi);
-    g_free (ctx);
+    ctx->ref_count++;
+    return ctx;
 }
 
-static void get_sim_info_step (RunContext *ctx);
+static void
+get_sim_info_context_unref (GetSimInfoContext *ctx)
+{
+    if (--ctx->ref_count > 0)
+        return;
+
+    g_assert (!ctx->ctx);
+    g_assert (!ctx->efoplmnwact_timeout_id);
+    if (ctx->efimsi)
+        g_array_unref (ctx->efimsi);
+    if (ctx->efad)
+        g_array_unref (ctx->efad);
+    if (ctx->efoplmnwact)
+        g_array_unref (ctx->efoplmnwact);
+    g_slice_free (GetSimInfoContext, ctx);
+}
 
 static void
 read_bcd_encoded_mccmnc (const guint8 *data,
@@ -1331,20 +2436,20 @@ read_act (const guint8 *data,
         *gsm = TRUE;
 }
 
-static void
-parse_plmns (GetSimInfoContext *get_sim_info_ctx,
-             const guint8 *bytearray,
+static GArray *
+parse_plmns (const guint8 *bytearray,
              guint32 bytearray_size)
 {
+    GArray *plmns;
     guint i;
 
     if (!bytearray || !bytearray_size)
-        return;
+        return NULL;
 
-    get_sim_info_ctx->plmns = g_array_sized_new (FALSE,
-                                                 FALSE,
-                                                 sizeof (RmfPlmnInfo),
-                                                 (bytearray_size / 5) + 1);
+    plmns = g_array_sized_new (FALSE,
+                               FALSE,
+                               sizeof (RmfPlmnInfo),
+                               (bytearray_size / 5) + 1);
 
     for (i = 0; (bytearray_size - i) >= 5; i+=5) {
         RmfPlmnInfo plmn;
@@ -1360,55 +2465,40 @@ parse_plmns (GetSimInfoContext *get_sim_info_ctx,
                   &plmn.umts,
                   &plmn.lte);
 
-        g_array_append_val (get_sim_info_ctx->plmns, plmn);
+        g_array_append_val (plmns, plmn);
     }
+
+    return plmns;
 }
 
 static void
-sim_info_efoplmnwact_ready (RmfdPortProcessorQmi *self,
-                            GAsyncResult         *res,
-                            RunContext           *ctx)
+parse_mccmnc (GArray  *efimsi,
+              GArray  *efad,
+              guint32 *mcc,
+              guint32 *mnc)
 {
-    GetSimInfoContext *get_sim_info_ctx = (GetSimInfoContext *)ctx->additional_context;
-    g_autoptr(GArray) read_result = NULL;
-
-    read_result = common_read_sim_file_finish (self, res, NULL);
-
-    /* Enable for testing */
-#if 0
-    {
-        static const guint8 example[] = {
-            0x21, 0x40, 0x3F, 0x40, 0x00, /* MCC:214, MNC:03, LTE */
-            0x21, 0x40, 0x3F, 0x80, 0x80, /* MCC:214, MNC:03, GSM, UMTS */
-            0x21, 0x40, 0x3F, 0xC0, 0x80, /* MCC:214, MNC:03, GSM, UMTS, LTE */
-        };
+    g_autofree gchar *imsi_str = NULL;
+    const gchar *imsi;
+    guint8 mnc_length = 0; /* just to mark it invalid */
+    gchar aux[4];
 
-        parse_plmns (get_sim_info_ctx, example, G_N_ELEMENTS (example));
-    }
-#else
-    if (read_result)
-        parse_plmns (get_sim_info_ctx, (const guint8 *) read_result->data, read_result->len);
-#endif
+    *mcc = 0;
+    *mnc = 0;
 
-    /* And go on */
-    get_sim_info_ctx->step++;
-    get_sim_info_step (ctx);
-}
+    /* Errors reading EFimsi are ignored; mcc/mnc are just set to 0 */
+    if (!efimsi)
+        return;
+    imsi_str = read_bcd_encoded_string ((const guint8 *) efimsi->data, efimsi->len);
+    if (strlen (imsi_str) < 3)
+        return;
 
-static void
-sim_info_efad_ready (RmfdPortProcessorQmi *self,
-                     GAsyncResult         *res,
-                     RunContext           *ctx)
-{
-    GetSimInfoContext *get_sim_info_ctx = (GetSimInfoContext *)ctx->additional_context;
-    g_autoptr(GArray) read_result = NULL;
-    guint8 mnc_length = 0; /* just to mark it invalid */
+    /* Skip length byte and parity nibble in EFimsi */
+    imsi = imsi_str + 3;
 
-    read_result = common_read_sim_file_finish (self, res, NULL);
-    if (read_result) {
+    if (efad) {
         /* MCN length is optional; available in the 4th byte of the EFad field */
-        if (read_result->len >= 4) {
-            mnc_length = g_array_index (read_result, guint8, 3);
+        if (efad->len >= 4) {
+            mnc_length = g_array_index (efad, guint8, 3);
             if (mnc_length != 3 && mnc_length != 2)
                 /* It must be either 3 or 2, no other values allowed. */
                 mnc_length = 0; /* invalid */
@@ -1416,122 +2506,147 @@ sim_info_efad_ready (RmfdPortProcessorQmi *self,
     }
 
     /* Compute MCC and MNC values */
-    if (strlen (get_sim_info_ctx->imsi) >= 3) {
-        gchar aux[4];
-
-        memcpy (aux, get_sim_info_ctx->imsi, 3);
+    if (strlen (imsi) >= 3) {
+        memcpy (aux, imsi, 3);
         aux[3] = '\0';
-        get_sim_info_ctx->mcc = atoi (aux);
+        *mcc = atoi (aux);
 
         if (mnc_length == 0)
             mnc_length = rmfd_utils_get_mnc_length_for_mcc (aux);
 
-        if (strlen (get_sim_info_ctx->imsi) >= (3 + mnc_length)) {
-            memcpy (aux, &get_sim_info_ctx->imsi[3], mnc_length);
+        if (strlen (imsi) >= (3 + mnc_length)) {
+            memcpy (aux, &imsi[3], mnc_length);
             aux[mnc_length] = '\0';
-            get_sim_info_ctx->mnc = atoi (aux);
+            *mnc = atoi (aux);
         }
     }
-
-    /* And go on */
-    get_sim_info_ctx->step++;
-    get_sim_info_step (ctx);
 }
 
 static void
-sim_info_efimsi_ready (RmfdPortProcessorQmi *self,
-                       GAsyncResult         *res,
-                       RunContext           *ctx)
+get_sim_info_complete (GetSimInfoContext *sim_info_ctx)
 {
-    GetSimInfoContext *get_sim_info_ctx = (GetSimInfoContext *)ctx->additional_context;
-    g_autoptr(GArray) read_result = NULL;
-    g_autofree gchar *imsi = NULL;
+    g_autoptr(GArray) plmns = NULL;
+    guint32 mcc;
+    guint32 mnc;
 
-    read_result = common_read_sim_file_finish (self, res, NULL);
-    if (read_result)
-        imsi = read_bcd_encoded_string ((const guint8 *) read_result->data, read_result->len);
+    g_assert (sim_info_ctx->ctx);
 
-    if (!imsi || strlen (imsi) < 3) {
-        /* Ignore these errors; just will set mcc/mnc to 0. And ignore reading
-         * EFad, as it won't be needed. */
-        get_sim_info_ctx->step = GET_SIM_INFO_STEP_EFAD + 1;
-        get_sim_info_step (ctx);
-        return;
+    if (sim_info_ctx->efoplmnwact_timeout_id) {
+        g_source_remove (sim_info_ctx->efoplmnwact_timeout_id);
+        sim_info_ctx->efoplmnwact_timeout_id = 0;
     }
 
-    /* Skip length byte and parity nibble in EFimsi */
-    get_sim_info_ctx->imsi = g_strdup (imsi + 3);
+    parse_mccmnc (sim_info_ctx->efimsi, sim_info_ctx->efad, &mcc, &mnc);
 
-    /* And go on */
-    get_sim_info_ctx->step++;
-    get_sim_info_step (ctx);
-}
+    /* Enable for testing */
+#if 0
+    {
+        static const guint8 example[] = {
+            0x21, 0x40, 0x3F, 0x40, 0x00, /* MCC:214, MNC:03, LTE */
+            0x21, 0x40, 0x3F, 0x80, 0x80, /* MCC:214, MNC:03, GSM, UMTS */
+            0x21, 0x40, 0x3F, 0xC0, 0x80, /* MCC:214, MNC:03, GSM, UMTS, LTE */
+        };
 
-static void
-get_sim_info_step (RunContext *ctx)
-{
-    GetSimInfoContext *get_sim_info_ctx = (GetSimInfoContext *)ctx->additional_context;
+        plmns = parse_plmns (example, G_N_ELEMENTS (example));
+    }
+#else
+    if (sim_info_ctx->efoplmnwact)
+        plmns = parse_plmns ((const guint8 *) sim_info_ctx->efoplmnwact->data, sim_info_ctx->efoplmnwact->len);
+#endif
 
-    switch (get_sim_info_ctx->step) {
-    case GET_SIM_INFO_STEP_FIRST:
-        get_sim_info_ctx->step++;
-        /* fall through */
+    run_context_complete_with_response (sim_info_ctx->ctx,
+                                        rmf_message_get_sim_info_response_new (mcc,
+                                                                               mnc,
+                                                                               plmns ? plmns->len : 0,
+                                                                               plmns ? (const RmfPlmnInfo *)plmns->data : NULL));
+    sim_info_ctx->ctx = NULL;
+}
 
-    case GET_SIM_INFO_STEP_IMSI:
-        common_read_sim_file (ctx->self,
-                              "EFimsi",
-                              (GAsyncReadyCallback)sim_info_efimsi_ready,
-                              ctx);
-        return;
+static gboolean
+sim_info_efoplmnwact_timeout (GetSimInfoContext *sim_info_ctx)
+{
+    g_debug ("EFoplmnwact not read yet: sending SIM info without PLMNs");
+    sim_info_ctx->efoplmnwact_timeout_id = 0;
+    get_sim_info_complete (sim_info_ctx);
+    return G_SOURCE_REMOVE;
+}
 
-    case GET_SIM_INFO_STEP_EFAD:
-        common_read_sim_file (ctx->self,
-                              "EFad",
-                              (GAsyncReadyCallback)sim_info_efad_ready,
-                              ctx);
+static void
+get_sim_info_check (GetSimInfoContext *sim_info_ctx)
+{
+    /* Already replied */
+    if (!sim_info_ctx->ctx)
         return;
 
-    case GET_SIM_INFO_STEP_EFOPLMNWACT:
-        common_read_sim_file (ctx->self,
-                              "EFoplmnwact",
-                              (GAsyncReadyCallback)sim_info_efoplmnwact_ready,
-                              ctx);
+    if (!sim_info_ctx->efimsi_done || !sim_info_ctx->efad_done)
         return;
 
-    case GET_SIM_INFO_STEP_LAST: {
-        /* Build result */
-        guint8 *response;
-
-        response = rmf_message_get_sim_info_response_new (get_sim_info_ctx->mcc,
-                                                          get_sim_info_ctx->mnc,
-                                                          get_sim_info_ctx->plmns ? get_sim_info_ctx->plmns->len : 0,
-                                                          get_sim_info_ctx->plmns ? (const RmfPlmnInfo *)get_sim_info_ctx->plmns->data : NULL);
-        g_simple_async_result_set_op_res_gpointer (ctx->result,
-                                                   g_byte_array_new_take (response, rmf_message_get_length (response)),
-                                                   (GDestroyNotify)g_byte_array_unref);
-        run_context_complete_and_free (ctx);
+    if (sim_info_ctx->efoplmnwact_done) {
+        get_sim_info_complete (sim_info_ctx);
         return;
     }
 
-    default:
-        break;
-    }
-
-    g_assert_not_reached ();
+    if (!sim_info_ctx->efoplmnwact_timeout_id)
+        sim_info_ctx->efoplmnwact_timeout_id = g_timeout_add (SIM_INFO_EFOPLMNWACT_GRACE_TIMEOUT_MS,
+                                                              (GSourceFunc) sim_info_efoplmnwact_timeout,
+                                                              sim_info_ctx);
 }
 
 static void
-get_sim_info (RunContext *ctx)
+sim_info_read_ready (RmfdPortProcessorQmi *self,
+                     GAsyncResult         *res,
+                     GetSimInfoContext    *sim_info_ctx)
 {
-    GetSimInfoContext *get_sim_info_ctx;
+    ReadSimFileContext *read_ctx;
+    GArray *read_result;
+    GError *error = NULL;
 
-    get_sim_info_ctx = g_new0 (GetSimInfoContext, 1);
-    get_sim_info_ctx->step = GET_SIM_INFO_STEP_FIRST;
-    run_context_set_additional_context (ctx,
-                                        get_sim_info_ctx,
-                                        (GDestroyNotify)get_sim_info_context_free);
+    read_ctx = g_task_get_task_data (G_TASK (res));
+    read_result = common_read_sim_file_finish (self, res, &error);
+    if (!read_result) {
+        g_debug ("couldn't read %s: %s", read_ctx->filename, error->message);
+        g_error_free (error);
+    }
+
+    if (g_str_equal (read_ctx->filename, "EFimsi")) {
+        sim_info_ctx->efimsi = read_result;
+        sim_info_ctx->efimsi_done = TRUE;
+    } else if (g_str_equal (read_ctx->filename, "EFad")) {
+        sim_info_ctx->efad = read_result;
+        sim_info_ctx->efad_done = TRUE;
+    } else if (g_str_equal (read_ctx->filename, "EFoplmnwact")) {
+        sim_info_ctx->efoplmnwact = read_result;
+        sim_info_ctx->efoplmnwact_done = TRUE;
+    } else
+        g_assert_not_reached ();
+
+    get_sim_info_check (sim_info_ctx);
+    get_sim_info_context_unref (sim_info_ctx);
+}
+
+static void
+get_sim_info (RunContext *ctx)
+{
+    GetSimInfoContext *sim_info_ctx;
+
+    sim_info_ctx = g_slice_new0 (GetSimInfoContext);
+    sim_info_ctx->ref_count = 1;
+    sim_info_ctx->ctx = ctx;
+
+    common_read_sim_file (ctx->self,
+                          "EFimsi",
+                          (GAsyncReadyCallback)sim_info_read_ready,
+                          get_sim_info_context_ref (sim_info_ctx));
+    common_read_sim_file (ctx->self,
+                          "EFad",
+                          (GAsyncReadyCallback)sim_info_read_ready,
+                          get_sim_info_context_ref (sim_info_ctx));
+    common_read_sim_file (ctx->self,
+                          "EFoplmnwact",
+                          (GAsyncReadyCallback)sim_info_read_ready,
+                          get_sim_info_context_ref (sim_info_ctx));
 
-    get_sim_info_step (ctx);
+    get_sim_info_context_unref (sim_info_ctx);
 }
 
 /**********************/
@@ -1540,12 +2655,13 @@ get_sim_info (RunContext *ctx)
 typedef struct {
     RmfdPortProcessorQmi *self;
     GSimpleAsyncResult *simple;
+    guint generation;
 } CommonUnlockCheckContext;
 
 static void
 common_unlock_check_context_complete_and_free (CommonUnlockCheckContext *ctx)
 {
-    g_simple_async_result_complete (ctx->simple);
+    g_simple_async_result_complete_in_idle (ctx->simple);
     g_object_unref (ctx->simple);
     g_object_unref (ctx->self);
     g_slice_free (CommonUnlockCheckContext, ctx);
@@ -1743,8 +2859,15 @@ get_card_status_ready (QmiClientUim *client,
 out:
     if (error)
         g_simple_async_result_take_error (ctx->simple, error);
-    else
+    else {
+        /* Only cache if the indications will tell us when it changes */
+        if (ctx->generation == ctx->self->priv->card_status_generation &&
+            ctx->self->priv->card_status_indications_enabled) {
+            ctx->self->priv->card_status_valid = TRUE;
+            ctx->self->priv->card_status_unlocked = unlocked;
+        }
         g_simple_async_result_set_op_res_gboolean (ctx->simple, unlocked);
+    }
     if (output)
         qmi_message_uim_get_card_status_output_unref (output);
     common_unlock_check_context_complete_and_free (ctx);
@@ -1760,12 +2883,20 @@ common_unlock_check (RmfdPortProcessorQmi *self,
     ctx = g_slice_new0 (CommonUnlockCheckContext);
     ctx->self = g_object_ref (self);
     ctx->simple = g_simple_async_result_new (G_OBJECT (self), callback, user_data, common_unlock_check);
+    ctx->generation = self->priv->card_status_generation;
+
+    if (self->priv->card_status_valid) {
+        g_simple_async_result_set_op_res_gboolean (ctx->simple, self->priv->card_status_unlocked);
+        common_unlock_check_context_complete_and_free (ctx);
+        return;
+    }
+
     qmi_client_uim_get_card_status (QMI_CLIENT_UIM (peek_qmi_client (ctx->self, QMI_SERVICE_UIM)),
                                     NULL,
                                     5,
                                     NULL,
-                                    (GAsyncReadyCallback) get_card_status_ready,
-                                    ctx);
+                                    (GAsyncReadyCallback) qmi_transaction_ready,
+                                    qmi_transaction_new (QMI_SERVICE_UIM, 5, (GAsyncReadyCallback) get_card_status_ready, ctx));
 }
 
 /**********************/
@@ -1804,8 +2935,13 @@ is_sim_locked (RunContext *ctx)
 /**********************/
 /* Unlock PIN */
 
+/* After a successful PIN verification the card takes a while to report the
+ * application as ready. The check is retried whenever a card status
+ * indication arrives, and periodically as a fallback in case none does. */
+
 typedef struct {
     guint after_unlock_checks;
+    guint timeout_id;
 } UnlockPinContext;
 
 static void run_after_unlock_checks (RunContext *ctx);
@@ -1825,6 +2961,7 @@ after_unlock_check_ready (RmfdPortProcessorQmi *self,
     }
 
     /* Unlocked! */
+    self->priv->card_status_unlock_waiting = g_list_remove (self->priv->card_status_unlock_waiting, ctx);
     response = rmf_message_unlock_response_new ();
     g_simple_async_result_set_op_res_gpointer (ctx->result,
                                                g_byte_array_new_take (response, rmf_message_get_length (response)),
@@ -1842,18 +2979,39 @@ after_unlock_check_ready (RmfdPortProcessorQmi *self,
 static gboolean
 after_unlock_check_cb (RunContext *ctx)
 {
+    UnlockPinContext *unlock_ctx = (UnlockPinContext *)ctx->additional_context;
+
+    unlock_ctx->timeout_id = 0;
     common_unlock_check (ctx->self,
                          (GAsyncReadyCallback)after_unlock_check_ready,
                          ctx);
     return FALSE;
 }
 
+static void
+after_unlock_wake (RmfdPortProcessorQmi *self)
+{
+    GList *l;
+
+    /* Only those waiting for the next poll; the others have a check ongoing */
+    for (l = self->priv->card_status_unlock_waiting; l; l = g_list_next (l)) {
+        RunContext       *ctx = (RunContext *)l->data;
+        UnlockPinContext *unlock_ctx = (UnlockPinContext *)ctx->additional_context;
+
+        if (unlock_ctx->timeout_id) {
+            g_source_remove (unlock_ctx->timeout_id);
+            after_unlock_check_cb (ctx);
+        }
+    }
+}
+
 static void
 run_after_unlock_checks (RunContext *ctx)
 {
     UnlockPinContext *unlock_ctx = (UnlockPinContext *)ctx->additional_context;
 
     if (unlock_ctx->after_unlock_checks == 20) {
+        ctx->self->priv->card_status_unlock_waiting = g_list_remove (ctx->self->priv->card_status_unlock_waiting, ctx);
         g_simple_async_result_set_error (ctx->result,
                                          RMFD_ERROR,
                                          RMFD_ERROR_UNKNOWN,
@@ -1864,7 +3022,7 @@ run_after_unlock_checks (RunContext *ctx)
 
     /* Recheck lock status. The change is not immediate */
     unlock_ctx->after_unlock_checks++;
-    g_timeout_add (500, (GSourceFunc)after_unlock_check_cb, ctx);
+    unlock_ctx->timeout_id = g_timeout_add (500, (GSourceFunc)after_unlock_check_cb, ctx);
 }
 
 static void
@@ -1893,8 +3051,13 @@ uim_verify_pin_ready (QmiClientUim *client,
     }
 
     qmi_message_uim_verify_pin_output_unref (output);
+
+    /* Lock status changed, the cached one is no longer valid */
+    card_status_invalidate (ctx->self);
+
     unlock_ctx = g_new0 (UnlockPinContext, 1);
     run_context_set_additional_context (ctx, unlock_ctx, g_free);
+    ctx->self->priv->card_status_unlock_waiting = g_list_append (ctx->self->priv->card_status_unlock_waiting, ctx);
     run_after_unlock_checks (ctx);
 }
 
@@ -1946,8 +3109,8 @@ before_unlock_check_ready (RmfdPortProcessorQmi *self,
                                input,
                                5,
                                NULL,
-                               (GAsyncReadyCallback) uim_verify_pin_ready,
-                               ctx);
+                               (GAsyncReadyCallback) qmi_transaction_ready,
+                               qmi_transaction_new (QMI_SERVICE_UIM, 5, (GAsyncReadyCallback) uim_verify_pin_ready, ctx));
     qmi_message_uim_verify_pin_input_unref (input);
 }
 
@@ -2035,8 +3198,8 @@ enable_pin (RunContext *ctx)
                                        input,
                                        5,
                                        NULL,
-                                       (GAsyncReadyCallback)uim_set_pin_protection_ready,
-                                       ctx);
+                                       (GAsyncReadyCallback) qmi_transaction_ready,
+                                       qmi_transaction_new (QMI_SERVICE_UIM, 5, (GAsyncReadyCallback)uim_set_pin_protection_ready, ctx));
     qmi_message_uim_set_pin_protection_input_unref (input);
 }
 
@@ -2115,8 +3278,8 @@ change_pin (RunContext *ctx)
                                input,
                                5,
                                NULL,
-                               (GAsyncReadyCallback)uim_change_pin_ready,
-                               ctx);
+                               (GAsyncReadyCallback) qmi_transaction_ready,
+                               qmi_transaction_new (QMI_SERVICE_UIM, 5, (GAsyncReadyCallback)uim_change_pin_ready, ctx));
     qmi_message_uim_change_pin_input_unref (input);
 }
 
@@ -2183,8 +3346,8 @@ get_power_status (RunContext *ctx)
                                        NULL,
                                        5,
                                        NULL,
-                                       (GAsyncReadyCallback)dms_get_operating_mode_ready,
-                                       ctx);
+                                       (GAsyncReadyCallback) qmi_transaction_ready,
+                                       qmi_transaction_new (QMI_SERVICE_DMS, 5, (GAsyncReadyCallback)dms_get_operating_mode_ready, ctx));
 }
 
 /**********************/
@@ -2267,8 +3430,8 @@ set_power_status (RunContext *ctx)
                                        input,
                                        20,
                                        NULL,
-                                       (GAsyncReadyCallback)dms_set_operating_mode_ready,
-                                       ctx);
+                                       (GAsyncReadyCallback) qmi_transaction_ready,
+                                       qmi_transaction_new (QMI_SERVICE_DMS, 20, (GAsyncReadyCallback)dms_set_operating_mode_ready, ctx));
     qmi_message_dms_set_operating_mode_input_unref (input);
 }
 
@@ -2339,8 +3502,8 @@ dms_power_cycle_set_operating_mode_offline_ready (QmiClientDms *client,
                                        input,
                                        20,
                                        NULL,
-                                       (GAsyncReadyCallback)dms_power_cycle_set_operating_mode_reset_ready,
-                                       ctx);
+                                       (GAsyncReadyCallback) qmi_transaction_ready,
+                                       qmi_transaction_new (QMI_SERVICE_DMS, 20, (GAsyncReadyCallback)dms_power_cycle_set_operating_mode_reset_ready, ctx));
     qmi_message_dms_set_operating_mode_input_unref (input);
 }
 
@@ -2356,8 +3519,8 @@ power_cycle (RunContext *ctx)
                                        input,
                                        20,
                                        NULL,
-                                       (GAsyncReadyCallback)dms_power_cycle_set_operating_mode_offline_ready,
-                                       ctx);
+                                       (GAsyncReadyCallback) qmi_transaction_ready,
+                                       qmi_transaction_new (QMI_SERVICE_DMS, 20, (GAsyncReadyCallback)dms_power_cycle_set_operating_mode_offline_ready, ctx));
     qmi_message_dms_set_operating_mode_input_unref (input);
 }
 
@@ -2365,51 +3528,52 @@ power_cycle (RunContext *ctx)
 /* Get power info */
 
 typedef struct {
-    gboolean gsm_run;
-    guint32 gsm_in_traffic;
-    gint32 gsm_tx_power;
-    guint32 gsm_rx0_radio_tuned;
-    gint32 gsm_rx0_power;
-    guint32 gsm_rx1_radio_tuned;
-    gint32 gsm_rx1_power;
-    gboolean umts_run;
-    guint32 umts_in_traffic;
-    gint32 umts_tx_power;
-    guint32 umts_rx0_radio_tuned;
-    gint32 umts_rx0_power;
-    guint32 umts_rx1_radio_tuned;
-    gint32 umts_rx1_power;
-    gboolean lte_run;
-    guint32 lte_in_traffic;
-    gint32 lte_tx_power;
-    guint32 lte_rx0_radio_tuned;
-    gint32 lte_rx0_power;
-    guint32 lte_rx1_radio_tuned;
-    gint32 lte_rx1_power;
+    guint32 in_traffic;
+    gint32 tx_power;
+    guint32 rx0_radio_tuned;
+    gint32 rx0_power;
+    guint32 rx1_radio_tuned;
+    gint32 rx1_power;
+} PowerInfo;
+
+typedef struct {
+    /* Indexed by RmfRadioInterface */
+    PowerInfo info[RMF_RADIO_INTERFACE_LTE + 1];
+    guint n_pending;
 } GetPowerInfoContext;
 
+typedef struct {
+    RunContext *ctx;
+    RmfRadioInterface interface;
+} GetTxRxInfoContext;
+
 static void
 get_power_info_context_free (GetPowerInfoContext *ctx)
 {
     g_slice_free (GetPowerInfoContext, ctx);
 }
 
-static void get_next_power_info (RunContext *ctx);
-
 static void
-nas_get_tx_rx_info_ready (QmiClientNas *client,
-                          GAsyncResult *res,
-                          RunContext   *ctx)
+nas_get_tx_rx_info_ready (QmiClientNas       *client,
+                          GAsyncResult       *res,
+                          GetTxRxInfoContext *tx_rx_ctx)
 {
+    RunContext *ctx;
     GetPowerInfoContext *additional_context;
+    PowerInfo *info;
     QmiMessageNasGetTxRxInfoOutput *output;
     GError *error = NULL;
     gboolean is_radio_tuned;
     gboolean is_in_traffic;
     gint32 power;
 
+    ctx = tx_rx_ctx->ctx;
     additional_context = (GetPowerInfoContext *)ctx->additional_context;
+    info = &additional_context->info[tx_rx_ctx->interface];
+    g_slice_free (GetTxRxInfoContext, tx_rx_ctx);
 
+    /* Failures for a given radio interface are not fatal, the interface is
+     * just reported as not tuned and not in traffic */
     output = qmi_client_nas_get_tx_rx_info_finish (client, res, &error);
     if (output && qmi_message_nas_get_tx_rx_info_output_get_result (output, NULL)) {
         /* RX Channel 0 */
@@ -2422,20 +3586,9 @@ nas_get_tx_rx_info_ready (QmiClientNas *client,
                 NULL,
                 NULL,
                 NULL)) {
-            if (!additional_context->gsm_run) {
-                additional_context->gsm_rx0_radio_tuned = is_radio_tuned;
-                if (additional_context->gsm_rx0_radio_tuned)
-                    additional_context->gsm_rx0_power = power;
-            } else if (!additional_context->umts_run) {
-                additional_context->umts_rx0_radio_tuned = is_radio_tuned;
-                if (additional_context->umts_rx0_radio_tuned)
-                    additional_context->umts_rx0_power = power;
-            } else if (!additional_context->lte_run) {
-                additional_context->lte_rx0_radio_tuned = is_radio_tuned;
-                if (additional_context->lte_rx0_radio_tuned)
-                    additional_context->lte_rx0_power = power;
-            } else
-                g_assert_not_reached ();
+            info->rx0_radio_tuned = is_radio_tuned;
+            if (info->rx0_radio_tuned)
+                info->rx0_power = power;
         }
 
         /* RX Channel 1 */
@@ -2448,20 +3601,9 @@ nas_get_tx_rx_info_ready (QmiClientNas *client,
                 NULL,
                 NULL,
                 NULL)) {
-            if (!additional_context->gsm_run) {
-                additional_context->gsm_rx1_radio_tuned = is_radio_tuned;
-                if (additional_context->gsm_rx1_radio_tuned)
-                    additional_context->gsm_rx1_power = power;
-            } else if (!additional_context->umts_run) {
-                additional_context->umts_rx1_radio_tuned = is_radio_tuned;
-                if (additional_context->umts_rx1_radio_tuned)
-                    additional_context->umts_rx1_power = power;
-            } else if (!additional_context->lte_run) {
-                additional_context->lte_rx1_radio_tuned = is_radio_tuned;
-                if (additional_context->lte_rx1_radio_tuned)
-                    additional_context->lte_rx1_power = power;
-            } else
-                g_assert_not_reached ();
+            info->rx1_radio_tuned = is_radio_tuned;
+            if (info->rx1_radio_tuned)
+                info->rx1_power = power;
         }
 
         /* TX Channel */
@@ -2470,109 +3612,111 @@ nas_get_tx_rx_info_ready (QmiClientNas *client,
                 &is_in_traffic,
                 &power,
                 NULL)) {
-            if (!additional_context->gsm_run) {
-                additional_context->gsm_in_traffic = is_in_traffic;
-                if (additional_context->gsm_in_traffic)
-                    additional_context->gsm_tx_power = power;
-            } else if (!additional_context->umts_run) {
-                additional_context->umts_in_traffic = is_in_traffic;
-                if (additional_context->umts_in_traffic)
-                    additional_context->umts_tx_power = power;
-            } else if (!additional_context->lte_run) {
-                additional_context->lte_in_traffic = is_in_traffic;
-                if (additional_context->lte_in_traffic)
-                    additional_context->lte_tx_power = power;
-            } else
-                g_assert_not_reached ();
+            info->in_traffic = is_in_traffic;
+            if (info->in_traffic)
+                info->tx_power = power;
         }
     }
 
-    if (!additional_context->gsm_run)
-        additional_context->gsm_run = TRUE;
-    else if (!additional_context->umts_run)
-        additional_context->umts_run = TRUE;
-    else if (!additional_context->lte_run)
-        additional_context->lte_run = TRUE;
-    else
-        g_assert_not_reached ();
-
+    if (error)
+        g_error_free (error);
     if (output)
         qmi_message_nas_get_tx_rx_info_output_unref (output);
 
-    get_next_power_info (ctx);
+    g_assert (additional_context->n_pending > 0);
+    if (--additional_context->n_pending > 0)
+        return;
+
+    /* All done */
+    run_context_complete_with_response (ctx, rmf_message_get_power_info_response_new (
+                                            additional_context->info[RMF_RADIO_INTERFACE_GSM].in_traffic,
+                                            additional_context->info[RMF_RADIO_INTERFACE_GSM].tx_power,
+                                            additional_context->info[RMF_RADIO_INTERFACE_GSM].rx0_radio_tuned,
+                                            additional_context->info[RMF_RADIO_INTERFACE_GSM].rx0_power,
+                                            additional_context->info[RMF_RADIO_INTERFACE_GSM].rx1_radio_tuned,
+                                            additional_context->info[RMF_RADIO_INTERFACE_GSM].rx1_power,
+                                            additional_context->info[RMF_RADIO_INTERFACE_UMTS].in_traffic,
+                                            additional_context->info[RMF_RADIO_INTERFACE_UMTS].tx_power,
+                                            additional_context->info[RMF_RADIO_INTERFACE_UMTS].rx0_radio_tuned,
+                                            additional_context->info[RMF_RADIO_INTERFACE_UMTS].rx0_power,
+                                            additional_context->info[RMF_RADIO_INTERFACE_UMTS].rx1_radio_tuned,
+                                            additional_context->info[RMF_RADIO_INTERFACE_UMTS].rx1_power,
+                                            additional_context->info[RMF_RADIO_INTERFACE_LTE].in_traffic,
+                                            additional_context->info[RMF_RADIO_INTERFACE_LTE].tx_power,
+                                            additional_context->info[RMF_RADIO_INTERFACE_LTE].rx0_radio_tuned,
+                                            additional_context->info[RMF_RADIO_INTERFACE_LTE].rx0_power,
+                                            additional_context->info[RMF_RADIO_INTERFACE_LTE].rx1_radio_tuned,
+                                            additional_context->info[RMF_RADIO_INTERFACE_LTE].rx1_power));
+}
+
+static QmiNasRadioInterface
+rmf_radio_interface_to_qmi (RmfRadioInterface interface)
+{
+    switch (interface) {
+    case RMF_RADIO_INTERFACE_GSM:
+        return QMI_NAS_RADIO_INTERFACE_GSM;
+    case RMF_RADIO_INTERFACE_UMTS:
+        return QMI_NAS_RADIO_INTERFACE_UMTS;
+    case RMF_RADIO_INTERFACE_LTE:
+        return QMI_NAS_RADIO_INTERFACE_LTE;
+    default:
+        g_assert_not_reached ();
+        return QMI_NAS_RADIO_INTERFACE_UNKNOWN;
+    }
 }
 
 static void
-get_next_power_info (RunContext *ctx)
+get_power_info (RunContext *ctx)
 {
     GetPowerInfoContext *additional_context;
-    QmiNasRadioInterface interface;
-    guint8 *response;
+    guint32 radio_interfaces;
+    guint i;
 
-    additional_context = (GetPowerInfoContext *)ctx->additional_context;
+    rmf_message_get_power_info_request_parse (ctx->request->data, &radio_interfaces);
+    radio_interfaces &= RMF_RADIO_INTERFACE_MASK_ALL;
+    if (!radio_interfaces) {
+        g_simple_async_result_set_error (ctx->result,
+                                         RMFD_ERROR,
+                                         RMFD_ERROR_INVALID_INPUT,
+                                         "No radio interface requested");
+        run_context_complete_and_free (ctx);
+        return;
+    }
 
-    if (!additional_context->gsm_run)
-        interface = QMI_NAS_RADIO_INTERFACE_GSM;
-    else if (!additional_context->umts_run)
-        interface = QMI_NAS_RADIO_INTERFACE_UMTS;
-    else if (!additional_context->lte_run)
-        interface = QMI_NAS_RADIO_INTERFACE_LTE;
-    else
-        interface = QMI_NAS_RADIO_INTERFACE_UNKNOWN;
+    additional_context = g_slice_new0 (GetPowerInfoContext);
+    run_context_set_additional_context (ctx,
+                                        additional_context,
+                                        (GDestroyNotify)get_power_info_context_free);
+
+    /* Count all requests before launching any, so that no early reply
+     * completes the operation */
+    for (i = RMF_RADIO_INTERFACE_GSM; i <= RMF_RADIO_INTERFACE_LTE; i++) {
+        if (radio_interfaces & RMF_RADIO_INTERFACE_MASK (i))
+            additional_context->n_pending++;
+    }
 
-    /* Request next */
-    if (interface != QMI_NAS_RADIO_INTERFACE_UNKNOWN) {
+    /* All requested radio interfaces are queried at the same time */
+    for (i = RMF_RADIO_INTERFACE_GSM; i <= RMF_RADIO_INTERFACE_LTE; i++) {
         QmiMessageNasGetTxRxInfoInput *input;
+        GetTxRxInfoContext *tx_rx_ctx;
+
+        if (!(radio_interfaces & RMF_RADIO_INTERFACE_MASK (i)))
+            continue;
+
+        tx_rx_ctx = g_slice_new (GetTxRxInfoContext);
+        tx_rx_ctx->ctx = ctx;
+        tx_rx_ctx->interface = (RmfRadioInterface) i;
 
         input = qmi_message_nas_get_tx_rx_info_input_new ();
-        qmi_message_nas_get_tx_rx_info_input_set_radio_interface (input, interface, NULL);
+        qmi_message_nas_get_tx_rx_info_input_set_radio_interface (input, rmf_radio_interface_to_qmi (i), NULL);
         qmi_client_nas_get_tx_rx_info (QMI_CLIENT_NAS (peek_qmi_client (ctx->self, QMI_SERVICE_NAS)),
                                        input,
                                        10,
                                        NULL,
-                                       (GAsyncReadyCallback)nas_get_tx_rx_info_ready,
-                                       ctx);
+                                       (GAsyncReadyCallback) qmi_transaction_ready,
+                                       qmi_transaction_new (QMI_SERVICE_NAS, 10, (GAsyncReadyCallback)nas_get_tx_rx_info_ready, tx_rx_ctx));
         qmi_message_nas_get_tx_rx_info_input_unref (input);
-        return;
     }
-
-    /* All done */
-    response = (rmf_message_get_power_info_response_new (
-                    additional_context->gsm_in_traffic,
-                    additional_context->gsm_tx_power,
-                    additional_context->gsm_rx0_radio_tuned,
-                    additional_context->gsm_rx0_power,
-                    additional_context->gsm_rx1_radio_tuned,
-                    additional_context->gsm_rx1_power,
-                    additional_context->umts_in_traffic,
-                    additional_context->umts_tx_power,
-                    additional_context->umts_rx0_radio_tuned,
-                    additional_context->umts_rx0_power,
-                    additional_context->umts_rx1_radio_tuned,
-                    additional_context->umts_rx1_power,
-                    additional_context->lte_in_traffic,
-                    additional_context->lte_tx_power,
-                    additional_context->lte_rx0_radio_tuned,
-                    additional_context->lte_rx0_power,
-                    additional_context->lte_rx1_radio_tuned,
-                    additional_context->lte_rx1_power));
-    g_simple_async_result_set_op_res_gpointer (ctx->result,
-                                               g_byte_array_new_take (response, rmf_message_get_length (response)),
-                                               (GDestroyNotify)g_byte_array_unref);
-    run_context_complete_and_free (ctx);
-}
-
-static void
-get_power_info (RunContext *ctx)
-{
-    GetPowerInfoContext *additional_context;
-
-    additional_context = g_slice_new0 (GetPowerInfoContext);
-    run_context_set_additional_context (ctx,
-                                        additional_context,
-                                        (GDestroyNotify)get_power_info_context_free);
-
-    get_next_power_info (ctx);
 }
 
 /**********************/
@@ -2582,69 +3726,110 @@ get_power_info (RunContext *ctx)
 #define STRENGTH_TO_QUALITY(strength)                                   \
     (guint8)(100 - ((CLAMP (strength, -113, -51) + 51) * 100 / (-113 + 51)))
 
+/* Signal info is served from the values kept up to date by the NAS signal
+ * info indications. As these are only emitted when a RSSI threshold is
+ * crossed, values older than SIGNAL_INFO_MAX_AGE_SECS are refreshed with
+ * an explicit query, shared by all requests waiting for it. */
+
 static void
-nas_get_signal_info_ready (QmiClientNas *client,
-                           GAsyncResult *res,
-                           RunContext   *ctx)
+get_signal_info_complete (RunContext *ctx)
+{
+    RmfdPortProcessorQmiPrivate *priv = ctx->self->priv;
+    guint32 quality[RMF_RADIO_INTERFACE_LTE + 1] = { 0 };
+    gint32 rssi[RMF_RADIO_INTERFACE_LTE + 1];
+    guint i;
+
+    for (i = RMF_RADIO_INTERFACE_GSM; i <= RMF_RADIO_INTERFACE_LTE; i++) {
+        if (priv->signal_available[i]) {
+            rssi[i] = priv->signal_rssi[i];
+            quality[i] = STRENGTH_TO_QUALITY (rssi[i]);
+        } else
+            rssi[i] = -125;
+    }
+
+    run_context_complete_with_response (ctx, rmf_message_get_signal_info_response_new (
+                                            priv->signal_available[RMF_RADIO_INTERFACE_GSM],
+                                            rssi[RMF_RADIO_INTERFACE_GSM],
+                                            quality[RMF_RADIO_INTERFACE_GSM],
+                                            priv->signal_available[RMF_RADIO_INTERFACE_UMTS],
+                                            rssi[RMF_RADIO_INTERFACE_UMTS],
+                                            quality[RMF_RADIO_INTERFACE_UMTS],
+                                            priv->signal_available[RMF_RADIO_INTERFACE_LTE],
+                                            rssi[RMF_RADIO_INTERFACE_LTE],
+                                            quality[RMF_RADIO_INTERFACE_LTE],
+                                            (g_get_monotonic_time () - priv->signal_info_time) / G_USEC_PER_SEC));
+}
+
+static void
+nas_get_signal_info_ready (QmiClientNas         *client,
+                           GAsyncResult         *res,
+                           RmfdPortProcessorQmi *self)
 {
     QmiMessageNasGetSignalInfoOutput *output;
     GError *error = NULL;
+    GList *waiting;
+    GList *l;
 
     output = qmi_client_nas_get_signal_info_finish (client, res, &error);
-    if (!output) {
+    if (!output)
         g_prefix_error (&error, "QMI operation failed: ");
-        g_simple_async_result_take_error (ctx->result, error);
-    } else if (!qmi_message_nas_get_signal_info_output_get_result (output, &error)) {
+    else if (!qmi_message_nas_get_signal_info_output_get_result (output, &error))
         g_prefix_error (&error, "couldn't get signal info: ");
-        g_simple_async_result_take_error (ctx->result, error);
-    } else {
-        guint8 *response;
-        gboolean gsm_available = FALSE;
-        gint8 gsm_rssi = -125;
-        guint32 gsm_quality = 0;
-        guint32 umts_available = FALSE;
-        gint8 umts_rssi = -125;
-        guint32 umts_quality = 0;
-        guint32 lte_available = FALSE;
-        gint8 lte_rssi = -125;
-        guint32 lte_quality = 0;
-
-        if (qmi_message_nas_get_signal_info_output_get_gsm_signal_strength (output, &gsm_rssi, NULL)) {
-            gsm_available = TRUE;
-            gsm_quality = STRENGTH_TO_QUALITY (gsm_rssi);
-        }
-        if (qmi_message_nas_get_signal_info_output_get_wcdma_signal_strength (output, &umts_rssi, NULL, NULL)) {
-            umts_available = TRUE;
-            umts_quality = STRENGTH_TO_QUALITY (umts_rssi);
-        }
-        if (qmi_message_nas_get_signal_info_output_get_lte_signal_strength (output, &lte_rssi, NULL, NULL, NULL, NULL)) {
-            lte_available = TRUE;
-            lte_quality = STRENGTH_TO_QUALITY (lte_rssi);
-        }
-
-        response = rmf_message_get_signal_info_response_new (gsm_available, gsm_rssi, gsm_quality,
-                                                             umts_available, umts_rssi, umts_quality,
-                                                             lte_available, lte_rssi, lte_quality);
-        g_simple_async_result_set_op_res_gpointer (ctx->result,
-                                                   g_byte_array_new_take (response, rmf_message_get_length (response)),
-                                                   (GDestroyNotify)g_byte_array_unref);
-    }
+    else
+        process_signal_info (self, output, NULL);
 
     if (output)
         qmi_message_nas_get_signal_info_output_unref (output);
 
-    run_context_complete_and_free (ctx);
+    self->priv->signal_info_refreshing = FALSE;
+    waiting = self->priv->signal_info_waiting;
+    self->priv->signal_info_waiting = NULL;
+    for (l = waiting; l; l = g_list_next (l)) {
+        RunContext *ctx = l->data;
+
+        if (error) {
+            g_simple_async_result_set_from_error (ctx->result, error);
+            run_context_complete_and_free (ctx);
+        } else
+            get_signal_info_complete (ctx);
+    }
+    g_list_free (waiting);
+
+    if (error) {
+        g_debug ("%s", error->message);
+        g_error_free (error);
+    }
+    g_object_unref (self);
 }
 
 static void
-get_signal_info (RunContext *ctx)
+signal_info_refresh (RmfdPortProcessorQmi *self)
 {
-    qmi_client_nas_get_signal_info (QMI_CLIENT_NAS (peek_qmi_client (ctx->self, QMI_SERVICE_NAS)),
+    if (self->priv->signal_info_refreshing)
+        return;
+
+    self->priv->signal_info_refreshing = TRUE;
+    qmi_client_nas_get_signal_info (QMI_CLIENT_NAS (peek_qmi_client (self, QMI_SERVICE_NAS)),
                                     NULL,
                                     10,
                                     NULL,
-                                    (GAsyncReadyCallback)nas_get_signal_info_ready,
-                                    ctx);
+                                    (GAsyncReadyCallback) qmi_transaction_ready,
+                                    qmi_transaction_new (QMI_SERVICE_NAS, 10, (GAsyncReadyCallback)nas_get_signal_info_ready, g_object_ref (self)));
+}
+
+static void
+get_signal_info (RunContext *ctx)
+{
+    RmfdPortProcessorQmiPrivate *priv = ctx->self->priv;
+
+    if (priv->signal_info_time &&
+        (g_get_monotonic_time () - priv->signal_info_time) < (SIGNAL_INFO_MAX_AGE_SECS * G_USEC_PER_SEC)) {
+        get_signal_info_complete (ctx);
+        return;
+    }
+
+    priv->signal_info_waiting = g_list_append (priv->signal_info_waiting, ctx);
+    signal_info_refresh (ctx->self);
 }
 
 /***************************/
@@ -2670,123 +3855,406 @@ get_registration_status (RunContext *ctx)
 }
 
 /****************************/
-/* Get registration timeout */
+/* Network scan */
+
+/* The scan is shared between the automatic registration, which launches it
+ * when the registration times out, and the explicit Scan Networks requests.
+ * Its results are kept so that they can be queried afterwards with Get
+ * Available Networks, without scanning again. */
+
+typedef struct {
+    guint16            mcc;
+    guint16            mnc;
+    RmfRadioInterface  radio_interface;
+    RmfNetworkStatus   status;
+    gchar             *description;
+} NetworkScanResult;
 
 static void
-get_registration_timeout (RunContext *ctx)
+network_scan_result_clear (NetworkScanResult *result)
 {
-    guint8 *response;
+    g_free (result->description);
+}
 
-    response = rmf_message_get_registration_timeout_response_new (ctx->self->priv->registration_timeout);
-    g_simple_async_result_set_op_res_gpointer (ctx->result,
-                                               g_byte_array_new_take (response, rmf_message_get_length (response)),
-                                               (GDestroyNotify)g_byte_array_unref);
-    run_context_complete_and_free (ctx);
+static RmfNetworkStatus
+network_status_from_qmi (QmiNasNetworkStatus status)
+{
+    if (status & QMI_NAS_NETWORK_STATUS_CURRENT_SERVING)
+        return RMF_NETWORK_STATUS_CURRENT;
+    if (status & QMI_NAS_NETWORK_STATUS_FORBIDDEN)
+        return RMF_NETWORK_STATUS_FORBIDDEN;
+    if (status & QMI_NAS_NETWORK_STATUS_AVAILABLE)
+        return RMF_NETWORK_STATUS_AVAILABLE;
+    return RMF_NETWORK_STATUS_UNKNOWN;
 }
 
-/****************************/
-/* Set registration timeout */
+static gboolean
+radio_interface_from_qmi (QmiNasRadioInterface  interface,
+                          RmfRadioInterface    *out)
+{
+    switch (interface) {
+    case QMI_NAS_RADIO_INTERFACE_GSM:
+        *out = RMF_RADIO_INTERFACE_GSM;
+        return TRUE;
+    case QMI_NAS_RADIO_INTERFACE_UMTS:
+        *out = RMF_RADIO_INTERFACE_UMTS;
+        return TRUE;
+    case QMI_NAS_RADIO_INTERFACE_LTE:
+        *out = RMF_RADIO_INTERFACE_LTE;
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
 
 static void
-set_registration_timeout (RunContext *ctx)
+network_scan_store (RmfdPortProcessorQmi           *self,
+                    QmiMessageNasNetworkScanOutput *output)
 {
-    guint8 *response;
-    guint32 timeout;
+    GArray *info = NULL;
+    GArray *rats = NULL;
+    guint   i;
 
-    rmf_message_set_registration_timeout_request_parse (ctx->request->data, &timeout);
+    g_array_set_size (self->priv->network_scan_results, 0);
+    self->priv->network_scan_time = g_get_real_time () / G_USEC_PER_SEC;
 
-    if (timeout < 10) {
-        g_simple_async_result_set_error (ctx->result,
-                                         RMFD_ERROR,
-                                         RMFD_ERROR_UNKNOWN,
-                                         "Timeout is too short");
-    } else {
-        ctx->self->priv->registration_timeout = timeout;
+    qmi_message_nas_network_scan_output_get_network_information (output, &info, NULL);
+    qmi_message_nas_network_scan_output_get_radio_access_technology (output, &rats, NULL);
+    if (!info || !rats)
+        return;
 
-        response = rmf_message_set_registration_timeout_response_new ();
-        g_simple_async_result_set_op_res_gpointer (ctx->result,
-                                                   g_byte_array_new_take (response, rmf_message_get_length (response)),
-                                                   (GDestroyNotify)g_byte_array_unref);
+    /* Each network is reported in both arrays, usually in the same order */
+    for (i = 0; i < info->len; i++) {
+        QmiMessageNasNetworkScanOutputNetworkInformationElement *info_element;
+        QmiMessageNasNetworkScanOutputRadioAccessTechnologyElement *rat_element = NULL;
+        NetworkScanResult result;
+        guint j;
+
+        info_element = &g_array_index (info, QmiMessageNasNetworkScanOutputNetworkInformationElement, i);
+        for (j = 0; j < rats->len; j++) {
+            QmiMessageNasNetworkScanOutputRadioAccessTechnologyElement *candidate;
+
+            candidate = &g_array_index (rats, QmiMessageNasNetworkScanOutputRadioAccessTechnologyElement, (i + j) % rats->len);
+            if (candidate->mcc == info_element->mcc && candidate->mnc == info_element->mnc) {
+                rat_element = candidate;
+                break;
+            }
+        }
+
+        if (!rat_element || !radio_interface_from_qmi (rat_element->radio_interface, &result.radio_interface)) {
+            g_debug ("ignoring scanned network %03u-%02u: unsupported radio interface",
+                     info_element->mcc, info_element->mnc);
+            continue;
+        }
+
+        result.mcc         = info_element->mcc;
+        result.mnc         = info_element->mnc;
+        result.status      = network_status_from_qmi (info_element->network_status);
+        result.description = g_strdup (info_element->description);
+        g_array_append_val (self->priv->network_scan_results, result);
     }
 
-    run_context_complete_and_free (ctx);
+    g_debug ("network scan found %u networks", self->priv->network_scan_results->len);
 }
 
-/**********************/
-/* Get connection status */
+static RmfNetworkInfo *
+network_scan_build_info (RmfdPortProcessorQmi *self)
+{
+    RmfNetworkInfo *networks;
+    guint           i;
+
+    networks = g_new0 (RmfNetworkInfo, self->priv->network_scan_results->len);
+    for (i = 0; i < self->priv->network_scan_results->len; i++) {
+        NetworkScanResult *result;
+
+        result = &g_array_index (self->priv->network_scan_results, NetworkScanResult, i);
+        networks[i].mcc             = result->mcc;
+        networks[i].mnc             = result->mnc;
+        networks[i].radio_interface = result->radio_interface;
+        networks[i].status          = result->status;
+        networks[i].description     = result->description;
+    }
+    return networks;
+}
+
+typedef struct {
+    RmfdPortProcessorQmi *self;
+    GCancellable         *cancellable;
+} NetworkScanContext;
 
 static void
-get_connection_status (RunContext *ctx)
+network_scan_context_free (NetworkScanContext *ctx)
 {
-    guint8 *response;
-
-    response = rmf_message_get_connection_status_response_new (ctx->self->priv->connection_status);
-    g_simple_async_result_set_op_res_gpointer (ctx->result,
-                                               g_byte_array_new_take (response, rmf_message_get_length (response)),
-                                               (GDestroyNotify)g_byte_array_unref);
-    run_context_complete_and_free (ctx);
+    g_object_unref (ctx->cancellable);
+    g_object_unref (ctx->self);
+    g_slice_free (NetworkScanContext, ctx);
 }
 
-/**********************/
-/* Get Connection Stats */
+static void
+network_scan_complete_waiting (RmfdPortProcessorQmi *self,
+                               const GError         *error)
+{
+    RmfNetworkInfo *networks = NULL;
+    GList *waiting;
+    GList *l;
+
+    /* Complete all explicit scan requests */
+    waiting = self->priv->network_scan_waiting;
+    self->priv->network_scan_waiting = NULL;
+    if (!error)
+        networks = network_scan_build_info (self);
+    for (l = waiting; l; l = g_list_next (l)) {
+        RunContext *ctx = (RunContext *)l->data;
+
+        if (error) {
+            g_simple_async_result_set_from_error (ctx->result, error);
+            run_context_complete_and_free (ctx);
+        } else
+            run_context_complete_with_response (ctx,
+                                                rmf_message_scan_networks_response_new ((guint32) self->priv->network_scan_time,
+                                                                                        self->priv->network_scan_results->len,
+                                                                                        networks));
+    }
+    g_list_free (waiting);
+    g_free (networks);
+}
 
 static void
-get_packet_statistics_ready (QmiClientWds *client,
-                             GAsyncResult *res,
-                             RunContext   *ctx)
+nas_network_scan_ready (QmiClientNas       *client,
+                        GAsyncResult       *res,
+                        NetworkScanContext *scan_ctx)
 {
+    RmfdPortProcessorQmi *self = scan_ctx->self;
+    RegistrationContext *registration_ctx = (RegistrationContext *)self->priv->registration_ctx;
+    QmiMessageNasNetworkScanOutput *output;
     GError *error = NULL;
-    QmiMessageWdsGetPacketStatisticsOutput *output;
+    gboolean cancelled;
 
-    output = qmi_client_wds_get_packet_statistics_finish (client, res, &error);
-    if (!output) {
-        g_prefix_error (&error, "QMI operation failed: ");
-        g_simple_async_result_take_error (ctx->result, error);
-    } else if (!qmi_message_wds_get_packet_statistics_output_get_result (output, &error)) {
-        g_prefix_error (&error, "couldn't get packet statistics: ");
-        g_simple_async_result_take_error (ctx->result, error);
-    } else {
-        guint8 *response;
-        guint32 tx_packets_ok = 0xFFFFFFFF;
-        guint32 rx_packets_ok = 0xFFFFFFFF;
-        guint32 tx_packets_error = 0xFFFFFFFF;
-        guint32 rx_packets_error = 0xFFFFFFFF;
-        guint32 tx_packets_overflow = 0xFFFFFFFF;
-        guint32 rx_packets_overflow = 0xFFFFFFFF;
-        guint64 tx_bytes_ok = 0;
-        guint64 rx_bytes_ok = 0;
-
-        qmi_message_wds_get_packet_statistics_output_get_tx_packets_ok (output, &tx_packets_ok, NULL);
-        qmi_message_wds_get_packet_statistics_output_get_rx_packets_ok (output, &rx_packets_ok, NULL);
-        qmi_message_wds_get_packet_statistics_output_get_tx_packets_error (output, &tx_packets_error, NULL);
-        qmi_message_wds_get_packet_statistics_output_get_rx_packets_error (output, &rx_packets_error, NULL);
-        qmi_message_wds_get_packet_statistics_output_get_tx_overflows (output, &tx_packets_overflow, NULL);
-        qmi_message_wds_get_packet_statistics_output_get_rx_overflows (output, &rx_packets_overflow, NULL);
-        qmi_message_wds_get_packet_statistics_output_get_tx_bytes_ok (output, &tx_bytes_ok, NULL);
-        qmi_message_wds_get_packet_statistics_output_get_rx_bytes_ok (output, &rx_bytes_ok, NULL);
-
-        response = rmf_message_get_connection_stats_response_new (tx_packets_ok,
-                                                                  rx_packets_ok,
-                                                                  tx_packets_error,
-                                                                  rx_packets_error,
-                                                                  tx_packets_overflow,
-                                                                  rx_packets_overflow,
-                                                                  tx_bytes_ok,
-                                                                  rx_bytes_ok);
-        g_simple_async_result_set_op_res_gpointer (ctx->result,
-                                                   g_byte_array_new_take (response, rmf_message_get_length (response)),
-                                                   (GDestroyNotify)g_byte_array_unref);
+    output = qmi_client_nas_network_scan_finish (client, res, &error);
+
+    /* Cancelled scan replaced by a new one, which owns the requests now */
+    if (scan_ctx->cancellable != self->priv->network_scan_cancellable) {
+        g_debug ("cancelled network scan finished");
+        if (output)
+            qmi_message_nas_network_scan_output_unref (output);
+        g_clear_error (&error);
+        network_scan_context_free (scan_ctx);
+        return;
     }
 
+    if (!output)
+        g_prefix_error (&error, "QMI operation failed: ");
+    else if (!qmi_message_nas_network_scan_output_get_result (output, &error))
+        g_prefix_error (&error, "couldn't scan networks: ");
+    else
+        network_scan_store (self, output);
     if (output)
-        qmi_message_wds_get_packet_statistics_output_unref (output);
-    run_context_complete_and_free (ctx);
-}
+        qmi_message_nas_network_scan_output_unref (output);
 
-static void
-get_connection_stats (RunContext *ctx)
-{
-    QmiMessageWdsGetPacketStatisticsInput *input;
+    cancelled = g_cancellable_is_cancelled (self->priv->network_scan_cancellable);
+    g_clear_object (&self->priv->network_scan_cancellable);
+
+    network_scan_complete_waiting (self, error);
+
+    /* Relaunch automatic registration without timeout, if it was waiting for
+     * this scan. A cancellation here always comes from a Cancel Network Scan
+     * request (the registration context is gone if it released the scan
+     * itself), and the registration must not be left stranded because of it. */
+    if (registration_ctx && registration_ctx->scanning) {
+        if (cancelled)
+            g_debug ("network scan cancelled: relaunching automatic network registration");
+        registration_context_cleanup (self);
+        initiate_registration (self, FALSE);
+    }
+
+    g_clear_error (&error);
+    network_scan_context_free (scan_ctx);
+}
+
+static void
+network_scan_start (RmfdPortProcessorQmi *self)
+{
+    NetworkScanContext *scan_ctx;
+
+    /* Single scan at a time, join the ongoing one unless it was cancelled */
+    if (self->priv->network_scan_cancellable) {
+        if (!g_cancellable_is_cancelled (self->priv->network_scan_cancellable)) {
+            g_debug ("network scan already ongoing");
+            return;
+        }
+
+        /* Requests waiting for the cancelled scan get the cancellation
+         * right away, and its results are ignored when it finishes */
+        g_debug ("network scan cancelled but not finished yet");
+        if (self->priv->network_scan_waiting) {
+            GError *error;
+
+            error = g_error_new (G_IO_ERROR, G_IO_ERROR_CANCELLED, "network scan cancelled");
+            network_scan_complete_waiting (self, error);
+            g_error_free (error);
+        }
+        g_clear_object (&self->priv->network_scan_cancellable);
+    }
+
+    g_debug ("launching network scan...");
+    self->priv->network_scan_cancellable = g_cancellable_new ();
+
+    scan_ctx = g_slice_new0 (NetworkScanContext);
+    scan_ctx->self        = g_object_ref (self);
+    scan_ctx->cancellable = g_object_ref (self->priv->network_scan_cancellable);
+
+    qmi_client_nas_network_scan (QMI_CLIENT_NAS (peek_qmi_client (self, QMI_SERVICE_NAS)),
+                                 NULL,
+                                 120,
+                                 self->priv->network_scan_cancellable,
+                                 (GAsyncReadyCallback) qmi_transaction_ready,
+                                 qmi_transaction_new (QMI_SERVICE_NAS, 120, (GAsyncReadyCallback)nas_network_scan_ready, scan_ctx));
+}
+
+static void
+network_scan_release (RmfdPortProcessorQmi *self)
+{
+    /* The registration no longer needs the scan; stop it unless explicitly
+     * requested */
+    if (self->priv->network_scan_cancellable && !self->priv->network_scan_waiting)
+        g_cancellable_cancel (self->priv->network_scan_cancellable);
+}
+
+static void
+get_available_networks (RunContext *ctx)
+{
+    RmfNetworkInfo *networks;
+
+    networks = network_scan_build_info (ctx->self);
+    run_context_complete_with_response (ctx,
+                                        rmf_message_get_available_networks_response_new (!!ctx->self->priv->network_scan_cancellable,
+                                                                                         (guint32) ctx->self->priv->network_scan_time,
+                                                                                         ctx->self->priv->network_scan_results->len,
+                                                                                         networks));
+    g_free (networks);
+}
+
+static void
+scan_networks (RunContext *ctx)
+{
+    /* Started before queueing the request, so that it doesn't wait for a
+     * cancelled scan */
+    network_scan_start (ctx->self);
+    ctx->self->priv->network_scan_waiting = g_list_append (ctx->self->priv->network_scan_waiting, ctx);
+}
+
+static void
+cancel_network_scan (RunContext *ctx)
+{
+    /* Waiting requests complete with the cancellation error */
+    if (ctx->self->priv->network_scan_cancellable)
+        g_cancellable_cancel (ctx->self->priv->network_scan_cancellable);
+
+    run_context_complete_with_response (ctx, rmf_message_cancel_network_scan_response_new ());
+}
+
+/****************************/
+/* Get registration timeout */
+
+static void
+get_registration_timeout (RunContext *ctx)
+{
+    guint8 *response;
+
+    response = rmf_message_get_registration_timeout_response_new (ctx->self->priv->registration_timeout);
+    g_simple_async_result_set_op_res_gpointer (ctx->result,
+                                               g_byte_array_new_take (response, rmf_message_get_length (response)),
+                                               (GDestroyNotify)g_byte_array_unref);
+    run_context_complete_and_free (ctx);
+}
+
+/****************************/
+/* Set registration timeout */
+
+static void
+set_registration_timeout (RunContext *ctx)
+{
+    guint8 *response;
+    guint32 timeout;
+
+    rmf_message_set_registration_timeout_request_parse (ctx->request->data, &timeout);
+
+    if (timeout < 10) {
+        g_simple_async_result_set_error (ctx->result,
+                                         RMFD_ERROR,
+                                         RMFD_ERROR_UNKNOWN,
+                                         "Timeout is too short");
+    } else {
+        ctx->self->priv->registration_timeout = timeout;
+
+        response = rmf_message_set_registration_timeout_response_new ();
+        g_simple_async_result_set_op_res_gpointer (ctx->result,
+                                                   g_byte_array_new_take (response, rmf_message_get_length (response)),
+                                                   (GDestroyNotify)g_byte_array_unref);
+    }
+
+    run_context_complete_and_free (ctx);
+}
+
+/**********************/
+/* Get connection status */
+
+static void
+get_connection_status (RunContext *ctx)
+{
+    guint8 *response;
+
+    response = rmf_message_get_connection_status_response_new (ctx->self->priv->connection_status);
+    g_simple_async_result_set_op_res_gpointer (ctx->result,
+                                               g_byte_array_new_take (response, rmf_message_get_length (response)),
+                                               (GDestroyNotify)g_byte_array_unref);
+    run_context_complete_and_free (ctx);
+}
+
+/**********************/
+/* Get Connection Stats */
+
+/* When WDS event reports are enabled, packet statistics are kept up to date
+ * by the modem itself, so they're only queried explicitly to seed the cache
+ * after each connection or disconnection. */
+
+static void
+packet_stats_reset (PacketStats *stats)
+{
+    stats->tx_packets_ok    = 0xFFFFFFFF;
+    stats->rx_packets_ok    = 0xFFFFFFFF;
+    stats->tx_packets_error = 0xFFFFFFFF;
+    stats->rx_packets_error = 0xFFFFFFFF;
+    stats->tx_overflows     = 0xFFFFFFFF;
+    stats->rx_overflows     = 0xFFFFFFFF;
+    stats->tx_bytes_ok      = 0;
+    stats->rx_bytes_ok      = 0;
+}
+
+static void
+packet_stats_invalidate (RmfdPortProcessorQmi *self)
+{
+    self->priv->packet_stats_valid = FALSE;
+}
+
+static void
+get_connection_stats_complete (RunContext        *ctx,
+                               const PacketStats *stats)
+{
+    run_context_complete_with_response (ctx, rmf_message_get_connection_stats_response_new (stats->tx_packets_ok,
+                                                                                             stats->rx_packets_ok,
+                                                                                             stats->tx_packets_error,
+                                                                                             stats->rx_packets_error,
+                                                                                             stats->tx_overflows,
+                                                                                             stats->rx_overflows,
+                                                                                             stats->tx_bytes_ok,
+                                                                                             stats->rx_bytes_ok));
+}
+
+static QmiMessageWdsGetPacketStatisticsInput *
+packet_statistics_input_new (void)
+{
+    QmiMessageWdsGetPacketStatisticsInput *input;
 
     input = qmi_message_wds_get_packet_statistics_input_new ();
     qmi_message_wds_get_packet_statistics_input_set_mask (
@@ -2802,34 +4270,96 @@ get_connection_stats (RunContext *ctx)
          QMI_WDS_PACKET_STATISTICS_MASK_FLAG_TX_PACKETS_DROPPED |
          QMI_WDS_PACKET_STATISTICS_MASK_FLAG_RX_PACKETS_DROPPED),
         NULL);
+    return input;
+}
+
+static void
+packet_stats_load (PacketStats                            *stats,
+                   QmiMessageWdsGetPacketStatisticsOutput *output)
+{
+    packet_stats_reset (stats);
+    qmi_message_wds_get_packet_statistics_output_get_tx_packets_ok (output, &stats->tx_packets_ok, NULL);
+    qmi_message_wds_get_packet_statistics_output_get_rx_packets_ok (output, &stats->rx_packets_ok, NULL);
+    qmi_message_wds_get_packet_statistics_output_get_tx_packets_error (output, &stats->tx_packets_error, NULL);
+    qmi_message_wds_get_packet_statistics_output_get_rx_packets_error (output, &stats->rx_packets_error, NULL);
+    qmi_message_wds_get_packet_statistics_output_get_tx_overflows (output, &stats->tx_overflows, NULL);
+    qmi_message_wds_get_packet_statistics_output_get_rx_overflows (output, &stats->rx_overflows, NULL);
+    qmi_message_wds_get_packet_statistics_output_get_tx_bytes_ok (output, &stats->tx_bytes_ok, NULL);
+    qmi_message_wds_get_packet_statistics_output_get_rx_bytes_ok (output, &stats->rx_bytes_ok, NULL);
+}
+
+static void
+get_packet_statistics_ready (QmiClientWds *client,
+                             GAsyncResult *res,
+                             RunContext   *ctx)
+{
+    GError *error = NULL;
+    QmiMessageWdsGetPacketStatisticsOutput *output;
+    PacketStats stats;
+
+    output = qmi_client_wds_get_packet_statistics_finish (client, res, &error);
+    if (!output) {
+        g_prefix_error (&error, "QMI operation failed: ");
+        g_simple_async_result_take_error (ctx->result, error);
+        run_context_complete_and_free (ctx);
+        return;
+    }
+
+    if (!qmi_message_wds_get_packet_statistics_output_get_result (output, &error)) {
+        g_prefix_error (&error, "couldn't get packet statistics: ");
+        g_simple_async_result_take_error (ctx->result, error);
+        run_context_complete_and_free (ctx);
+        qmi_message_wds_get_packet_statistics_output_unref (output);
+        return;
+    }
+
+    packet_stats_load (&stats, output);
+    qmi_message_wds_get_packet_statistics_output_unref (output);
+
+    /* Seed the cache, event reports only give the counters that changed */
+    if (ctx->self->priv->packet_stats_indications_enabled) {
+        ctx->self->priv->packet_stats = stats;
+        ctx->self->priv->packet_stats_valid = TRUE;
+    }
+
+    get_connection_stats_complete (ctx, &stats);
+}
+
+static void
+get_connection_stats (RunContext *ctx)
+{
+    QmiMessageWdsGetPacketStatisticsInput *input;
+
+    if (ctx->self->priv->packet_stats_valid) {
+        get_connection_stats_complete (ctx, &ctx->self->priv->packet_stats);
+        return;
+    }
+
+    input = packet_statistics_input_new ();
 
     g_debug ("Asynchronously getting packet statistics...");
     qmi_client_wds_get_packet_statistics (QMI_CLIENT_WDS (peek_qmi_client (ctx->self, QMI_SERVICE_WDS)),
                                           input,
                                           10,
                                           NULL,
-                                          (GAsyncReadyCallback)get_packet_statistics_ready,
-                                          ctx);
+                                          (GAsyncReadyCallback) qmi_transaction_ready,
+                                          qmi_transaction_new (QMI_SERVICE_WDS, 10, (GAsyncReadyCallback)get_packet_statistics_ready, ctx));
     qmi_message_wds_get_packet_statistics_input_unref (input);
 }
 
 /***********************************************/
 /* Ongoing connection stats and info gathering */
 
-typedef enum {
-    WRITE_CONNECTION_STATS_STEP_FIRST,
-    WRITE_CONNECTION_STATS_STEP_TIMESTAMP,
-    WRITE_CONNECTION_STATS_STEP_STATS,
-    WRITE_CONNECTION_STATS_STEP_SIGNAL_STRENGTH,
-    WRITE_CONNECTION_STATS_STEP_SERVING_SYSTEM,
-    WRITE_CONNECTION_STATS_STEP_LAST
-} WriteConnectionStatsStep;
+/* Operator and signal info are taken from the state kept up to date by the
+ * NAS indications, and packet statistics from the WDS event reports when
+ * available; any other info is queried concurrently. */
 
 typedef struct {
     RmfdPortProcessorQmi     *self;
     RmfdStatsRecordType       type;
     GSimpleAsyncResult       *result;
-    WriteConnectionStatsStep  step;
+    guint                     n_pending;
+    GError                   *error;
     guint64                   rx_bytes;
     guint64                   tx_bytes;
     GDateTime                *system_time;
@@ -2839,6 +4369,7 @@ typedef struct {
     guint16                   mnc;
     guint16                   lac;
     guint32                   cid;
+    gboolean                  seed_packet_stats;
 } WriteConnectionStatsContext;
 
 static void
@@ -2860,50 +4391,55 @@ write_connection_stats_finish (RmfdPortProcessorQmi  *self,
     return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
 }
 
-static void write_connection_stats_context_step (WriteConnectionStatsContext *ctx);
-
 static void
-get_serving_system_stats_ready (QmiClientNas                *client,
-                                GAsyncResult                *res,
-                                WriteConnectionStatsContext *ctx)
+write_connection_stats_context_done (WriteConnectionStatsContext *ctx)
 {
-    QmiMessageNasGetServingSystemOutput *output;
+    g_assert (ctx->n_pending > 0);
+    if (--ctx->n_pending > 0)
+        return;
 
-    if ((output = qmi_client_nas_get_serving_system_finish (client, res, NULL)) &&
-        qmi_message_nas_get_serving_system_output_get_result (output, NULL)) {
-        /* MCC/MNC */
-        qmi_message_nas_get_serving_system_output_get_current_plmn (output, &ctx->mcc, &ctx->mnc, NULL, NULL);
-        /* LAC/CID */
-        qmi_message_nas_get_serving_system_output_get_lac_3gpp (output, &ctx->lac, NULL);
-        qmi_message_nas_get_serving_system_output_get_cid_3gpp (output, &ctx->cid, NULL);
+    /* Loading packet statistics failed (e.g. timeout error); we'll fully
+     * skip writing a record. */
+    if (ctx->error) {
+        g_simple_async_result_take_error (ctx->result, ctx->error);
+        write_connection_stats_context_complete_and_free (ctx);
+        return;
     }
 
-    if (output)
-        qmi_message_nas_get_serving_system_output_unref (output);
-
-    /* Continue */
-    ctx->step++;
-    write_connection_stats_context_step (ctx);
-}
+    /* Validate SIM slot just in case */
+    if (ctx->self->priv->connected_sim_slot < 1 || ctx->self->priv->connected_sim_slot > 2) {
+        g_simple_async_result_set_error (ctx->result, RMFD_ERROR, RMFD_ERROR_UNKNOWN,
+                                         "Invalid SIM slot reported: %u",
+                                         ctx->self->priv->connected_sim_slot);
+        write_connection_stats_context_complete_and_free (ctx);
+        return;
+    }
 
-static void
-get_signal_strength_stats_ready (QmiClientNas                *client,
-                                 GAsyncResult                *res,
-                                 WriteConnectionStatsContext *ctx)
-{
-    QmiMessageNasGetSignalStrengthOutput *output;
+    /* Issue stats record */
+    rmfd_stats_record (ctx->self->priv->stats[ctx->self->priv->connected_sim_slot - 1],
+                       ctx->type,
+                       ctx->system_time,
+                       ctx->rx_bytes,
+                       ctx->tx_bytes,
+                       qmi_nas_radio_interface_get_string (ctx->radio_interface),
+                       ctx->rssi,
+                       ctx->mcc,
+                       ctx->mnc,
+                       ctx->lac,
+                       ctx->cid);
 
-    if ((output = qmi_client_nas_get_signal_strength_finish (client, res, NULL)) &&
-        qmi_message_nas_get_signal_strength_output_get_result (output, NULL)) {
-        qmi_message_nas_get_signal_strength_output_get_signal_strength (output, &ctx->rssi, &ctx->radio_interface, NULL);
-    }
+    /* Keep track of the last record written, for the change-aware sampling */
+    ctx->self->priv->stats_last_record_time     = g_get_monotonic_time ();
+    ctx->self->priv->stats_last_record_rx_bytes = ctx->rx_bytes;
+    ctx->self->priv->stats_last_record_tx_bytes = ctx->tx_bytes;
 
-    if (output)
-        qmi_message_nas_get_signal_strength_output_unref (output);
+    /* If writing a final record, reset connected SIM slot */
+    if (ctx->type == RMFD_STATS_RECORD_TYPE_FINAL)
+        ctx->self->priv->connected_sim_slot = 0;
 
-    /* Continue */
-    ctx->step++;
-    write_connection_stats_context_step (ctx);
+    /* Complete and finish */
+    g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+    write_connection_stats_context_complete_and_free (ctx);
 }
 
 static void
@@ -2914,12 +4450,8 @@ get_packet_statistics_stats_ready (QmiClientWds                *client,
     QmiMessageWdsGetPacketStatisticsOutput *output;
     GError *error = NULL;
 
-    if (!(output = qmi_client_wds_get_packet_statistics_finish (client, res, &error))) {
-        /* Loading packet statistics failed (e.g. timeout error); we'll fully
-         * skip writing a record. */
-        /* Complete and finish */
-        g_simple_async_result_take_error (ctx->result, error);
-        write_connection_stats_context_complete_and_free (ctx);
+    if (!(output = qmi_client_wds_get_packet_statistics_finish (client, res, &ctx->error))) {
+        write_connection_stats_context_done (ctx);
         return;
     }
 
@@ -2940,15 +4472,67 @@ get_packet_statistics_stats_ready (QmiClientWds                *client,
         if (qmi_message_wds_get_packet_statistics_output_get_result (output, NULL)) {
             qmi_message_wds_get_packet_statistics_output_get_tx_bytes_ok (output, &ctx->tx_bytes, NULL);
             qmi_message_wds_get_packet_statistics_output_get_rx_bytes_ok (output, &ctx->rx_bytes, NULL);
+
+            /* Seed the cache so that the event reports keep it up to date
+             * and the next samples don't need to query the modem */
+            if (ctx->seed_packet_stats && ctx->self->priv->packet_stats_indications_enabled) {
+                packet_stats_load (&ctx->self->priv->packet_stats, output);
+                ctx->self->priv->packet_stats_valid = TRUE;
+            }
         }
     } else
         g_assert_not_reached ();
 
     qmi_message_wds_get_packet_statistics_output_unref (output);
 
-    /* Continue */
-    ctx->step++;
-    write_connection_stats_context_step (ctx);
+    write_connection_stats_context_done (ctx);
+}
+
+/* The modem system time is only queried once per session and then every
+ * CLOCK_RESYNC_INTERVAL_SECS; records in between are stamped with the
+ * monotonic clock plus the offset computed in the last sync. A resync is
+ * also forced if the host realtime clock is stepped, as that usually comes
+ * with a network time update in the modem as well. */
+
+static gboolean
+clock_offset_needs_sync (RmfdPortProcessorQmi *self)
+{
+    gint64 now;
+
+    if (!self->priv->clock_offset_valid)
+        return TRUE;
+
+    now = g_get_monotonic_time ();
+    if ((now - self->priv->clock_sync_time) >= (CLOCK_RESYNC_INTERVAL_SECS * G_USEC_PER_SEC))
+        return TRUE;
+
+    if (ABS ((g_get_real_time () - now) - self->priv->clock_sync_realtime_offset) >= (CLOCK_DRIFT_THRESHOLD_SECS * G_USEC_PER_SEC)) {
+        g_debug ("system clock changed: modem clock offset needs resync");
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+static void
+clock_offset_sync (RmfdPortProcessorQmi *self,
+                   gint64                modem_time)
+{
+    gint64 now;
+    gint64 offset;
+
+    now = g_get_monotonic_time ();
+    offset = modem_time - now;
+
+    if (self->priv->clock_offset_valid &&
+        ABS (offset - self->priv->clock_offset) >= (CLOCK_DRIFT_THRESHOLD_SECS * G_USEC_PER_SEC))
+        g_debug ("modem clock drifted %" G_GINT64_FORMAT "s since last sync",
+                 (offset - self->priv->clock_offset) / G_USEC_PER_SEC);
+
+    self->priv->clock_offset_valid = TRUE;
+    self->priv->clock_offset = offset;
+    self->priv->clock_sync_time = now;
+    self->priv->clock_sync_realtime_offset = g_get_real_time () - now;
 }
 
 static void
@@ -2966,116 +4550,51 @@ dms_get_time_stats_ready (QmiClientDms                *client,
             output,
             &time_count,
             NULL)) {
-        GTimeZone *tz;
-        GDateTime *gpstime_epoch;
+        gint64 modem_time;
 
-        /* January 6th 1980 */
-        tz = g_time_zone_new_utc ();
-        gpstime_epoch = g_date_time_new (tz, 1980, 1, 6, 0, 0, 0.0);
-        ctx->system_time = g_date_time_add_seconds (gpstime_epoch, ((gdouble) time_count / 1000.0));
-        g_date_time_unref (gpstime_epoch);
-        g_time_zone_unref (tz);
+        /* System time given in milliseconds since the GPS epoch */
+        modem_time = (GPS_EPOCH_UNIX_TIME * G_USEC_PER_SEC) + (gint64)(time_count * 1000);
+        clock_offset_sync (ctx->self, modem_time);
+        ctx->system_time = g_date_time_new_from_unix_utc (modem_time / G_USEC_PER_SEC);
     }
 
     if (output)
         qmi_message_dms_get_time_output_unref (output);
 
-    /* Continue */
-    ctx->step++;
-    write_connection_stats_context_step (ctx);
+    write_connection_stats_context_done (ctx);
 }
 
 static void
-write_connection_stats_context_step (WriteConnectionStatsContext *ctx)
+write_connection_stats_load_cached (WriteConnectionStatsContext *ctx)
 {
-    switch (ctx->step) {
-    case WRITE_CONNECTION_STATS_STEP_FIRST:
-        ctx->step++;
-        /* fall through */
+    RmfdPortProcessorQmiPrivate *priv = ctx->self->priv;
+    gint i;
 
-    case WRITE_CONNECTION_STATS_STEP_TIMESTAMP:
-        qmi_client_dms_get_time (QMI_CLIENT_DMS (peek_qmi_client (ctx->self, QMI_SERVICE_DMS)),
-                                 NULL,
-                                 5,
-                                 NULL,
-                                 (GAsyncReadyCallback)dms_get_time_stats_ready,
-                                 ctx);
-        return;
-
-    case WRITE_CONNECTION_STATS_STEP_STATS:
-        /* For the START record, just assume 0 bytes TX/RX */
-        if (ctx->type != RMFD_STATS_RECORD_TYPE_START) {
-            QmiMessageWdsGetPacketStatisticsInput *input;
+    /* MCC/MNC */
+    if (priv->registration_status == RMF_REGISTRATION_STATUS_HOME ||
+        priv->registration_status == RMF_REGISTRATION_STATUS_ROAMING) {
+        ctx->mcc = priv->operator_mcc;
+        ctx->mnc = priv->operator_mnc;
+    }
 
-            input = qmi_message_wds_get_packet_statistics_input_new ();
-            qmi_message_wds_get_packet_statistics_input_set_mask (input,
-                                                                  (QMI_WDS_PACKET_STATISTICS_MASK_FLAG_TX_BYTES_OK |
-                                                                   QMI_WDS_PACKET_STATISTICS_MASK_FLAG_RX_BYTES_OK),
-                                                                  NULL);
-            qmi_client_wds_get_packet_statistics (QMI_CLIENT_WDS (peek_qmi_client (ctx->self, QMI_SERVICE_WDS)),
-                                                  input,
-                                                  5,
-                                                  NULL,
-                                                  (GAsyncReadyCallback)get_packet_statistics_stats_ready,
-                                                  ctx);
-            qmi_message_wds_get_packet_statistics_input_unref (input);
-            return;
-        }
-        ctx->step++;
-        /* fall through */
+    /* LAC/CID */
+    ctx->lac = priv->lac;
+    ctx->cid = priv->cid;
 
-    case WRITE_CONNECTION_STATS_STEP_SIGNAL_STRENGTH:
-        qmi_client_nas_get_signal_strength (QMI_CLIENT_NAS (peek_qmi_client (ctx->self, QMI_SERVICE_NAS)),
-                                            NULL,
-                                            5,
-                                            NULL,
-                                            (GAsyncReadyCallback)get_signal_strength_stats_ready,
-                                            ctx);
-        return;
-
-    case WRITE_CONNECTION_STATS_STEP_SERVING_SYSTEM:
-        qmi_client_nas_get_serving_system (QMI_CLIENT_NAS (peek_qmi_client (ctx->self, QMI_SERVICE_NAS)),
-                                           NULL,
-                                           5,
-                                           NULL,
-                                           (GAsyncReadyCallback)get_serving_system_stats_ready,
-                                           ctx);
-        return;
-
-    case WRITE_CONNECTION_STATS_STEP_LAST:
-        /* Validate SIM slot just in case */
-        if (ctx->self->priv->connected_sim_slot < 1 || ctx->self->priv->connected_sim_slot > 2) {
-            g_simple_async_result_set_error (ctx->result, RMFD_ERROR, RMFD_ERROR_UNKNOWN,
-                                             "Invalid SIM slot reported: %u",
-                                             ctx->self->priv->connected_sim_slot);
-            write_connection_stats_context_complete_and_free (ctx);
-            return;
+    /* RSSI of the most advanced radio interface with signal */
+    for (i = RMF_RADIO_INTERFACE_LTE; i >= RMF_RADIO_INTERFACE_GSM; i--) {
+        if (priv->signal_available[i]) {
+            ctx->rssi = priv->signal_rssi[i];
+            ctx->radio_interface = rmf_radio_interface_to_qmi (i);
+            break;
         }
-
-        /* Issue stats record */
-        rmfd_stats_record (ctx->self->priv->stats[ctx->self->priv->connected_sim_slot - 1],
-                           ctx->type,
-                           ctx->system_time,
-                           ctx->rx_bytes,
-                           ctx->tx_bytes,
-                           qmi_nas_radio_interface_get_string (ctx->radio_interface),
-                           ctx->rssi,
-                           ctx->mcc,
-                           ctx->mnc,
-                           ctx->lac,
-                           ctx->cid);
-
-        /* If writing a final record, reset connected SIM slot */
-        if (ctx->type == RMFD_STATS_RECORD_TYPE_FINAL)
-            ctx->self->priv->connected_sim_slot = 0;
-
-        /* Complete and finish */
-        g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
-        write_connection_stats_context_complete_and_free (ctx);
-        return;
     }
 
-    g_assert_not_reached ();
+    /* TX/RX bytes, for partial records while the event reports are enabled */
+    if (ctx->type == RMFD_STATS_RECORD_TYPE_PARTIAL && priv->packet_stats_valid) {
+        ctx->tx_bytes = priv->packet_stats.tx_bytes_ok;
+        ctx->rx_bytes = priv->packet_stats.rx_bytes_ok;
+    }
 }
 
 static void
@@ -3091,10 +4610,51 @@ write_connection_stats (RmfdPortProcessorQmi *self,
     ctx->self            = g_object_ref (self);
     ctx->result          = g_simple_async_result_new (G_OBJECT (self), callback, user_data, write_connection_stats);
     ctx->type            = type;
-    ctx->step            = WRITE_CONNECTION_STATS_STEP_FIRST;
     ctx->radio_interface = QMI_NAS_RADIO_INTERFACE_UNKNOWN;
 
-    write_connection_stats_context_step (ctx);
+    write_connection_stats_load_cached (ctx);
+
+    /* Hold an extra pending operation until all requests are sent */
+    ctx->n_pending = 1;
+
+    if (ctx->type == RMFD_STATS_RECORD_TYPE_START || clock_offset_needs_sync (self)) {
+        ctx->n_pending++;
+        qmi_client_dms_get_time (QMI_CLIENT_DMS (peek_qmi_client (ctx->self, QMI_SERVICE_DMS)),
+                                 NULL,
+                                 5,
+                                 NULL,
+                                 (GAsyncReadyCallback) qmi_transaction_ready,
+                                 qmi_transaction_new (QMI_SERVICE_DMS, 5, (GAsyncReadyCallback)dms_get_time_stats_ready, ctx));
+    } else
+        ctx->system_time = g_date_time_new_from_unix_utc ((g_get_monotonic_time () + self->priv->clock_offset) / G_USEC_PER_SEC);
+
+    /* For the START record, just assume 0 bytes TX/RX */
+    if (ctx->type == RMFD_STATS_RECORD_TYPE_FINAL ||
+        (ctx->type == RMFD_STATS_RECORD_TYPE_PARTIAL && !self->priv->packet_stats_valid)) {
+        QmiMessageWdsGetPacketStatisticsInput *input;
+
+        ctx->n_pending++;
+        if (ctx->type == RMFD_STATS_RECORD_TYPE_PARTIAL && self->priv->packet_stats_indications_enabled) {
+            /* Query all counters, the cache needs them */
+            ctx->seed_packet_stats = TRUE;
+            input = packet_statistics_input_new ();
+        } else {
+            input = qmi_message_wds_get_packet_statistics_input_new ();
+            qmi_message_wds_get_packet_statistics_input_set_mask (input,
+                                                                  (QMI_WDS_PACKET_STATISTICS_MASK_FLAG_TX_BYTES_OK |
+                                                                   QMI_WDS_PACKET_STATISTICS_MASK_FLAG_RX_BYTES_OK),
+                                                                  NULL);
+        }
+        qmi_client_wds_get_packet_statistics (QMI_CLIENT_WDS (peek_qmi_client (ctx->self, QMI_SERVICE_WDS)),
+                                              input,
+                                              5,
+                                              NULL,
+                                              (GAsyncReadyCallback) qmi_transaction_ready,
+                                              qmi_transaction_new (QMI_SERVICE_WDS, 5, (GAsyncReadyCallback)get_packet_statistics_stats_ready, ctx));
+        qmi_message_wds_get_packet_statistics_input_unref (input);
+    }
+
+    write_connection_stats_context_done (ctx);
 }
 
 /**********************/
@@ -3109,18 +4669,53 @@ write_connection_stats_timeout_ready (RmfdPortProcessorQmi *self,
     schedule_stats (self);
 }
 
+/* In change-aware mode, a partial record is only worth writing if the byte
+ * counters moved enough or if the last record is too old. This can only be
+ * decided without querying the modem while the event reports are enabled;
+ * otherwise, always write. */
 static gboolean
-stats_cb (RmfdPortProcessorQmi *self)
+stats_sample_is_relevant (RmfdPortProcessorQmi *self)
 {
-    self->priv->stats_timeout_id = 0;
+    RmfdPortProcessorQmiPrivate *priv = self->priv;
+    guint64                      delta;
 
-    write_connection_stats (self,
-                            RMFD_STATS_RECORD_TYPE_PARTIAL,
-                            (GAsyncReadyCallback) write_connection_stats_timeout_ready,
-                            NULL);
+    if (!priv->stats_change_threshold || !priv->packet_stats_valid)
+        return TRUE;
 
-    return FALSE;
-}
+    if ((g_get_monotonic_time () - priv->stats_last_record_time) >= ((gint64) priv->stats_max_interval * G_USEC_PER_SEC))
+        return TRUE;
+
+    /* Counters may go backwards if reset in the modem */
+    delta = 0;
+    if (priv->packet_stats.rx_bytes_ok != priv->stats_last_record_rx_bytes)
+        delta += (priv->packet_stats.rx_bytes_ok > priv->stats_last_record_rx_bytes ?
+                  priv->packet_stats.rx_bytes_ok - priv->stats_last_record_rx_bytes :
+                  priv->packet_stats.rx_bytes_ok);
+    if (priv->packet_stats.tx_bytes_ok != priv->stats_last_record_tx_bytes)
+        delta += (priv->packet_stats.tx_bytes_ok > priv->stats_last_record_tx_bytes ?
+                  priv->packet_stats.tx_bytes_ok - priv->stats_last_record_tx_bytes :
+                  priv->packet_stats.tx_bytes_ok);
+
+    return (delta >= priv->stats_change_threshold);
+}
+
+static gboolean
+stats_cb (RmfdPortProcessorQmi *self)
+{
+    self->priv->stats_timeout_id = 0;
+
+    if (!stats_sample_is_relevant (self)) {
+        schedule_stats (self);
+        return FALSE;
+    }
+
+    write_connection_stats (self,
+                            RMFD_STATS_RECORD_TYPE_PARTIAL,
+                            (GAsyncReadyCallback) write_connection_stats_timeout_ready,
+                            NULL);
+
+    return FALSE;
+}
 
 static void
 schedule_stats (RmfdPortProcessorQmi *self)
@@ -3131,7 +4726,7 @@ schedule_stats (RmfdPortProcessorQmi *self)
     }
 
     if (self->priv->stats_enabled)
-        self->priv->stats_timeout_id = g_timeout_add_seconds (DEFAULT_STATS_TIMEOUT_SECS, (GSourceFunc) stats_cb, self);
+        self->priv->stats_timeout_id = g_timeout_add_seconds (self->priv->stats_interval, (GSourceFunc) stats_cb, self);
 }
 
 /*******************************/
@@ -3194,6 +4789,7 @@ write_connection_stats_stop_ready (RmfdPortProcessorQmi *self,
     /* Remove ongoing stats timeout */
     self->priv->stats_enabled = FALSE;
     schedule_stats (self);
+    packet_stats_invalidate (self);
 
     if (self->priv->connected_data) {
         rmfd_port_data_setup (self->priv->connected_data,
@@ -3213,6 +4809,10 @@ update_final_stats (GTask *task)
     RmfdPortProcessorQmi *self;
 
     self = g_task_get_source_object (task);
+
+    /* Network stopped, nothing to resume after a restart */
+    rmfd_session_state_clear ();
+
     write_connection_stats (self,
                             RMFD_STATS_RECORD_TYPE_FINAL,
                             (GAsyncReadyCallback)write_connection_stats_stop_ready,
@@ -3270,17 +4870,174 @@ common_disconnect (RmfdPortProcessorQmi *self,
                                      input,
                                      30,
                                      NULL,
-                                     (GAsyncReadyCallback)wds_stop_network_ready,
-                                     task);
+                                     (GAsyncReadyCallback) qmi_transaction_ready,
+                                     qmi_transaction_new (QMI_SERVICE_WDS, 30, (GAsyncReadyCallback)wds_stop_network_ready, task));
         return;
     }
 
     update_final_stats (task);
 }
 
+/*************************************/
+/* Automatic reconnection */
+
+static void run_connect (RunContext *ctx);
+
+static void
+auto_reconnect_cancel (RmfdPortProcessorQmi *self)
+{
+    if (self->priv->auto_reconnect_timeout_id) {
+        g_source_remove (self->priv->auto_reconnect_timeout_id);
+        self->priv->auto_reconnect_timeout_id = 0;
+    }
+    self->priv->auto_reconnect_state = RMF_AUTO_RECONNECT_STATE_IDLE;
+    self->priv->auto_reconnect_attempt = 0;
+}
+
+static void
+auto_reconnect_store (RmfdPortProcessorQmi *self,
+                      GByteArray           *request,
+                      RmfdPortData         *data)
+{
+    if (self->priv->auto_reconnect_request != request) {
+        g_clear_pointer (&self->priv->auto_reconnect_request, g_byte_array_unref);
+        self->priv->auto_reconnect_request = g_byte_array_ref (request);
+    }
+    if (self->priv->auto_reconnect_data != data) {
+        g_clear_object (&self->priv->auto_reconnect_data);
+        self->priv->auto_reconnect_data = g_object_ref (data);
+    }
+}
+
+/* The user explicitly wants to be disconnected (or the network rejected
+ * the request permanently); abort any pending reconnection and don't
+ * reconnect again until the next Connect. If a connection attempt is already
+ * ongoing, it won't be retried on failure nor stored on success. */
+static void
+auto_reconnect_forget (RmfdPortProcessorQmi *self)
+{
+    if (self->priv->auto_reconnect_state == RMF_AUTO_RECONNECT_STATE_WAITING) {
+        g_message ("automatic reconnection aborted");
+        auto_reconnect_cancel (self);
+        self->priv->connection_status = RMF_CONNECTION_STATUS_DISCONNECTED;
+    }
+    self->priv->auto_reconnect_generation++;
+    g_clear_pointer (&self->priv->auto_reconnect_request, g_byte_array_unref);
+    g_clear_object (&self->priv->auto_reconnect_data);
+}
+
+static void auto_reconnect_schedule (RmfdPortProcessorQmi *self);
+static gboolean call_end_reason_is_permanent (QmiWdsVerboseCallEndReasonType verbose_cer_type,
+                                              gint16                         verbose_cer_reason);
+
+static void
+auto_reconnect_ready (RmfdPortProcessorQmi *self,
+                      GAsyncResult         *res)
+{
+    GByteArray *response;
+    GError     *error = NULL;
+    gboolean    success = FALSE;
+
+    response = run_finish (RMFD_PORT_PROCESSOR (self), res, &error);
+    if (response) {
+        success = (rmf_message_get_status (response->data) == RMF_RESPONSE_STATUS_OK);
+        g_byte_array_unref (response);
+    } else {
+        g_warning ("error: automatic reconnection attempt failed: %s", error->message);
+        g_error_free (error);
+    }
+
+    if (success) {
+        self->priv->auto_reconnect_reconnects++;
+        self->priv->auto_reconnect_last_recovery_time = (g_get_monotonic_time () - self->priv->auto_reconnect_drop_time) / 1000;
+        g_message ("automatic reconnection succeeded in attempt %u, %ums after the network disconnection",
+                   self->priv->auto_reconnect_attempt, self->priv->auto_reconnect_last_recovery_time);
+        auto_reconnect_cancel (self);
+        return;
+    }
+
+    auto_reconnect_schedule (self);
+}
+
+static gboolean
+auto_reconnect_cb (RmfdPortProcessorQmi *self)
+{
+    RunContext *ctx;
+
+    self->priv->auto_reconnect_timeout_id = 0;
+    self->priv->auto_reconnect_state = RMF_AUTO_RECONNECT_STATE_RECONNECTING;
+
+    /* Run the same connection sequence as for an explicit request */
+    self->priv->connection_status = RMF_CONNECTION_STATUS_DISCONNECTED;
+
+    ctx = g_slice_new0 (RunContext);
+    ctx->self = g_object_ref (self);
+    ctx->result = g_simple_async_result_new (G_OBJECT (self),
+                                             (GAsyncReadyCallback) auto_reconnect_ready,
+                                             NULL,
+                                             auto_reconnect_cb);
+    ctx->request = g_byte_array_ref (self->priv->auto_reconnect_request);
+    ctx->data = g_object_ref (self->priv->auto_reconnect_data);
+    run_connect (ctx);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+auto_reconnect_schedule (RmfdPortProcessorQmi *self)
+{
+    guint delay;
+
+    if (!self->priv->auto_reconnect_enabled || !self->priv->auto_reconnect_request) {
+        auto_reconnect_cancel (self);
+        return;
+    }
+
+    if (self->priv->auto_reconnect_max_attempts &&
+        self->priv->auto_reconnect_attempt >= self->priv->auto_reconnect_max_attempts) {
+        g_warning ("error: automatic reconnection failed: no more attempts left");
+        self->priv->auto_reconnect_failures++;
+        auto_reconnect_cancel (self);
+        return;
+    }
+
+    /* First attempt right away, then backoff */
+    self->priv->auto_reconnect_attempt++;
+    delay = (self->priv->auto_reconnect_attempt == 1 ?
+             0 :
+             rmfd_utils_get_backoff_delay (1000,
+                                           self->priv->auto_reconnect_max_delay * 1000,
+                                           self->priv->auto_reconnect_attempt - 1));
+
+    g_message ("automatic reconnection attempt %u in %ums...", self->priv->auto_reconnect_attempt, delay);
+    self->priv->auto_reconnect_state = RMF_AUTO_RECONNECT_STATE_WAITING;
+    self->priv->connection_status = RMF_CONNECTION_STATUS_CONNECTING;
+    self->priv->auto_reconnect_timeout_id = g_timeout_add (delay, (GSourceFunc) auto_reconnect_cb, self);
+}
+
 /*************************************/
 /* Unsolicited network disconnection */
 
+static void
+network_disconnection_ready (RmfdPortProcessorQmi *self,
+                             GAsyncResult         *res,
+                             gpointer              was_connected)
+{
+    GError *error = NULL;
+
+    if (!common_disconnect_finish (self, res, &error)) {
+        g_warning ("error: couldn't process network disconnection: %s", error->message);
+        g_error_free (error);
+    }
+
+    /* Only reconnect if the drop happened on an established connection, not
+     * while a (re)connection attempt was ongoing */
+    if (GPOINTER_TO_UINT (was_connected) &&
+        self->priv->connection_status == RMF_CONNECTION_STATUS_DISCONNECTED &&
+        self->priv->auto_reconnect_state == RMF_AUTO_RECONNECT_STATE_IDLE)
+        auto_reconnect_schedule (self);
+}
+
 static void
 packet_service_status_indication_cb (QmiClientWds                              *client,
                                      QmiIndicationWdsPacketServiceStatusOutput *output,
@@ -3290,6 +5047,7 @@ packet_service_status_indication_cb (QmiClientWds                              *
     QmiWdsCallEndReason            cer;
     QmiWdsVerboseCallEndReasonType verbose_cer_type;
     gint16                         verbose_cer_reason;
+    gboolean                       was_connected;
 
     if (!qmi_indication_wds_packet_service_status_output_get_connection_status (output, &connection_status, NULL, NULL))
         return;
@@ -3327,13 +5085,110 @@ packet_service_status_indication_cb (QmiClientWds                              *
                    verbose_cer_reason,
                    domain_str,
                    str);
+
+        /* Reconnecting with the same request would just be rejected again */
+        if (call_end_reason_is_permanent (verbose_cer_type, verbose_cer_reason)) {
+            g_warning ("permanent call end reason: no automatic reconnection");
+            auto_reconnect_forget (self);
+        }
     }
 
     /* Now, process the disconnection */
+    was_connected = (self->priv->connection_status == RMF_CONNECTION_STATUS_CONNECTED);
+    if (was_connected) {
+        self->priv->auto_reconnect_drops++;
+        self->priv->auto_reconnect_drop_time = g_get_monotonic_time ();
+    }
     self->priv->packet_data_handle = 0;
-    common_disconnect (self, NULL, NULL);
+    common_disconnect (self, (GAsyncReadyCallback) network_disconnection_ready, GUINT_TO_POINTER (was_connected));
+}
+
+/**********************************/
+/* Packet statistics event report */
+
+#define PACKET_STATS_EVENT_REPORT_MASK                               \
+    (QMI_WDS_SET_EVENT_REPORT_TRANSFER_STATISTICS_TX_PACKETS_OK    | \
+     QMI_WDS_SET_EVENT_REPORT_TRANSFER_STATISTICS_RX_PACKETS_OK    | \
+     QMI_WDS_SET_EVENT_REPORT_TRANSFER_STATISTICS_TX_PACKETS_ERROR | \
+     QMI_WDS_SET_EVENT_REPORT_TRANSFER_STATISTICS_RX_PACKETS_ERROR | \
+     QMI_WDS_SET_EVENT_REPORT_TRANSFER_STATISTICS_TX_OVERFLOWS     | \
+     QMI_WDS_SET_EVENT_REPORT_TRANSFER_STATISTICS_RX_OVERFLOWS     | \
+     QMI_WDS_SET_EVENT_REPORT_TRANSFER_STATISTICS_TX_BYTES_OK      | \
+     QMI_WDS_SET_EVENT_REPORT_TRANSFER_STATISTICS_RX_BYTES_OK)
+
+static void
+event_report_indication_cb (QmiClientWds                     *client,
+                            QmiIndicationWdsEventReportOutput *output,
+                            RmfdPortProcessorQmi              *self)
+{
+    PacketStats *stats = &self->priv->packet_stats;
+
+    /* Only the counters that changed are reported, so there's nothing to
+     * update until the cache is seeded */
+    if (!self->priv->packet_stats_valid)
+        return;
+
+    qmi_indication_wds_event_report_output_get_tx_packets_ok (output, &stats->tx_packets_ok, NULL);
+    qmi_indication_wds_event_report_output_get_rx_packets_ok (output, &stats->rx_packets_ok, NULL);
+    qmi_indication_wds_event_report_output_get_tx_packets_error (output, &stats->tx_packets_error, NULL);
+    qmi_indication_wds_event_report_output_get_rx_packets_error (output, &stats->rx_packets_error, NULL);
+    qmi_indication_wds_event_report_output_get_tx_overflows (output, &stats->tx_overflows, NULL);
+    qmi_indication_wds_event_report_output_get_rx_overflows (output, &stats->rx_overflows, NULL);
+    qmi_indication_wds_event_report_output_get_tx_bytes_ok (output, &stats->tx_bytes_ok, NULL);
+    qmi_indication_wds_event_report_output_get_rx_bytes_ok (output, &stats->rx_bytes_ok, NULL);
+}
+
+static void
+set_packet_stats_event_report_ready (QmiClientWds         *client,
+                                     GAsyncResult         *res,
+                                     RmfdPortProcessorQmi *self)
+{
+    QmiMessageWdsSetEventReportOutput *output;
+    GError *error = NULL;
+
+    /* Until the modem accepts the event reports, stats keep being polled */
+    output = qmi_client_wds_set_event_report_finish (client, res, &error);
+    if (!output || !qmi_message_wds_set_event_report_output_get_result (output, &error)) {
+        g_warning ("couldn't enable packet statistics event reports: %s", error->message);
+        g_error_free (error);
+    } else if (self->priv->event_report_indication_id != 0)
+        self->priv->packet_stats_indications_enabled = TRUE;
+
+    if (output)
+        qmi_message_wds_set_event_report_output_unref (output);
+    g_object_unref (self);
 }
 
+static void
+set_packet_stats_event_report (RmfdPortProcessorQmi *self,
+                               QmiClientWds         *wds,
+                               guint8                period)
+{
+    QmiMessageWdsSetEventReportInput *input;
+    gpointer transaction;
+
+    /* Only enabling the reports needs to know whether they were accepted */
+    if (period)
+        transaction = qmi_transaction_new (QMI_SERVICE_WDS, 5, (GAsyncReadyCallback) set_packet_stats_event_report_ready, g_object_ref (self));
+    else
+        transaction = qmi_transaction_new (QMI_SERVICE_WDS, 5, NULL, NULL);
+
+    input = qmi_message_wds_set_event_report_input_new ();
+    qmi_message_wds_set_event_report_input_set_transfer_statistics (input,
+                                                                    period,
+                                                                    period ? PACKET_STATS_EVENT_REPORT_MASK : 0,
+                                                                    NULL);
+    qmi_client_wds_set_event_report (wds,
+                                     input,
+                                     5,
+                                     NULL,
+                                     (GAsyncReadyCallback) qmi_transaction_ready,
+                                     transaction);
+    qmi_message_wds_set_event_report_input_unref (input);
+}
+
+/**********************/
+
 static void
 unregister_wds_indications (RmfdPortProcessorQmi *self)
 {
@@ -3347,6 +5202,14 @@ unregister_wds_indications (RmfdPortProcessorQmi *self)
 
     g_signal_handler_disconnect (wds, self->priv->packet_service_status_indication_id);
     self->priv->packet_service_status_indication_id = 0;
+
+    if (self->priv->event_report_indication_id) {
+        g_signal_handler_disconnect (wds, self->priv->event_report_indication_id);
+        self->priv->event_report_indication_id = 0;
+        self->priv->packet_stats_indications_enabled = FALSE;
+        packet_stats_invalidate (self);
+        set_packet_stats_event_report (self, wds, 0);
+    }
 }
 
 static void
@@ -3364,6 +5227,68 @@ register_wds_indications (RmfdPortProcessorQmi *self)
                           "packet-service-status",
                           G_CALLBACK (packet_service_status_indication_cb),
                           self);
+
+    if (self->priv->packet_stats_period) {
+        self->priv->event_report_indication_id =
+            g_signal_connect (wds,
+                              "event-report",
+                              G_CALLBACK (event_report_indication_cb),
+                              self);
+        set_packet_stats_event_report (self, wds, self->priv->packet_stats_period);
+    }
+}
+
+/**********************/
+/* Session state */
+
+static void
+save_session_state (RmfdPortProcessorQmi *self,
+                    const gchar          *ip,
+                    const gchar          *subnet,
+                    const gchar          *gw,
+                    const gchar          *dns1,
+                    const gchar          *dns2,
+                    guint32               mtu)
+{
+    RmfdSessionState *state;
+    QmiClient        *wds;
+    guint             slot_i;
+    GDateTime        *start_system_time = NULL;
+    time_t            start_time = 0;
+
+    /* No data port means nothing to keep up across restarts */
+    if (!self->priv->connected_data)
+        return;
+
+    wds = peek_qmi_client (self, QMI_SERVICE_WDS);
+    g_assert (wds);
+
+    state = rmfd_session_state_new ();
+    state->control_port       = g_strdup (rmfd_port_get_interface (RMFD_PORT (self)));
+    state->data_port          = g_strdup (rmfd_port_get_interface (RMFD_PORT (self->priv->connected_data)));
+    state->wds_cid            = qmi_client_get_cid (wds);
+    state->packet_data_handle = self->priv->packet_data_handle;
+    state->sim_slot           = self->priv->connected_sim_slot;
+    state->ip                 = g_strdup (ip);
+    state->subnet             = g_strdup (subnet);
+    state->gw                 = g_strdup (gw);
+    state->dns1               = g_strdup (dns1);
+    state->dns2               = g_strdup (dns2);
+    state->mtu                = mtu;
+
+    slot_i = self->priv->connected_sim_slot - 1;
+    if (slot_i < G_N_ELEMENTS (self->priv->stats) &&
+        rmfd_stats_get_session_start (self->priv->stats[slot_i], &start_system_time, &start_time)) {
+        state->stats[slot_i].valid      = TRUE;
+        state->stats[slot_i].start_time = start_time;
+        if (start_system_time) {
+            state->stats[slot_i].start_system_time = g_date_time_to_unix (start_system_time);
+            g_date_time_unref (start_system_time);
+        }
+    }
+
+    rmfd_session_state_save (state);
+    rmfd_session_state_free (state);
 }
 
 /**********************/
@@ -3385,12 +5310,16 @@ typedef struct {
     guint        iteration;
     gboolean     default_ip_family_set;
     GError      *error;
+    gboolean     error_is_permanent;
+    guint        auto_reconnect_generation;
     gchar       *ip_str;
     gchar       *subnet_str;
     gchar       *gw_str;
     gchar       *dns1_str;
     gchar       *dns2_str;
     guint32      mtu;
+    gint64       wait_start_time;
+    gint64       wwan_setup_start_time;
 } ConnectContext;
 
 static void
@@ -3411,32 +5340,48 @@ static void connect_step (RunContext *ctx);
 static gboolean
 connect_step_scheduled (RunContext *ctx)
 {
+    ConnectContext *connect_ctx = (ConnectContext *)ctx->additional_context;
+
+    rmfd_tracing_add_span ("rmfd", "connect_step_schedule", NULL,
+                           ctx->trace_request_id, ctx->trace_command,
+                           connect_ctx->wait_start_time, g_get_monotonic_time ());
+
+    rmfd_tracing_set_current (ctx->trace_request_id, ctx->trace_command);
     connect_step (ctx);
+    rmfd_tracing_set_current (0, RMF_MESSAGE_COMMAND_UNKNOWN);
     return G_SOURCE_REMOVE;
 }
 
 static void
 connect_step_schedule (RunContext *ctx,
-                       guint       n_seconds)
+                       guint       n_milliseconds)
 {
-    g_timeout_add_seconds (n_seconds, (GSourceFunc) connect_step_scheduled, ctx);
+    ConnectContext *connect_ctx = (ConnectContext *)ctx->additional_context;
+
+    connect_ctx->wait_start_time = g_get_monotonic_time ();
+    g_timeout_add (n_milliseconds, (GSourceFunc) connect_step_scheduled, ctx);
 }
 
+
 static void
 connect_step_restart_iteration (RunContext *ctx)
 {
     ConnectContext *connect_ctx = (ConnectContext *)ctx->additional_context;
+    guint           delay;
 
     g_assert (connect_ctx->error);
-    connect_ctx->iteration++;
 
-    if (connect_ctx->iteration > MAX_CONNECT_ITERATIONS) {
+    if (connect_ctx->error_is_permanent || connect_ctx->iteration >= ctx->self->priv->connect_max_attempts) {
         GByteArray *error_message;
 
         ctx->self->priv->connection_status = RMF_CONNECTION_STATUS_DISCONNECTED;
         unregister_wds_indications (ctx->self);
 
-        g_warning ("error: no more connection attempts left");
+        if (connect_ctx->error_is_permanent) {
+            g_warning ("error: connection attempt failed with a permanent error");
+            auto_reconnect_forget (ctx->self);
+        } else
+            g_warning ("error: no more connection attempts left");
 
         error_message = rmfd_error_message_new_from_gerror (ctx->request, connect_ctx->error);
         g_simple_async_result_set_op_res_gpointer (ctx->result, error_message,
@@ -3445,14 +5390,19 @@ connect_step_restart_iteration (RunContext *ctx)
         return;
     }
 
-    g_warning ("error: restarting connection iteration");
+    delay = rmfd_utils_get_backoff_delay (ctx->self->priv->connect_retry_initial_delay,
+                                          ctx->self->priv->connect_retry_max_delay,
+                                          connect_ctx->iteration);
+    connect_ctx->iteration++;
+
+    g_warning ("error: restarting connection iteration in %ums", delay);
 
     /* From the very beginning */
     g_clear_error (&connect_ctx->error);
     connect_ctx->step = CONNECT_STEP_FIRST;
     connect_ctx->default_ip_family_set = FALSE;
 
-    connect_step_schedule (ctx, 5);
+    connect_step_schedule (ctx, delay);
 }
 
 static void
@@ -3485,8 +5435,8 @@ wds_stop_network_after_start (RunContext *ctx)
                                  input,
                                  30,
                                  NULL,
-                                 (GAsyncReadyCallback)wds_stop_network_after_start_ready,
-                                 ctx);
+                                 (GAsyncReadyCallback) qmi_transaction_ready,
+                                 qmi_transaction_new (QMI_SERVICE_WDS, 30, (GAsyncReadyCallback)wds_stop_network_after_start_ready, ctx));
 }
 
 static void
@@ -3504,6 +5454,7 @@ write_connection_stats_start_ready (RmfdPortProcessorQmi *self,
 
     self->priv->stats_enabled = TRUE;
     schedule_stats (self);
+    packet_stats_invalidate (self);
 
     /* Go on to next step */
     connect_ctx->step++;
@@ -3528,20 +5479,26 @@ data_setup_start_ready (RmfdPortData *data,
     ConnectContext *connect_ctx = (ConnectContext *)ctx->additional_context;
     GError *error = NULL;
 
+    rmfd_tracing_add_span ("rmfd", "rmfd_port_data_setup", NULL,
+                           ctx->trace_request_id, ctx->trace_command,
+                           connect_ctx->wwan_setup_start_time, g_get_monotonic_time ());
+    rmfd_tracing_set_current (ctx->trace_request_id, ctx->trace_command);
+
     if (!rmfd_port_data_setup_finish (data, res, &error)) {
         g_assert (!connect_ctx->error);
         connect_ctx->error = error;
         wds_stop_network_after_start (ctx);
-        return;
-    }
+    } else {
+        /* Store connected data port  */
+        g_clear_object (&ctx->self->priv->connected_data);
+        ctx->self->priv->connected_data = g_object_ref (ctx->data);
 
-    /* Store connected data port  */
-    g_clear_object (&ctx->self->priv->connected_data);
-    ctx->self->priv->connected_data = g_object_ref (ctx->data);
+        /* Go on to next step */
+        connect_ctx->step++;
+        connect_step (ctx);
+    }
 
-    /* Go on to next step */
-    connect_ctx->step++;
-    connect_step (ctx);
+    rmfd_tracing_set_current (0, RMF_MESSAGE_COMMAND_UNKNOWN);
 }
 
 static void
@@ -3549,6 +5506,8 @@ connect_step_wwan_setup (RunContext *ctx)
 {
     ConnectContext *connect_ctx = (ConnectContext *)ctx->additional_context;
 
+    connect_ctx->wwan_setup_start_time = g_get_monotonic_time ();
+
     /* If we have a device running in 802.3 mode, we must run DHCP because some
      * devices require that to actually initialize the data flow in the WWAN.
      */
@@ -3586,6 +5545,68 @@ connect_step_wwan_setup (RunContext *ctx)
     wds_stop_network_after_start (ctx);
 }
 
+static QmiMessageWdsGetCurrentSettingsInput *
+current_settings_input_new (void)
+{
+    QmiMessageWdsGetCurrentSettingsInput *input;
+
+    input = qmi_message_wds_get_current_settings_input_new ();
+    qmi_message_wds_get_current_settings_input_set_requested_settings (
+        input,
+        (QMI_WDS_GET_CURRENT_SETTINGS_REQUESTED_SETTINGS_IP_ADDRESS   |
+         QMI_WDS_GET_CURRENT_SETTINGS_REQUESTED_SETTINGS_DNS_ADDRESS  |
+         QMI_WDS_GET_CURRENT_SETTINGS_REQUESTED_SETTINGS_GATEWAY_INFO |
+         QMI_WDS_GET_CURRENT_SETTINGS_REQUESTED_SETTINGS_MTU),
+        NULL);
+    return input;
+}
+
+static gchar *
+current_settings_address_to_string (guint32      addr,
+                                    const gchar *description)
+{
+    struct in_addr in_addr_val;
+    gchar buf4[INET_ADDRSTRLEN];
+
+    in_addr_val.s_addr = GUINT32_TO_BE (addr);
+    memset (buf4, 0, sizeof (buf4));
+    inet_ntop (AF_INET, &in_addr_val, buf4, sizeof (buf4));
+    g_debug ("  IPv4 %s: %s", description, buf4);
+    return g_strdup (buf4);
+}
+
+static void
+current_settings_load (QmiMessageWdsGetCurrentSettingsOutput  *output,
+                       gchar                                 **ip_str,
+                       gchar                                 **subnet_str,
+                       gchar                                 **gw_str,
+                       gchar                                 **dns1_str,
+                       gchar                                 **dns2_str,
+                       guint32                                *mtu)
+{
+    guint32 addr = 0;
+
+    g_debug ("Current IP settings retrieved:");
+
+    if (qmi_message_wds_get_current_settings_output_get_ipv4_address (output, &addr, NULL))
+        *ip_str = current_settings_address_to_string (addr, "address");
+
+    if (qmi_message_wds_get_current_settings_output_get_ipv4_gateway_subnet_mask (output, &addr, NULL))
+        *subnet_str = current_settings_address_to_string (addr, "subnet mask");
+
+    if (qmi_message_wds_get_current_settings_output_get_ipv4_gateway_address (output, &addr, NULL))
+        *gw_str = current_settings_address_to_string (addr, "gateway address");
+
+    if (qmi_message_wds_get_current_settings_output_get_primary_ipv4_dns_address (output, &addr, NULL))
+        *dns1_str = current_settings_address_to_string (addr, "primary DNS");
+
+    if (qmi_message_wds_get_current_settings_output_get_secondary_ipv4_dns_address (output, &addr, NULL))
+        *dns2_str = current_settings_address_to_string (addr, "secondary DNS");
+
+    if (qmi_message_wds_get_current_settings_output_get_mtu (output, mtu, NULL))
+        g_debug ("  MTU: %u", *mtu);
+}
+
 static void
 get_current_settings_ready (QmiClientWds *client,
                             GAsyncResult *res,
@@ -3594,9 +5615,6 @@ get_current_settings_ready (QmiClientWds *client,
     ConnectContext *connect_ctx = (ConnectContext *)ctx->additional_context;
     GError *error = NULL;
     QmiMessageWdsGetCurrentSettingsOutput *output;
-    guint32 addr = 0;
-    struct in_addr in_addr_val;
-    gchar buf4[INET_ADDRSTRLEN];
 
     g_assert (!connect_ctx->ip_str);
     g_assert (!connect_ctx->subnet_str);
@@ -3606,52 +5624,14 @@ get_current_settings_ready (QmiClientWds *client,
     g_assert (!connect_ctx->mtu);
 
     output = qmi_client_wds_get_current_settings_finish (client, res, &error);
-    if (output && qmi_message_wds_get_current_settings_output_get_result (output, &error)) {
-        g_debug ("Current IP settings retrieved:");
-
-        if (qmi_message_wds_get_current_settings_output_get_ipv4_address (output, &addr, NULL)) {
-            in_addr_val.s_addr = GUINT32_TO_BE (addr);
-            memset (buf4, 0, sizeof (buf4));
-            inet_ntop (AF_INET, &in_addr_val, buf4, sizeof (buf4));
-            g_debug ("  IPv4 address: %s", buf4);
-            connect_ctx->ip_str = g_strdup (buf4);
-        }
-
-        if (qmi_message_wds_get_current_settings_output_get_ipv4_gateway_subnet_mask (output, &addr, NULL)) {
-            in_addr_val.s_addr = GUINT32_TO_BE (addr);
-            memset (buf4, 0, sizeof (buf4));
-            inet_ntop (AF_INET, &in_addr_val, buf4, sizeof (buf4));
-            g_debug ("  IPv4 subnet mask: %s", buf4);
-            connect_ctx->subnet_str = g_strdup (buf4);
-        }
-
-        if (qmi_message_wds_get_current_settings_output_get_ipv4_gateway_address (output, &addr, NULL)) {
-            in_addr_val.s_addr = GUINT32_TO_BE (addr);
-            memset (buf4, 0, sizeof (buf4));
-            inet_ntop (AF_INET, &in_addr_val, buf4, sizeof (buf4));
-            g_debug ("  IPv4 gateway address: %s", buf4);
-            connect_ctx->gw_str = g_strdup (buf4);
-        }
-
-        if (qmi_message_wds_get_current_settings_output_get_primary_ipv4_dns_address (output, &addr, NULL)) {
-            in_addr_val.s_addr = GUINT32_TO_BE (addr);
-            memset (buf4, 0, sizeof (buf4));
-            inet_ntop (AF_INET, &in_addr_val, buf4, sizeof (buf4));
-            g_debug ("  IPv4 primary DNS: %s", buf4);
-            connect_ctx->dns1_str = g_strdup (buf4);
-        }
-
-        if (qmi_message_wds_get_current_settings_output_get_secondary_ipv4_dns_address (output, &addr, NULL)) {
-            in_addr_val.s_addr = GUINT32_TO_BE (addr);
-            memset (buf4, 0, sizeof (buf4));
-            inet_ntop (AF_INET, &in_addr_val, buf4, sizeof (buf4));
-            g_debug ("  IPv4 secondary DNS: %s", buf4);
-            connect_ctx->dns2_str = g_strdup (buf4);
-        }
-
-        if (qmi_message_wds_get_current_settings_output_get_mtu (output, &connect_ctx->mtu, NULL))
-            g_debug ("  MTU: %u", connect_ctx->mtu);
-    }
+    if (output && qmi_message_wds_get_current_settings_output_get_result (output, &error))
+        current_settings_load (output,
+                               &connect_ctx->ip_str,
+                               &connect_ctx->subnet_str,
+                               &connect_ctx->gw_str,
+                               &connect_ctx->dns1_str,
+                               &connect_ctx->dns2_str,
+                               &connect_ctx->mtu);
 
     if (output)
         qmi_message_wds_get_current_settings_output_unref (output);
@@ -3673,14 +5653,7 @@ connect_step_ip_settings (RunContext *ctx)
     QmiMessageWdsGetCurrentSettingsInput *input;
     ConnectContext *connect_ctx = (ConnectContext *)ctx->additional_context;
 
-    input = qmi_message_wds_get_current_settings_input_new ();
-    qmi_message_wds_get_current_settings_input_set_requested_settings (
-        input,
-        (QMI_WDS_GET_CURRENT_SETTINGS_REQUESTED_SETTINGS_IP_ADDRESS   |
-         QMI_WDS_GET_CURRENT_SETTINGS_REQUESTED_SETTINGS_DNS_ADDRESS  |
-         QMI_WDS_GET_CURRENT_SETTINGS_REQUESTED_SETTINGS_GATEWAY_INFO |
-         QMI_WDS_GET_CURRENT_SETTINGS_REQUESTED_SETTINGS_MTU),
-        NULL);
+    input = current_settings_input_new ();
 
     g_free (connect_ctx->ip_str);
     g_free (connect_ctx->subnet_str);
@@ -3700,11 +5673,27 @@ connect_step_ip_settings (RunContext *ctx)
                                          input,
                                          10,
                                          NULL,
-                                         (GAsyncReadyCallback)get_current_settings_ready,
-                                         ctx);
+                                         (GAsyncReadyCallback) qmi_transaction_ready,
+                                         qmi_transaction_new (QMI_SERVICE_WDS, 10, (GAsyncReadyCallback)get_current_settings_ready, ctx));
     qmi_message_wds_get_current_settings_input_unref (input);
 }
 
+static gboolean
+call_end_reason_is_permanent (QmiWdsVerboseCallEndReasonType verbose_cer_type,
+                              gint16                         verbose_cer_reason)
+{
+    guint i;
+
+    if (verbose_cer_type != QMI_WDS_VERBOSE_CALL_END_REASON_TYPE_3GPP)
+        return FALSE;
+
+    for (i = 0; i < G_N_ELEMENTS (permanent_3gpp_call_end_reasons); i++) {
+        if ((QmiWdsVerboseCallEndReason3gpp) verbose_cer_reason == permanent_3gpp_call_end_reasons[i])
+            return TRUE;
+    }
+    return FALSE;
+}
+
 static void
 wds_start_network_ready (QmiClientWds *client,
                          GAsyncResult *res,
@@ -3775,6 +5764,8 @@ wds_start_network_ready (QmiClientWds *client,
                                domain_str,
                                str);
 
+                    connect_ctx->error_is_permanent = call_end_reason_is_permanent (verbose_cer_type, verbose_cer_reason);
+
                     if (domain_str || str)
                         g_string_append_printf (error_str,
                                                 "%s[%s (%u)] %s (%d)",
@@ -3795,6 +5786,11 @@ wds_start_network_ready (QmiClientWds *client,
     }
 
     if (error) {
+        /* The request itself was malformed, e.g. invalid APN */
+        if (g_error_matches (error, QMI_PROTOCOL_ERROR, QMI_PROTOCOL_ERROR_INVALID_ARGUMENT) ||
+            g_error_matches (error, QMI_PROTOCOL_ERROR, QMI_PROTOCOL_ERROR_MISSING_ARGUMENT))
+            connect_ctx->error_is_permanent = TRUE;
+
         if (error_str) {
             connect_ctx->error = g_error_new (error->domain,
                                               error->code,
@@ -3809,7 +5805,7 @@ wds_start_network_ready (QmiClientWds *client,
 
     /* Go on to next step */
     connect_ctx->step++;
-    connect_step_schedule (ctx, 1);
+    connect_step_schedule (ctx, 1000);
 }
 
 static void
@@ -3851,8 +5847,8 @@ connect_step_start_network (RunContext *ctx)
                                   input,
                                   45,
                                   NULL,
-                                  (GAsyncReadyCallback)wds_start_network_ready,
-                                  ctx);
+                                  (GAsyncReadyCallback) qmi_transaction_ready,
+                                  qmi_transaction_new (QMI_SERVICE_WDS, 45, (GAsyncReadyCallback)wds_start_network_ready, ctx));
     qmi_message_wds_start_network_input_unref (input);
 }
 
@@ -3890,8 +5886,8 @@ connect_step_ip_family (RunContext *ctx)
                                   input,
                                   10,
                                   NULL,
-                                  (GAsyncReadyCallback)wds_set_ip_family_ready,
-                                  ctx);
+                                  (GAsyncReadyCallback) qmi_transaction_ready,
+                                  qmi_transaction_new (QMI_SERVICE_WDS, 10, (GAsyncReadyCallback)wds_set_ip_family_ready, ctx));
     qmi_message_wds_set_ip_family_input_unref (input);
 }
 
@@ -3911,225 +5907,1108 @@ common_sim_slot_query_in_connect_ready (RmfdPortProcessorQmi  *self,
         self->priv->connected_sim_slot = 1;
     }
 
-    /* Go on to next step */
-    connect_ctx->step++;
-    connect_step (ctx);
+    /* Go on to next step */
+    connect_ctx->step++;
+    connect_step (ctx);
+}
+
+static void
+connect_step_sim_query (RunContext *ctx)
+{
+    common_sim_slot_query (ctx->self,
+                           (GAsyncReadyCallback)common_sim_slot_query_in_connect_ready,
+                           ctx);
+}
+
+static void
+connect_step (RunContext *ctx)
+{
+    ConnectContext *connect_ctx = (ConnectContext *)ctx->additional_context;
+    guint8 *response;
+
+    switch (connect_ctx->step) {
+    case CONNECT_STEP_FIRST:
+        g_warning ("connection: new connection attempt (%u/%u)...", connect_ctx->iteration, ctx->self->priv->connect_max_attempts);
+        connect_ctx->step++;
+        /* fall through */
+
+    case CONNECT_STEP_SIM_QUERY:
+        g_message ("connection %u/%u step %u/%u: querying current SIM slot...",
+                   connect_ctx->iteration, ctx->self->priv->connect_max_attempts, connect_ctx->step, CONNECT_STEP_LAST);
+        connect_step_sim_query (ctx);
+        return;
+
+    case CONNECT_STEP_IP_FAMILY:
+        g_message ("connection %u/%u step %u/%u: setting IPv4 family...",
+                   connect_ctx->iteration, ctx->self->priv->connect_max_attempts, connect_ctx->step, CONNECT_STEP_LAST);
+        connect_step_ip_family (ctx);
+        return;
+
+    case CONNECT_STEP_START_NETWORK:
+        g_message ("connection %u/%u step %u/%u: starting network...",
+                   connect_ctx->iteration, ctx->self->priv->connect_max_attempts, connect_ctx->step, CONNECT_STEP_LAST);
+        connect_step_start_network (ctx);
+        return;
+
+    case CONNECT_STEP_IP_SETTINGS:
+        g_message ("connection %u/%u step %u/%u: retrieving IPv4 settings...",
+                   connect_ctx->iteration, ctx->self->priv->connect_max_attempts, connect_ctx->step, CONNECT_STEP_LAST);
+        connect_step_ip_settings (ctx);
+        return;
+
+    case CONNECT_STEP_WWAN_SETUP:
+        g_message ("connection %u/%u step %u/%u: wwan interface setup...",
+                   connect_ctx->iteration, ctx->self->priv->connect_max_attempts, connect_ctx->step, CONNECT_STEP_LAST);
+        connect_step_wwan_setup (ctx);
+        return;
+
+    case CONNECT_STEP_STATS:
+        g_message ("connection %u/%u step %u/%u: reseting stats...",
+                   connect_ctx->iteration, ctx->self->priv->connect_max_attempts, connect_ctx->step, CONNECT_STEP_LAST);
+        connect_step_stats (ctx);
+        return;
+
+    case CONNECT_STEP_LAST:
+        /* Ok! */
+        g_message ("connection %u/%u step %u/%u: successfully connected",
+                   connect_ctx->iteration, ctx->self->priv->connect_max_attempts, connect_ctx->step, CONNECT_STEP_LAST);
+        ctx->self->priv->connection_status = RMF_CONNECTION_STATUS_CONNECTED;
+
+        /* Allow resuming this same session if the daemon gets restarted */
+        save_session_state (ctx->self,
+                            connect_ctx->ip_str,
+                            connect_ctx->subnet_str,
+                            connect_ctx->gw_str,
+                            connect_ctx->dns1_str,
+                            connect_ctx->dns2_str,
+                            connect_ctx->mtu);
+
+        /* Keep the request around for automatic reconnections, unless a
+         * Disconnect arrived while connecting */
+        if (connect_ctx->auto_reconnect_generation == ctx->self->priv->auto_reconnect_generation)
+            auto_reconnect_store (ctx->self, ctx->request, ctx->data);
+
+        response = rmf_message_connect_response_new ();
+        g_simple_async_result_set_op_res_gpointer (ctx->result,
+                                                   g_byte_array_new_take (response, rmf_message_get_length (response)),
+                                                   (GDestroyNotify)g_byte_array_unref);
+        run_context_complete_and_free (ctx);
+        return;
+    }
+}
+
+static void
+run_connect (RunContext *ctx)
+{
+    ConnectContext *connect_ctx;
+
+    /* With QMAP enabled, the kernel drops non-multiplexed traffic in the
+     * master interface */
+    if (ctx->self->priv->mux_enabled) {
+        g_warning ("error connecting: multiplexed sessions enabled");
+        g_simple_async_result_set_op_res_gpointer (
+            ctx->result,
+            rmfd_error_message_new_from_error (ctx->request, RMFD_ERROR, RMFD_ERROR_INVALID_STATE, "Multiplexed sessions enabled, connect a session instead"),
+            (GDestroyNotify)g_byte_array_unref);
+        run_context_complete_and_free (ctx);
+        return;
+    }
+
+    /* An explicit connection request takes over a pending reconnection */
+    if (ctx->self->priv->auto_reconnect_state == RMF_AUTO_RECONNECT_STATE_WAITING) {
+        auto_reconnect_cancel (ctx->self);
+        ctx->self->priv->connection_status = RMF_CONNECTION_STATUS_DISCONNECTED;
+    }
+
+    if (ctx->self->priv->connection_status != RMF_CONNECTION_STATUS_DISCONNECTED) {
+        switch (ctx->self->priv->connection_status) {
+        case RMF_CONNECTION_STATUS_DISCONNECTING:
+            g_warning ("error connecting: currenty disconnecting");
+            g_simple_async_result_set_op_res_gpointer (
+                ctx->result,
+                rmfd_error_message_new_from_error (ctx->request, RMFD_ERROR, RMFD_ERROR_INVALID_STATE, "Currently disconnecting"),
+                (GDestroyNotify)g_byte_array_unref);
+            break;
+        case RMF_CONNECTION_STATUS_CONNECTING:
+            g_warning ("error connecting: already connecting");
+            g_simple_async_result_set_op_res_gpointer (
+                ctx->result,
+                rmfd_error_message_new_from_error (ctx->request, RMFD_ERROR, RMFD_ERROR_INVALID_STATE, "Already connecting"),
+                (GDestroyNotify)g_byte_array_unref);
+            break;
+        case RMF_CONNECTION_STATUS_CONNECTED: {
+            guint8 *response;
+
+            g_debug ("already connected");
+            response = rmf_message_connect_response_new ();
+            g_simple_async_result_set_op_res_gpointer (
+                ctx->result,
+                g_byte_array_new_take (response, rmf_message_get_length (response)),
+                (GDestroyNotify)g_byte_array_unref);
+            break;
+        }
+        case RMF_CONNECTION_STATUS_DISCONNECTED:
+        default:
+            g_assert_not_reached ();
+        }
+
+        run_context_complete_and_free (ctx);
+        return;
+    }
+
+    /* Now connecting */
+    ctx->self->priv->connection_status = RMF_CONNECTION_STATUS_CONNECTING;
+    register_wds_indications (ctx->self);
+
+    /* Setup connect context */
+    connect_ctx = g_slice_new0 (ConnectContext);
+    connect_ctx->step = CONNECT_STEP_FIRST;
+    connect_ctx->iteration = 1;
+    connect_ctx->auto_reconnect_generation = ctx->self->priv->auto_reconnect_generation;
+    run_context_set_additional_context (ctx, connect_ctx, (GDestroyNotify)connect_context_free);
+    connect_step (ctx);
+}
+
+/**********************/
+/* Disconnect */
+
+static void
+common_disconnect_ready (RmfdPortProcessorQmi *self,
+                         GAsyncResult         *res,
+                         RunContext           *ctx)
+{
+    g_autoptr(GError) error = NULL;
+
+    if (!common_disconnect_finish (self, res, &error)) {
+        g_simple_async_result_set_op_res_gpointer (ctx->result,
+                                                   rmfd_error_message_new_from_gerror (ctx->request, error),
+                                                   (GDestroyNotify)g_byte_array_unref);
+    } else {
+        guint8 *response;
+
+        response = rmf_message_disconnect_response_new ();
+        g_simple_async_result_set_op_res_gpointer (ctx->result,
+                                                   g_byte_array_new_take (response, rmf_message_get_length (response)),
+                                                   (GDestroyNotify)g_byte_array_unref);
+    }
+
+    run_context_complete_and_free (ctx);
+}
+
+static void
+disconnect (RunContext *ctx)
+{
+    auto_reconnect_forget (ctx->self);
+
+    if (ctx->self->priv->connection_status != RMF_CONNECTION_STATUS_CONNECTED) {
+        switch (ctx->self->priv->connection_status) {
+        case RMF_CONNECTION_STATUS_DISCONNECTING:
+            g_warning ("error: cannot disconnect: already disconnecting");
+            g_simple_async_result_set_op_res_gpointer (
+                ctx->result,
+                rmfd_error_message_new_from_error (ctx->request, RMFD_ERROR, RMFD_ERROR_INVALID_STATE, "Already disconnecting"),
+                (GDestroyNotify)g_byte_array_unref);
+            break;
+        case RMF_CONNECTION_STATUS_CONNECTING:
+            g_warning ("error: cannot disconnect: currently connecting");
+            g_simple_async_result_set_op_res_gpointer (
+                ctx->result,
+                rmfd_error_message_new_from_error (ctx->request, RMFD_ERROR, RMFD_ERROR_INVALID_STATE, "Currently connecting"),
+                (GDestroyNotify)g_byte_array_unref);
+            break;
+        case RMF_CONNECTION_STATUS_DISCONNECTED: {
+            guint8 *response;
+
+            g_debug ("already disconnected");
+            response = rmf_message_disconnect_response_new ();
+            g_simple_async_result_set_op_res_gpointer (
+                ctx->result,
+                g_byte_array_new_take (response, rmf_message_get_length (response)),
+                (GDestroyNotify)g_byte_array_unref);
+            break;
+        }
+        case RMF_CONNECTION_STATUS_CONNECTED:
+        default:
+            g_assert_not_reached ();
+        }
+
+        run_context_complete_and_free (ctx);
+        return;
+    }
+
+    common_disconnect (ctx->self,
+                       (GAsyncReadyCallback)common_disconnect_ready,
+                       ctx);
+}
+
+/**********************/
+/* Get auto reconnect */
+
+static void
+get_auto_reconnect (RunContext *ctx)
+{
+    RmfdPortProcessorQmiPrivate *priv = ctx->self->priv;
+
+    run_context_complete_with_response (ctx,
+                                        rmf_message_get_auto_reconnect_response_new (priv->auto_reconnect_enabled,
+                                                                                     priv->auto_reconnect_max_attempts,
+                                                                                     priv->auto_reconnect_max_delay,
+                                                                                     priv->auto_reconnect_state,
+                                                                                     priv->auto_reconnect_attempt,
+                                                                                     priv->auto_reconnect_drops,
+                                                                                     priv->auto_reconnect_reconnects,
+                                                                                     priv->auto_reconnect_failures,
+                                                                                     priv->auto_reconnect_last_recovery_time));
+}
+
+/**********************/
+/* Set auto reconnect */
+
+static void
+set_auto_reconnect (RunContext *ctx)
+{
+    RmfdPortProcessorQmiPrivate *priv = ctx->self->priv;
+    guint32                      enabled;
+    guint32                      max_attempts;
+    guint32                      max_delay;
+
+    rmf_message_set_auto_reconnect_request_parse (ctx->request->data, &enabled, &max_attempts, &max_delay);
+
+    if (max_delay == 0 || max_delay > AUTO_RECONNECT_MAX_DELAY_LIMIT_SECS) {
+        g_simple_async_result_set_error (ctx->result,
+                                         RMFD_ERROR,
+                                         RMFD_ERROR_INVALID_INPUT,
+                                         "Max delay must be between 1 and %u seconds",
+                                         AUTO_RECONNECT_MAX_DELAY_LIMIT_SECS);
+        run_context_complete_and_free (ctx);
+        return;
+    }
+
+    priv->auto_reconnect_enabled = !!enabled;
+    priv->auto_reconnect_max_attempts = max_attempts;
+    priv->auto_reconnect_max_delay = max_delay;
+
+    /* Abort the pending reconnection if disabled; an ongoing attempt will
+     * not be retried */
+    if (!priv->auto_reconnect_enabled && priv->auto_reconnect_state == RMF_AUTO_RECONNECT_STATE_WAITING) {
+        g_message ("automatic reconnection disabled");
+        auto_reconnect_cancel (ctx->self);
+        priv->connection_status = RMF_CONNECTION_STATUS_DISCONNECTED;
+    }
+
+    run_context_complete_with_response (ctx, rmf_message_set_auto_reconnect_response_new ());
+}
+
+/**********************/
+/* Is messaging ready */
+
+static void
+is_messaging_ready (RunContext *ctx)
+{
+    run_context_complete_with_response (ctx, rmf_message_is_messaging_ready_response_new (ctx->self->priv->messaging_ready));
+}
+
+/**********************/
+/* Get data format */
+
+static void
+get_data_format (RunContext *ctx)
+{
+    run_context_complete_with_response (ctx, rmf_message_get_data_format_response_new (ctx->self->priv->llp_is_raw_ip,
+                                                                                        ctx->self->priv->ul_max_datagrams,
+                                                                                        ctx->self->priv->ul_max_size,
+                                                                                        ctx->self->priv->dl_max_datagrams,
+                                                                                        ctx->self->priv->dl_max_size));
+}
+
+/**********************/
+/* Get manufacturer */
+
+static gboolean
+get_data_port_cb (RunContext *ctx)
+{
+    guint8 *response;
+
+    response = rmf_message_get_data_port_response_new (rmfd_port_get_interface (RMFD_PORT (ctx->data)));
+    g_simple_async_result_set_op_res_gpointer (ctx->result,
+                                               g_byte_array_new_take (response, rmf_message_get_length (response)),
+                                               (GDestroyNotify)g_byte_array_unref);
+    run_context_complete_and_free (ctx);
+    return FALSE;
+}
+
+static void
+get_data_port (RunContext *ctx)
+{
+    g_idle_add ((GSourceFunc) get_data_port_cb, ctx);
+}
+
+/**********************/
+/* Multiplexed sessions */
+
+static void
+mux_session_unregister_indications (MuxSession *session)
+{
+    if (!session->packet_service_status_indication_id)
+        return;
+
+    g_signal_handler_disconnect (session->wds, session->packet_service_status_indication_id);
+    session->packet_service_status_indication_id = 0;
+}
+
+/* Releasing the WDS client id also tears down the call in the modem, if any,
+ * and removing the link drops the network interface */
+static void
+mux_session_reset (MuxSession *session)
+{
+    RmfdPortProcessorQmi *self = session->self;
+
+    if (session->wds) {
+        mux_session_unregister_indications (session);
+        if (self->priv->qmi_device && qmi_device_is_open (self->priv->qmi_device))
+            qmi_device_release_client (self->priv->qmi_device,
+                                       QMI_CLIENT (session->wds),
+                                       QMI_DEVICE_RELEASE_CLIENT_FLAGS_RELEASE_CID,
+                                       3, NULL, NULL, NULL);
+        g_clear_object (&session->wds);
+    }
+
+    if (session->link) {
+        GError *error = NULL;
+
+        if (!rmfd_qmimux_del_link (session->master, session->mux_id, &error)) {
+            g_warning ("error: couldn't remove session %u link '%s': %s", session->id, session->link, error->message);
+            g_error_free (error);
+        }
+        g_clear_pointer (&session->link, g_free);
+    }
+
+    g_clear_pointer (&session->master, g_free);
+    g_clear_object (&session->data);
+    session->packet_data_handle = 0;
+    session->connection_status = RMF_CONNECTION_STATUS_DISCONNECTED;
+}
+
+/* Completes the context with an error if the session isn't valid */
+static MuxSession *
+mux_session_lookup (RunContext *ctx,
+                    guint32     id)
+{
+    GByteArray *error_message = NULL;
+
+    if (!ctx->self->priv->mux_enabled)
+        error_message = rmfd_error_message_new_from_error (ctx->request, RMFD_ERROR, RMFD_ERROR_NOT_SUPPORTED, "Multiplexed sessions not enabled");
+    else if (id < 1 || id > ctx->self->priv->mux_sessions)
+        error_message = rmfd_error_message_new_from_error (ctx->request, RMFD_ERROR, RMFD_ERROR_INVALID_INPUT, "Invalid session");
+
+    if (error_message) {
+        g_simple_async_result_set_op_res_gpointer (ctx->result, error_message, (GDestroyNotify)g_byte_array_unref);
+        run_context_complete_and_free (ctx);
+        return NULL;
+    }
+
+    return &ctx->self->priv->mux_session_list[id - 1];
+}
+
+static void
+mux_session_data_stop_ready (RmfdPortData *data,
+                             GAsyncResult *res,
+                             MuxSession   *session)
+{
+    RmfdPortProcessorQmi *self = session->self;
+    GError               *error = NULL;
+
+    if (!rmfd_port_data_setup_finish (data, res, &error)) {
+        g_warning ("error: couldn't stop session %u interface: %s", session->id, error->message);
+        g_error_free (error);
+    }
+
+    mux_session_reset (session);
+    g_object_unref (self);
+}
+
+static void
+mux_session_packet_service_status_indication_cb (QmiClientWds                              *client,
+                                                 QmiIndicationWdsPacketServiceStatusOutput *output,
+                                                 MuxSession                                *session)
+{
+    QmiWdsConnectionStatus connection_status;
+
+    if (!qmi_indication_wds_packet_service_status_output_get_connection_status (output, &connection_status, NULL, NULL))
+        return;
+
+    if (connection_status != QMI_WDS_CONNECTION_STATUS_DISCONNECTED ||
+        session->connection_status != RMF_CONNECTION_STATUS_CONNECTED)
+        return;
+
+    g_message ("session %u: network disconnected", session->id);
+
+    session->connection_status = RMF_CONNECTION_STATUS_DISCONNECTING;
+    session->packet_data_handle = 0;
+    mux_session_unregister_indications (session);
+    g_object_ref (session->self);
+    rmfd_port_data_setup (session->data,
+                          FALSE,
+                          NULL, NULL, NULL, NULL, NULL, 0,
+                          (GAsyncReadyCallback)mux_session_data_stop_ready,
+                          session);
+}
+
+/* Connect session */
+
+typedef enum {
+    MUX_CONNECT_STEP_FIRST,
+    MUX_CONNECT_STEP_CLIENT,
+    MUX_CONNECT_STEP_BIND,
+    MUX_CONNECT_STEP_IP_FAMILY,
+    MUX_CONNECT_STEP_START_NETWORK,
+    MUX_CONNECT_STEP_IP_SETTINGS,
+    MUX_CONNECT_STEP_LINK,
+    MUX_CONNECT_STEP_LINK_SETUP,
+    MUX_CONNECT_STEP_LAST,
+} MuxConnectStep;
+
+typedef struct {
+    MuxSession     *session;
+    MuxConnectStep  step;
+    gboolean        default_ip_family_set;
+    gchar          *ip_str;
+    gchar          *subnet_str;
+    gchar          *gw_str;
+    gchar          *dns1_str;
+    gchar          *dns2_str;
+    guint32         mtu;
+} MuxConnectContext;
+
+static void
+mux_connect_context_free (MuxConnectContext *ctx)
+{
+    g_free (ctx->ip_str);
+    g_free (ctx->subnet_str);
+    g_free (ctx->gw_str);
+    g_free (ctx->dns1_str);
+    g_free (ctx->dns2_str);
+    g_slice_free (MuxConnectContext, ctx);
+}
+
+static void mux_connect_step (RunContext *ctx);
+
+static void
+mux_connect_fail (RunContext *ctx,
+                  GError     *error)
+{
+    MuxConnectContext *mux_ctx = (MuxConnectContext *)ctx->additional_context;
+
+    g_warning ("error: session %u connection attempt failed: %s", mux_ctx->session->id, error->message);
+    mux_session_reset (mux_ctx->session);
+
+    g_simple_async_result_set_op_res_gpointer (ctx->result,
+                                               rmfd_error_message_new_from_gerror (ctx->request, error),
+                                               (GDestroyNotify)g_byte_array_unref);
+    g_error_free (error);
+    run_context_complete_and_free (ctx);
+}
+
+static void
+mux_data_setup_start_ready (RmfdPortData *data,
+                            GAsyncResult *res,
+                            RunContext   *ctx)
+{
+    MuxConnectContext *mux_ctx = (MuxConnectContext *)ctx->additional_context;
+    GError *error = NULL;
+
+    if (!rmfd_port_data_setup_finish (data, res, &error)) {
+        mux_connect_fail (ctx, error);
+        return;
+    }
+
+    /* Go on to next step */
+    mux_ctx->step++;
+    mux_connect_step (ctx);
+}
+
+static void
+mux_connect_step_link_setup (RunContext *ctx)
+{
+    MuxConnectContext *mux_ctx = (MuxConnectContext *)ctx->additional_context;
+
+    /* Links are always raw-ip, so static IP configuration is required */
+    if (!mux_ctx->ip_str || !mux_ctx->subnet_str) {
+        mux_connect_fail (ctx, g_error_new (RMFD_ERROR, RMFD_ERROR_UNKNOWN,
+                                            "unexpected connect state: no IP settings available"));
+        return;
+    }
+
+    rmfd_port_data_setup (mux_ctx->session->data,
+                          TRUE,
+                          mux_ctx->ip_str,
+                          mux_ctx->subnet_str,
+                          mux_ctx->gw_str,
+                          mux_ctx->dns1_str,
+                          mux_ctx->dns2_str,
+                          mux_ctx->mtu,
+                          (GAsyncReadyCallback)mux_data_setup_start_ready,
+                          ctx);
+}
+
+static void
+mux_connect_step_link (RunContext *ctx)
+{
+    MuxConnectContext *mux_ctx = (MuxConnectContext *)ctx->additional_context;
+    MuxSession *session = mux_ctx->session;
+    GError *error = NULL;
+
+    session->master = g_strdup (rmfd_port_get_interface (RMFD_PORT (ctx->data)));
+
+    /* The master interface carries the traffic of all links, with the USB
+     * transfers sized for the downlink aggregation */
+    if (!rmfd_qmimux_setup_master (session->master, ctx->self->priv->dl_max_size, &error)) {
+        mux_connect_fail (ctx, error);
+        return;
+    }
+
+    /* The link may be around already if we didn't clean it up */
+    session->link = rmfd_qmimux_find_link (session->master, session->mux_id);
+    if (!session->link) {
+        if (!rmfd_qmimux_add_link (session->master, session->mux_id, &error)) {
+            mux_connect_fail (ctx, error);
+            return;
+        }
+        session->link = rmfd_qmimux_find_link (session->master, session->mux_id);
+        if (!session->link) {
+            mux_connect_fail (ctx, g_error_new (RMFD_ERROR, RMFD_ERROR_UNKNOWN,
+                                                "couldn't find link for mux id 0x%02x", session->mux_id));
+            return;
+        }
+    }
+
+    g_debug ("session %u using link %s (mux id 0x%02x)", session->id, session->link, session->mux_id);
+    session->data = rmfd_port_data_wwan_new (session->link);
+
+    /* Go on to next step */
+    mux_ctx->step++;
+    mux_connect_step (ctx);
+}
+
+static void
+mux_get_current_settings_ready (QmiClientWds *client,
+                                GAsyncResult *res,
+                                RunContext   *ctx)
+{
+    MuxConnectContext *mux_ctx = (MuxConnectContext *)ctx->additional_context;
+    GError *error = NULL;
+    QmiMessageWdsGetCurrentSettingsOutput *output;
+
+    output = qmi_client_wds_get_current_settings_finish (client, res, &error);
+    if (output && qmi_message_wds_get_current_settings_output_get_result (output, &error))
+        current_settings_load (output,
+                               &mux_ctx->ip_str,
+                               &mux_ctx->subnet_str,
+                               &mux_ctx->gw_str,
+                               &mux_ctx->dns1_str,
+                               &mux_ctx->dns2_str,
+                               &mux_ctx->mtu);
+
+    if (output)
+        qmi_message_wds_get_current_settings_output_unref (output);
+
+    if (error) {
+        mux_connect_fail (ctx, error);
+        return;
+    }
+
+    /* Go on to next step */
+    mux_ctx->step++;
+    mux_connect_step (ctx);
+}
+
+static void
+mux_connect_step_ip_settings (RunContext *ctx)
+{
+    MuxConnectContext *mux_ctx = (MuxConnectContext *)ctx->additional_context;
+    QmiMessageWdsGetCurrentSettingsInput *input;
+
+    input = current_settings_input_new ();
+    qmi_client_wds_get_current_settings (mux_ctx->session->wds,
+                                         input,
+                                         10,
+                                         NULL,
+                                         (GAsyncReadyCallback) qmi_transaction_ready,
+                                         qmi_transaction_new (QMI_SERVICE_WDS, 10, (GAsyncReadyCallback)mux_get_current_settings_ready, ctx));
+    qmi_message_wds_get_current_settings_input_unref (input);
+}
+
+static void
+mux_wds_start_network_ready (QmiClientWds *client,
+                             GAsyncResult *res,
+                             RunContext   *ctx)
+{
+    MuxConnectContext *mux_ctx = (MuxConnectContext *)ctx->additional_context;
+    MuxSession *session = mux_ctx->session;
+    GError *error = NULL;
+    g_autoptr(QmiMessageWdsStartNetworkOutput) output = NULL;
+
+    output = qmi_client_wds_start_network_finish (client, res, &error);
+    if (output && !qmi_message_wds_start_network_output_get_result (output, &error)) {
+        /* Same as in the default session, a no-effect error means the call is
+         * already up */
+        if (g_error_matches (error, QMI_PROTOCOL_ERROR, QMI_PROTOCOL_ERROR_NO_EFFECT)) {
+            g_clear_error (&error);
+            session->packet_data_handle = GLOBAL_PACKET_DATA_HANDLE;
+        } else {
+            QmiWdsCallEndReason  cer;
+            const gchar         *str;
+
+            if (qmi_message_wds_start_network_output_get_call_end_reason (output, &cer, NULL) &&
+                (str = qmi_wds_call_end_reason_get_string (cer)) != NULL)
+                g_prefix_error (&error, "%s (%u): ", str, (guint)cer);
+        }
+    }
+
+    if (error) {
+        g_prefix_error (&error, "couldn't start network: ");
+        mux_connect_fail (ctx, error);
+        return;
+    }
+
+    if (session->packet_data_handle != GLOBAL_PACKET_DATA_HANDLE)
+        qmi_message_wds_start_network_output_get_packet_data_handle (output, &session->packet_data_handle, NULL);
+
+    session->packet_service_status_indication_id =
+        g_signal_connect (session->wds,
+                          "packet-service-status",
+                          G_CALLBACK (mux_session_packet_service_status_indication_cb),
+                          session);
+
+    /* Go on to next step */
+    mux_ctx->step++;
+    mux_connect_step (ctx);
+}
+
+static void
+mux_connect_step_start_network (RunContext *ctx)
+{
+    MuxConnectContext *mux_ctx = (MuxConnectContext *)ctx->additional_context;
+    g_autoptr(QmiMessageWdsStartNetworkInput) input = NULL;
+    guint32 id;
+    const gchar *apn;
+    const gchar *user;
+    const gchar *password;
+
+    rmf_message_connect_session_request_parse (ctx->request->data, &id, &apn, &user, &password);
+
+    input = qmi_message_wds_start_network_input_new ();
+    if (apn && apn[0])
+        qmi_message_wds_start_network_input_set_apn (input, apn, NULL);
+
+    if ((user && user[0]) || (password && password[0])) {
+        qmi_message_wds_start_network_input_set_authentication_preference (
+            input,
+            (QMI_WDS_AUTHENTICATION_PAP | QMI_WDS_AUTHENTICATION_CHAP),
+            NULL);
+        if (user && user[0])
+            qmi_message_wds_start_network_input_set_username (input, user, NULL);
+        if (password && password[0])
+            qmi_message_wds_start_network_input_set_password (input, password, NULL);
+    }
+
+    if (!mux_ctx->default_ip_family_set)
+        qmi_message_wds_start_network_input_set_ip_family_preference (input, QMI_WDS_IP_FAMILY_IPV4, NULL);
+
+    qmi_client_wds_start_network (mux_ctx->session->wds,
+                                  input,
+                                  45,
+                                  NULL,
+                                  (GAsyncReadyCallback) qmi_transaction_ready,
+                                  qmi_transaction_new (QMI_SERVICE_WDS, 45, (GAsyncReadyCallback)mux_wds_start_network_ready, ctx));
+}
+
+static void
+mux_wds_set_ip_family_ready (QmiClientWds *client,
+                             GAsyncResult *res,
+                             RunContext   *ctx)
+{
+    MuxConnectContext *mux_ctx = (MuxConnectContext *)ctx->additional_context;
+    g_autoptr(QmiMessageWdsSetIpFamilyOutput) output = NULL;
+
+    /* If there is an error setting default IP family, explicitly add it when
+     * starting network */
+    output = qmi_client_wds_set_ip_family_finish (client, res, NULL);
+    if (output && qmi_message_wds_set_ip_family_output_get_result (output, NULL))
+        mux_ctx->default_ip_family_set = TRUE;
+
+    /* Go on to next step */
+    mux_ctx->step++;
+    mux_connect_step (ctx);
+}
+
+static void
+mux_connect_step_ip_family (RunContext *ctx)
+{
+    MuxConnectContext *mux_ctx = (MuxConnectContext *)ctx->additional_context;
+    g_autoptr(QmiMessageWdsSetIpFamilyInput) input = NULL;
+
+    input = qmi_message_wds_set_ip_family_input_new ();
+    qmi_message_wds_set_ip_family_input_set_preference (input, QMI_WDS_IP_FAMILY_IPV4, NULL);
+    qmi_client_wds_set_ip_family (mux_ctx->session->wds,
+                                  input,
+                                  10,
+                                  NULL,
+                                  (GAsyncReadyCallback) qmi_transaction_ready,
+                                  qmi_transaction_new (QMI_SERVICE_WDS, 10, (GAsyncReadyCallback)mux_wds_set_ip_family_ready, ctx));
+}
+
+static void
+mux_wds_bind_mux_data_port_ready (QmiClientWds *client,
+                                  GAsyncResult *res,
+                                  RunContext   *ctx)
+{
+    MuxConnectContext *mux_ctx = (MuxConnectContext *)ctx->additional_context;
+    GError *error = NULL;
+    g_autoptr(QmiMessageWdsBindMuxDataPortOutput) output = NULL;
+
+    output = qmi_client_wds_bind_mux_data_port_finish (client, res, &error);
+    if (!output || !qmi_message_wds_bind_mux_data_port_output_get_result (output, &error)) {
+        g_prefix_error (&error, "couldn't bind mux data port: ");
+        mux_connect_fail (ctx, error);
+        return;
+    }
+
+    /* Go on to next step */
+    mux_ctx->step++;
+    mux_connect_step (ctx);
+}
+
+static void
+mux_connect_step_bind (RunContext *ctx)
+{
+    MuxConnectContext *mux_ctx = (MuxConnectContext *)ctx->additional_context;
+    g_autoptr(QmiMessageWdsBindMuxDataPortInput) input = NULL;
+    gchar *control_port;
+    guint interface_number = 0;
+    GError *error = NULL;
+
+    control_port = g_path_get_basename (rmfd_port_get_interface (RMFD_PORT (ctx->self)));
+    if (!rmfd_qmimux_get_interface_number (control_port, &interface_number, &error)) {
+        g_free (control_port);
+        mux_connect_fail (ctx, error);
+        return;
+    }
+    g_free (control_port);
+
+    input = qmi_message_wds_bind_mux_data_port_input_new ();
+    qmi_message_wds_bind_mux_data_port_input_set_endpoint_info (input, QMI_DATA_ENDPOINT_TYPE_HSUSB, interface_number, NULL);
+    qmi_message_wds_bind_mux_data_port_input_set_mux_id (input, mux_ctx->session->mux_id, NULL);
+    qmi_message_wds_bind_mux_data_port_input_set_client_type (input, QMI_WDS_CLIENT_TYPE_TETHERED, NULL);
+    qmi_client_wds_bind_mux_data_port (mux_ctx->session->wds,
+                                       input,
+                                       10,
+                                       NULL,
+                                       (GAsyncReadyCallback) qmi_transaction_ready,
+                                       qmi_transaction_new (QMI_SERVICE_WDS, 10, (GAsyncReadyCallback)mux_wds_bind_mux_data_port_ready, ctx));
 }
 
 static void
-connect_step_sim_query (RunContext *ctx)
+mux_allocate_client_ready (QmiDevice    *qmi_device,
+                           GAsyncResult *res,
+                           RunContext   *ctx)
 {
-    common_sim_slot_query (ctx->self,
-                           (GAsyncReadyCallback)common_sim_slot_query_in_connect_ready,
-                           ctx);
+    MuxConnectContext *mux_ctx = (MuxConnectContext *)ctx->additional_context;
+    QmiClient *client;
+    GError *error = NULL;
+
+    client = qmi_device_allocate_client_finish (qmi_device, res, &error);
+    if (!client) {
+        g_prefix_error (&error, "couldn't allocate WDS client: ");
+        mux_connect_fail (ctx, error);
+        return;
+    }
+    mux_ctx->session->wds = QMI_CLIENT_WDS (client);
+
+    /* Go on to next step */
+    mux_ctx->step++;
+    mux_connect_step (ctx);
 }
 
 static void
-connect_step (RunContext *ctx)
+mux_connect_step (RunContext *ctx)
 {
-    ConnectContext *connect_ctx = (ConnectContext *)ctx->additional_context;
-    guint8 *response;
+    MuxConnectContext *mux_ctx = (MuxConnectContext *)ctx->additional_context;
+    MuxSession *session = mux_ctx->session;
 
-    switch (connect_ctx->step) {
-    case CONNECT_STEP_FIRST:
-        g_warning ("connection: new connection attempt (%u/%u)...", connect_ctx->iteration, MAX_CONNECT_ITERATIONS);
-        connect_ctx->step++;
+    switch (mux_ctx->step) {
+    case MUX_CONNECT_STEP_FIRST:
+        g_message ("session %u: new connection attempt...", session->id);
+        mux_ctx->step++;
         /* fall through */
 
-    case CONNECT_STEP_SIM_QUERY:
-        g_message ("connection %u/%u step %u/%u: querying current SIM slot...",
-                   connect_ctx->iteration, MAX_CONNECT_ITERATIONS, connect_ctx->step, CONNECT_STEP_LAST);
-        connect_step_sim_query (ctx);
+    case MUX_CONNECT_STEP_CLIENT:
+        g_message ("session %u step %u/%u: allocating WDS client...", session->id, mux_ctx->step, MUX_CONNECT_STEP_LAST);
+        qmi_device_allocate_client (ctx->self->priv->qmi_device,
+                                    QMI_SERVICE_WDS,
+                                    QMI_CID_NONE,
+                                    10,
+                                    NULL,
+                                    (GAsyncReadyCallback) mux_allocate_client_ready,
+                                    ctx);
         return;
 
-    case CONNECT_STEP_IP_FAMILY:
-        g_message ("connection %u/%u step %u/%u: setting IPv4 family...",
-                   connect_ctx->iteration, MAX_CONNECT_ITERATIONS, connect_ctx->step, CONNECT_STEP_LAST);
-        connect_step_ip_family (ctx);
+    case MUX_CONNECT_STEP_BIND:
+        g_message ("session %u step %u/%u: binding mux id 0x%02x...", session->id, mux_ctx->step, MUX_CONNECT_STEP_LAST, session->mux_id);
+        mux_connect_step_bind (ctx);
         return;
 
-    case CONNECT_STEP_START_NETWORK:
-        g_message ("connection %u/%u step %u/%u: starting network...",
-                   connect_ctx->iteration, MAX_CONNECT_ITERATIONS, connect_ctx->step, CONNECT_STEP_LAST);
-        connect_step_start_network (ctx);
+    case MUX_CONNECT_STEP_IP_FAMILY:
+        g_message ("session %u step %u/%u: setting IPv4 family...", session->id, mux_ctx->step, MUX_CONNECT_STEP_LAST);
+        mux_connect_step_ip_family (ctx);
         return;
 
-    case CONNECT_STEP_IP_SETTINGS:
-        g_message ("connection %u/%u step %u/%u: retrieving IPv4 settings...",
-                   connect_ctx->iteration, MAX_CONNECT_ITERATIONS, connect_ctx->step, CONNECT_STEP_LAST);
-        connect_step_ip_settings (ctx);
+    case MUX_CONNECT_STEP_START_NETWORK:
+        g_message ("session %u step %u/%u: starting network...", session->id, mux_ctx->step, MUX_CONNECT_STEP_LAST);
+        mux_connect_step_start_network (ctx);
         return;
 
-    case CONNECT_STEP_WWAN_SETUP:
-        g_message ("connection %u/%u step %u/%u: wwan interface setup...",
-                   connect_ctx->iteration, MAX_CONNECT_ITERATIONS, connect_ctx->step, CONNECT_STEP_LAST);
-        connect_step_wwan_setup (ctx);
+    case MUX_CONNECT_STEP_IP_SETTINGS:
+        g_message ("session %u step %u/%u: retrieving IPv4 settings...", session->id, mux_ctx->step, MUX_CONNECT_STEP_LAST);
+        mux_connect_step_ip_settings (ctx);
         return;
 
-    case CONNECT_STEP_STATS:
-        g_message ("connection %u/%u step %u/%u: reseting stats...",
-                   connect_ctx->iteration, MAX_CONNECT_ITERATIONS, connect_ctx->step, CONNECT_STEP_LAST);
-        connect_step_stats (ctx);
+    case MUX_CONNECT_STEP_LINK:
+        g_message ("session %u step %u/%u: link setup...", session->id, mux_ctx->step, MUX_CONNECT_STEP_LAST);
+        mux_connect_step_link (ctx);
         return;
 
-    case CONNECT_STEP_LAST:
-        /* Ok! */
-        g_message ("connection %u/%u step %u/%u: successfully connected",
-                   connect_ctx->iteration, MAX_CONNECT_ITERATIONS, connect_ctx->step, CONNECT_STEP_LAST);
-        ctx->self->priv->connection_status = RMF_CONNECTION_STATUS_CONNECTED;
+    case MUX_CONNECT_STEP_LINK_SETUP:
+        g_message ("session %u step %u/%u: link interface setup...", session->id, mux_ctx->step, MUX_CONNECT_STEP_LAST);
+        mux_connect_step_link_setup (ctx);
+        return;
 
-        response = rmf_message_connect_response_new ();
-        g_simple_async_result_set_op_res_gpointer (ctx->result,
-                                                   g_byte_array_new_take (response, rmf_message_get_length (response)),
-                                                   (GDestroyNotify)g_byte_array_unref);
-        run_context_complete_and_free (ctx);
+    case MUX_CONNECT_STEP_LAST:
+        g_message ("session %u step %u/%u: successfully connected", session->id, mux_ctx->step, MUX_CONNECT_STEP_LAST);
+        session->connection_status = RMF_CONNECTION_STATUS_CONNECTED;
+        run_context_complete_with_response (ctx, rmf_message_connect_session_response_new (session->link));
         return;
     }
 }
 
 static void
-run_connect (RunContext *ctx)
+connect_session (RunContext *ctx)
 {
-    ConnectContext *connect_ctx;
-
-    if (ctx->self->priv->connection_status != RMF_CONNECTION_STATUS_DISCONNECTED) {
-        switch (ctx->self->priv->connection_status) {
-        case RMF_CONNECTION_STATUS_DISCONNECTING:
-            g_warning ("error connecting: currenty disconnecting");
-            g_simple_async_result_set_op_res_gpointer (
-                ctx->result,
-                rmfd_error_message_new_from_error (ctx->request, RMFD_ERROR, RMFD_ERROR_INVALID_STATE, "Currently disconnecting"),
-                (GDestroyNotify)g_byte_array_unref);
-            break;
-        case RMF_CONNECTION_STATUS_CONNECTING:
-            g_warning ("error connecting: already connecting");
-            g_simple_async_result_set_op_res_gpointer (
-                ctx->result,
-                rmfd_error_message_new_from_error (ctx->request, RMFD_ERROR, RMFD_ERROR_INVALID_STATE, "Already connecting"),
-                (GDestroyNotify)g_byte_array_unref);
-            break;
-        case RMF_CONNECTION_STATUS_CONNECTED: {
-            guint8 *response;
+    MuxConnectContext *mux_ctx;
+    MuxSession *session;
+    guint32 id;
 
-            g_debug ("already connected");
-            response = rmf_message_connect_response_new ();
-            g_simple_async_result_set_op_res_gpointer (
-                ctx->result,
-                g_byte_array_new_take (response, rmf_message_get_length (response)),
-                (GDestroyNotify)g_byte_array_unref);
-            break;
-        }
-        case RMF_CONNECTION_STATUS_DISCONNECTED:
-        default:
-            g_assert_not_reached ();
-        }
+    rmf_message_connect_session_request_parse (ctx->request->data, &id, NULL, NULL, NULL);
+    if (!(session = mux_session_lookup (ctx, id)))
+        return;
 
+    switch (session->connection_status) {
+    case RMF_CONNECTION_STATUS_DISCONNECTED:
+        break;
+    case RMF_CONNECTION_STATUS_CONNECTED:
+        g_debug ("session %u already connected", session->id);
+        run_context_complete_with_response (ctx, rmf_message_connect_session_response_new (session->link));
+        return;
+    case RMF_CONNECTION_STATUS_CONNECTING:
+    case RMF_CONNECTION_STATUS_DISCONNECTING:
+    default:
+        g_warning ("error connecting session %u: connection status change ongoing", session->id);
+        g_simple_async_result_set_op_res_gpointer (
+            ctx->result,
+            rmfd_error_message_new_from_error (ctx->request, RMFD_ERROR, RMFD_ERROR_INVALID_STATE, "Connection status change ongoing"),
+            (GDestroyNotify)g_byte_array_unref);
         run_context_complete_and_free (ctx);
         return;
     }
 
-    /* Now connecting */
-    ctx->self->priv->connection_status = RMF_CONNECTION_STATUS_CONNECTING;
-    register_wds_indications (ctx->self);
+    session->connection_status = RMF_CONNECTION_STATUS_CONNECTING;
 
-    /* Setup connect context */
-    connect_ctx = g_slice_new0 (ConnectContext);
-    connect_ctx->step = CONNECT_STEP_FIRST;
-    connect_ctx->iteration = 1;
-    run_context_set_additional_context (ctx, connect_ctx, (GDestroyNotify)connect_context_free);
-    connect_step (ctx);
+    mux_ctx = g_slice_new0 (MuxConnectContext);
+    mux_ctx->session = session;
+    mux_ctx->step = MUX_CONNECT_STEP_FIRST;
+    run_context_set_additional_context (ctx, mux_ctx, (GDestroyNotify)mux_connect_context_free);
+    mux_connect_step (ctx);
 }
 
-/**********************/
-/* Disconnect */
+/* Disconnect session */
 
 static void
-common_disconnect_ready (RmfdPortProcessorQmi *self,
-                         GAsyncResult         *res,
-                         RunContext           *ctx)
+mux_disconnect_data_stop_ready (RmfdPortData *data,
+                                GAsyncResult *res,
+                                RunContext   *ctx)
 {
-    g_autoptr(GError) error = NULL;
+    MuxSession *session = ctx->additional_context;
+    GError *error = NULL;
 
-    if (!common_disconnect_finish (self, res, &error)) {
+    mux_session_reset (session);
+
+    if (!rmfd_port_data_setup_finish (data, res, &error)) {
+        g_warning ("error: couldn't stop session %u interface: %s", session->id, error->message);
+        g_warning ("error: will assume disconnected");
         g_simple_async_result_set_op_res_gpointer (ctx->result,
                                                    rmfd_error_message_new_from_gerror (ctx->request, error),
                                                    (GDestroyNotify)g_byte_array_unref);
-    } else {
-        guint8 *response;
+        g_error_free (error);
+        run_context_complete_and_free (ctx);
+        return;
+    }
 
-        response = rmf_message_disconnect_response_new ();
+    g_message ("session %u: disconnected", session->id);
+    run_context_complete_with_response (ctx, rmf_message_disconnect_session_response_new ());
+}
+
+static void
+mux_wds_stop_network_ready (QmiClientWds *client,
+                            GAsyncResult *res,
+                            RunContext   *ctx)
+{
+    MuxSession *session = ctx->additional_context;
+    g_autoptr(QmiMessageWdsStopNetworkOutput) output = NULL;
+    GError *error = NULL;
+
+    output = qmi_client_wds_stop_network_finish (client, res, &error);
+    if (output && !qmi_message_wds_stop_network_output_get_result (output, &error)) {
+        if (g_error_matches (error, QMI_PROTOCOL_ERROR, QMI_PROTOCOL_ERROR_NO_EFFECT))
+            g_clear_error (&error);
+    }
+
+    if (error) {
+        g_warning ("error: couldn't disconnect session %u: %s", session->id, error->message);
+        session->connection_status = RMF_CONNECTION_STATUS_CONNECTED;
         g_simple_async_result_set_op_res_gpointer (ctx->result,
-                                                   g_byte_array_new_take (response, rmf_message_get_length (response)),
+                                                   rmfd_error_message_new_from_gerror (ctx->request, error),
                                                    (GDestroyNotify)g_byte_array_unref);
+        g_error_free (error);
+        run_context_complete_and_free (ctx);
+        return;
     }
 
-    run_context_complete_and_free (ctx);
+    session->packet_data_handle = 0;
+    mux_session_unregister_indications (session);
+    rmfd_port_data_setup (session->data,
+                          FALSE,
+                          NULL, NULL, NULL, NULL, NULL, 0,
+                          (GAsyncReadyCallback)mux_disconnect_data_stop_ready,
+                          ctx);
 }
 
 static void
-disconnect (RunContext *ctx)
+disconnect_session (RunContext *ctx)
 {
-    if (ctx->self->priv->connection_status != RMF_CONNECTION_STATUS_CONNECTED) {
-        switch (ctx->self->priv->connection_status) {
-        case RMF_CONNECTION_STATUS_DISCONNECTING:
-            g_warning ("error: cannot disconnect: already disconnecting");
-            g_simple_async_result_set_op_res_gpointer (
-                ctx->result,
-                rmfd_error_message_new_from_error (ctx->request, RMFD_ERROR, RMFD_ERROR_INVALID_STATE, "Already disconnecting"),
-                (GDestroyNotify)g_byte_array_unref);
-            break;
-        case RMF_CONNECTION_STATUS_CONNECTING:
-            g_warning ("error: cannot disconnect: currently connecting");
-            g_simple_async_result_set_op_res_gpointer (
-                ctx->result,
-                rmfd_error_message_new_from_error (ctx->request, RMFD_ERROR, RMFD_ERROR_INVALID_STATE, "Currently connecting"),
-                (GDestroyNotify)g_byte_array_unref);
-            break;
-        case RMF_CONNECTION_STATUS_DISCONNECTED: {
-            guint8 *response;
+    g_autoptr(QmiMessageWdsStopNetworkInput) input = NULL;
+    MuxSession *session;
+    guint32 id;
 
-            g_debug ("already disconnected");
-            response = rmf_message_disconnect_response_new ();
-            g_simple_async_result_set_op_res_gpointer (
-                ctx->result,
-                g_byte_array_new_take (response, rmf_message_get_length (response)),
-                (GDestroyNotify)g_byte_array_unref);
-            break;
-        }
-        case RMF_CONNECTION_STATUS_CONNECTED:
-        default:
-            g_assert_not_reached ();
-        }
+    rmf_message_disconnect_session_request_parse (ctx->request->data, &id);
+    if (!(session = mux_session_lookup (ctx, id)))
+        return;
 
+    switch (session->connection_status) {
+    case RMF_CONNECTION_STATUS_CONNECTED:
+        break;
+    case RMF_CONNECTION_STATUS_DISCONNECTED:
+        g_debug ("session %u already disconnected", session->id);
+        run_context_complete_with_response (ctx, rmf_message_disconnect_session_response_new ());
+        return;
+    case RMF_CONNECTION_STATUS_CONNECTING:
+    case RMF_CONNECTION_STATUS_DISCONNECTING:
+    default:
+        g_warning ("error disconnecting session %u: connection status change ongoing", session->id);
+        g_simple_async_result_set_op_res_gpointer (
+            ctx->result,
+            rmfd_error_message_new_from_error (ctx->request, RMFD_ERROR, RMFD_ERROR_INVALID_STATE, "Connection status change ongoing"),
+            (GDestroyNotify)g_byte_array_unref);
         run_context_complete_and_free (ctx);
         return;
     }
 
-    common_disconnect (ctx->self,
-                       (GAsyncReadyCallback)common_disconnect_ready,
-                       ctx);
+    session->connection_status = RMF_CONNECTION_STATUS_DISCONNECTING;
+    run_context_set_additional_context (ctx, session, NULL);
+
+    input = qmi_message_wds_stop_network_input_new ();
+    qmi_message_wds_stop_network_input_set_packet_data_handle (input, session->packet_data_handle, NULL);
+    qmi_client_wds_stop_network (session->wds,
+                                 input,
+                                 30,
+                                 NULL,
+                                 (GAsyncReadyCallback) qmi_transaction_ready,
+                                 qmi_transaction_new (QMI_SERVICE_WDS, 30, (GAsyncReadyCallback)mux_wds_stop_network_ready, ctx));
 }
 
-/**********************/
-/* Get manufacturer */
+/* Get session status */
 
-static gboolean
-get_data_port_cb (RunContext *ctx)
+static void
+get_session_status (RunContext *ctx)
 {
-    guint8 *response;
+    MuxSession *session;
+    guint32 id;
 
-    response = rmf_message_get_data_port_response_new (rmfd_port_get_interface (RMFD_PORT (ctx->data)));
-    g_simple_async_result_set_op_res_gpointer (ctx->result,
-                                               g_byte_array_new_take (response, rmf_message_get_length (response)),
-                                               (GDestroyNotify)g_byte_array_unref);
-    run_context_complete_and_free (ctx);
-    return FALSE;
+    rmf_message_get_session_status_request_parse (ctx->request->data, &id);
+    if (!(session = mux_session_lookup (ctx, id)))
+        return;
+
+    run_context_complete_with_response (ctx, rmf_message_get_session_status_response_new (session->connection_status,
+                                                                                           session->link ? session->link : ""));
 }
 
+/* Get session stats */
+
 static void
-get_data_port (RunContext *ctx)
+mux_get_packet_statistics_ready (QmiClientWds *client,
+                                 GAsyncResult *res,
+                                 RunContext   *ctx)
 {
-    g_idle_add ((GSourceFunc) get_data_port_cb, ctx);
+    g_autoptr(QmiMessageWdsGetPacketStatisticsOutput) output = NULL;
+    GError *error = NULL;
+    PacketStats stats;
+
+    output = qmi_client_wds_get_packet_statistics_finish (client, res, &error);
+    if (!output || !qmi_message_wds_get_packet_statistics_output_get_result (output, &error)) {
+        g_prefix_error (&error, "couldn't get packet statistics: ");
+        g_simple_async_result_take_error (ctx->result, error);
+        run_context_complete_and_free (ctx);
+        return;
+    }
+
+    packet_stats_load (&stats, output);
+    run_context_complete_with_response (ctx, rmf_message_get_session_stats_response_new (stats.tx_packets_ok,
+                                                                                          stats.rx_packets_ok,
+                                                                                          stats.tx_packets_error,
+                                                                                          stats.rx_packets_error,
+                                                                                          stats.tx_overflows,
+                                                                                          stats.rx_overflows,
+                                                                                          stats.tx_bytes_ok,
+                                                                                          stats.rx_bytes_ok));
+}
+
+static void
+get_session_stats (RunContext *ctx)
+{
+    QmiMessageWdsGetPacketStatisticsInput *input;
+    MuxSession *session;
+    guint32 id;
+
+    rmf_message_get_session_stats_request_parse (ctx->request->data, &id);
+    if (!(session = mux_session_lookup (ctx, id)))
+        return;
+
+    if (!session->wds) {
+        g_simple_async_result_set_op_res_gpointer (
+            ctx->result,
+            rmfd_error_message_new_from_error (ctx->request, RMFD_ERROR, RMFD_ERROR_INVALID_STATE, "Session not connected"),
+            (GDestroyNotify)g_byte_array_unref);
+        run_context_complete_and_free (ctx);
+        return;
+    }
+
+    input = packet_statistics_input_new ();
+    qmi_client_wds_get_packet_statistics (session->wds,
+                                          input,
+                                          10,
+                                          NULL,
+                                          (GAsyncReadyCallback) qmi_transaction_ready,
+                                          qmi_transaction_new (QMI_SERVICE_WDS, 10, (GAsyncReadyCallback)mux_get_packet_statistics_ready, ctx));
+    qmi_message_wds_get_packet_statistics_input_unref (input);
 }
 
 /**********************/
@@ -4151,6 +7030,7 @@ run (RmfdPortProcessor   *self,
                                              rmfd_port_processor_run);
     ctx->request = g_byte_array_ref (request);
     ctx->data = g_object_ref (data);
+    rmfd_tracing_get_current (&ctx->trace_request_id, &ctx->trace_command);
 
     if (rmf_message_get_type (request->data) != RMF_MESSAGE_TYPE_REQUEST) {
         g_simple_async_result_set_error (ctx->result,
@@ -4195,6 +7075,9 @@ run (RmfdPortProcessor   *self,
     case RMF_MESSAGE_COMMAND_IS_SIM_LOCKED:
         is_sim_locked (ctx);
         return;
+    case RMF_MESSAGE_COMMAND_IS_MESSAGING_READY:
+        is_messaging_ready (ctx);
+        return;
     case RMF_MESSAGE_COMMAND_UNLOCK:
         unlock (ctx);
         return;
@@ -4228,6 +7111,15 @@ run (RmfdPortProcessor   *self,
     case RMF_MESSAGE_COMMAND_SET_REGISTRATION_TIMEOUT:
         set_registration_timeout (ctx);
         return;
+    case RMF_MESSAGE_COMMAND_GET_AVAILABLE_NETWORKS:
+        get_available_networks (ctx);
+        return;
+    case RMF_MESSAGE_COMMAND_SCAN_NETWORKS:
+        scan_networks (ctx);
+        return;
+    case RMF_MESSAGE_COMMAND_CANCEL_NETWORK_SCAN:
+        cancel_network_scan (ctx);
+        return;
     case RMF_MESSAGE_COMMAND_GET_CONNECTION_STATUS:
         get_connection_status (ctx);
         return;
@@ -4240,9 +7132,30 @@ run (RmfdPortProcessor   *self,
     case RMF_MESSAGE_COMMAND_DISCONNECT:
         disconnect (ctx);
         return;
+    case RMF_MESSAGE_COMMAND_GET_AUTO_RECONNECT:
+        get_auto_reconnect (ctx);
+        return;
+    case RMF_MESSAGE_COMMAND_SET_AUTO_RECONNECT:
+        set_auto_reconnect (ctx);
+        return;
     case RMF_MESSAGE_COMMAND_GET_DATA_PORT:
         get_data_port (ctx);
         return;
+    case RMF_MESSAGE_COMMAND_GET_DATA_FORMAT:
+        get_data_format (ctx);
+        return;
+    case RMF_MESSAGE_COMMAND_CONNECT_SESSION:
+        connect_session (ctx);
+        return;
+    case RMF_MESSAGE_COMMAND_DISCONNECT_SESSION:
+        disconnect_session (ctx);
+        return;
+    case RMF_MESSAGE_COMMAND_GET_SESSION_STATUS:
+        get_session_status (ctx);
+        return;
+    case RMF_MESSAGE_COMMAND_GET_SESSION_STATS:
+        get_session_stats (ctx);
+        return;
     default:
         break;
     }
@@ -4301,7 +7214,12 @@ sms_added_cb (RmfdSmsList          *sms_list,
             qmi_message_wms_delete_input_set_memory_storage (input, rmfd_sms_get_storage (sms), NULL);
             qmi_message_wms_delete_input_set_memory_index   (input, (guint32) rmfd_sms_part_get_index ((RmfdSmsPart *)l->data), NULL);
             qmi_message_wms_delete_input_set_message_mode   (input, QMI_WMS_MESSAGE_MODE_GSM_WCDMA, NULL);
-            qmi_client_wms_delete (wms, input, 5, NULL, NULL, NULL);
+            qmi_client_wms_delete (wms,
+                                   input,
+                                   5,
+                                   NULL,
+                                   (GAsyncReadyCallback) qmi_transaction_ready,
+                                   qmi_transaction_new (QMI_SERVICE_WMS, 5, NULL, NULL));
             qmi_message_wms_delete_input_unref (input);
         }
     }
@@ -4424,8 +7342,8 @@ messaging_event_report_indication_cb (QmiClientNas                      *client,
                                  input,
                                  3,
                                  NULL,
-                                 (GAsyncReadyCallback)wms_indication_raw_read_ready,
-                                 ctx);
+                                 (GAsyncReadyCallback) qmi_transaction_ready,
+                                 qmi_transaction_new (QMI_SERVICE_WMS, 3, (GAsyncReadyCallback)wms_indication_raw_read_ready, ctx));
         qmi_message_wms_raw_read_input_unref (input);
     }
 }
@@ -4449,7 +7367,12 @@ unregister_wms_indications (RmfdPortProcessorQmi *self)
 
     input = qmi_message_wms_set_event_report_input_new ();
     qmi_message_wms_set_event_report_input_set_new_mt_message_indicator (input, FALSE, NULL);
-    qmi_client_wms_set_event_report (wms, input, 5, NULL, NULL, NULL);
+    qmi_client_wms_set_event_report (wms,
+                                     input,
+                                     5,
+                                     NULL,
+                                     (GAsyncReadyCallback) qmi_transaction_ready,
+                                     qmi_transaction_new (QMI_SERVICE_WMS, 5, NULL, NULL));
     qmi_message_wms_set_event_report_input_unref (input);
 }
 
@@ -4483,8 +7406,8 @@ messaging_list_parts_context_free (MessagingListPartsContext *ctx)
     g_slice_free (MessagingListPartsContext, ctx);
 }
 
-static void messaging_list_parts_context_step (MessagingListPartsContext *ctx);
-static void read_next_sms_part                (MessagingListPartsContext *ctx);
+static void     messaging_list_parts_context_step (MessagingListPartsContext *ctx);
+static gboolean read_next_sms_part                (MessagingListPartsContext *ctx);
 
 static void
 wms_raw_read_ready (QmiClientWms              *client,
@@ -4517,12 +7440,13 @@ wms_raw_read_ready (QmiClientWms              *client,
     if (output)
         qmi_message_wms_raw_read_output_unref (output);
 
-    /* Keep on reading parts */
+    /* Keep on reading parts, but only when there's nothing more important to
+     * do, as a SIM full of messages may take long to read */
     ctx->i++;
-    read_next_sms_part (ctx);
+    g_idle_add_full (G_PRIORITY_LOW, (GSourceFunc) read_next_sms_part, ctx, NULL);
 }
 
-static void
+static gboolean
 read_next_sms_part (MessagingListPartsContext *ctx)
 {
     QmiMessageWmsListMessagesOutputMessageListElement *message;
@@ -4531,7 +7455,7 @@ read_next_sms_part (MessagingListPartsContext *ctx)
     if (!ctx->message_array || (ctx->i >= ctx->message_array->len)) {
         ctx->step++;
         messaging_list_parts_context_step (ctx);
-        return;
+        return FALSE;
     }
 
     message = &g_array_index (ctx->message_array,
@@ -4552,9 +7476,10 @@ read_next_sms_part (MessagingListPartsContext *ctx)
                              input,
                              3,
                              NULL,
-                             (GAsyncReadyCallback)wms_raw_read_ready,
-                             ctx);
+                             (GAsyncReadyCallback) qmi_transaction_ready,
+                             qmi_transaction_new (QMI_SERVICE_WMS, 3, (GAsyncReadyCallback)wms_raw_read_ready, ctx));
     qmi_message_wms_raw_read_input_unref (input);
+    return FALSE;
 }
 
 static void
@@ -4615,8 +7540,8 @@ messaging_list_parts_context_list (MessagingListPartsContext *ctx)
                                   input,
                                   5,
                                   NULL,
-                                  (GAsyncReadyCallback) wms_list_messages_ready,
-                                  ctx);
+                                  (GAsyncReadyCallback) qmi_transaction_ready,
+                                  qmi_transaction_new (QMI_SERVICE_WMS, 5, (GAsyncReadyCallback) wms_list_messages_ready, ctx));
     qmi_message_wms_list_messages_input_unref (input);
 }
 
@@ -4798,6 +7723,12 @@ messaging_list_context_init (RmfdPortProcessorQmi *self,
 static void
 messaging_list (RmfdPortProcessorQmi *self)
 {
+    /* Listing is launched once setup finishes */
+    if (!self->priv->messaging_ready) {
+        g_debug ("[messaging] not ready yet, deferring listing...");
+        return;
+    }
+
     if (!G_LIKELY (self->priv->messaging_sms_contexts)) {
         MessagingListContext ctx;
 
@@ -4866,6 +7797,9 @@ ser_messaging_indicator_ready (QmiClientWms         *client,
 
     output = qmi_client_wms_set_event_report_finish (client, res, &error);
     if (!output || !qmi_message_wms_set_event_report_output_get_result (output, &error)) {
+        /* Connected again if the setup is retried */
+        g_signal_handler_disconnect (client, ctx->self->priv->messaging_event_report_indication_id);
+        ctx->self->priv->messaging_event_report_indication_id = 0;
         g_simple_async_result_take_error (ctx->result, error);
         messaging_init_context_complete_and_free (ctx);
     } else {
@@ -4932,8 +7866,8 @@ messaging_init_context_step (MessagingInitContext *ctx)
                                    input,
                                    5,
                                    NULL,
-                                   (GAsyncReadyCallback)wms_set_routes_ready,
-                                   ctx);
+                                   (GAsyncReadyCallback) qmi_transaction_ready,
+                                   qmi_transaction_new (QMI_SERVICE_WMS, 5, (GAsyncReadyCallback)wms_set_routes_ready, ctx));
         qmi_message_wms_set_routes_input_unref (input);
         g_array_unref (routes_array);
         return;
@@ -4956,8 +7890,8 @@ messaging_init_context_step (MessagingInitContext *ctx)
                                          input,
                                          5,
                                          NULL,
-                                         (GAsyncReadyCallback)ser_messaging_indicator_ready,
-                                         ctx);
+                                         (GAsyncReadyCallback) qmi_transaction_ready,
+                                         qmi_transaction_new (QMI_SERVICE_WMS, 5, (GAsyncReadyCallback)ser_messaging_indicator_ready, ctx));
         qmi_message_wms_set_event_report_input_unref (input);
         return;
     }
@@ -4991,6 +7925,88 @@ messaging_init (RmfdPortProcessorQmi *self,
     messaging_init_context_step (ctx);
 }
 
+/*****************************************************************************/
+/* Messaging background setup */
+
+static gboolean messaging_setup_cb (RmfdPortProcessorQmi *self);
+
+static void
+messaging_setup_ready (RmfdPortProcessorQmi *self,
+                       GAsyncResult         *res)
+{
+    GError *error = NULL;
+
+    /* Counted once finished, so that it isn't rerun while ongoing */
+    self->priv->messaging_setup_attempt++;
+
+    if (!messaging_init_finish (self, res, &error)) {
+        guint delay;
+
+        if (self->priv->messaging_setup_attempt >= MESSAGING_SETUP_MAX_ATTEMPTS) {
+            g_warning ("[messaging] couldn't initialize SMS messaging support: %s (retrying on next card status change)",
+                       error->message);
+            g_error_free (error);
+            return;
+        }
+
+        delay = rmfd_utils_get_backoff_delay (MESSAGING_SETUP_RETRY_INITIAL_MSECS,
+                                              MESSAGING_SETUP_RETRY_MAX_MSECS,
+                                              self->priv->messaging_setup_attempt);
+        g_warning ("[messaging] couldn't initialize SMS messaging support: %s (retrying in %ums)",
+                   error->message, delay);
+        g_error_free (error);
+
+        g_assert (!self->priv->messaging_setup_id);
+        self->priv->messaging_setup_id = g_timeout_add (delay, (GSourceFunc) messaging_setup_cb, self);
+        return;
+    }
+
+    g_debug ("SMS messaging support initialized");
+    self->priv->messaging_ready = TRUE;
+
+    /* Launch SMS listing, which will succeed here only if PIN unlocked or disabled */
+    messaging_list (self);
+}
+
+static gboolean
+messaging_setup_cb (RmfdPortProcessorQmi *self)
+{
+    self->priv->messaging_setup_id = 0;
+
+    g_debug ("initializing messaging support...");
+    messaging_init (self,
+                    (GAsyncReadyCallback) messaging_setup_ready,
+                    NULL);
+    return FALSE;
+}
+
+static void
+messaging_setup (RmfdPortProcessorQmi *self)
+{
+    /* Not needed to serve connection requests, so don't delay the processor
+     * being reported ready because of it */
+    g_assert (!self->priv->messaging_setup_id);
+    self->priv->messaging_setup_attempt = 0;
+    self->priv->messaging_setup_id = g_idle_add_full (G_PRIORITY_LOW,
+                                                      (GSourceFunc) messaging_setup_cb,
+                                                      self,
+                                                      NULL);
+}
+
+static void
+messaging_setup_rerun (RmfdPortProcessorQmi *self)
+{
+    /* Only once out of attempts; otherwise the setup is either done, not
+     * launched yet, or ongoing or scheduled */
+    if (self->priv->messaging_ready ||
+        self->priv->messaging_setup_attempt < MESSAGING_SETUP_MAX_ATTEMPTS ||
+        self->priv->messaging_setup_id)
+        return;
+
+    g_debug ("[messaging] relaunching setup...");
+    messaging_setup (self);
+}
+
 /*****************************************************************************/
 /* Data format init */
 
@@ -4998,6 +8014,7 @@ typedef enum {
     DATA_FORMAT_INIT_CONTEXT_STEP_FIRST,
     DATA_FORMAT_INIT_CONTEXT_STEP_KERNEL_DATA_FORMAT,
     DATA_FORMAT_INIT_CONTEXT_STEP_CLIENT_WDA,
+    DATA_FORMAT_INIT_CONTEXT_STEP_CLIENT_SET_DATA_FORMAT,
     DATA_FORMAT_INIT_CONTEXT_STEP_CLIENT_DATA_FORMAT,
     DATA_FORMAT_INIT_CONTEXT_STEP_CHECK,
     DATA_FORMAT_INIT_CONTEXT_STEP_SET_KERNEL_DATA_FORMAT,
@@ -5012,19 +8029,28 @@ typedef struct {
     QmiDeviceExpectedDataFormat  kernel_data_format;
     QmiWdaLinkLayerProtocol      llp;
     QmiClientWda                *wda;
+    gboolean                     qmap_failed;
+    gboolean                     disable_aggregation;
 } DataFormatInitContext;
 
+static void
+data_format_init_context_release_wda (DataFormatInitContext *ctx)
+{
+    if (!ctx->wda)
+        return;
+
+    qmi_device_release_client (ctx->self->priv->qmi_device,
+                               QMI_CLIENT (ctx->wda),
+                               QMI_DEVICE_RELEASE_CLIENT_FLAGS_RELEASE_CID,
+                               3, NULL, NULL, NULL);
+    g_clear_object (&ctx->wda);
+}
+
 static void
 data_format_init_context_complete_and_free (DataFormatInitContext *ctx)
 {
     g_simple_async_result_complete_in_idle (ctx->result);
-    if (ctx->wda) {
-        qmi_device_release_client (ctx->self->priv->qmi_device,
-                                   QMI_CLIENT (ctx->wda),
-                                   QMI_DEVICE_RELEASE_CLIENT_FLAGS_RELEASE_CID,
-                                   3, NULL, NULL, NULL);
-        g_object_unref (ctx->wda);
-    }
+    data_format_init_context_release_wda (ctx);
     if (ctx->cancellable)
         g_object_unref (ctx->cancellable);
     g_object_unref (ctx->result);
@@ -5050,6 +8076,9 @@ get_data_format_ready (QmiClientWda          *client,
     QmiMessageWdaGetDataFormatOutput *output;
     GError                           *error = NULL;
 
+    QmiWdaDataAggregationProtocol     ul_aggregation = QMI_WDA_DATA_AGGREGATION_PROTOCOL_DISABLED;
+    QmiWdaDataAggregationProtocol     dl_aggregation = QMI_WDA_DATA_AGGREGATION_PROTOCOL_DISABLED;
+
     output = qmi_client_wda_get_data_format_finish (client, res, &error);
     if (!output ||
         !qmi_message_wda_get_data_format_output_get_result (output, &error) ||
@@ -5060,6 +8089,21 @@ get_data_format_ready (QmiClientWda          *client,
         goto out;
     }
 
+    /* A single session can't be used while the modem aggregates packets,
+     * e.g. if QMAP was left enabled by a previous multiplexing run */
+    qmi_message_wda_get_data_format_output_get_uplink_data_aggregation_protocol (output, &ul_aggregation, NULL);
+    qmi_message_wda_get_data_format_output_get_downlink_data_aggregation_protocol (output, &dl_aggregation, NULL);
+    if (ul_aggregation != QMI_WDA_DATA_AGGREGATION_PROTOCOL_DISABLED ||
+        dl_aggregation != QMI_WDA_DATA_AGGREGATION_PROTOCOL_DISABLED) {
+        g_debug ("Data aggregation enabled (uplink %s, downlink %s): disabling it",
+                 qmi_wda_data_aggregation_protocol_get_string (ul_aggregation),
+                 qmi_wda_data_aggregation_protocol_get_string (dl_aggregation));
+        ctx->disable_aggregation = TRUE;
+        ctx->step = DATA_FORMAT_INIT_CONTEXT_STEP_CLIENT_SET_DATA_FORMAT;
+        data_format_init_context_step (ctx);
+        goto out;
+    }
+
     /* Go on to next step */
     ctx->step++;
     data_format_init_context_step (ctx);
@@ -5069,6 +8113,99 @@ out:
         qmi_message_wda_get_data_format_output_unref (output);
 }
 
+static void
+set_data_format_ready (QmiClientWda          *client,
+                       GAsyncResult          *res,
+                       DataFormatInitContext *ctx)
+{
+    QmiMessageWdaSetDataFormatOutput *output;
+    GError                           *error = NULL;
+    QmiWdaLinkLayerProtocol           llp = QMI_WDA_LINK_LAYER_PROTOCOL_UNKNOWN;
+    QmiWdaDataAggregationProtocol     ul_aggregation = QMI_WDA_DATA_AGGREGATION_PROTOCOL_DISABLED;
+    QmiWdaDataAggregationProtocol     dl_aggregation = QMI_WDA_DATA_AGGREGATION_PROTOCOL_DISABLED;
+
+    output = qmi_client_wda_set_data_format_finish (client, res, &error);
+    if (!output ||
+        !qmi_message_wda_set_data_format_output_get_result (output, &error)) {
+        /* Without QMAP, go on with a single session in whatever data format
+         * the modem is using */
+        if (!ctx->disable_aggregation) {
+            g_warning ("couldn't set QMAP data format: %s: falling back to a single data session", error->message);
+            g_error_free (error);
+            ctx->qmap_failed = TRUE;
+            ctx->step = DATA_FORMAT_INIT_CONTEXT_STEP_CLIENT_DATA_FORMAT;
+            data_format_init_context_step (ctx);
+            goto out;
+        }
+        g_prefix_error (&error, "error disabling data aggregation with WDA client: ");
+        g_simple_async_result_take_error (ctx->result, error);
+        data_format_init_context_complete_and_free (ctx);
+        goto out;
+    }
+
+    /* The modem reports the data format it actually uses, which may not be
+     * the one requested */
+    qmi_message_wda_set_data_format_output_get_link_layer_protocol (output, &llp, NULL);
+    qmi_message_wda_set_data_format_output_get_uplink_data_aggregation_protocol (output, &ul_aggregation, NULL);
+    qmi_message_wda_set_data_format_output_get_downlink_data_aggregation_protocol (output, &dl_aggregation, NULL);
+
+    if (ctx->disable_aggregation) {
+        if (ul_aggregation != QMI_WDA_DATA_AGGREGATION_PROTOCOL_DISABLED ||
+            dl_aggregation != QMI_WDA_DATA_AGGREGATION_PROTOCOL_DISABLED) {
+            g_simple_async_result_set_error (ctx->result,
+                                             RMFD_ERROR,
+                                             RMFD_ERROR_NOT_SUPPORTED,
+                                             "couldn't disable data aggregation");
+            data_format_init_context_complete_and_free (ctx);
+            goto out;
+        }
+        if (llp == QMI_WDA_LINK_LAYER_PROTOCOL_RAW_IP || llp == QMI_WDA_LINK_LAYER_PROTOCOL_802_3)
+            ctx->llp = llp;
+        g_debug ("Data aggregation disabled");
+        ctx->step = DATA_FORMAT_INIT_CONTEXT_STEP_CHECK;
+        data_format_init_context_step (ctx);
+        goto out;
+    }
+
+    if (llp != QMI_WDA_LINK_LAYER_PROTOCOL_RAW_IP ||
+        ul_aggregation != QMI_WDA_DATA_AGGREGATION_PROTOCOL_QMAP ||
+        dl_aggregation != QMI_WDA_DATA_AGGREGATION_PROTOCOL_QMAP) {
+        g_warning ("modem didn't accept the QMAP data format (%s, uplink %s, downlink %s): falling back to a single data session",
+                   qmi_wda_link_layer_protocol_get_string (llp),
+                   qmi_wda_data_aggregation_protocol_get_string (ul_aggregation),
+                   qmi_wda_data_aggregation_protocol_get_string (dl_aggregation));
+        ctx->qmap_failed = TRUE;
+        ctx->step = DATA_FORMAT_INIT_CONTEXT_STEP_CLIENT_DATA_FORMAT;
+        data_format_init_context_step (ctx);
+        goto out;
+    }
+
+    /* The modem may reduce the requested limits; if it doesn't report them,
+     * they're unknown (0) rather than assumed to be the requested ones */
+    ctx->self->priv->dl_max_datagrams = 0;
+    ctx->self->priv->dl_max_size = 0;
+    ctx->self->priv->ul_max_datagrams = 0;
+    ctx->self->priv->ul_max_size = 0;
+    qmi_message_wda_set_data_format_output_get_downlink_data_aggregation_max_datagrams (output, &ctx->self->priv->dl_max_datagrams, NULL);
+    qmi_message_wda_set_data_format_output_get_downlink_data_aggregation_max_size (output, &ctx->self->priv->dl_max_size, NULL);
+    qmi_message_wda_set_data_format_output_get_uplink_data_aggregation_max_datagrams (output, &ctx->self->priv->ul_max_datagrams, NULL);
+    qmi_message_wda_set_data_format_output_get_uplink_data_aggregation_max_size (output, &ctx->self->priv->ul_max_size, NULL);
+
+    g_debug ("QMAP data format set: %u multiplexed sessions available", ctx->self->priv->mux_sessions);
+    g_debug ("  downlink aggregation: %u datagrams, %u bytes", ctx->self->priv->dl_max_datagrams, ctx->self->priv->dl_max_size);
+    g_debug ("  uplink aggregation: %u datagrams, %u bytes", ctx->self->priv->ul_max_datagrams, ctx->self->priv->ul_max_size);
+    ctx->self->priv->mux_enabled = TRUE;
+    ctx->llp = QMI_WDA_LINK_LAYER_PROTOCOL_RAW_IP;
+
+    /* Go on to check the kernel data format */
+    ctx->step = DATA_FORMAT_INIT_CONTEXT_STEP_CHECK;
+    data_format_init_context_step (ctx);
+
+out:
+    if (output)
+        qmi_message_wda_set_data_format_output_unref (output);
+}
+
 static void
 wda_allocate_client_ready (QmiDevice             *qmi_device,
                            GAsyncResult          *res,
@@ -5108,6 +8245,26 @@ data_format_init_context_step (DataFormatInitContext *ctx)
             data_format_init_context_complete_and_free (ctx);
             return;
         }
+
+        /* If the device wasn't reset since a previous run, and the kernel
+         * still expects the data format we negotiated back then, there is no
+         * need to query it again. QMAP is always negotiated explicitly, and
+         * must be disabled if no longer requested, so the cached format is
+         * only reused for single sessions. */
+        if (!ctx->self->priv->mux_sessions &&
+            ctx->self->priv->probe_hint &&
+            ctx->self->priv->probe_hint->data_format_valid &&
+            !ctx->self->priv->probe_hint->qmap &&
+            ((ctx->self->priv->probe_hint->llp_is_raw_ip && ctx->kernel_data_format == QMI_DEVICE_EXPECTED_DATA_FORMAT_RAW_IP) ||
+             (!ctx->self->priv->probe_hint->llp_is_raw_ip && ctx->kernel_data_format == QMI_DEVICE_EXPECTED_DATA_FORMAT_802_3))) {
+            g_debug ("Reusing cached data format: %s",
+                     qmi_device_expected_data_format_get_string (ctx->kernel_data_format));
+            ctx->self->priv->llp_is_raw_ip = ctx->self->priv->probe_hint->llp_is_raw_ip;
+            ctx->step = DATA_FORMAT_INIT_CONTEXT_STEP_LAST;
+            data_format_init_context_step (ctx);
+            return;
+        }
+
         ctx->step++;
         /* fall through */
 
@@ -5121,16 +8278,59 @@ data_format_init_context_step (DataFormatInitContext *ctx)
                                     ctx);
         return;
 
+    case DATA_FORMAT_INIT_CONTEXT_STEP_CLIENT_SET_DATA_FORMAT:
+        /* Multiplexed sessions require raw-ip with QMAP aggregation in both
+         * directions */
+        if (ctx->self->priv->mux_sessions && !ctx->qmap_failed && !ctx->disable_aggregation) {
+            g_autoptr(QmiMessageWdaSetDataFormatInput) input = NULL;
+
+            input = qmi_message_wda_set_data_format_input_new ();
+            qmi_message_wda_set_data_format_input_set_link_layer_protocol (input, QMI_WDA_LINK_LAYER_PROTOCOL_RAW_IP, NULL);
+            qmi_message_wda_set_data_format_input_set_uplink_data_aggregation_protocol (input, QMI_WDA_DATA_AGGREGATION_PROTOCOL_QMAP, NULL);
+            qmi_message_wda_set_data_format_input_set_downlink_data_aggregation_protocol (input, QMI_WDA_DATA_AGGREGATION_PROTOCOL_QMAP, NULL);
+            qmi_message_wda_set_data_format_input_set_downlink_data_aggregation_max_datagrams (input, QMAP_DL_MAX_DATAGRAMS, NULL);
+            qmi_message_wda_set_data_format_input_set_downlink_data_aggregation_max_size (input, QMAP_DL_MAX_SIZE, NULL);
+            qmi_client_wda_set_data_format (ctx->wda,
+                                            input,
+                                            10,
+                                            ctx->cancellable,
+                                            (GAsyncReadyCallback) qmi_transaction_ready,
+                                            qmi_transaction_new (QMI_SERVICE_WDA, 10, (GAsyncReadyCallback) set_data_format_ready, ctx));
+            return;
+        }
+
+        /* Single sessions keep the link layer protocol the modem reported */
+        if (ctx->disable_aggregation) {
+            g_autoptr(QmiMessageWdaSetDataFormatInput) input = NULL;
+
+            input = qmi_message_wda_set_data_format_input_new ();
+            qmi_message_wda_set_data_format_input_set_link_layer_protocol (input, ctx->llp, NULL);
+            qmi_message_wda_set_data_format_input_set_uplink_data_aggregation_protocol (input, QMI_WDA_DATA_AGGREGATION_PROTOCOL_DISABLED, NULL);
+            qmi_message_wda_set_data_format_input_set_downlink_data_aggregation_protocol (input, QMI_WDA_DATA_AGGREGATION_PROTOCOL_DISABLED, NULL);
+            qmi_client_wda_set_data_format (ctx->wda,
+                                            input,
+                                            10,
+                                            ctx->cancellable,
+                                            (GAsyncReadyCallback) qmi_transaction_ready,
+                                            qmi_transaction_new (QMI_SERVICE_WDA, 10, (GAsyncReadyCallback) set_data_format_ready, ctx));
+            return;
+        }
+        ctx->step++;
+        /* fall through */
+
     case DATA_FORMAT_INIT_CONTEXT_STEP_CLIENT_DATA_FORMAT:
         qmi_client_wda_get_data_format (ctx->wda,
                                         NULL,
                                         10,
                                         ctx->cancellable,
-                                        (GAsyncReadyCallback) get_data_format_ready,
-                                        ctx);
+                                        (GAsyncReadyCallback) qmi_transaction_ready,
+                                        qmi_transaction_new (QMI_SERVICE_WDA, 10, (GAsyncReadyCallback) get_data_format_ready, ctx));
         return;
 
     case DATA_FORMAT_INIT_CONTEXT_STEP_CHECK:
+        /* The WDA client isn't needed any more */
+        data_format_init_context_release_wda (ctx);
+
         g_debug ("Checking data format: kernel %s, device %s",
                  qmi_device_expected_data_format_get_string (ctx->kernel_data_format),
                  qmi_wda_link_layer_protocol_get_string (ctx->llp));
@@ -5220,7 +8420,8 @@ typedef enum {
     INIT_CONTEXT_STEP_DEVICE_CLOSE_BEFORE_REOPEN,
     INIT_CONTEXT_STEP_DEVICE_REOPEN_802_3,
     INIT_CONTEXT_STEP_CLIENTS,
-    INIT_CONTEXT_STEP_MESSAGING_INIT,
+    INIT_CONTEXT_STEP_CLIENTS_CHECK,
+    INIT_CONTEXT_STEP_SESSION_RESUME,
     INIT_CONTEXT_STEP_LAST,
 } InitContextStep;
 
@@ -5229,7 +8430,8 @@ typedef struct {
     GSimpleAsyncResult          *result;
     GCancellable                *cancellable;
     InitContextStep              step;
-    guint                        clients_i;
+    guint                        clients_pending;
+    GError                      *clients_error;
 } InitContext;
 
 static void
@@ -5254,29 +8456,116 @@ initable_init_finish (GAsyncInitable  *initable,
 static void init_context_step (InitContext *ctx);
 
 static void
-messaging_init_ready (RmfdPortProcessorQmi *self,
-                      GAsyncResult         *res,
-                      InitContext          *ctx)
+stats_setup (RmfdPortProcessorQmi *self)
 {
-    GError *error = NULL;
+    guint i;
 
-    if (!messaging_init_finish (self, res, &error)) {
-        g_simple_async_result_take_error (ctx->result, error);
-        init_context_complete_and_free (ctx);
-        return;
+    /* Initialize stats for both SIM slots, keeping open the stats session of
+     * a data call that may be resumed */
+    for (i = 0; i < G_N_ELEMENTS (self->priv->stats); i++) {
+        gchar *name;
+
+        name = g_strdup_printf ("sim %u", i + 1);
+        if (self->priv->session && self->priv->session->stats[i].valid) {
+            GDateTime *start_system_time = NULL;
+
+            if (self->priv->session->stats[i].start_system_time)
+                start_system_time = g_date_time_new_from_unix_utc (self->priv->session->stats[i].start_system_time);
+            self->priv->stats[i] = rmfd_stats_setup_resume (stats_file_paths[i],
+                                                            name,
+                                                            start_system_time,
+                                                            (time_t) self->priv->session->stats[i].start_time);
+            if (start_system_time)
+                g_date_time_unref (start_system_time);
+        } else
+            self->priv->stats[i] = rmfd_stats_setup (stats_file_paths[i], name);
+        g_free (name);
     }
+}
 
-    g_debug ("SMS messaging support initialized");
+static void
+session_resume (RmfdPortProcessorQmi *self)
+{
+    RmfdSessionState *session = self->priv->session;
 
-    /* Go on to next step */
-    ctx->step++;
-    init_context_step (ctx);
+    g_message ("data session from a previous run resumed (handle %u, WDS client %u)",
+               session->packet_data_handle, session->wds_cid);
+
+    self->priv->session_resumed    = TRUE;
+    self->priv->connection_status  = RMF_CONNECTION_STATUS_CONNECTED;
+    self->priv->packet_data_handle = session->packet_data_handle;
+    self->priv->connected_sim_slot = session->sim_slot;
+    register_wds_indications (self);
+
+    /* Keep on writing partial records in the ongoing stats session */
+    if (session->sim_slot >= 1 && session->sim_slot <= G_N_ELEMENTS (self->priv->stats) &&
+        session->stats[session->sim_slot - 1].valid) {
+        self->priv->stats_enabled = TRUE;
+        schedule_stats (self);
+    }
 }
 
 static void
-allocate_client_ready (QmiDevice    *qmi_device,
-                       GAsyncResult *res,
-                       InitContext  *ctx)
+session_discard (RmfdPortProcessorQmi *self)
+{
+    guint i;
+
+    rmfd_session_state_clear ();
+
+    /* The stats session left open is now finished, so reload it to get it
+     * reported as a previous run */
+    for (i = 0; i < G_N_ELEMENTS (self->priv->stats); i++) {
+        gchar *name;
+
+        if (!self->priv->session->stats[i].valid)
+            continue;
+
+        name = g_strdup_printf ("sim %u", i + 1);
+        rmfd_stats_teardown (self->priv->stats[i]);
+        self->priv->stats[i] = rmfd_stats_setup (stats_file_paths[i], name);
+        g_free (name);
+    }
+}
+
+void
+rmfd_port_processor_qmi_keep_session (RmfdPortProcessorQmi *self)
+{
+    g_return_if_fail (RMFD_IS_PORT_PROCESSOR_QMI (self));
+
+    self->priv->keep_session = TRUE;
+}
+
+void
+rmfd_port_processor_qmi_resume_session (RmfdPortProcessorQmi *self,
+                                        RmfdPortData         *data)
+{
+    g_return_if_fail (RMFD_IS_PORT_PROCESSOR_QMI (self));
+    g_return_if_fail (RMFD_IS_PORT_DATA (data));
+
+    if (!self->priv->session)
+        return;
+
+    if (g_strcmp0 (self->priv->session->data_port, rmfd_port_get_interface (RMFD_PORT (data))) != 0)
+        g_warning ("data session from a previous run was setup in '%s', not in '%s'",
+                   self->priv->session->data_port, rmfd_port_get_interface (RMFD_PORT (data)));
+
+    if (self->priv->session_resumed) {
+        /* Keep the interface as it is, it will be stopped on disconnection */
+        g_clear_object (&self->priv->connected_data);
+        self->priv->connected_data = g_object_ref (data);
+    } else {
+        /* Cleanup whatever setup was left in the interface by the previous run */
+        g_debug ("cleaning up data session setup from a previous run...");
+        rmfd_port_data_setup (data, FALSE, NULL, NULL, NULL, NULL, NULL, 0, NULL, NULL);
+    }
+
+    g_clear_pointer (&self->priv->session, (GDestroyNotify) rmfd_session_state_free);
+}
+
+static void
+session_resume_allocate_client_ready (QmiDevice    *qmi_device,
+                                      GAsyncResult *res,
+                                      InitContext  *ctx)
 {
     GError    *error = NULL;
     QmiClient *client;
@@ -5284,21 +8573,104 @@ allocate_client_ready (QmiDevice    *qmi_device,
     client = qmi_device_allocate_client_finish (qmi_device, res, &error);
     if (!client) {
         g_prefix_error (&error, "couldn't allocate client for service '%s': ",
-                        qmi_service_get_string (service_items[ctx->clients_i].service));
+                        qmi_service_get_string (QMI_SERVICE_WDS));
         g_simple_async_result_take_error (ctx->result, error);
         init_context_complete_and_free (ctx);
         return;
     }
 
     g_debug ("QMI client for service '%s' created",
-             qmi_service_get_string (service_items[ctx->clients_i].service));
-    track_qmi_service (ctx->self,
-                       service_items[ctx->clients_i].service,
-                       client);
+             qmi_service_get_string (QMI_SERVICE_WDS));
+    track_qmi_service (ctx->self, QMI_SERVICE_WDS, client);
     g_object_unref (client);
 
-    /* Update client index and re-run the same step */
-    ctx->clients_i++;
+    /* Go on to next step */
+    ctx->step++;
+    init_context_step (ctx);
+}
+
+static void
+session_resume_get_packet_service_status_ready (QmiClientWds *client,
+                                                GAsyncResult *res,
+                                                InitContext  *ctx)
+{
+    g_autoptr(QmiMessageWdsGetPacketServiceStatusOutput)  output = NULL;
+    g_autoptr(GError)                                     error = NULL;
+    QmiWdsConnectionStatus                                status = QMI_WDS_CONNECTION_STATUS_UNKNOWN;
+
+    output = qmi_client_wds_get_packet_service_status_finish (client, res, &error);
+    if (output && qmi_message_wds_get_packet_service_status_output_get_result (output, &error))
+        qmi_message_wds_get_packet_service_status_output_get_connection_status (output, &status, NULL);
+
+    if (status == QMI_WDS_CONNECTION_STATUS_CONNECTED) {
+        session_resume (ctx->self);
+        /* Go on to next step */
+        ctx->step++;
+        init_context_step (ctx);
+        return;
+    }
+
+    g_warning ("couldn't resume data session from a previous run: %s",
+               error ? error->message : "not connected");
+    session_discard (ctx->self);
+
+    /* The reused client id may no longer be valid, so get a new one */
+    untrack_qmi_service (ctx->self, QMI_SERVICE_WDS, TRUE);
+    qmi_device_allocate_client (ctx->self->priv->qmi_device,
+                                QMI_SERVICE_WDS,
+                                QMI_CID_NONE,
+                                10,
+                                ctx->cancellable,
+                                (GAsyncReadyCallback) session_resume_allocate_client_ready,
+                                ctx);
+}
+
+typedef struct {
+    InitContext *ctx;
+    QmiService   service;
+} AllocateClientContext;
+
+static void
+allocate_client_ready (QmiDevice             *qmi_device,
+                       GAsyncResult          *res,
+                       AllocateClientContext *allocate_ctx)
+{
+    InitContext *ctx = allocate_ctx->ctx;
+    GError      *error = NULL;
+    QmiClient   *client;
+
+    client = qmi_device_allocate_client_finish (qmi_device, res, &error);
+    if (!client) {
+        g_prefix_error (&error, "couldn't allocate client for service '%s': ",
+                        qmi_service_get_string (allocate_ctx->service));
+        /* Report only the first error */
+        if (!ctx->clients_error)
+            ctx->clients_error = error;
+        else
+            g_error_free (error);
+    } else {
+        /* Track it even if another allocation failed, so that it's released */
+        g_debug ("QMI client for service '%s' created",
+                 qmi_service_get_string (allocate_ctx->service));
+        track_qmi_service (ctx->self, allocate_ctx->service, client);
+        g_object_unref (client);
+    }
+    g_slice_free (AllocateClientContext, allocate_ctx);
+
+    /* Wait for all allocations to finish */
+    g_assert (ctx->clients_pending > 0);
+    if (--ctx->clients_pending > 0)
+        return;
+
+    if (ctx->clients_error) {
+        g_simple_async_result_take_error (ctx->result, ctx->clients_error);
+        ctx->clients_error = NULL;
+        init_context_complete_and_free (ctx);
+        return;
+    }
+
+    /* Go on to next step */
+    ctx->step++;
     init_context_step (ctx);
 }
 
@@ -5328,6 +8700,7 @@ data_format_init_ready (RmfdPortProcessorQmi *self,
         g_debug ("Data format not initialized: %s", error->message);
         g_error_free (error);
         /* Go on to next step */
+        self->priv->llp_on_open = TRUE;
         ctx->step++;
     } else {
         g_debug ("Data format initialized");
@@ -5383,8 +8756,23 @@ static void
 init_context_step (InitContext *ctx)
 {
     switch (ctx->step) {
-    case INIT_CONTEXT_STEP_FIRST:
+    case INIT_CONTEXT_STEP_FIRST: {
+        RmfdSessionState *session;
+
+        /* Look for a data session left up by a previous run in this same port */
+        session = rmfd_session_state_load ();
+        if (session && g_strcmp0 (session->control_port, rmfd_port_get_interface (RMFD_PORT (ctx->self))) == 0) {
+            g_debug ("data session from a previous run found");
+            ctx->self->priv->session = session;
+        } else if (session)
+            rmfd_session_state_free (session);
+
+        /* Network to target in the first registration attempt, if any */
+        ctx->self->priv->last_registration_valid = rmfd_registration_state_load (&ctx->self->priv->last_registration);
+
+        stats_setup (ctx->self);
         ctx->step++;
+    }
         /* fall through */
 
     case INIT_CONTEXT_STEP_DEVICE_NEW: {
@@ -5402,7 +8790,29 @@ init_context_step (InitContext *ctx)
     }
 
     case INIT_CONTEXT_STEP_DEVICE_OPEN: {
-        QmiDeviceOpenFlags flags;
+        QmiDeviceOpenFlags          flags;
+        QmiDeviceExpectedDataFormat kernel_data_format;
+
+        /* If a previous run couldn't negotiate the data format, the device
+         * wasn't reset since then, and the kernel still doesn't expect a
+         * different one, request 802.3 right away instead of trying again and
+         * reopening. Not if multiplexing is requested or was in use, as QMAP
+         * is always negotiated explicitly. */
+        if (!ctx->self->priv->mux_sessions &&
+            ctx->self->priv->probe_hint &&
+            ctx->self->priv->probe_hint->data_format_valid &&
+            !ctx->self->priv->probe_hint->qmap &&
+            ctx->self->priv->probe_hint->llp_on_open) {
+            kernel_data_format = qmi_device_get_expected_data_format (ctx->self->priv->qmi_device, NULL);
+            if (kernel_data_format == QMI_DEVICE_EXPECTED_DATA_FORMAT_UNKNOWN ||
+                kernel_data_format == QMI_DEVICE_EXPECTED_DATA_FORMAT_802_3) {
+                g_debug ("Reusing cached data format: 802.3 requested on open");
+                ctx->self->priv->llp_on_open = TRUE;
+                ctx->step = INIT_CONTEXT_STEP_DEVICE_REOPEN_802_3;
+                init_context_step (ctx);
+                return;
+            }
+        }
 
         flags = (QMI_DEVICE_OPEN_FLAGS_SYNC |
                  QMI_DEVICE_OPEN_FLAGS_VERSION_INFO);
@@ -5461,39 +8871,79 @@ init_context_step (InitContext *ctx)
         return;
     }
 
-    case INIT_CONTEXT_STEP_CLIENTS:
-        /* Allocate next client */
-        if (ctx->clients_i < G_N_ELEMENTS (service_items)) {
-            g_debug ("allocating QMI client for service '%s'", qmi_service_get_string (service_items[ctx->clients_i].service));
+    case INIT_CONTEXT_STEP_CLIENTS: {
+        guint i;
+
+        /* Allocate all clients at once; init time is then bound by the
+         * slowest allocation instead of by the sum of all of them */
+        g_assert (ctx->clients_pending == 0);
+        ctx->clients_pending = G_N_ELEMENTS (service_items);
+        for (i = 0; i < G_N_ELEMENTS (service_items); i++) {
+            AllocateClientContext *allocate_ctx;
+            guint8                 cid = QMI_CID_NONE;
+
+            /* Reuse the WDS client id owning the call to resume, if any */
+            if (ctx->self->priv->session && service_items[i].service == QMI_SERVICE_WDS)
+                cid = ctx->self->priv->session->wds_cid;
+
+            allocate_ctx = g_slice_new0 (AllocateClientContext);
+            allocate_ctx->ctx     = ctx;
+            allocate_ctx->service = service_items[i].service;
+
+            g_debug ("allocating QMI client for service '%s'", qmi_service_get_string (service_items[i].service));
             qmi_device_allocate_client (ctx->self->priv->qmi_device,
-                                        service_items[ctx->clients_i].service,
-                                        QMI_CID_NONE,
+                                        service_items[i].service,
+                                        cid,
                                         10,
                                         ctx->cancellable,
                                         (GAsyncReadyCallback) allocate_client_ready,
-                                        ctx);
-            return;
+                                        allocate_ctx);
         }
+        return;
+    }
 
+    case INIT_CONTEXT_STEP_CLIENTS_CHECK:
         g_debug ("All QMI clients created");
 
+        /* A firmware upgrade keeping the same vid:pid would have different
+         * service versions; in that case the cached probing results cannot
+         * be trusted */
+        if (ctx->self->priv->probe_hint) {
+            GError *error = NULL;
+
+            if (!check_probe_hint_service_versions (ctx->self, &error)) {
+                g_prefix_error (&error, "probe cache outdated: ");
+                g_simple_async_result_take_error (ctx->result, error);
+                init_context_complete_and_free (ctx);
+                return;
+            }
+        }
+
         ctx->step++;
         /* fall through */
 
-    case INIT_CONTEXT_STEP_MESSAGING_INIT:
-        g_debug ("initializing messaging support...");
-        messaging_init (ctx->self,
-                        (GAsyncReadyCallback) messaging_init_ready,
-                        ctx);
-        return;
+    case INIT_CONTEXT_STEP_SESSION_RESUME:
+        if (ctx->self->priv->session) {
+            g_debug ("checking whether the data session from a previous run is still up...");
+            qmi_client_wds_get_packet_service_status (QMI_CLIENT_WDS (peek_qmi_client (ctx->self, QMI_SERVICE_WDS)),
+                                                      NULL,
+                                                      10,
+                                                      ctx->cancellable,
+                                                      (GAsyncReadyCallback) qmi_transaction_ready,
+                                                      qmi_transaction_new (QMI_SERVICE_WDS, 10, (GAsyncReadyCallback) session_resume_get_packet_service_status_ready, ctx));
+            return;
+        }
+        ctx->step++;
+        /* fall through */
 
     case INIT_CONTEXT_STEP_LAST:
-        /* Register NAS indications */
+        /* Register NAS and UIM indications */
         register_nas_indications (ctx->self);
+        register_uim_indications (ctx->self);
         /* Launch automatic network registration explicitly */
         initiate_registration (ctx->self, TRUE);
-        /* And launch SMS listing, which will succeed here only if PIN unlocked or disabled */
-        messaging_list (ctx->self);
+        /* And setup messaging in the background, which lists SMS when done */
+        messaging_setup (ctx->self);
 
         /* And complete with success */
         g_debug ("processor successfully initialized");
@@ -5520,7 +8970,7 @@ initable_init_async (GAsyncInitable      *initable,
                                              initable_init_async);
     ctx->cancellable = (cancellable ? g_object_ref (cancellable) : NULL);
     ctx->step = INIT_CONTEXT_STEP_FIRST;
-    ctx->clients_i = 0;
+    ctx->clients_pending = 0;
 
     init_context_step (ctx);
 }
@@ -5545,16 +8995,29 @@ rmfd_port_processor_qmi_new_finish (GAsyncResult  *res,
 }
 
 void
-rmfd_port_processor_qmi_new (const gchar         *interface,
-                             GAsyncReadyCallback  callback,
-                             gpointer             user_data)
+rmfd_port_processor_qmi_new (const gchar                        *interface,
+                             const RmfdProbeCacheEntry          *probe_hint,
+                             const RmfdPortProcessorQmiSettings *settings,
+                             GAsyncReadyCallback                 callback,
+                             gpointer                            user_data)
 {
+    g_assert (settings);
+
     g_async_initable_new_async (RMFD_TYPE_PORT_PROCESSOR_QMI,
                                 G_PRIORITY_DEFAULT,
                                 NULL,
                                 callback,
                                 user_data,
-                                RMFD_PORT_INTERFACE, interface,
+                                RMFD_PORT_INTERFACE,                                 interface,
+                                RMFD_PORT_PROCESSOR_QMI_PROBE_HINT,                  probe_hint,
+                                RMFD_PORT_PROCESSOR_QMI_PACKET_STATS_PERIOD,         settings->packet_stats_period,
+                                RMFD_PORT_PROCESSOR_QMI_STATS_INTERVAL,              settings->stats_interval,
+                                RMFD_PORT_PROCESSOR_QMI_STATS_CHANGE_THRESHOLD,      settings->stats_change_threshold,
+                                RMFD_PORT_PROCESSOR_QMI_STATS_MAX_INTERVAL,          settings->stats_max_interval,
+                                RMFD_PORT_PROCESSOR_QMI_CONNECT_MAX_ATTEMPTS,        settings->connect_max_attempts,
+                                RMFD_PORT_PROCESSOR_QMI_CONNECT_RETRY_INITIAL_DELAY, settings->connect_retry_initial_delay,
+                                RMFD_PORT_PROCESSOR_QMI_CONNECT_RETRY_MAX_DELAY,     settings->connect_retry_max_delay,
+                                RMFD_PORT_PROCESSOR_QMI_MUX_SESSIONS,                settings->mux_sessions,
                                 NULL);
 }
 
@@ -5563,19 +9026,112 @@ rmfd_port_processor_qmi_new (const gchar         *interface,
 static void
 rmfd_port_processor_qmi_init (RmfdPortProcessorQmi *self)
 {
+    guint i;
+
     /* Setup private data */
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, RMFD_TYPE_PORT_PROCESSOR_QMI, RmfdPortProcessorQmiPrivate);
     self->priv->connection_status = RMF_CONNECTION_STATUS_DISCONNECTED;
     self->priv->registration_timeout = DEFAULT_REGISTRATION_TIMEOUT_SECS;
     self->priv->registration_status = RMF_REGISTRATION_STATUS_IDLE;
+    self->priv->auto_reconnect_max_delay = AUTO_RECONNECT_DEFAULT_MAX_DELAY_SECS;
+    self->priv->auto_reconnect_state = RMF_AUTO_RECONNECT_STATE_IDLE;
+    self->priv->network_scan_results = g_array_new (FALSE, FALSE, sizeof (NetworkScanResult));
+    g_array_set_clear_func (self->priv->network_scan_results, (GDestroyNotify) network_scan_result_clear);
+    for (i = 0; i < G_N_ELEMENTS (self->priv->mux_session_list); i++) {
+        self->priv->mux_session_list[i].self = self;
+        self->priv->mux_session_list[i].id = i + 1;
+        self->priv->mux_session_list[i].mux_id = RMFD_QMIMUX_ID_FIRST + i;
+        self->priv->mux_session_list[i].connection_status = RMF_CONNECTION_STATUS_DISCONNECTED;
+    }
 
     /* Setup SMS list handler */
     self->priv->messaging_sms_list = rmfd_sms_list_new ();
     g_signal_connect (self->priv->messaging_sms_list, "sms-added", G_CALLBACK (sms_added_cb), self);
+}
+
+static void
+set_property (GObject      *object,
+              guint         prop_id,
+              const GValue *value,
+              GParamSpec   *pspec)
+{
+    RmfdPortProcessorQmiPrivate *priv = RMFD_PORT_PROCESSOR_QMI (object)->priv;
+
+    switch (prop_id) {
+    case PROP_PROBE_HINT:
+        g_clear_pointer (&priv->probe_hint, (GDestroyNotify) rmfd_probe_cache_entry_free);
+        priv->probe_hint = g_value_dup_boxed (value);
+        break;
+    case PROP_PACKET_STATS_PERIOD:
+        priv->packet_stats_period = g_value_get_uint (value);
+        break;
+    case PROP_STATS_INTERVAL:
+        priv->stats_interval = g_value_get_uint (value);
+        break;
+    case PROP_STATS_CHANGE_THRESHOLD:
+        priv->stats_change_threshold = g_value_get_uint64 (value);
+        break;
+    case PROP_STATS_MAX_INTERVAL:
+        priv->stats_max_interval = g_value_get_uint (value);
+        break;
+    case PROP_CONNECT_MAX_ATTEMPTS:
+        priv->connect_max_attempts = g_value_get_uint (value);
+        break;
+    case PROP_CONNECT_RETRY_INITIAL_DELAY:
+        priv->connect_retry_initial_delay = g_value_get_uint (value);
+        break;
+    case PROP_CONNECT_RETRY_MAX_DELAY:
+        priv->connect_retry_max_delay = g_value_get_uint (value);
+        break;
+    case PROP_MUX_SESSIONS:
+        priv->mux_sessions = g_value_get_uint (value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+get_property (GObject    *object,
+              guint       prop_id,
+              GValue     *value,
+              GParamSpec *pspec)
+{
+    RmfdPortProcessorQmiPrivate *priv = RMFD_PORT_PROCESSOR_QMI (object)->priv;
 
-    /* Initialize stats for both SIM slots */
-    self->priv->stats[0] = rmfd_stats_setup (stats_file_paths[0], "sim 1");
-    self->priv->stats[1] = rmfd_stats_setup (stats_file_paths[1], "sim 2");
+    switch (prop_id) {
+    case PROP_PROBE_HINT:
+        g_value_set_boxed (value, priv->probe_hint);
+        break;
+    case PROP_PACKET_STATS_PERIOD:
+        g_value_set_uint (value, priv->packet_stats_period);
+        break;
+    case PROP_STATS_INTERVAL:
+        g_value_set_uint (value, priv->stats_interval);
+        break;
+    case PROP_STATS_CHANGE_THRESHOLD:
+        g_value_set_uint64 (value, priv->stats_change_threshold);
+        break;
+    case PROP_STATS_MAX_INTERVAL:
+        g_value_set_uint (value, priv->stats_max_interval);
+        break;
+    case PROP_CONNECT_MAX_ATTEMPTS:
+        g_value_set_uint (value, priv->connect_max_attempts);
+        break;
+    case PROP_CONNECT_RETRY_INITIAL_DELAY:
+        g_value_set_uint (value, priv->connect_retry_initial_delay);
+        break;
+    case PROP_CONNECT_RETRY_MAX_DELAY:
+        g_value_set_uint (value, priv->connect_retry_max_delay);
+        break;
+    case PROP_MUX_SESSIONS:
+        g_value_set_uint (value, priv->mux_sessions);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
 }
 
 static void
@@ -5584,14 +9140,32 @@ dispose (GObject *object)
     RmfdPortProcessorQmi *self = RMFD_PORT_PROCESSOR_QMI (object);
     guint                 i;
 
+    g_clear_pointer (&self->priv->probe_hint, (GDestroyNotify) rmfd_probe_cache_entry_free);
+    g_clear_pointer (&self->priv->manufacturer, g_free);
+    g_clear_pointer (&self->priv->model, g_free);
+    g_clear_pointer (&self->priv->revision, g_free);
+    g_clear_pointer (&self->priv->hardware_revision, g_free);
+    g_clear_pointer (&self->priv->imei, g_free);
+    /* Reads or lookups still in progress must not load a new cache */
+    self->priv->sim_cache_generation++;
+    g_clear_pointer (&self->priv->sim_cache, g_hash_table_unref);
+    g_clear_pointer (&self->priv->sim_cache_iccid, g_array_unref);
+    card_iccid_invalidate (self);
+    g_clear_pointer (&self->priv->session, (GDestroyNotify) rmfd_session_state_free);
+    g_clear_pointer (&self->priv->network_scan_results, g_array_unref);
     g_clear_object  (&self->priv->connected_data);
     g_clear_pointer (&(self->priv->stats[0]), (GDestroyNotify)rmfd_stats_teardown);
     g_clear_pointer (&(self->priv->stats[1]), (GDestroyNotify)rmfd_stats_teardown);
 
+    if (self->priv->messaging_setup_id) {
+        g_source_remove (self->priv->messaging_setup_id);
+        self->priv->messaging_setup_id = 0;
+    }
     messaging_list_contexts_cancel (self);
     registration_context_cancel (self);
     unregister_wds_indications (self);
     unregister_nas_indications (self);
+    unregister_uim_indications (self);
     unregister_wms_indications (self);
 
     if (self->priv->messaging_sms_list)
@@ -5603,8 +9177,25 @@ dispose (GObject *object)
         self->priv->stats_timeout_id = 0;
     }
 
+    auto_reconnect_cancel (self);
+    g_clear_pointer (&self->priv->auto_reconnect_request, g_byte_array_unref);
+    g_clear_object  (&self->priv->auto_reconnect_data);
+
+    /* Multiplexed sessions don't survive the processor */
+    for (i = 0; i < G_N_ELEMENTS (self->priv->mux_session_list); i++)
+        mux_session_reset (&self->priv->mux_session_list[i]);
+
+    /* If connected on daemon shutdown, keep the WDS client id allocated so
+     * that the call isn't torn down, and a new run is able to resume it. If
+     * the device is gone, so is the call. */
+    if (self->priv->connection_status == RMF_CONNECTION_STATUS_CONNECTED && !self->priv->keep_session)
+        rmfd_session_state_clear ();
     for (i = 0; i < G_N_ELEMENTS (service_items); i++)
-        untrack_qmi_service (self, service_items[i].service);
+        untrack_qmi_service (self,
+                             service_items[i].service,
+                             (service_items[i].service != QMI_SERVICE_WDS ||
+                              self->priv->connection_status != RMF_CONNECTION_STATUS_CONNECTED ||
+                              !self->priv->keep_session));
 
     if (self->priv->qmi_device && qmi_device_is_open (self->priv->qmi_device))
         qmi_device_close_async (self->priv->qmi_device, 0, NULL, NULL, NULL);
@@ -5629,7 +9220,82 @@ rmfd_port_processor_qmi_class_init (RmfdPortProcessorQmiClass *processor_qmi_cla
     g_type_class_add_private (object_class, sizeof (RmfdPortProcessorQmiPrivate));
 
     /* Virtual methods */
+    object_class->set_property = set_property;
+    object_class->get_property = get_property;
     object_class->dispose = dispose;
     processor_class->run = run;
     processor_class->run_finish = run_finish;
+
+    /* Properties */
+    g_object_class_install_property
+        (object_class, PROP_PROBE_HINT,
+         g_param_spec_boxed (RMFD_PORT_PROCESSOR_QMI_PROBE_HINT,
+                             "Probe hint",
+                             "Result of a previous probing of the same device",
+                             RMFD_TYPE_PROBE_CACHE_ENTRY,
+                             G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+
+    g_object_class_install_property
+        (object_class, PROP_PACKET_STATS_PERIOD,
+         g_param_spec_uint (RMFD_PORT_PROCESSOR_QMI_PACKET_STATS_PERIOD,
+                            "Packet stats period",
+                            "Period of the WDS packet statistics reports, in seconds (0 to disable)",
+                            0, G_MAXUINT8, 0,
+                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+
+    g_object_class_install_property
+        (object_class, PROP_STATS_INTERVAL,
+         g_param_spec_uint (RMFD_PORT_PROCESSOR_QMI_STATS_INTERVAL,
+                            "Stats interval",
+                            "Time between connection stats samples, in seconds",
+                            1, G_MAXUINT, RMFD_PORT_PROCESSOR_QMI_DEFAULT_STATS_INTERVAL,
+                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+
+    g_object_class_install_property
+        (object_class, PROP_STATS_CHANGE_THRESHOLD,
+         g_param_spec_uint64 (RMFD_PORT_PROCESSOR_QMI_STATS_CHANGE_THRESHOLD,
+                              "Stats change threshold",
+                              "Minimum TX+RX bytes change to write a partial stats record (0 to write on every sample)",
+                              0, G_MAXUINT64, 0,
+                              G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+
+    g_object_class_install_property
+        (object_class, PROP_STATS_MAX_INTERVAL,
+         g_param_spec_uint (RMFD_PORT_PROCESSOR_QMI_STATS_MAX_INTERVAL,
+                            "Stats max interval",
+                            "Maximum time between partial stats records when the change threshold is set, in seconds",
+                            1, G_MAXUINT, RMFD_PORT_PROCESSOR_QMI_DEFAULT_STATS_MAX_INTERVAL,
+                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+
+    g_object_class_install_property
+        (object_class, PROP_CONNECT_MAX_ATTEMPTS,
+         g_param_spec_uint (RMFD_PORT_PROCESSOR_QMI_CONNECT_MAX_ATTEMPTS,
+                            "Connect max attempts",
+                            "Maximum number of attempts for each connection request",
+                            1, G_MAXUINT, RMFD_PORT_PROCESSOR_QMI_DEFAULT_CONNECT_MAX_ATTEMPTS,
+                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+
+    g_object_class_install_property
+        (object_class, PROP_CONNECT_RETRY_INITIAL_DELAY,
+         g_param_spec_uint (RMFD_PORT_PROCESSOR_QMI_CONNECT_RETRY_INITIAL_DELAY,
+                            "Connect retry initial delay",
+                            "Delay before the first connection retry, doubled on each subsequent retry, in milliseconds",
+                            0, G_MAXUINT, RMFD_PORT_PROCESSOR_QMI_DEFAULT_CONNECT_RETRY_INITIAL_DELAY,
+                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+
+    g_object_class_install_property
+        (object_class, PROP_CONNECT_RETRY_MAX_DELAY,
+         g_param_spec_uint (RMFD_PORT_PROCESSOR_QMI_CONNECT_RETRY_MAX_DELAY,
+                            "Connect retry max delay",
+                            "Maximum delay between connection retries, in milliseconds",
+                            0, G_MAXUINT, RMFD_PORT_PROCESSOR_QMI_DEFAULT_CONNECT_RETRY_MAX_DELAY,
+                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+
+    g_object_class_install_property
+        (object_class, PROP_MUX_SESSIONS,
+         g_param_spec_uint (RMFD_PORT_PROCESSOR_QMI_MUX_SESSIONS,
+                            "Mux sessions",
+                            "Number of QMAP multiplexed data sessions, 0 to disable multiplexing",
+                            0, RMFD_PORT_PROCESSOR_QMI_MAX_MUX_SESSIONS, 0,
+                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
 }
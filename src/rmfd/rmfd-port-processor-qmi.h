@@ -29,6 +29,8 @@
 #include <glib-object.h>
 
 #include "rmfd-port-processor.h"
+#include "rmfd-port-data.h"
+#include "rmfd-probe-cache.h"
 
 #define RMFD_TYPE_PORT_PROCESSOR_QMI            (rmfd_port_processor_qmi_get_type ())
 #define RMFD_PORT_PROCESSOR_QMI(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), RMFD_TYPE_PORT_PROCESSOR_QMI, RmfdPortProcessorQmi))
@@ -37,6 +39,37 @@
 #define RMFD_IS_PORT_PROCESSOR_QMI_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((obj), RMFD_TYPE_PORT_PROCESSOR_QMI))
 #define RMFD_PORT_PROCESSOR_QMI_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), RMFD_TYPE_PORT_PROCESSOR_QMI, RmfdPortProcessorQmiClass))
 
+#define RMFD_PORT_PROCESSOR_QMI_PROBE_HINT                  "probe-hint"
+#define RMFD_PORT_PROCESSOR_QMI_PACKET_STATS_PERIOD         "packet-stats-period"
+#define RMFD_PORT_PROCESSOR_QMI_STATS_INTERVAL              "stats-interval"
+#define RMFD_PORT_PROCESSOR_QMI_STATS_CHANGE_THRESHOLD      "stats-change-threshold"
+#define RMFD_PORT_PROCESSOR_QMI_STATS_MAX_INTERVAL          "stats-max-interval"
+#define RMFD_PORT_PROCESSOR_QMI_CONNECT_MAX_ATTEMPTS        "connect-max-attempts"
+#define RMFD_PORT_PROCESSOR_QMI_CONNECT_RETRY_INITIAL_DELAY "connect-retry-initial-delay"
+#define RMFD_PORT_PROCESSOR_QMI_CONNECT_RETRY_MAX_DELAY     "connect-retry-max-delay"
+#define RMFD_PORT_PROCESSOR_QMI_MUX_SESSIONS                "mux-sessions"
+
+#define RMFD_PORT_PROCESSOR_QMI_DEFAULT_PACKET_STATS_PERIOD         5
+#define RMFD_PORT_PROCESSOR_QMI_DEFAULT_STATS_INTERVAL              10
+#define RMFD_PORT_PROCESSOR_QMI_DEFAULT_STATS_MAX_INTERVAL          600
+#define RMFD_PORT_PROCESSOR_QMI_DEFAULT_CONNECT_MAX_ATTEMPTS        3
+#define RMFD_PORT_PROCESSOR_QMI_DEFAULT_CONNECT_RETRY_INITIAL_DELAY 1000
+#define RMFD_PORT_PROCESSOR_QMI_DEFAULT_CONNECT_RETRY_MAX_DELAY     16000
+
+#define RMFD_PORT_PROCESSOR_QMI_MAX_MUX_SESSIONS 8
+
+/* Daemon settings for the QMI processor */
+typedef struct {
+    guint   packet_stats_period;         /* seconds, 0 to disable WDS event reports */
+    guint   stats_interval;              /* seconds between stats samples */
+    guint64 stats_change_threshold;      /* bytes, 0 to write a record on every sample */
+    guint   stats_max_interval;          /* seconds, max time between records if change-aware */
+    guint   connect_max_attempts;
+    guint   connect_retry_initial_delay; /* milliseconds, doubled on each retry */
+    guint   connect_retry_max_delay;     /* milliseconds */
+    guint   mux_sessions;                /* QMAP multiplexed sessions, 0 to disable */
+} RmfdPortProcessorQmiSettings;
+
 typedef struct _RmfdPortProcessorQmi RmfdPortProcessorQmi;
 typedef struct _RmfdPortProcessorQmiClass RmfdPortProcessorQmiClass;
 typedef struct _RmfdPortProcessorQmiPrivate RmfdPortProcessorQmiPrivate;
@@ -52,11 +85,28 @@ struct _RmfdPortProcessorQmiClass {
 
 GType rmfd_port_processor_qmi_get_type (void);
 
-/* Create a QMI processor */
-void               rmfd_port_processor_qmi_new        (const gchar          *interface,
-                                                       GAsyncReadyCallback   callback,
-                                                       gpointer              user_data);
-RmfdPortProcessor *rmfd_port_processor_qmi_new_finish (GAsyncResult         *res,
-                                                       GError              **error);
+/* Create a QMI processor, optionally reusing the result of a previous probing */
+void               rmfd_port_processor_qmi_new        (const gchar                         *interface,
+                                                       const RmfdProbeCacheEntry           *probe_hint,
+                                                       const RmfdPortProcessorQmiSettings  *settings,
+                                                       GAsyncReadyCallback                  callback,
+                                                       gpointer                             user_data);
+RmfdPortProcessor *rmfd_port_processor_qmi_new_finish (GAsyncResult                        *res,
+                                                       GError                             **error);
+
+/* Probing results, to be stored in the probe cache */
+gboolean           rmfd_port_processor_qmi_get_llp_is_raw_ip    (RmfdPortProcessorQmi *self);
+gboolean           rmfd_port_processor_qmi_get_llp_on_open      (RmfdPortProcessorQmi *self);
+gboolean           rmfd_port_processor_qmi_get_qmap             (RmfdPortProcessorQmi *self);
+GArray            *rmfd_port_processor_qmi_get_service_versions (RmfdPortProcessorQmi *self);
+
+/* Keep the data session up when the processor is disposed, so that it can be
+ * resumed by the next run; only on daemon shutdown, not on device removal */
+void               rmfd_port_processor_qmi_keep_session         (RmfdPortProcessorQmi *self);
+
+/* Bind the WWAN port to a data session resumed from a previous run, or clean
+ * it up if the previous session couldn't be resumed */
+void               rmfd_port_processor_qmi_resume_session       (RmfdPortProcessorQmi *self,
+                                                                 RmfdPortData         *data);
 
 #endif /* RMFD_PORT_PROCESSOR_QMI_H */
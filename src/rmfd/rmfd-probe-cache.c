@@ -0,0 +1,270 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "rmfd-probe-cache.h"
+
+#define KEY_VID              "vid"
+#define KEY_PID              "pid"
+#define KEY_CONTROL_PORT     "control-port"
+#define KEY_DATA_PORT        "data-port"
+#define KEY_LLP              "llp"
+#define KEY_LLP_ON_OPEN      "llp-on-open"
+#define KEY_QMAP             "qmap"
+#define KEY_SERVICE_VERSIONS "service-versions"
+#define KEY_DEVNUM           "devnum"
+#define KEY_BOOT_ID          "boot-id"
+
+#define BOOT_ID_PATH "/proc/sys/kernel/random/boot_id"
+
+#define LLP_RAW_IP "raw-ip"
+#define LLP_802_3  "802-3"
+
+/*****************************************************************************/
+
+RmfdProbeCacheEntry *
+rmfd_probe_cache_entry_new (void)
+{
+    RmfdProbeCacheEntry *entry;
+
+    entry = g_slice_new0 (RmfdProbeCacheEntry);
+    entry->service_versions = g_array_new (FALSE, FALSE, sizeof (RmfdProbeCacheServiceVersion));
+    return entry;
+}
+
+RmfdProbeCacheEntry *
+rmfd_probe_cache_entry_copy (const RmfdProbeCacheEntry *entry)
+{
+    RmfdProbeCacheEntry *copy;
+
+    copy = rmfd_probe_cache_entry_new ();
+    copy->control_port  = g_strdup (entry->control_port);
+    copy->data_port     = g_strdup (entry->data_port);
+    copy->llp_is_raw_ip = entry->llp_is_raw_ip;
+    copy->llp_on_open   = entry->llp_on_open;
+    copy->qmap          = entry->qmap;
+    copy->data_format_valid = entry->data_format_valid;
+    g_array_append_vals (copy->service_versions,
+                         entry->service_versions->data,
+                         entry->service_versions->len);
+    return copy;
+}
+
+void
+rmfd_probe_cache_entry_free (RmfdProbeCacheEntry *entry)
+{
+    g_free (entry->control_port);
+    g_free (entry->data_port);
+    g_array_unref (entry->service_versions);
+    g_slice_free (RmfdProbeCacheEntry, entry);
+}
+
+G_DEFINE_BOXED_TYPE (RmfdProbeCacheEntry, rmfd_probe_cache_entry, rmfd_probe_cache_entry_copy, rmfd_probe_cache_entry_free)
+
+/*****************************************************************************/
+
+static GKeyFile *
+load_key_file (void)
+{
+    GKeyFile *key_file;
+    GError   *error = NULL;
+
+    key_file = g_key_file_new ();
+    if (!g_key_file_load_from_file (key_file, RMFD_PROBE_CACHE_FILE_PATH, G_KEY_FILE_NONE, &error)) {
+        if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+            g_warning ("couldn't load probe cache: %s", error->message);
+        g_error_free (error);
+    }
+    return key_file;
+}
+
+static void
+save_key_file (GKeyFile *key_file)
+{
+    gchar  *dirname;
+    gchar  *contents;
+    gsize   length;
+    GError *error = NULL;
+
+    dirname = g_path_get_dirname (RMFD_PROBE_CACHE_FILE_PATH);
+    if (g_mkdir_with_parents (dirname, 0755) < 0)
+        g_warning ("couldn't create probe cache directory '%s'", dirname);
+    g_free (dirname);
+
+    contents = g_key_file_to_data (key_file, &length, NULL);
+    if (!g_file_set_contents (RMFD_PROBE_CACHE_FILE_PATH, contents, length, &error)) {
+        g_warning ("couldn't write probe cache: %s", error->message);
+        g_error_free (error);
+    }
+    g_free (contents);
+}
+
+static gchar *
+load_boot_id (void)
+{
+    gchar *boot_id = NULL;
+
+    if (!g_file_get_contents (BOOT_ID_PATH, &boot_id, NULL, NULL))
+        return NULL;
+    return g_strstrip (boot_id);
+}
+
+/*****************************************************************************/
+
+RmfdProbeCacheEntry *
+rmfd_probe_cache_lookup (const gchar *sysfs_path,
+                         guint16      vid,
+                         guint16      pid,
+                         guint        devnum)
+{
+    GKeyFile            *key_file;
+    RmfdProbeCacheEntry *entry = NULL;
+    gchar               *llp = NULL;
+    gchar               *boot_id = NULL;
+    gchar               *stored_boot_id = NULL;
+    gchar              **versions = NULL;
+    guint                i;
+
+    g_assert (sysfs_path);
+
+    key_file = load_key_file ();
+    if (!g_key_file_has_group (key_file, sysfs_path))
+        goto out;
+
+    if (g_key_file_get_integer (key_file, sysfs_path, KEY_VID, NULL) != vid ||
+        g_key_file_get_integer (key_file, sysfs_path, KEY_PID, NULL) != pid) {
+        g_debug ("probe cache entry for '%s' doesn't match %04x:%04x", sysfs_path, vid, pid);
+        goto out;
+    }
+
+    entry = rmfd_probe_cache_entry_new ();
+    entry->control_port = g_key_file_get_string (key_file, sysfs_path, KEY_CONTROL_PORT, NULL);
+    entry->data_port    = g_key_file_get_string (key_file, sysfs_path, KEY_DATA_PORT, NULL);
+    llp = g_key_file_get_string (key_file, sysfs_path, KEY_LLP, NULL);
+
+    if (!entry->control_port || !entry->data_port || !llp) {
+        g_warning ("invalid probe cache entry for '%s'", sysfs_path);
+        g_clear_pointer (&entry, (GDestroyNotify) rmfd_probe_cache_entry_free);
+        goto out;
+    }
+    entry->llp_is_raw_ip = g_str_equal (llp, LLP_RAW_IP);
+    entry->llp_on_open   = g_key_file_get_boolean (key_file, sysfs_path, KEY_LLP_ON_OPEN, NULL);
+    entry->qmap          = g_key_file_get_boolean (key_file, sysfs_path, KEY_QMAP, NULL);
+
+    /* A reset modem may default to a different data format, regardless of
+     * what the kernel expects. Entries not telling whether QMAP was in use
+     * can't tell the data format either. */
+    boot_id = load_boot_id ();
+    stored_boot_id = g_key_file_get_string (key_file, sysfs_path, KEY_BOOT_ID, NULL);
+    entry->data_format_valid = (boot_id &&
+                                g_key_file_has_key (key_file, sysfs_path, KEY_QMAP, NULL) &&
+                                g_strcmp0 (boot_id, stored_boot_id) == 0 &&
+                                (guint) g_key_file_get_integer (key_file, sysfs_path, KEY_DEVNUM, NULL) == devnum);
+    if (!entry->data_format_valid)
+        g_debug ("device '%s' reset since the probe cache entry was stored: data format not reused", sysfs_path);
+
+    /* Each version stored as 'service:major.minor' */
+    versions = g_key_file_get_string_list (key_file, sysfs_path, KEY_SERVICE_VERSIONS, NULL, NULL);
+    for (i = 0; versions && versions[i]; i++) {
+        RmfdProbeCacheServiceVersion version;
+
+        if (sscanf (versions[i], "%u:%u.%u", &version.service, &version.major, &version.minor) != 3) {
+            g_warning ("invalid service version in probe cache entry for '%s': %s", sysfs_path, versions[i]);
+            continue;
+        }
+        g_array_append_val (entry->service_versions, version);
+    }
+
+out:
+    g_strfreev (versions);
+    g_free (stored_boot_id);
+    g_free (boot_id);
+    g_free (llp);
+    g_key_file_free (key_file);
+    return entry;
+}
+
+void
+rmfd_probe_cache_store (const gchar               *sysfs_path,
+                        guint16                    vid,
+                        guint16                    pid,
+                        guint                      devnum,
+                        const RmfdProbeCacheEntry *entry)
+{
+    GKeyFile  *key_file;
+    GPtrArray *versions;
+    gchar     *boot_id;
+    guint      i;
+
+    g_assert (sysfs_path);
+    g_assert (entry);
+
+    versions = g_ptr_array_new_with_free_func (g_free);
+    for (i = 0; i < entry->service_versions->len; i++) {
+        RmfdProbeCacheServiceVersion *version;
+
+        version = &g_array_index (entry->service_versions, RmfdProbeCacheServiceVersion, i);
+        g_ptr_array_add (versions, g_strdup_printf ("%u:%u.%u", version->service, version->major, version->minor));
+    }
+
+    key_file = load_key_file ();
+    g_key_file_remove_group (key_file, sysfs_path, NULL);
+    g_key_file_set_integer (key_file, sysfs_path, KEY_VID, vid);
+    g_key_file_set_integer (key_file, sysfs_path, KEY_PID, pid);
+    g_key_file_set_integer (key_file, sysfs_path, KEY_DEVNUM, devnum);
+    boot_id = load_boot_id ();
+    if (boot_id)
+        g_key_file_set_string (key_file, sysfs_path, KEY_BOOT_ID, boot_id);
+    g_free (boot_id);
+    g_key_file_set_string  (key_file, sysfs_path, KEY_CONTROL_PORT, entry->control_port);
+    g_key_file_set_string  (key_file, sysfs_path, KEY_DATA_PORT, entry->data_port);
+    g_key_file_set_string  (key_file, sysfs_path, KEY_LLP, entry->llp_is_raw_ip ? LLP_RAW_IP : LLP_802_3);
+    g_key_file_set_boolean (key_file, sysfs_path, KEY_LLP_ON_OPEN, entry->llp_on_open);
+    g_key_file_set_boolean (key_file, sysfs_path, KEY_QMAP, entry->qmap);
+    g_key_file_set_string_list (key_file, sysfs_path, KEY_SERVICE_VERSIONS,
+                                (const gchar * const *) versions->pdata, versions->len);
+    save_key_file (key_file);
+    g_key_file_free (key_file);
+
+    g_ptr_array_unref (versions);
+}
+
+void
+rmfd_probe_cache_invalidate (const gchar *sysfs_path)
+{
+    GKeyFile *key_file;
+
+    g_assert (sysfs_path);
+
+    key_file = load_key_file ();
+    if (g_key_file_remove_group (key_file, sysfs_path, NULL))
+        save_key_file (key_file);
+    g_key_file_free (key_file);
+}
@@ -0,0 +1,79 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#ifndef RMFD_PROBE_CACHE_H
+#define RMFD_PROBE_CACHE_H
+
+#include <glib-object.h>
+
+/* Overridable at build time, e.g. by the unit tests */
+#ifndef RMFD_PROBE_CACHE_FILE_PATH
+# define RMFD_PROBE_CACHE_FILE_PATH "/var/lib/rmfd/probe.cache"
+#endif
+
+typedef struct {
+    guint service; /* QmiService */
+    guint major;
+    guint minor;
+} RmfdProbeCacheServiceVersion;
+
+/* Result of a successful probing, for a given physical device */
+typedef struct {
+    gchar    *control_port;     /* e.g. "cdc-wdm0" */
+    gchar    *data_port;        /* e.g. "wwan0" */
+    gboolean  llp_is_raw_ip;
+    gboolean  llp_on_open;      /* 802.3 requested when opening the device */
+    gboolean  qmap;             /* QMAP aggregation negotiated for multiplexing */
+    GArray   *service_versions; /* RmfdProbeCacheServiceVersion */
+
+    /* Set on lookup: whether the device was neither reset nor re-enumerated
+     * since the entry was stored, i.e. whether the modem may still be using
+     * the data format negotiated back then */
+    gboolean  data_format_valid;
+} RmfdProbeCacheEntry;
+
+#define RMFD_TYPE_PROBE_CACHE_ENTRY (rmfd_probe_cache_entry_get_type ())
+
+GType                rmfd_probe_cache_entry_get_type (void);
+RmfdProbeCacheEntry *rmfd_probe_cache_entry_new      (void);
+RmfdProbeCacheEntry *rmfd_probe_cache_entry_copy     (const RmfdProbeCacheEntry *entry);
+void                 rmfd_probe_cache_entry_free     (RmfdProbeCacheEntry       *entry);
+
+/* Entries are keyed by the sysfs path of the physical device, and only
+ * returned if the USB vid:pid also match. The USB devnum changes whenever the
+ * device is re-enumerated (e.g. after a modem reset), and is used along with
+ * the kernel boot id to validate the cached data format. */
+RmfdProbeCacheEntry *rmfd_probe_cache_lookup         (const gchar               *sysfs_path,
+                                                      guint16                    vid,
+                                                      guint16                    pid,
+                                                      guint                      devnum);
+void                 rmfd_probe_cache_store          (const gchar               *sysfs_path,
+                                                      guint16                    vid,
+                                                      guint16                    pid,
+                                                      guint                      devnum,
+                                                      const RmfdProbeCacheEntry *entry);
+void                 rmfd_probe_cache_invalidate     (const gchar               *sysfs_path);
+
+#endif /* RMFD_PROBE_CACHE_H */
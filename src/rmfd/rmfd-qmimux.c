@@ -0,0 +1,222 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <net/if.h>
+
+#include <glib.h>
+
+#include "rmfd-qmimux.h"
+#include "rmfd-error.h"
+#include "rmfd-error-types.h"
+
+/* Overridable at build time, e.g. by the unit tests */
+#ifndef SYSFS_NET_PATH
+# define SYSFS_NET_PATH "/sys/class/net"
+#endif
+#ifndef SYSFS_USBMISC_PATH
+# define SYSFS_USBMISC_PATH "/sys/class/usbmisc"
+#endif
+
+/*****************************************************************************/
+
+gboolean
+rmfd_qmimux_get_interface_number (const gchar  *control_port,
+                                  guint        *interface_number,
+                                  GError      **error)
+{
+    gchar   *path;
+    gchar   *contents = NULL;
+    guint64  number;
+
+    path = g_build_filename (SYSFS_USBMISC_PATH, control_port, "device", "bInterfaceNumber", NULL);
+    if (!g_file_get_contents (path, &contents, NULL, error)) {
+        g_prefix_error (error, "couldn't read interface number: ");
+        g_free (path);
+        return FALSE;
+    }
+    g_free (path);
+
+    /* Given in hex, e.g. "08" */
+    number = g_ascii_strtoull (g_strstrip (contents), NULL, 16);
+    g_free (contents);
+
+    *interface_number = (guint) number;
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+gboolean
+rmfd_qmimux_setup_master (const gchar  *master,
+                          guint         mtu,
+                          GError      **error)
+{
+    struct ifreq ifr;
+    gint         fd;
+
+    fd = socket (AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        g_set_error (error, RMFD_ERROR, RMFD_ERROR_UNKNOWN,
+                     "couldn't open control socket: %s", g_strerror (errno));
+        return FALSE;
+    }
+
+    memset (&ifr, 0, sizeof (ifr));
+    g_strlcpy (ifr.ifr_name, master, IFNAMSIZ);
+    if (ioctl (fd, SIOCGIFFLAGS, &ifr) < 0) {
+        g_set_error (error, RMFD_ERROR, RMFD_ERROR_UNKNOWN,
+                     "couldn't get '%s' flags: %s", master, g_strerror (errno));
+        close (fd);
+        return FALSE;
+    }
+
+    /* Before bringing it up, so that the rx URBs are allocated once. Every
+     * session setup lands here, so leave an already running master alone if
+     * it has the right MTU. */
+    if (mtu) {
+        struct ifreq mtu_req;
+
+        memset (&mtu_req, 0, sizeof (mtu_req));
+        g_strlcpy (mtu_req.ifr_name, master, IFNAMSIZ);
+        if (!(ifr.ifr_flags & IFF_UP) ||
+            ioctl (fd, SIOCGIFMTU, &mtu_req) < 0 ||
+            mtu_req.ifr_mtu != (gint) mtu) {
+            mtu_req.ifr_mtu = mtu;
+            if (ioctl (fd, SIOCSIFMTU, &mtu_req) < 0) {
+                g_set_error (error, RMFD_ERROR, RMFD_ERROR_UNKNOWN,
+                             "couldn't set '%s' MTU to %u: %s", master, mtu, g_strerror (errno));
+                close (fd);
+                return FALSE;
+            }
+        }
+    }
+
+    if (!(ifr.ifr_flags & IFF_UP)) {
+        ifr.ifr_flags |= IFF_UP;
+        if (ioctl (fd, SIOCSIFFLAGS, &ifr) < 0) {
+            g_set_error (error, RMFD_ERROR, RMFD_ERROR_UNKNOWN,
+                         "couldn't bring '%s' up: %s", master, g_strerror (errno));
+            close (fd);
+            return FALSE;
+        }
+    }
+
+    close (fd);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+static gboolean
+write_mux_file (const gchar  *master,
+                const gchar  *file,
+                guint8        mux_id,
+                GError      **error)
+{
+    gchar    *path;
+    FILE     *f;
+    gboolean  success = FALSE;
+
+    /* Not g_file_set_contents(), sysfs attributes can't be replaced */
+    path = g_build_filename (SYSFS_NET_PATH, master, "qmi", file, NULL);
+    f = fopen (path, "w");
+    if (!f) {
+        g_set_error (error, RMFD_ERROR, RMFD_ERROR_NOT_SUPPORTED,
+                     "couldn't open '%s': %s", path, g_strerror (errno));
+        goto out;
+    }
+
+    if (fprintf (f, "0x%02x", mux_id) < 0 || fflush (f) != 0) {
+        g_set_error (error, RMFD_ERROR, RMFD_ERROR_UNKNOWN,
+                     "couldn't write mux id 0x%02x to '%s': %s", mux_id, path, g_strerror (errno));
+        goto out;
+    }
+
+    success = TRUE;
+
+out:
+    if (f)
+        fclose (f);
+    g_free (path);
+    return success;
+}
+
+gboolean
+rmfd_qmimux_add_link (const gchar  *master,
+                      guint8        mux_id,
+                      GError      **error)
+{
+    return write_mux_file (master, "add_mux", mux_id, error);
+}
+
+gboolean
+rmfd_qmimux_del_link (const gchar  *master,
+                      guint8        mux_id,
+                      GError      **error)
+{
+    return write_mux_file (master, "del_mux", mux_id, error);
+}
+
+/*****************************************************************************/
+
+gchar *
+rmfd_qmimux_find_link (const gchar *master,
+                       guint8       mux_id)
+{
+    gchar       *path;
+    GDir        *dir;
+    const gchar *name;
+    gchar       *link = NULL;
+
+    path = g_build_filename (SYSFS_NET_PATH, master, NULL);
+    dir = g_dir_open (path, 0, NULL);
+    g_free (path);
+    if (!dir)
+        return NULL;
+
+    /* Links are listed as 'upper_<iface>' in the master interface */
+    while (!link && (name = g_dir_read_name (dir))) {
+        gchar *contents = NULL;
+
+        if (!g_str_has_prefix (name, "upper_"))
+            continue;
+
+        path = g_build_filename (SYSFS_NET_PATH, name + strlen ("upper_"), "qmap", "mux_id", NULL);
+        if (g_file_get_contents (path, &contents, NULL, NULL) &&
+            g_ascii_strtoull (g_strstrip (contents), NULL, 0) == mux_id)
+            link = g_strdup (name + strlen ("upper_"));
+        g_free (contents);
+        g_free (path);
+    }
+
+    g_dir_close (dir);
+    return link;
+}
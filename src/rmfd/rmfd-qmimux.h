@@ -0,0 +1,59 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#ifndef RMFD_QMIMUX_H
+#define RMFD_QMIMUX_H
+
+#include <glib.h>
+
+/* QMAP multiplexing support in the qmi_wwan driver; each mux id gets its own
+ * qmimux link network interface on top of the master wwan interface */
+
+#define RMFD_QMIMUX_ID_FIRST 0x80
+
+/* USB interface number of the given control port (e.g. "cdc-wdm0") */
+gboolean  rmfd_qmimux_get_interface_number (const gchar  *control_port,
+                                            guint        *interface_number,
+                                            GError      **error);
+
+/* Master interface must be up for the links to get any traffic. The qmi_wwan
+ * rx_urb_size follows the master MTU, so it is set to the downlink
+ * aggregation size, if any (0 to leave it untouched). */
+gboolean  rmfd_qmimux_setup_master         (const gchar  *master,
+                                            guint         mtu,
+                                            GError      **error);
+
+gboolean  rmfd_qmimux_add_link             (const gchar  *master,
+                                            guint8        mux_id,
+                                            GError      **error);
+gboolean  rmfd_qmimux_del_link             (const gchar  *master,
+                                            guint8        mux_id,
+                                            GError      **error);
+
+/* Returns the name of the link with the given mux id, or NULL if none */
+gchar    *rmfd_qmimux_find_link            (const gchar  *master,
+                                            guint8        mux_id);
+
+#endif /* RMFD_QMIMUX_H */
@@ -0,0 +1,140 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#include <string.h>
+#include <errno.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "rmfd-registration-state.h"
+#include "rmfd-writer.h"
+
+#define GROUP_REGISTRATION "registration"
+
+#define KEY_ICCID                  "iccid"
+#define KEY_MCC                    "mcc"
+#define KEY_MNC                    "mnc"
+#define KEY_MNC_INCLUDES_PCS_DIGIT "mnc-includes-pcs-digit"
+#define KEY_RADIO_INTERFACE        "radio-interface"
+
+/*****************************************************************************/
+
+gboolean
+rmfd_registration_state_load (RmfdRegistrationState *state)
+{
+    GKeyFile *key_file;
+    GError   *error = NULL;
+    gchar    *iccid = NULL;
+    gboolean  loaded = FALSE;
+
+    g_assert (state);
+
+    key_file = g_key_file_new ();
+    if (!g_key_file_load_from_file (key_file, RMFD_REGISTRATION_STATE_FILE_PATH, G_KEY_FILE_NONE, &error)) {
+        if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+            g_warning ("couldn't load registration state: %s", error->message);
+        g_error_free (error);
+        goto out;
+    }
+
+    /* States stored without the card can't be used */
+    iccid = g_key_file_get_string (key_file, GROUP_REGISTRATION, KEY_ICCID, NULL);
+    if (!iccid) {
+        g_debug ("registration state without card: ignored");
+        goto out;
+    }
+
+    state->mcc                    = (guint16) g_key_file_get_integer (key_file, GROUP_REGISTRATION, KEY_MCC, NULL);
+    state->mnc                    = (guint16) g_key_file_get_integer (key_file, GROUP_REGISTRATION, KEY_MNC, NULL);
+    state->mnc_includes_pcs_digit = g_key_file_get_boolean (key_file, GROUP_REGISTRATION, KEY_MNC_INCLUDES_PCS_DIGIT, NULL);
+    state->radio_interface        = (guint) g_key_file_get_integer (key_file, GROUP_REGISTRATION, KEY_RADIO_INTERFACE, NULL);
+
+    if (!iccid[0] || strlen (iccid) >= sizeof (state->iccid) ||
+        !state->mcc || state->mcc > 999 ||
+        state->mnc > (state->mnc_includes_pcs_digit ? 999 : 99)) {
+        g_warning ("invalid registration state");
+        goto out;
+    }
+    g_strlcpy (state->iccid, iccid, sizeof (state->iccid));
+
+    loaded = TRUE;
+
+out:
+    g_free (iccid);
+    g_key_file_free (key_file);
+    return loaded;
+}
+
+/* Only the serialized contents are given to the writer */
+static void
+save_job_run (gchar *contents)
+{
+    gchar  *dirname;
+    GError *error = NULL;
+
+    dirname = g_path_get_dirname (RMFD_REGISTRATION_STATE_FILE_PATH);
+    if (g_mkdir_with_parents (dirname, 0755) < 0)
+        g_warning ("couldn't create registration state directory '%s'", dirname);
+    g_free (dirname);
+
+    if (!g_file_set_contents (RMFD_REGISTRATION_STATE_FILE_PATH, contents, -1, &error)) {
+        g_warning ("couldn't write registration state: %s", error->message);
+        g_error_free (error);
+    }
+}
+
+void
+rmfd_registration_state_save (const RmfdRegistrationState *state)
+{
+    GKeyFile *key_file;
+
+    g_assert (state);
+
+    key_file = g_key_file_new ();
+    g_key_file_set_string  (key_file, GROUP_REGISTRATION, KEY_ICCID, state->iccid);
+    g_key_file_set_integer (key_file, GROUP_REGISTRATION, KEY_MCC, state->mcc);
+    g_key_file_set_integer (key_file, GROUP_REGISTRATION, KEY_MNC, state->mnc);
+    g_key_file_set_boolean (key_file, GROUP_REGISTRATION, KEY_MNC_INCLUDES_PCS_DIGIT, state->mnc_includes_pcs_digit);
+    g_key_file_set_integer (key_file, GROUP_REGISTRATION, KEY_RADIO_INTERFACE, state->radio_interface);
+
+    rmfd_writer_push ((RmfdWriterFunc) save_job_run,
+                      g_key_file_to_data (key_file, NULL, NULL),
+                      g_free);
+    g_key_file_free (key_file);
+}
+
+static void
+clear_job_run (gpointer unused)
+{
+    if (g_unlink (RMFD_REGISTRATION_STATE_FILE_PATH) < 0 && errno != ENOENT)
+        g_warning ("couldn't remove registration state: %s", g_strerror (errno));
+}
+
+void
+rmfd_registration_state_clear (void)
+{
+    rmfd_writer_push (clear_job_run, NULL, NULL);
+}
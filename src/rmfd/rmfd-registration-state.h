@@ -0,0 +1,56 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#ifndef RMFD_REGISTRATION_STATE_H
+#define RMFD_REGISTRATION_STATE_H
+
+#include <glib.h>
+
+/* Overridable at build time, e.g. by the unit tests */
+#ifndef RMFD_REGISTRATION_STATE_FILE_PATH
+# define RMFD_REGISTRATION_STATE_FILE_PATH "/var/lib/rmfd/registration.state"
+#endif
+
+/* ICCIDs have at most 20 digits */
+#define RMFD_REGISTRATION_STATE_ICCID_SIZE 21
+
+/* Last network the modem was successfully registered in, and the card it
+ * was registered with, so that the next registration with the same card may
+ * directly target it */
+typedef struct {
+    gchar    iccid[RMFD_REGISTRATION_STATE_ICCID_SIZE];
+    guint16  mcc;
+    guint16  mnc;
+    gboolean mnc_includes_pcs_digit; /* i.e. 3-digit MNC */
+    guint    radio_interface;        /* QmiNasRadioInterface */
+} RmfdRegistrationState;
+
+/* Returns FALSE if no registration state was stored. Saves and clears are
+ * run in the writer, in order. */
+gboolean rmfd_registration_state_load  (RmfdRegistrationState       *state);
+void     rmfd_registration_state_save  (const RmfdRegistrationState *state);
+void     rmfd_registration_state_clear (void);
+
+#endif /* RMFD_REGISTRATION_STATE_H */
@@ -0,0 +1,204 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "rmfd-session-state.h"
+#include "rmfd-writer.h"
+
+#define GROUP_SESSION "session"
+
+#define KEY_CONTROL_PORT       "control-port"
+#define KEY_DATA_PORT          "data-port"
+#define KEY_WDS_CID            "wds-cid"
+#define KEY_PACKET_DATA_HANDLE "packet-data-handle"
+#define KEY_SIM_SLOT           "sim-slot"
+#define KEY_IP                 "ip"
+#define KEY_SUBNET             "subnet"
+#define KEY_GW                 "gw"
+#define KEY_DNS1               "dns1"
+#define KEY_DNS2               "dns2"
+#define KEY_MTU                "mtu"
+
+#define GROUP_STATS_FORMAT         "stats-%u"
+#define KEY_STATS_START_TIME        "start-time"
+#define KEY_STATS_START_SYSTEM_TIME "start-system-time"
+
+/*****************************************************************************/
+
+RmfdSessionState *
+rmfd_session_state_new (void)
+{
+    return g_slice_new0 (RmfdSessionState);
+}
+
+void
+rmfd_session_state_free (RmfdSessionState *state)
+{
+    g_free (state->control_port);
+    g_free (state->data_port);
+    g_free (state->ip);
+    g_free (state->subnet);
+    g_free (state->gw);
+    g_free (state->dns1);
+    g_free (state->dns2);
+    g_slice_free (RmfdSessionState, state);
+}
+
+/*****************************************************************************/
+
+RmfdSessionState *
+rmfd_session_state_load (void)
+{
+    GKeyFile         *key_file;
+    RmfdSessionState *state = NULL;
+    GError           *error = NULL;
+    guint             i;
+
+    key_file = g_key_file_new ();
+    if (!g_key_file_load_from_file (key_file, RMFD_SESSION_STATE_FILE_PATH, G_KEY_FILE_NONE, &error)) {
+        if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+            g_warning ("couldn't load session state: %s", error->message);
+        g_error_free (error);
+        goto out;
+    }
+
+    state = rmfd_session_state_new ();
+    state->control_port       = g_key_file_get_string  (key_file, GROUP_SESSION, KEY_CONTROL_PORT, NULL);
+    state->data_port          = g_key_file_get_string  (key_file, GROUP_SESSION, KEY_DATA_PORT, NULL);
+    state->wds_cid            = (guint8) g_key_file_get_integer (key_file, GROUP_SESSION, KEY_WDS_CID, NULL);
+    state->packet_data_handle = (guint32) g_key_file_get_uint64 (key_file, GROUP_SESSION, KEY_PACKET_DATA_HANDLE, NULL);
+    state->sim_slot           = (guint) g_key_file_get_integer (key_file, GROUP_SESSION, KEY_SIM_SLOT, NULL);
+    state->ip                 = g_key_file_get_string  (key_file, GROUP_SESSION, KEY_IP, NULL);
+    state->subnet             = g_key_file_get_string  (key_file, GROUP_SESSION, KEY_SUBNET, NULL);
+    state->gw                 = g_key_file_get_string  (key_file, GROUP_SESSION, KEY_GW, NULL);
+    state->dns1               = g_key_file_get_string  (key_file, GROUP_SESSION, KEY_DNS1, NULL);
+    state->dns2               = g_key_file_get_string  (key_file, GROUP_SESSION, KEY_DNS2, NULL);
+    state->mtu                = (guint32) g_key_file_get_uint64 (key_file, GROUP_SESSION, KEY_MTU, NULL);
+
+    for (i = 0; i < G_N_ELEMENTS (state->stats); i++) {
+        gchar *group;
+
+        group = g_strdup_printf (GROUP_STATS_FORMAT, i);
+        if (g_key_file_has_group (key_file, group)) {
+            state->stats[i].valid             = TRUE;
+            state->stats[i].start_time        = g_key_file_get_int64 (key_file, group, KEY_STATS_START_TIME, NULL);
+            state->stats[i].start_system_time = g_key_file_get_int64 (key_file, group, KEY_STATS_START_SYSTEM_TIME, NULL);
+        }
+        g_free (group);
+    }
+
+    if (!state->control_port || !state->data_port || !state->wds_cid || !state->packet_data_handle) {
+        g_warning ("invalid session state");
+        g_clear_pointer (&state, (GDestroyNotify) rmfd_session_state_free);
+    }
+
+out:
+    g_key_file_free (key_file);
+    return state;
+}
+
+/* Only the serialized contents are given to the writer, so that a save
+ * followed by a clear is run in order */
+static void
+save_job_run (gchar *contents)
+{
+    gchar  *dirname;
+    GError *error = NULL;
+
+    dirname = g_path_get_dirname (RMFD_SESSION_STATE_FILE_PATH);
+    if (g_mkdir_with_parents (dirname, 0755) < 0)
+        g_warning ("couldn't create session state directory '%s'", dirname);
+    g_free (dirname);
+
+    if (!g_file_set_contents (RMFD_SESSION_STATE_FILE_PATH, contents, -1, &error)) {
+        g_warning ("couldn't write session state: %s", error->message);
+        g_error_free (error);
+    }
+}
+
+void
+rmfd_session_state_save (const RmfdSessionState *state)
+{
+    GKeyFile *key_file;
+    guint     i;
+
+    g_assert (state);
+    g_assert (state->control_port);
+    g_assert (state->data_port);
+
+    key_file = g_key_file_new ();
+    g_key_file_set_string  (key_file, GROUP_SESSION, KEY_CONTROL_PORT, state->control_port);
+    g_key_file_set_string  (key_file, GROUP_SESSION, KEY_DATA_PORT, state->data_port);
+    g_key_file_set_integer (key_file, GROUP_SESSION, KEY_WDS_CID, state->wds_cid);
+    g_key_file_set_uint64  (key_file, GROUP_SESSION, KEY_PACKET_DATA_HANDLE, state->packet_data_handle);
+    g_key_file_set_integer (key_file, GROUP_SESSION, KEY_SIM_SLOT, state->sim_slot);
+    g_key_file_set_uint64  (key_file, GROUP_SESSION, KEY_MTU, state->mtu);
+    if (state->ip)
+        g_key_file_set_string (key_file, GROUP_SESSION, KEY_IP, state->ip);
+    if (state->subnet)
+        g_key_file_set_string (key_file, GROUP_SESSION, KEY_SUBNET, state->subnet);
+    if (state->gw)
+        g_key_file_set_string (key_file, GROUP_SESSION, KEY_GW, state->gw);
+    if (state->dns1)
+        g_key_file_set_string (key_file, GROUP_SESSION, KEY_DNS1, state->dns1);
+    if (state->dns2)
+        g_key_file_set_string (key_file, GROUP_SESSION, KEY_DNS2, state->dns2);
+
+    for (i = 0; i < G_N_ELEMENTS (state->stats); i++) {
+        gchar *group;
+
+        if (!state->stats[i].valid)
+            continue;
+
+        group = g_strdup_printf (GROUP_STATS_FORMAT, i);
+        g_key_file_set_int64 (key_file, group, KEY_STATS_START_TIME, state->stats[i].start_time);
+        g_key_file_set_int64 (key_file, group, KEY_STATS_START_SYSTEM_TIME, state->stats[i].start_system_time);
+        g_free (group);
+    }
+
+    rmfd_writer_push ((RmfdWriterFunc) save_job_run,
+                      g_key_file_to_data (key_file, NULL, NULL),
+                      g_free);
+    g_key_file_free (key_file);
+}
+
+static void
+clear_job_run (gpointer unused)
+{
+    if (g_unlink (RMFD_SESSION_STATE_FILE_PATH) < 0 && errno != ENOENT)
+        g_warning ("couldn't remove session state: %s", g_strerror (errno));
+}
+
+void
+rmfd_session_state_clear (void)
+{
+    rmfd_writer_push (clear_job_run, NULL, NULL);
+}
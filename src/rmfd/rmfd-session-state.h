@@ -0,0 +1,69 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#ifndef RMFD_SESSION_STATE_H
+#define RMFD_SESSION_STATE_H
+
+#include <glib.h>
+
+/* Overridable at build time, e.g. by the unit tests */
+#ifndef RMFD_SESSION_STATE_FILE_PATH
+# define RMFD_SESSION_STATE_FILE_PATH "/var/lib/rmfd/session.state"
+#endif
+
+/* Per-slot stats session start, so that the ongoing stats session can be
+ * continued after a restart */
+typedef struct {
+    gboolean valid;
+    gint64   start_time;        /* unix timestamp */
+    gint64   start_system_time; /* unix timestamp, 0 if unknown */
+} RmfdSessionStateStats;
+
+/* Data session that may be resumed after a daemon restart */
+typedef struct {
+    gchar                 *control_port; /* e.g. "cdc-wdm0" */
+    gchar                 *data_port;    /* e.g. "wwan0" */
+    guint8                 wds_cid;
+    guint32                packet_data_handle;
+    guint                  sim_slot;
+    gchar                 *ip;
+    gchar                 *subnet;
+    gchar                 *gw;
+    gchar                 *dns1;
+    gchar                 *dns2;
+    guint32                mtu;
+    RmfdSessionStateStats  stats[2];
+} RmfdSessionState;
+
+RmfdSessionState *rmfd_session_state_new   (void);
+void              rmfd_session_state_free  (RmfdSessionState       *state);
+
+/* Returns NULL if no session was stored. Saves and clears are run in the
+ * writer, in order. */
+RmfdSessionState *rmfd_session_state_load  (void);
+void              rmfd_session_state_save  (const RmfdSessionState *state);
+void              rmfd_session_state_clear (void);
+
+#endif /* RMFD_SESSION_STATE_H */
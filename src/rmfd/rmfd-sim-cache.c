@@ -0,0 +1,344 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "rmfd-sim-cache.h"
+#include "rmfd-writer.h"
+
+/* Cards other than the most recent ones are forgotten */
+#define MAX_CARDS 8
+
+/*****************************************************************************/
+
+static gchar *
+bytes_to_hex (const GArray *array)
+{
+    GString *str;
+    guint    i;
+
+    str = g_string_sized_new (array->len * 2 + 1);
+    for (i = 0; i < array->len; i++)
+        g_string_append_printf (str, "%02x", g_array_index (array, guint8, i));
+    return g_string_free (str, FALSE);
+}
+
+static GArray *
+hex_to_bytes (const gchar *hex)
+{
+    GArray *array;
+    gsize   len;
+    gsize   i;
+
+    len = strlen (hex);
+    if (len % 2 != 0)
+        return NULL;
+
+    array = g_array_sized_new (FALSE, FALSE, sizeof (guint8), len / 2);
+    for (i = 0; i < len; i += 2) {
+        gint high;
+        gint low;
+        guint8 val;
+
+        high = g_ascii_xdigit_value (hex[i]);
+        low  = g_ascii_xdigit_value (hex[i + 1]);
+        if (high < 0 || low < 0) {
+            g_array_unref (array);
+            return NULL;
+        }
+        val = (guint8) ((high << 4) | low);
+        g_array_append_val (array, val);
+    }
+    return array;
+}
+
+static GKeyFile *
+load_key_file (void)
+{
+    GKeyFile *key_file;
+    GError   *error = NULL;
+
+    key_file = g_key_file_new ();
+    if (!g_key_file_load_from_file (key_file, RMFD_SIM_CACHE_FILE_PATH, G_KEY_FILE_NONE, &error)) {
+        if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+            g_warning ("couldn't load SIM cache: %s", error->message);
+        g_error_free (error);
+    }
+    return key_file;
+}
+
+/*****************************************************************************/
+
+typedef struct {
+    GTask *task;
+    gchar *group;
+} LookupJob;
+
+static void
+lookup_job_free (LookupJob *job)
+{
+    g_object_unref (job->task);
+    g_free (job->group);
+    g_slice_free (LookupJob, job);
+}
+
+static void
+lookup_job_run (LookupJob *job)
+{
+    GKeyFile    *key_file;
+    GHashTable  *files = NULL;
+    gchar      **keys;
+    guint        i;
+
+    key_file = load_key_file ();
+    keys = g_key_file_get_keys (key_file, job->group, NULL, NULL);
+    for (i = 0; keys && keys[i]; i++) {
+        gchar  *hex;
+        GArray *contents;
+
+        hex = g_key_file_get_string (key_file, job->group, keys[i], NULL);
+        contents = hex ? hex_to_bytes (hex) : NULL;
+        g_free (hex);
+        if (!contents) {
+            g_warning ("invalid SIM cache entry '%s' for card '%s'", keys[i], job->group);
+            continue;
+        }
+
+        if (!files)
+            files = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_array_unref);
+        g_hash_table_insert (files, g_strdup (keys[i]), contents);
+    }
+
+    g_strfreev (keys);
+    g_key_file_free (key_file);
+
+    /* Completed in the main context of the caller */
+    g_task_return_pointer (job->task, files, files ? (GDestroyNotify) g_hash_table_unref : NULL);
+}
+
+GHashTable *
+rmfd_sim_cache_lookup_finish (GAsyncResult *res)
+{
+    return g_task_propagate_pointer (G_TASK (res), NULL);
+}
+
+void
+rmfd_sim_cache_lookup (const GArray        *iccid,
+                       GAsyncReadyCallback  callback,
+                       gpointer             user_data)
+{
+    LookupJob *job;
+
+    g_assert (iccid);
+
+    job = g_slice_new (LookupJob);
+    job->task  = g_task_new (NULL, NULL, callback, user_data);
+    job->group = bytes_to_hex (iccid);
+
+    rmfd_writer_push ((RmfdWriterFunc) lookup_job_run,
+                      job,
+                      (GDestroyNotify) lookup_job_free);
+}
+
+/*****************************************************************************/
+
+/* Card contents (e.g. the IMSI) must not be world readable, so instead of
+ * g_file_set_contents(), which honours the umask, write a 0600 temporary file
+ * and rename it over the cache. */
+static gboolean
+write_private_file (const gchar  *path,
+                    const gchar  *data,
+                    gsize         length,
+                    GError      **error)
+{
+    gchar *tmp_path;
+    gint   fd;
+    gsize  written = 0;
+
+    tmp_path = g_strdup_printf ("%s.XXXXXX", path);
+    fd = g_mkstemp_full (tmp_path, O_RDWR, 0600);
+    if (fd < 0) {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                     "couldn't create temporary file '%s': %s", tmp_path, g_strerror (errno));
+        g_free (tmp_path);
+        return FALSE;
+    }
+
+    while (written < length) {
+        gssize n;
+
+        n = write (fd, data + written, length - written);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                         "couldn't write temporary file '%s': %s", tmp_path, g_strerror (errno));
+            close (fd);
+            g_unlink (tmp_path);
+            g_free (tmp_path);
+            return FALSE;
+        }
+        written += n;
+    }
+
+    if (close (fd) < 0 || g_rename (tmp_path, path) < 0) {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                     "couldn't replace '%s': %s", path, g_strerror (errno));
+        g_unlink (tmp_path);
+        g_free (tmp_path);
+        return FALSE;
+    }
+
+    g_free (tmp_path);
+    return TRUE;
+}
+
+static void
+save_key_file (GKeyFile *key_file)
+{
+    gchar  *dirname;
+    gchar  *data;
+    gsize   length;
+    GError *error = NULL;
+
+    dirname = g_path_get_dirname (RMFD_SIM_CACHE_FILE_PATH);
+    if (g_mkdir_with_parents (dirname, 0755) < 0)
+        g_warning ("couldn't create SIM cache directory '%s'", dirname);
+    g_free (dirname);
+
+    data = g_key_file_to_data (key_file, &length, NULL);
+    if (!write_private_file (RMFD_SIM_CACHE_FILE_PATH, data, length, &error)) {
+        g_warning ("couldn't write SIM cache: %s", error->message);
+        g_error_free (error);
+    }
+    g_free (data);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+    gchar *group;
+    gchar *file_name;
+    gchar *contents;
+} StoreJob;
+
+static void
+store_job_free (StoreJob *job)
+{
+    g_free (job->group);
+    g_free (job->file_name);
+    g_free (job->contents);
+    g_slice_free (StoreJob, job);
+}
+
+static void
+store_job_run (StoreJob *job)
+{
+    GKeyFile  *key_file;
+    gchar    **keys;
+    gchar    **values;
+    gsize      n_keys = 0;
+    gchar    **groups;
+    gsize      n_groups;
+    guint      i;
+
+    key_file = load_key_file ();
+
+    /* The most recently updated card is always the last group, so that the
+     * oldest ones are the first ones removed */
+    keys = g_key_file_get_keys (key_file, job->group, &n_keys, NULL);
+    values = g_new0 (gchar *, n_keys);
+    for (i = 0; i < n_keys; i++)
+        values[i] = g_key_file_get_string (key_file, job->group, keys[i], NULL);
+    g_key_file_remove_group (key_file, job->group, NULL);
+
+    groups = g_key_file_get_groups (key_file, &n_groups);
+    for (i = 0; n_groups >= MAX_CARDS && i <= n_groups - MAX_CARDS; i++)
+        g_key_file_remove_group (key_file, groups[i], NULL);
+    g_strfreev (groups);
+
+    for (i = 0; i < n_keys; i++) {
+        if (values[i] && !g_str_equal (keys[i], job->file_name))
+            g_key_file_set_string (key_file, job->group, keys[i], values[i]);
+    }
+    g_key_file_set_string (key_file, job->group, job->file_name, job->contents);
+    for (i = 0; i < n_keys; i++)
+        g_free (values[i]);
+    g_free (values);
+    g_strfreev (keys);
+
+    save_key_file (key_file);
+    g_key_file_free (key_file);
+}
+
+void
+rmfd_sim_cache_store (const GArray *iccid,
+                      const gchar  *file_name,
+                      const GArray *contents)
+{
+    StoreJob *job;
+
+    g_assert (iccid);
+    g_assert (file_name);
+    g_assert (contents);
+
+    job = g_slice_new (StoreJob);
+    job->group     = bytes_to_hex (iccid);
+    job->file_name = g_strdup (file_name);
+    job->contents  = bytes_to_hex (contents);
+
+    rmfd_writer_push ((RmfdWriterFunc) store_job_run,
+                      job,
+                      (GDestroyNotify) store_job_free);
+}
+
+/*****************************************************************************/
+
+static void
+remove_job_run (gchar *group)
+{
+    GKeyFile *key_file;
+
+    key_file = load_key_file ();
+    if (g_key_file_remove_group (key_file, group, NULL))
+        save_key_file (key_file);
+    g_key_file_free (key_file);
+}
+
+void
+rmfd_sim_cache_remove (const GArray *iccid)
+{
+    g_assert (iccid);
+
+    rmfd_writer_push ((RmfdWriterFunc) remove_job_run,
+                      bytes_to_hex (iccid),
+                      g_free);
+}
@@ -0,0 +1,49 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#ifndef RMFD_SIM_CACHE_H
+#define RMFD_SIM_CACHE_H
+
+#include <gio/gio.h>
+
+/* Overridable at build time, e.g. by the unit tests */
+#ifndef RMFD_SIM_CACHE_FILE_PATH
+# define RMFD_SIM_CACHE_FILE_PATH "/var/lib/rmfd/sim.cache"
+#endif
+
+/* Contents of SIM files, persisted per card, keyed by the raw EFiccid
+ * contents. The lookup gives a table of file name -> GArray of guint8, or
+ * NULL if nothing stored for the given card. Lookups, stores and removals
+ * are all run in the writer, in order. */
+void        rmfd_sim_cache_lookup        (const GArray        *iccid,
+                                          GAsyncReadyCallback  callback,
+                                          gpointer             user_data);
+GHashTable *rmfd_sim_cache_lookup_finish (GAsyncResult        *res);
+void        rmfd_sim_cache_store         (const GArray        *iccid,
+                                          const gchar         *file_name,
+                                          const GArray        *contents);
+void        rmfd_sim_cache_remove        (const GArray        *iccid);
+
+#endif /* RMFD_SIM_CACHE_H */
@@ -34,6 +34,7 @@
 
 #include "rmfd-stats.h"
 #include "rmfd-syslog.h"
+#include "rmfd-writer.h"
 
 typedef struct {
     guint   year;
@@ -42,13 +43,19 @@ typedef struct {
     guint64 tx_bytes;
 } MonthlyStats;
 
-struct _RmfdStatsContext {
+/* Stats file where records are written, along with the monthly stats loaded
+ * from it; only used from the writer */
+typedef struct {
     gchar        *path;
     gchar        *name;
     FILE         *file;
-    GDateTime    *start_system_time;
-    time_t        start_time;
     MonthlyStats  monthly_stats;
+} StatsFile;
+
+struct _RmfdStatsContext {
+    StatsFile *stats_file;
+    GDateTime *start_system_time;
+    time_t     start_time;
 };
 
 #define MAX_LINE_LENGTH 255
@@ -124,11 +131,224 @@ write_monthly_stats (const gchar *context_name,
 }
 
 /******************************************************************************/
-/* Write to tmp stats file */
+/* Stats file operations, run in the writer */
+
+typedef enum {
+    STATS_FILE_OP_LOAD,
+    STATS_FILE_OP_LOAD_KEEP_OPEN_SESSION,
+    STATS_FILE_OP_OPEN_APPEND,
+    STATS_FILE_OP_START,
+    STATS_FILE_OP_WRITE,
+    STATS_FILE_OP_FINAL,
+    STATS_FILE_OP_FREE,
+} StatsFileOp;
+
+/* Contents of the Final record, also reported to syslog */
+typedef struct {
+    gchar   *from_str;
+    gchar   *to_str;
+    gulong   duration;
+    guint64  rx_bytes;
+    guint64  tx_bytes;
+    gchar   *radio_interface;
+    gint8    rssi;
+    guint16  mcc;
+    guint16  mnc;
+    guint16  lac;
+    guint32  cid;
+} FinalRecord;
+
+typedef struct {
+    StatsFileOp  op;
+    StatsFile   *stats_file;
+    gchar       *line;
+    guint        year;  /* START only */
+    guint        month; /* START only */
+    FinalRecord  final; /* FINAL only */
+} StatsFileJob;
+
+static void load_previous_stats (StatsFile *stats_file,
+                                 gboolean   keep_open_session);
+
+static void
+stats_file_job_free (StatsFileJob *job)
+{
+    g_free (job->line);
+    g_free (job->final.from_str);
+    g_free (job->final.to_str);
+    g_free (job->final.radio_interface);
+    g_slice_free (StatsFileJob, job);
+}
+
+static void
+stats_file_open (StatsFile *stats_file,
+                 gboolean   append)
+{
+    if (stats_file->file)
+        fclose (stats_file->file);
+    errno = 0;
+    if (!(stats_file->file = fopen (stats_file->path, append ? "a" : "w")))
+        g_warning ("error: cannot open stats file: %s", g_strerror (errno));
+}
 
 static void
-write_record (FILE        *file,
-              gchar        record_type,
+stats_file_write (StatsFile   *stats_file,
+                  const gchar *line)
+{
+    if (!stats_file->file)
+        return;
+    if (fprintf (stats_file->file, "%s", line) < 0)
+        g_warning ("error: cannot write to stats file: %s", g_strerror (ferror (stats_file->file)));
+    else
+        fflush (stats_file->file);
+}
+
+static void
+stats_file_close (StatsFile *stats_file)
+{
+    if (stats_file->file) {
+        fclose (stats_file->file);
+        stats_file->file = NULL;
+    }
+}
+
+static void
+stats_file_start (StatsFile   *stats_file,
+                  guint        year,
+                  guint        month,
+                  const gchar *line)
+{
+    MonthlyStats *monthly_stats = &stats_file->monthly_stats;
+    gboolean      append = TRUE;
+
+    /* If changing stats month, syslog and remove the previous file */
+    if ((year == monthly_stats->year && month > monthly_stats->month) ||
+        (year > monthly_stats->year)) {
+        if (monthly_stats->year > 0)
+            write_monthly_stats (stats_file->name,
+                                 monthly_stats->year,
+                                 monthly_stats->month,
+                                 monthly_stats->rx_bytes,
+                                 monthly_stats->tx_bytes);
+
+        g_debug ("updated stats date: %u/%u", year, month);
+        monthly_stats->year     = year;
+        monthly_stats->month    = month;
+        monthly_stats->rx_bytes = 0;
+        monthly_stats->tx_bytes = 0;
+
+        append = FALSE;
+    }
+
+    /* Open the file only when started */
+    stats_file_open (stats_file, append);
+    stats_file_write (stats_file, line);
+}
+
+static void
+stats_file_final (StatsFile         *stats_file,
+                  const gchar       *line,
+                  const FinalRecord *final)
+{
+    MonthlyStats *monthly_stats = &stats_file->monthly_stats;
+
+    stats_file_write (stats_file, line);
+
+    /* Update monthly stats */
+    monthly_stats->rx_bytes += final->rx_bytes;
+    monthly_stats->tx_bytes += final->tx_bytes;
+
+    g_debug ("writing stats to syslog...");
+    write_syslog_record (stats_file->name,
+                         FALSE,
+                         final->from_str,
+                         final->to_str,
+                         final->duration,
+                         final->rx_bytes,
+                         final->tx_bytes,
+                         final->radio_interface, final->rssi,
+                         final->mcc, final->mnc, final->lac, final->cid,
+                         monthly_stats->year,
+                         monthly_stats->month,
+                         monthly_stats->rx_bytes,
+                         monthly_stats->tx_bytes);
+
+    stats_file_close (stats_file);
+}
+
+static void
+stats_file_job_run (StatsFileJob *job)
+{
+    StatsFile *stats_file = job->stats_file;
+
+    switch (job->op) {
+    case STATS_FILE_OP_LOAD:
+    case STATS_FILE_OP_LOAD_KEEP_OPEN_SESSION:
+        load_previous_stats (stats_file, job->op == STATS_FILE_OP_LOAD_KEEP_OPEN_SESSION);
+        return;
+
+    case STATS_FILE_OP_OPEN_APPEND:
+        stats_file_open (stats_file, TRUE);
+        return;
+
+    case STATS_FILE_OP_START:
+        stats_file_start (stats_file, job->year, job->month, job->line);
+        return;
+
+    case STATS_FILE_OP_WRITE:
+        stats_file_write (stats_file, job->line);
+        return;
+
+    case STATS_FILE_OP_FINAL:
+        stats_file_final (stats_file, job->line, &job->final);
+        return;
+
+    case STATS_FILE_OP_FREE:
+        stats_file_close (stats_file);
+        g_free (stats_file->path);
+        g_free (stats_file->name);
+        g_slice_free (StatsFile, stats_file);
+        return;
+    }
+
+    g_assert_not_reached ();
+}
+
+static StatsFileJob *
+stats_file_job_new (StatsFile   *stats_file,
+                    StatsFileOp  op,
+                    gchar       *line)
+{
+    StatsFileJob *job;
+
+    job = g_slice_new0 (StatsFileJob);
+    job->op         = op;
+    job->stats_file = stats_file;
+    job->line       = line;
+    return job;
+}
+
+static void
+stats_file_job_push (StatsFileJob *job)
+{
+    rmfd_writer_push ((RmfdWriterFunc) stats_file_job_run,
+                      job,
+                      (GDestroyNotify) stats_file_job_free);
+}
+
+static void
+stats_file_push (StatsFile   *stats_file,
+                 StatsFileOp  op,
+                 gchar       *line)
+{
+    stats_file_job_push (stats_file_job_new (stats_file, op, line));
+}
+
+/******************************************************************************/
+/* Build stats file record */
+
+static gchar *
+build_record (gchar        record_type,
               GDateTime   *from_system_time,
               time_t       from_time,
               GDateTime   *to_system_time,
@@ -167,13 +387,10 @@ write_record (FILE        *file,
                 (guint) lac,
                 (guint) cid);
 
-    if (fprintf (file, "%s", line) < 0)
-        g_warning ("error: cannot write to stats file: %s", g_strerror (ferror (file)));
-    else
-        fflush (file);
-
     g_free (from_str);
     g_free (to_str);
+
+    return g_strdup (line);
 }
 
 /******************************************************************************/
@@ -229,7 +446,7 @@ parse_record (gchar *line,
 /* Monthly stats computation */
 
 static void
-monthly_stats_append_record (RmfdStatsContext *ctx,
+monthly_stats_append_record (StatsFile        *stats_file,
                              const gchar      *system_time_str,
                              const gchar      *rx_bytes_str,
                              const gchar      *tx_bytes_str)
@@ -277,30 +494,30 @@ monthly_stats_append_record (RmfdStatsContext *ctx,
     tx_bytes = g_ascii_strtoull (tx_bytes_str, NULL, 10);
 
     /* If year/month info not yet added, do it right away */
-    if (ctx->monthly_stats.year == 0 || ctx->monthly_stats.month == 0) {
+    if (stats_file->monthly_stats.year == 0 || stats_file->monthly_stats.month == 0) {
         g_debug ("  set initial stats date: %u/%u", year, month);
-        ctx->monthly_stats.year = year;
-        ctx->monthly_stats.month = month;
+        stats_file->monthly_stats.year = year;
+        stats_file->monthly_stats.month = month;
     }
 
     /* If stats for the same month as the first one, add them */
-    if (year == ctx->monthly_stats.year && month == ctx->monthly_stats.month) {
+    if (year == stats_file->monthly_stats.year && month == stats_file->monthly_stats.month) {
         g_debug ("  record (%u/%u): rx+=%" G_GUINT64_FORMAT ", tx+=%" G_GUINT64_FORMAT,
                  year, month, rx_bytes, tx_bytes);
-        ctx->monthly_stats.rx_bytes += rx_bytes;
-        ctx->monthly_stats.tx_bytes += tx_bytes;
-    } else if ((year == ctx->monthly_stats.year && month > ctx->monthly_stats.month) ||
-               (year > ctx->monthly_stats.year)) {
+        stats_file->monthly_stats.rx_bytes += rx_bytes;
+        stats_file->monthly_stats.tx_bytes += tx_bytes;
+    } else if ((year == stats_file->monthly_stats.year && month > stats_file->monthly_stats.month) ||
+               (year > stats_file->monthly_stats.year)) {
         g_debug ("  updated stats date: %u/%u", year, month);
         g_debug ("  record (%u/%u): rx=%" G_GUINT64_FORMAT ", tx=%" G_GUINT64_FORMAT,
                  year, month, rx_bytes, tx_bytes);
-        ctx->monthly_stats.year     = year;
-        ctx->monthly_stats.month    = month;
-        ctx->monthly_stats.rx_bytes = rx_bytes;
-        ctx->monthly_stats.tx_bytes = tx_bytes;
+        stats_file->monthly_stats.year     = year;
+        stats_file->monthly_stats.month    = month;
+        stats_file->monthly_stats.rx_bytes = rx_bytes;
+        stats_file->monthly_stats.tx_bytes = tx_bytes;
     } else {
         g_debug ("  ignoring record with wrong date: %u/%u (reference: %u/%u)",
-                 year, month, ctx->monthly_stats.year, ctx->monthly_stats.month);
+                 year, month, stats_file->monthly_stats.year, stats_file->monthly_stats.month);
         g_debug ("  record (%u/%u): rx (ignored) %" G_GUINT64_FORMAT ", tx (ignored) %" G_GUINT64_FORMAT,
                  year, month, rx_bytes, tx_bytes);
     }
@@ -360,12 +577,12 @@ seek_current_record (FILE *file)
 }
 
 static void
-process_previous_stats (RmfdStatsContext *ctx,
+process_previous_stats (StatsFile        *stats_file,
                         glong             record_offset,
                         gboolean          set_as_final,
                         gboolean          append_monthly_stats)
 {
-    if (fseek (ctx->file, record_offset, SEEK_SET) < 0) {
+    if (fseek (stats_file->file, record_offset, SEEK_SET) < 0) {
         g_warning ("  cannot seek to previous record");
         return;
     }
@@ -376,22 +593,22 @@ process_previous_stats (RmfdStatsContext *ctx,
 
         /* This may happen if e.g. the immediate previous record wasn't correctly
          * parsed and also was actually the first one in the log file */
-        if (!fgets (line, sizeof (line), ctx->file))
+        if (!fgets (line, sizeof (line), stats_file->file))
             return;
 
         /* If correctly parsed, notify and we're done */
         if (parse_record (line, fields)) {
             if (append_monthly_stats)
-                monthly_stats_append_record (ctx,
+                monthly_stats_append_record (stats_file,
                                              fields[FIELD_FROM_SYSTEM_TIME],
                                              fields[FIELD_RX_BYTES],
                                              fields[FIELD_TX_BYTES]);
             if (set_as_final) {
                 glong record_end;
 
-                record_end = ftell (ctx->file);
+                record_end = ftell (stats_file->file);
 
-                write_syslog_record (ctx->name,
+                write_syslog_record (stats_file->name,
                                      TRUE,
                                      fields[FIELD_FROM_SYSTEM_TIME],
                                      fields[FIELD_TO_SYSTEM_TIME],
@@ -404,19 +621,19 @@ process_previous_stats (RmfdStatsContext *ctx,
                                      (guint16) g_ascii_strtoull (fields[FIELD_MNC], NULL, 10),
                                      (guint32) g_ascii_strtoull (fields[FIELD_LAC], NULL, 10),
                                      (guint32) g_ascii_strtoull (fields[FIELD_CID], NULL, 10),
-                                     ctx->monthly_stats.year,
-                                     ctx->monthly_stats.month,
-                                     ctx->monthly_stats.rx_bytes,
-                                     ctx->monthly_stats.tx_bytes);
+                                     stats_file->monthly_stats.year,
+                                     stats_file->monthly_stats.month,
+                                     stats_file->monthly_stats.rx_bytes,
+                                     stats_file->monthly_stats.tx_bytes);
 
-                if (fseek (ctx->file, record_offset, SEEK_SET) < 0)
+                if (fseek (stats_file->file, record_offset, SEEK_SET) < 0)
                     g_warning ("  cannot seek to previous record to update it");
                 else {
                     g_debug ("  previous record set as final");
-                    fputc ('F', ctx->file);
+                    fputc ('F', stats_file->file);
                     /* Also, remove any additional text found after this record,
                      * like e.g. a possible record which wasn't correctly parsed */
-                    if (record_end > 0 && truncate (ctx->path, (off_t) record_end) < 0)
+                    if (record_end > 0 && truncate (stats_file->path, (off_t) record_end) < 0)
                         g_warning ("  cannot truncate stats file: %s", g_strerror (errno));
                 }
             }
@@ -426,13 +643,13 @@ process_previous_stats (RmfdStatsContext *ctx,
 
         /* If not correctly parsed, go one record back */
         /* Need to go backwards one more line */
-        if (fseek (ctx->file, record_offset - 1, SEEK_SET) < 0)
+        if (fseek (stats_file->file, record_offset - 1, SEEK_SET) < 0)
             return;
         /* Seek to start of the current record */
-        if (!seek_current_record (ctx->file))
+        if (!seek_current_record (stats_file->file))
             return;
         /* Store new record offset */
-        if ((record_offset = ftell (ctx->file)) < 0)
+        if ((record_offset = ftell (stats_file->file)) < 0)
             return;
         /* Looooop */
     }
@@ -441,7 +658,8 @@ process_previous_stats (RmfdStatsContext *ctx,
 }
 
 static void
-load_previous_stats (RmfdStatsContext *ctx)
+load_previous_stats (StatsFile        *stats_file,
+                     gboolean          keep_open_session)
 {
     gchar    line [MAX_LINE_LENGTH + 1];
     gboolean started = FALSE;
@@ -450,27 +668,32 @@ load_previous_stats (RmfdStatsContext *ctx)
 
     g_debug ("loading previous monthly stats...");
 
-    if (!(ctx->file = fopen (ctx->path, "r+"))) {
+    if (!(stats_file->file = fopen (stats_file->path, "r+"))) {
         g_debug ("  stats file doesn't exist");
         return;
     }
 
     do {
-        current_line_offset = ftell (ctx->file);
+        current_line_offset = ftell (stats_file->file);
         if (current_line_offset < 0)
             break;
 
-        if (!fgets (line, sizeof (line), ctx->file)) {
+        if (!fgets (line, sizeof (line), stats_file->file)) {
             /* When reaching EOF, check if the last log was notified to syslog or not */
-            if (feof (ctx->file)) {
-                if (started && previous_line_offset >= 0) {
+            if (feof (stats_file->file)) {
+                if (started && keep_open_session) {
+                    /* The last session is still ongoing (e.g. the data call
+                     * survived a daemon restart), so it will get its own
+                     * Final record once the connection is stopped. */
+                    g_debug ("  keeping last session open");
+                } else if (started && previous_line_offset >= 0) {
                     /* We got a new Start record without a previous Final record.
                      * This means that rmfd was halted before being able to log
                      * to syslog, so we must do it ourselves now. Re-read the
                      * previous record as final and continue. */
-                    process_previous_stats (ctx, previous_line_offset, TRUE, TRUE);
+                    process_previous_stats (stats_file, previous_line_offset, TRUE, TRUE);
                     /* Seek to the end again */
-                    if (fseek (ctx->file, 0, SEEK_END) < 0)
+                    if (fseek (stats_file->file, 0, SEEK_END) < 0)
                         break;
                 }
             }
@@ -479,7 +702,7 @@ load_previous_stats (RmfdStatsContext *ctx)
 
         if (line[0] == 'S') {
             if (started) {
-                current_line_offset = ftell (ctx->file);
+                current_line_offset = ftell (stats_file->file);
                 if (current_line_offset < 0)
                     break;
 
@@ -487,10 +710,10 @@ load_previous_stats (RmfdStatsContext *ctx)
                  * need to parse the previous record and add it as if it were a
                  * final one */
                 if (previous_line_offset >= 0)
-                    process_previous_stats (ctx, previous_line_offset, FALSE, TRUE);
+                    process_previous_stats (stats_file, previous_line_offset, FALSE, TRUE);
 
                 /* Seek to the start record */
-                if (fseek (ctx->file, current_line_offset, SEEK_SET) < 0)
+                if (fseek (stats_file->file, current_line_offset, SEEK_SET) < 0)
                     break;
 
                 /* Re-read the new start record, this time we won't have the started
@@ -507,7 +730,7 @@ load_previous_stats (RmfdStatsContext *ctx)
 
             /* If correctly parsed, notify and we're done */
             if (parse_record (line, fields))
-                monthly_stats_append_record (ctx,
+                monthly_stats_append_record (stats_file,
                                              fields[FIELD_FROM_SYSTEM_TIME],
                                              fields[FIELD_RX_BYTES],
                                              fields[FIELD_TX_BYTES]);
@@ -517,12 +740,12 @@ load_previous_stats (RmfdStatsContext *ctx)
         previous_line_offset = current_line_offset;
     } while (1);
 
-    fclose (ctx->file);
-    ctx->file = NULL;
+    fclose (stats_file->file);
+    stats_file->file = NULL;
 
-    if (ctx->monthly_stats.year && ctx->monthly_stats.month)
+    if (stats_file->monthly_stats.year && stats_file->monthly_stats.month)
         g_debug ("  monthly stats (%u/%u): rx %" G_GUINT64_FORMAT ", tx %" G_GUINT64_FORMAT,
-                 ctx->monthly_stats.year, ctx->monthly_stats.month, ctx->monthly_stats.rx_bytes, ctx->monthly_stats.tx_bytes);
+                 stats_file->monthly_stats.year, stats_file->monthly_stats.month, stats_file->monthly_stats.rx_bytes, stats_file->monthly_stats.tx_bytes);
 }
 
 /******************************************************************************/
@@ -540,7 +763,8 @@ rmfd_stats_record (RmfdStatsContext    *ctx,
                    guint16              lac,
                    guint32              cid)
 {
-    time_t current_time;
+    time_t        current_time;
+    StatsFileJob *job;
 
     /* Bail out if stats not enabled */
     if (!ctx)
@@ -550,75 +774,48 @@ rmfd_stats_record (RmfdStatsContext    *ctx,
 
     /* Start record */
     if (type == RMFD_STATS_RECORD_TYPE_START) {
-        guint    year;
-        guint    month;
-        gboolean append = TRUE;
+        /* Keep track of when this was started */
+        if (ctx->start_system_time)
+            g_date_time_unref (ctx->start_system_time);
+        ctx->start_system_time = system_time ? g_date_time_ref (system_time) : NULL;
+        ctx->start_time = current_time;
+
+        job = stats_file_job_new (ctx->stats_file,
+                                  STATS_FILE_OP_START,
+                                  build_record ('S',
+                                                ctx->start_system_time, ctx->start_time,
+                                                system_time, current_time,
+                                                rx_bytes, tx_bytes,
+                                                radio_interface, rssi,
+                                                mcc, mnc, lac, cid));
 
-        /* If we changed month, remove previous file */
+        /* The writer checks whether the stats month changed */
         if (system_time) {
-            year  = g_date_time_get_year   (system_time);
-            month = g_date_time_get_month (system_time);
+            job->year  = g_date_time_get_year  (system_time);
+            job->month = g_date_time_get_month (system_time);
         } else {
             GDateTime *datetime;
 
-            datetime  = g_date_time_new_from_unix_utc (current_time);
-            year      = g_date_time_get_year (datetime);
-            month     = g_date_time_get_month (datetime);
+            datetime   = g_date_time_new_from_unix_utc (current_time);
+            job->year  = g_date_time_get_year (datetime);
+            job->month = g_date_time_get_month (datetime);
             g_date_time_unref (datetime);
         }
 
-        /* If changing stats month, syslog and remove the previous file */
-        if ((year == ctx->monthly_stats.year && month > ctx->monthly_stats.month) ||
-            (year > ctx->monthly_stats.year)) {
-            if (ctx->monthly_stats.year > 0)
-                write_monthly_stats (ctx->name,
-                                     ctx->monthly_stats.year,
-                                     ctx->monthly_stats.month,
-                                     ctx->monthly_stats.rx_bytes,
-                                     ctx->monthly_stats.tx_bytes);
-
-            g_debug ("updated stats date: %u/%u", year, month);
-            ctx->monthly_stats.year     = year;
-            ctx->monthly_stats.month    = month;
-            ctx->monthly_stats.rx_bytes = 0;
-            ctx->monthly_stats.tx_bytes = 0;
-
-            append = FALSE;
-        }
-
-        /* Open the file only when started */
-        errno = 0;
-        if (!(ctx->file = fopen (ctx->path, append ? "a" : "w"))) {
-            g_warning ("error: cannot open stats file: %s", g_strerror (errno));
-            return;
-        }
-
-        /* Keep track of when this was started */
-        if (ctx->start_system_time)
-            g_date_time_unref (ctx->start_system_time);
-        ctx->start_system_time = system_time ? g_date_time_ref (system_time) : NULL;
-        ctx->start_time = current_time;
-
-        write_record (ctx->file,
-                      'S',
-                      ctx->start_system_time, ctx->start_time,
-                      system_time, current_time,
-                      rx_bytes, tx_bytes,
-                      radio_interface, rssi,
-                      mcc, mnc, lac, cid);
-
+        stats_file_job_push (job);
         return;
     }
 
     /* Partial record? */
     if (type == RMFD_STATS_RECORD_TYPE_PARTIAL) {
-        write_record (ctx->file,
-                      'P',
-                      ctx->start_system_time, ctx->start_time,
-                      system_time, current_time,
-                      rx_bytes, tx_bytes,
-                      radio_interface, rssi,
-                      mcc, mnc, lac, cid);
+        stats_file_push (ctx->stats_file,
+                         STATS_FILE_OP_WRITE,
+                         build_record ('P',
+                                       ctx->start_system_time, ctx->start_time,
+                                       system_time, current_time,
+                                       rx_bytes, tx_bytes,
+                                       radio_interface, rssi,
+                                       mcc, mnc, lac, cid));
         return;
     }
 
@@ -628,74 +825,103 @@ rmfd_stats_record (RmfdStatsContext    *ctx,
     if (!ctx->start_system_time)
         return;
 
-    /* Final record */
-    write_record (ctx->file,
-                  'F',
-                  ctx->start_system_time, ctx->start_time,
-                  system_time, current_time,
-                  rx_bytes, tx_bytes,
-                  radio_interface, rssi,
-                  mcc, mnc, lac, cid);
-
-    /* Update monthly stats */
-    ctx->monthly_stats.rx_bytes += rx_bytes;
-    ctx->monthly_stats.tx_bytes += tx_bytes;
-
-    /* Syslog writing */
-    {
-        gchar *from_str;
-        gchar *to_str;
-
-        from_str = common_build_date_string (ctx->start_system_time, ctx->start_time);
-        to_str   = common_build_date_string (system_time, current_time);
-
-        g_debug ("writing stats to syslog...");
-        write_syslog_record (ctx->name,
-                             FALSE,
-                             from_str,
-                             to_str,
-                             (current_time > ctx->start_time ? (current_time - ctx->start_time) : 0),
-                             rx_bytes,
-                             tx_bytes,
-                             radio_interface, rssi,
-                             mcc, mnc, lac, cid,
-                             ctx->monthly_stats.year,
-                             ctx->monthly_stats.month,
-                             ctx->monthly_stats.rx_bytes,
-                             ctx->monthly_stats.tx_bytes);
-
-        g_free (from_str);
-        g_free (to_str);
-    }
+    /* Final record, along with the syslog report and the monthly stats update */
+    job = stats_file_job_new (ctx->stats_file,
+                              STATS_FILE_OP_FINAL,
+                              build_record ('F',
+                                            ctx->start_system_time, ctx->start_time,
+                                            system_time, current_time,
+                                            rx_bytes, tx_bytes,
+                                            radio_interface, rssi,
+                                            mcc, mnc, lac, cid));
+    job->final.from_str        = common_build_date_string (ctx->start_system_time, ctx->start_time);
+    job->final.to_str          = common_build_date_string (system_time, current_time);
+    job->final.duration        = (current_time > ctx->start_time ? (current_time - ctx->start_time) : 0);
+    job->final.rx_bytes        = rx_bytes;
+    job->final.tx_bytes        = tx_bytes;
+    job->final.radio_interface = g_strdup (radio_interface);
+    job->final.rssi            = rssi;
+    job->final.mcc             = mcc;
+    job->final.mnc             = mnc;
+    job->final.lac             = lac;
+    job->final.cid             = cid;
+    stats_file_job_push (job);
 
     /* Cleanup start time */
     if (ctx->start_system_time)
         g_date_time_unref (ctx->start_system_time);
     ctx->start_system_time = NULL;
     ctx->start_time = 0;
-
-    fclose (ctx->file);
-    ctx->file = NULL;
 }
 
 /******************************************************************************/
 
+static RmfdStatsContext *
+stats_context_new (const gchar *path,
+                   const gchar *context_name,
+                   gboolean     keep_open_session)
+{
+    RmfdStatsContext *ctx;
+
+    ctx = g_slice_new0 (RmfdStatsContext);
+    ctx->stats_file = g_slice_new0 (StatsFile);
+    ctx->stats_file->path = g_strdup (path);
+    ctx->stats_file->name = g_strdup (context_name);
+
+    /* Records pushed by a previous context on the same file are written
+     * before the previous stats are loaded, as jobs are run in order */
+    stats_file_push (ctx->stats_file,
+                     keep_open_session ? STATS_FILE_OP_LOAD_KEEP_OPEN_SESSION : STATS_FILE_OP_LOAD,
+                     NULL);
+
+    return ctx;
+}
+
 RmfdStatsContext *
 rmfd_stats_setup (const gchar *path,
                   const gchar *context_name)
+{
+    /* Process last stats right away */
+    return stats_context_new (path, context_name, FALSE);
+}
+
+RmfdStatsContext *
+rmfd_stats_setup_resume (const gchar *path,
+                         const gchar *context_name,
+                         GDateTime   *start_system_time,
+                         time_t       start_time)
 {
     RmfdStatsContext *ctx;
 
-    ctx = g_slice_new0 (RmfdStatsContext);
-    ctx->path = g_strdup (path);
-    ctx->name = g_strdup (context_name);
+    /* Process last stats, but leave the ongoing session unfinished */
+    ctx = stats_context_new (path, context_name, TRUE);
 
-    /* Try to process last stats right away */
-    load_previous_stats (ctx);
+    /* Keep on appending records to the ongoing session */
+    stats_file_push (ctx->stats_file, STATS_FILE_OP_OPEN_APPEND, NULL);
+
+    ctx->start_system_time = start_system_time ? g_date_time_ref (start_system_time) : NULL;
+    ctx->start_time = start_time;
 
     return ctx;
 }
 
+gboolean
+rmfd_stats_get_session_start (RmfdStatsContext  *ctx,
+                              GDateTime        **start_system_time,
+                              time_t            *start_time)
+{
+    g_return_val_if_fail (ctx != NULL, FALSE);
+
+    if (!ctx->start_time)
+        return FALSE;
+
+    if (start_system_time)
+        *start_system_time = ctx->start_system_time ? g_date_time_ref (ctx->start_system_time) : NULL;
+    if (start_time)
+        *start_time = ctx->start_time;
+    return TRUE;
+}
+
 void
 rmfd_stats_teardown (RmfdStatsContext *ctx)
 {
@@ -704,19 +930,19 @@ rmfd_stats_teardown (RmfdStatsContext *ctx)
 
     if (ctx->start_system_time)
         g_date_time_unref (ctx->start_system_time);
-    if (ctx->file)
-        fclose (ctx->file);
-    g_free (ctx->name);
-    g_free (ctx->path);
+    stats_file_push (ctx->stats_file, STATS_FILE_OP_FREE, NULL);
     g_slice_free (RmfdStatsContext, ctx);
 }
 
+/* Monthly stats are owned by the writer, so these are only reliable once
+ * all pushed jobs have been run (e.g. when the writer isn't running) */
+
 guint
 rmfd_stats_get_year (RmfdStatsContext *ctx)
 {
     g_return_val_if_fail (ctx != NULL, 0);
 
-    return ctx->monthly_stats.year;
+    return ctx->stats_file->monthly_stats.year;
 }
 
 guint
@@ -724,7 +950,7 @@ rmfd_stats_get_month (RmfdStatsContext *ctx)
 {
     g_return_val_if_fail (ctx != NULL, 0);
 
-    return ctx->monthly_stats.month;
+    return ctx->stats_file->monthly_stats.month;
 }
 
 guint64
@@ -732,7 +958,7 @@ rmfd_stats_get_rx_bytes (RmfdStatsContext *ctx)
 {
     g_return_val_if_fail (ctx != NULL, 0);
 
-    return ctx->monthly_stats.rx_bytes;
+    return ctx->stats_file->monthly_stats.rx_bytes;
 }
 
 guint64
@@ -740,5 +966,5 @@ rmfd_stats_get_tx_bytes (RmfdStatsContext *ctx)
 {
     g_return_val_if_fail (ctx != NULL, 0);
 
-    return ctx->monthly_stats.tx_bytes;
+    return ctx->stats_file->monthly_stats.tx_bytes;
 }
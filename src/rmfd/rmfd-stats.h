@@ -26,6 +26,8 @@
 #ifndef RMFD_STATS_H
 #define RMFD_STATS_H
 
+#include <time.h>
+
 #include <glib.h>
 
 typedef enum {
@@ -38,6 +40,10 @@ typedef struct _RmfdStatsContext RmfdStatsContext;
 
 RmfdStatsContext *rmfd_stats_setup        (const gchar         *path,
                                            const gchar         *context_name);
+RmfdStatsContext *rmfd_stats_setup_resume (const gchar         *path,
+                                           const gchar         *context_name,
+                                           GDateTime           *start_system_time,
+                                           time_t               start_time);
 void              rmfd_stats_record       (RmfdStatsContext    *ctx,
                                            RmfdStatsRecordType  type,
                                            GDateTime           *system_time,
@@ -51,6 +57,10 @@ void              rmfd_stats_record       (RmfdStatsContext    *ctx,
                                            guint32              cid);
 void              rmfd_stats_teardown     (RmfdStatsContext    *ctx);
 
+gboolean          rmfd_stats_get_session_start (RmfdStatsContext  *ctx,
+                                                GDateTime        **start_system_time,
+                                                time_t            *start_time);
+
 guint             rmfd_stats_get_year     (RmfdStatsContext *ctx);
 guint             rmfd_stats_get_month    (RmfdStatsContext *ctx);
 guint64           rmfd_stats_get_rx_bytes (RmfdStatsContext *ctx);
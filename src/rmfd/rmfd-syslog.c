@@ -28,6 +28,7 @@
 #include <syslog.h>
 #include <malloc.h>
 #include "rmfd-syslog.h"
+#include "rmfd-writer.h"
 
 static gboolean syslog_open;
 
@@ -47,23 +48,42 @@ rmfd_syslog_teardown (void)
     }
 }
 
+typedef struct {
+    gint   type;
+    gchar *message;
+} SyslogJob;
+
+static void
+syslog_job_free (SyslogJob *job)
+{
+    g_free (job->message);
+    g_slice_free (SyslogJob, job);
+}
+
+static void
+syslog_job_run (SyslogJob *job)
+{
+    syslog (job->type, "%s", job->message);
+}
+
 void
 rmfd_syslog (gint type, const gchar *fmt, ...)
 {
-    char    *message;
-    va_list  args;
-    int      ret;
+    SyslogJob *job;
+    va_list    args;
 
     if (!syslog_open)
         return;
 
+    job = g_slice_new (SyslogJob);
+    job->type = type;
+
     va_start (args, fmt);
-    ret = vasprintf (&message, fmt, args);
+    job->message = g_strdup_vprintf (fmt, args);
     va_end (args);
 
-    if (ret < 0)
-        return;
-
-    syslog (type, "%s", message);
-    free (message);
+    /* syslog() may block, so run it in the writer */
+    rmfd_writer_push ((RmfdWriterFunc) syslog_job_run,
+                      job,
+                      (GDestroyNotify) syslog_job_free);
 }
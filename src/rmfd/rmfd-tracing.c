@@ -0,0 +1,208 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#include <unistd.h>
+
+#include <rmf-messages.h>
+
+#include "rmfd-tracing.h"
+#include "rmfd-writer.h"
+
+typedef struct {
+    const gchar *category;
+    const gchar *name;
+    const gchar *detail;
+    guint        request_id;
+    guint32      command;
+    gint64       start_time;
+    gint64       duration;
+} Span;
+
+typedef struct {
+    Span    *spans;
+    guint    n_spans;
+    guint    next;
+    gboolean full;
+    guint    current_request_id;
+    guint32  current_command;
+} Tracing;
+
+static Tracing *tracing;
+
+/*****************************************************************************/
+
+gboolean
+rmfd_tracing_is_enabled (void)
+{
+    return !!tracing;
+}
+
+void
+rmfd_tracing_set_current (guint   request_id,
+                          guint32 command)
+{
+    if (!tracing)
+        return;
+
+    tracing->current_request_id = request_id;
+    tracing->current_command    = command;
+}
+
+void
+rmfd_tracing_get_current (guint   *request_id,
+                          guint32 *command)
+{
+    *request_id = tracing ? tracing->current_request_id : 0;
+    *command    = tracing ? tracing->current_command : RMF_MESSAGE_COMMAND_UNKNOWN;
+}
+
+void
+rmfd_tracing_add_span (const gchar *category,
+                       const gchar *name,
+                       const gchar *detail,
+                       guint        request_id,
+                       guint32      command,
+                       gint64       start_time,
+                       gint64       end_time)
+{
+    Span *span;
+
+    if (!tracing)
+        return;
+
+    /* Oldest span is overwritten when the ring is full */
+    span = &tracing->spans[tracing->next];
+    span->category   = category;
+    span->name       = name;
+    span->detail     = detail;
+    span->request_id = request_id;
+    span->command    = command;
+    span->start_time = start_time;
+    span->duration   = MAX (end_time - start_time, 0);
+
+    tracing->next = (tracing->next + 1) % tracing->n_spans;
+    if (tracing->next == 0)
+        tracing->full = TRUE;
+}
+
+/*****************************************************************************/
+/* Dump */
+
+typedef struct {
+    gchar   *path;
+    GString *contents;
+} DumpJob;
+
+static void
+dump_job_free (DumpJob *job)
+{
+    g_free (job->path);
+    g_string_free (job->contents, TRUE);
+    g_slice_free (DumpJob, job);
+}
+
+static void
+dump_job_run (DumpJob *job)
+{
+    GError *error = NULL;
+
+    if (!g_file_set_contents (job->path, job->contents->str, job->contents->len, &error)) {
+        g_warning ("couldn't write trace: %s", error->message);
+        g_error_free (error);
+        return;
+    }
+    g_message ("trace written to '%s'", job->path);
+}
+
+void
+rmfd_tracing_dump (const gchar *path)
+{
+    DumpJob *job;
+    guint    n_spans;
+    guint    first;
+    guint    i;
+
+    if (!tracing)
+        return;
+
+    job = g_slice_new (DumpJob);
+    job->path = g_strdup (path);
+    job->contents = g_string_new ("{\"traceEvents\":[\n");
+
+    /* Each request goes in its own track */
+    n_spans = tracing->full ? tracing->n_spans : tracing->next;
+    first   = tracing->full ? tracing->next : 0;
+    for (i = 0; i < n_spans; i++) {
+        const Span *span;
+
+        span = &tracing->spans[(first + i) % tracing->n_spans];
+        g_string_append_printf (job->contents,
+                                "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+                                "\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT ","
+                                "\"pid\":%u,\"tid\":%u,"
+                                "\"args\":{\"request\":%u,\"command\":\"%s\"",
+                                i > 0 ? ",\n" : "",
+                                span->name,
+                                span->category,
+                                span->start_time,
+                                span->duration,
+                                (guint) getpid (),
+                                span->request_id,
+                                span->request_id,
+                                rmf_message_command_get_string (span->command));
+        if (span->detail)
+            g_string_append_printf (job->contents, ",\"detail\":\"%s\"", span->detail);
+        g_string_append (job->contents, "}}");
+    }
+    g_string_append (job->contents, "\n]}\n");
+
+    rmfd_writer_push ((RmfdWriterFunc) dump_job_run,
+                      job,
+                      (GDestroyNotify) dump_job_free);
+}
+
+/*****************************************************************************/
+
+void
+rmfd_tracing_setup (guint n_spans)
+{
+    g_assert (!tracing);
+    g_assert (n_spans > 0);
+
+    tracing = g_slice_new0 (Tracing);
+    tracing->spans   = g_new0 (Span, n_spans);
+    tracing->n_spans = n_spans;
+}
+
+void
+rmfd_tracing_teardown (void)
+{
+    if (!tracing)
+        return;
+
+    g_free (tracing->spans);
+    g_slice_free (Tracing, tracing);
+    tracing = NULL;
+}
@@ -0,0 +1,61 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#ifndef RMFD_TRACING_H
+#define RMFD_TRACING_H
+
+#include <glib.h>
+
+#define RMFD_TRACING_FILE_PATH "/var/log/rmfd.trace.json"
+
+/* Optional per-request tracing. Spans are kept in a fixed-size ring, and
+ * dumped on demand in Chrome trace-event format. All methods are no-ops unless
+ * tracing has been setup. Span category, name and detail strings are not
+ * copied, so they must be static. */
+
+void     rmfd_tracing_setup       (guint        n_spans);
+void     rmfd_tracing_teardown    (void);
+gboolean rmfd_tracing_is_enabled  (void);
+
+/* The request being processed in the current main loop dispatch, so that
+ * spans recorded by the processor can be linked to it. Request ID 0 is used
+ * for operations not linked to any request. */
+void     rmfd_tracing_set_current (guint        request_id,
+                                   guint32      command);
+void     rmfd_tracing_get_current (guint       *request_id,
+                                   guint32     *command);
+
+/* Times in microseconds, as given by g_get_monotonic_time() */
+void     rmfd_tracing_add_span    (const gchar *category,
+                                   const gchar *name,
+                                   const gchar *detail,
+                                   guint        request_id,
+                                   guint32      command,
+                                   gint64       start_time,
+                                   gint64       end_time);
+
+void     rmfd_tracing_dump        (const gchar *path);
+
+#endif /* RMFD_TRACING_H */
@@ -178,3 +178,21 @@ rmfd_utils_get_physical_device (GUdevDevice *child)
 
     return physdev;
 }
+
+guint
+rmfd_utils_get_backoff_delay (guint initial,
+                              guint max,
+                              guint retry)
+{
+    guint delay;
+    guint i;
+
+    delay = initial;
+    for (i = 1; i < retry && delay < max; i++)
+        delay *= 2;
+    delay = MIN (delay, max);
+
+    if (delay >= 2)
+        delay = (delay / 2) + g_random_int_range (0, (delay / 2) + 1);
+    return delay;
+}
@@ -42,4 +42,11 @@ gchar *rmfd_utils_build_interface_name (GUdevDevice *device);
 
 GUdevDevice *rmfd_utils_get_physical_device (GUdevDevice *child);
 
+/* Exponential backoff delay for the given retry (1-based), doubling the
+ * initial delay on each retry up to the given maximum, and with up to half of
+ * it randomized so that failures at the same time don't retry in lockstep */
+guint rmfd_utils_get_backoff_delay (guint initial,
+                                    guint max,
+                                    guint retry);
+
 #endif /* RMFD_UTILS_H */
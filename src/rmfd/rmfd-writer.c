@@ -0,0 +1,120 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+
+#include <glib.h>
+
+#include "rmfd-writer.h"
+
+typedef struct {
+    RmfdWriterFunc func;
+    gpointer       user_data;
+    GDestroyNotify destroy;
+} Job;
+
+static GThread     *writer_thread;
+static GAsyncQueue *writer_queue;
+
+/*****************************************************************************/
+
+static void
+job_run_and_free (Job *job)
+{
+    job->func (job->user_data);
+    if (job->destroy)
+        job->destroy (job->user_data);
+    g_slice_free (Job, job);
+}
+
+static gpointer
+writer_thread_func (gpointer user_data)
+{
+    while (1) {
+        Job *job;
+
+        job = g_async_queue_pop (writer_queue);
+
+        /* A job without method requests the thread to exit */
+        if (!job->func) {
+            g_slice_free (Job, job);
+            break;
+        }
+
+        job_run_and_free (job);
+    }
+
+    return NULL;
+}
+
+void
+rmfd_writer_push (RmfdWriterFunc func,
+                  gpointer       user_data,
+                  GDestroyNotify destroy)
+{
+    Job *job;
+
+    g_assert (func);
+
+    job = g_slice_new (Job);
+    job->func      = func;
+    job->user_data = user_data;
+    job->destroy   = destroy;
+
+    /* Jobs pushed from another job (e.g. syslog messages while processing
+     * stats) are run right away, as they would otherwise be queued after a
+     * pending exit request */
+    if (!writer_thread || g_thread_self () == writer_thread) {
+        job_run_and_free (job);
+        return;
+    }
+
+    g_async_queue_push (writer_queue, job);
+}
+
+/*****************************************************************************/
+
+void
+rmfd_writer_setup (void)
+{
+    g_assert (!writer_thread);
+
+    writer_queue  = g_async_queue_new ();
+    writer_thread = g_thread_new ("rmfd-writer", writer_thread_func, NULL);
+}
+
+void
+rmfd_writer_teardown (void)
+{
+    if (!writer_thread)
+        return;
+
+    /* Pending jobs are run before the exit request */
+    g_async_queue_push (writer_queue, g_slice_new0 (Job));
+    g_thread_join (writer_thread);
+    writer_thread = NULL;
+
+    g_async_queue_unref (writer_queue);
+    writer_queue = NULL;
+}
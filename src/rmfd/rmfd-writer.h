@@ -0,0 +1,44 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+
+#ifndef RMFD_WRITER_H
+#define RMFD_WRITER_H
+
+#include <glib.h>
+
+/* Blocking I/O (stats files, syslog) is run in a dedicated writer thread, in
+ * the same order in which it was pushed. If the writer isn't running, jobs are
+ * run right away in the caller thread. */
+
+typedef void (* RmfdWriterFunc) (gpointer user_data);
+
+void rmfd_writer_setup    (void);
+void rmfd_writer_teardown (void);
+void rmfd_writer_push     (RmfdWriterFunc  func,
+                           gpointer        user_data,
+                           GDestroyNotify  destroy);
+
+#endif /* RMFD_WRITER_H */
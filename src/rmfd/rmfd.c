@@ -38,7 +38,11 @@
 
 #include "rmfd-manager.h"
 #include "rmfd-syslog.h"
+#include "rmfd-writer.h"
+#include "rmfd-metrics.h"
+#include "rmfd-tracing.h"
 #include "rmfd-stats.h"
+#include "rmfd-port-data-wwan.h"
 
 #define PROGRAM_NAME    "rmfd"
 #define PROGRAM_VERSION PACKAGE_VERSION
@@ -53,6 +57,16 @@ static gchar    *address;
 static gint      port;
 static gboolean  verbose_flag;
 static gboolean  version_flag;
+static gint      trace_spans;
+static gint      packet_stats_period = RMFD_PORT_PROCESSOR_QMI_DEFAULT_PACKET_STATS_PERIOD;
+static gint      stats_interval = RMFD_PORT_PROCESSOR_QMI_DEFAULT_STATS_INTERVAL;
+static gint64    stats_change_threshold;
+static gint      stats_max_interval = RMFD_PORT_PROCESSOR_QMI_DEFAULT_STATS_MAX_INTERVAL;
+static gint      connect_max_attempts = RMFD_PORT_PROCESSOR_QMI_DEFAULT_CONNECT_MAX_ATTEMPTS;
+static gint      connect_retry_initial_delay = RMFD_PORT_PROCESSOR_QMI_DEFAULT_CONNECT_RETRY_INITIAL_DELAY;
+static gint      connect_retry_max_delay = RMFD_PORT_PROCESSOR_QMI_DEFAULT_CONNECT_RETRY_MAX_DELAY;
+static gint      mux_sessions;
+static gboolean  data_port_script_flag;
 
 static GOptionEntry main_entries[] = {
     { "address", 'y', 0, G_OPTION_ARG_STRING, &address,
@@ -67,6 +81,46 @@ static GOptionEntry main_entries[] = {
       "Run action with verbose logs",
       NULL
     },
+    { "trace", 't', 0, G_OPTION_ARG_INT, &trace_spans,
+      "Enable request tracing, keeping the last N spans; dumped on SIGUSR1",
+      "[N]"
+    },
+    { "packet-stats-period", 'p', 0, G_OPTION_ARG_INT, &packet_stats_period,
+      "Period of the packet statistics reports from the modem, in seconds (0 to disable; default 5)",
+      "[SECS]"
+    },
+    { "stats-interval", 'i', 0, G_OPTION_ARG_INT, &stats_interval,
+      "Time between connection stats samples, in seconds (default 10)",
+      "[SECS]"
+    },
+    { "stats-change-threshold", 'c', 0, G_OPTION_ARG_INT64, &stats_change_threshold,
+      "Only write partial stats records if TX+RX bytes changed at least this much, requires packet stats reports (0 to write on every sample; default 0)",
+      "[BYTES]"
+    },
+    { "stats-max-interval", 'm', 0, G_OPTION_ARG_INT, &stats_max_interval,
+      "Maximum time between partial stats records when a change threshold is given, in seconds (default 600)",
+      "[SECS]"
+    },
+    { "connect-max-attempts", 'a', 0, G_OPTION_ARG_INT, &connect_max_attempts,
+      "Maximum number of attempts for each connection request (default 3)",
+      "[N]"
+    },
+    { "connect-retry-initial-delay", 'r', 0, G_OPTION_ARG_INT, &connect_retry_initial_delay,
+      "Delay before the first connection retry, doubled on each subsequent one, in milliseconds (default 1000)",
+      "[MSECS]"
+    },
+    { "connect-retry-max-delay", 'R', 0, G_OPTION_ARG_INT, &connect_retry_max_delay,
+      "Maximum delay between connection retries, in milliseconds (default 16000)",
+      "[MSECS]"
+    },
+    { "mux-sessions", 0, 0, G_OPTION_ARG_INT, &mux_sessions,
+      "Number of QMAP multiplexed data sessions, each with its own APN and network interface (0 to disable; default 0)",
+      "[N]"
+    },
+    { "data-port-script", 'd', 0, G_OPTION_ARG_NONE, &data_port_script_flag,
+      "Configure WWAN interfaces with the rmfd-port-data-wwan-service script instead of netlink (DHCP always uses the script)",
+      NULL
+    },
     { "version", 'V', 0, G_OPTION_ARG_NONE, &version_flag,
       "Print version",
       NULL
@@ -82,6 +136,13 @@ quit_cb (gpointer user_data)
     return FALSE;
 }
 
+static gboolean
+dump_trace_cb (gpointer user_data)
+{
+    rmfd_tracing_dump (RMFD_TRACING_FILE_PATH);
+    return TRUE;
+}
+
 static void
 log_handler (const gchar    *log_domain,
              GLogLevelFlags  log_level,
@@ -91,11 +152,12 @@ log_handler (const gchar    *log_domain,
     const gchar *log_level_str;
 	time_t now;
 	gchar time_str[64];
-	struct tm    *local_time;
+	struct tm     local_time;
 
+	/* May be called from the writer thread as well */
 	now = time ((time_t *) NULL);
-	local_time = localtime (&now);
-	strftime (time_str, 64, "%d %b %Y, %H:%M:%S", local_time);
+	localtime_r (&now, &local_time);
+	strftime (time_str, 64, "%d %b %Y, %H:%M:%S", &local_time);
 
 	switch (log_level) {
 	case G_LOG_LEVEL_WARNING:
@@ -137,7 +199,8 @@ print_version_and_exit (void)
 int
 main (int argc, char *argv[])
 {
-    GOptionContext *context;
+    GOptionContext               *context;
+    RmfdPortProcessorQmiSettings  settings;
 
 #if !GLIB_CHECK_VERSION (2,36,0)
     g_type_init ();
@@ -157,6 +220,47 @@ main (int argc, char *argv[])
         return -1;
     }
 
+    if (packet_stats_period < 0 || packet_stats_period > G_MAXUINT8) {
+        g_printerr ("error: packet stats period must be between 0 and %u seconds\n", G_MAXUINT8);
+        return -1;
+    }
+
+    if (stats_interval <= 0) {
+        g_printerr ("error: stats interval must be at least 1 second\n");
+        return -1;
+    }
+
+    if (stats_change_threshold < 0) {
+        g_printerr ("error: stats change threshold must not be negative\n");
+        return -1;
+    }
+
+    /* The threshold is checked against the counters from the event reports */
+    if (stats_change_threshold > 0 && packet_stats_period == 0) {
+        g_printerr ("error: stats change threshold requires packet stats event reports (--packet-stats-period)\n");
+        return -1;
+    }
+
+    if (stats_max_interval < stats_interval) {
+        g_printerr ("error: stats max interval must not be lower than the stats interval\n");
+        return -1;
+    }
+
+    if (connect_max_attempts <= 0) {
+        g_printerr ("error: at least 1 connection attempt is required\n");
+        return -1;
+    }
+
+    if (connect_retry_initial_delay < 0 || connect_retry_max_delay < connect_retry_initial_delay) {
+        g_printerr ("error: invalid connection retry delays\n");
+        return -1;
+    }
+
+    if (mux_sessions < 0 || mux_sessions > RMFD_PORT_PROCESSOR_QMI_MAX_MUX_SESSIONS) {
+        g_printerr ("error: at most %u multiplexed sessions are supported\n", RMFD_PORT_PROCESSOR_QMI_MAX_MUX_SESSIONS);
+        return -1;
+    }
+
     /* Setup logging if running in verbose mode */
     if (verbose_flag) {
         g_log_set_handler (G_LOG_DOMAIN, G_LOG_LEVEL_MASK, log_handler, NULL);
@@ -166,17 +270,33 @@ main (int argc, char *argv[])
 
     g_debug (PROGRAM_NAME " starting...");
 
+    rmfd_writer_setup ();
     rmfd_syslog_setup ();
+    rmfd_metrics_setup ();
+    if (trace_spans > 0)
+        rmfd_tracing_setup (trace_spans);
 
     /* Setup signals */
     g_unix_signal_add (SIGTERM, quit_cb, NULL);
     g_unix_signal_add (SIGINT, quit_cb, NULL);
+    if (rmfd_tracing_is_enabled ())
+        g_unix_signal_add (SIGUSR1, dump_trace_cb, NULL);
+
+    rmfd_port_data_wwan_set_use_script (data_port_script_flag);
 
     /* Create manager */
+    settings.packet_stats_period         = packet_stats_period;
+    settings.stats_interval              = stats_interval;
+    settings.stats_change_threshold      = stats_change_threshold;
+    settings.stats_max_interval          = stats_max_interval;
+    settings.connect_max_attempts        = connect_max_attempts;
+    settings.connect_retry_initial_delay = connect_retry_initial_delay;
+    settings.connect_retry_max_delay     = connect_retry_max_delay;
+    settings.mux_sessions                = mux_sessions;
     if (address && port)
-        manager = rmfd_manager_new_tcp (address, port);
+        manager = rmfd_manager_new_tcp (address, port, &settings);
     else
-        manager = rmfd_manager_new_unix ();
+        manager = rmfd_manager_new_unix (&settings);
 
     /* Go into the main loop */
     loop = g_main_loop_new (NULL, FALSE);
@@ -186,7 +306,11 @@ main (int argc, char *argv[])
 
     g_main_loop_unref (loop);
     g_object_unref (manager);
+    rmfd_metrics_teardown ();
+    rmfd_tracing_teardown ();
 
+    /* Flush pending stats records and syslog messages */
+    rmfd_writer_teardown ();
     rmfd_syslog_teardown ();
 
     return 0;
@@ -0,0 +1,113 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd netlink tests
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#include <glib.h>
+
+#include <rmfd-netlink.h>
+#include <rmfd-error.h>
+#include <rmfd-error-types.h>
+
+/* No interface will be given this index */
+#define UNKNOWN_IFINDEX 0x7ffffff0
+
+GQuark
+rmfd_error_quark (void)
+{
+    return g_quark_from_static_string ("rmfd_error_quark");
+}
+
+/* Only requests that leave the host network setup untouched, i.e. those
+ * failing or not matching anything, regardless of the privileges */
+
+static void
+test_link_set_unknown (void)
+{
+    RmfdNetlink *netlink;
+    GError      *error = NULL;
+
+    netlink = rmfd_netlink_new (&error);
+    g_assert_no_error (error);
+    g_assert (netlink != NULL);
+
+    g_assert (!rmfd_netlink_link_set (netlink, UNKNOWN_IFINDEX, TRUE, 1500, &error));
+    g_assert_error (error, RMFD_ERROR, RMFD_ERROR_UNKNOWN);
+    g_assert (g_str_has_prefix (error->message, "couldn't set link up: "));
+    g_error_free (error);
+
+    rmfd_netlink_free (netlink);
+}
+
+static void
+test_address_add_unknown (void)
+{
+    RmfdNetlink *netlink;
+    GError      *error = NULL;
+
+    netlink = rmfd_netlink_new (&error);
+    g_assert_no_error (error);
+
+    /* 192.0.2.1/24, documentation range */
+    g_assert (!rmfd_netlink_address_add (netlink, UNKNOWN_IFINDEX,
+                                         g_htonl (0xc0000201), 24, g_htonl (0xc00002ff),
+                                         &error));
+    g_assert_error (error, RMFD_ERROR, RMFD_ERROR_UNKNOWN);
+    g_assert (g_str_has_prefix (error->message, "couldn't add address: "));
+    g_error_free (error);
+
+    rmfd_netlink_free (netlink);
+}
+
+static void
+test_address_flush_unknown (void)
+{
+    RmfdNetlink *netlink;
+    GError      *error = NULL;
+
+    netlink = rmfd_netlink_new (&error);
+    g_assert_no_error (error);
+
+    /* A failed request must not leave replies behind for the next ones */
+    g_assert (!rmfd_netlink_link_set (netlink, UNKNOWN_IFINDEX, FALSE, 0, &error));
+    g_clear_error (&error);
+
+    /* The whole dump is read, with nothing to remove */
+    g_assert (rmfd_netlink_address_flush (netlink, UNKNOWN_IFINDEX, &error));
+    g_assert_no_error (error);
+    g_assert (rmfd_netlink_address_flush (netlink, UNKNOWN_IFINDEX, &error));
+    g_assert_no_error (error);
+
+    rmfd_netlink_free (netlink);
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/rmfd/netlink/link-set/unknown",      test_link_set_unknown);
+    g_test_add_func ("/rmfd/netlink/address-add/unknown",   test_address_add_unknown);
+    g_test_add_func ("/rmfd/netlink/address-flush/unknown", test_address_flush_unknown);
+
+    return g_test_run ();
+}
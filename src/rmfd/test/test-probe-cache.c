@@ -0,0 +1,209 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd probe cache tests
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <rmfd-probe-cache.h>
+
+#define SYSFS_PATH "/sys/devices/pci0000:00/0000:00:14.0/usb1/1-2"
+#define VID        0x1199
+#define PID        0x9071
+#define DEVNUM     4
+
+static RmfdProbeCacheEntry *
+common_entry_new (void)
+{
+    RmfdProbeCacheEntry          *entry;
+    RmfdProbeCacheServiceVersion  versions[] = {
+        { 1, 1, 67 }, /* wds */
+        { 3, 1, 25 }, /* nas */
+    };
+
+    entry = rmfd_probe_cache_entry_new ();
+    entry->control_port  = g_strdup ("cdc-wdm0");
+    entry->data_port     = g_strdup ("wwan0");
+    entry->llp_is_raw_ip = TRUE;
+    entry->llp_on_open   = FALSE;
+    entry->qmap          = TRUE;
+    g_array_append_vals (entry->service_versions, versions, G_N_ELEMENTS (versions));
+    return entry;
+}
+
+static void
+common_write (const gchar *contents)
+{
+    GError *error = NULL;
+
+    g_file_set_contents (RMFD_PROBE_CACHE_FILE_PATH, contents, -1, &error);
+    g_assert_no_error (error);
+}
+
+static void
+test_store_lookup (void)
+{
+    RmfdProbeCacheEntry          *entry;
+    RmfdProbeCacheEntry          *cached;
+    RmfdProbeCacheServiceVersion *version;
+
+    entry = common_entry_new ();
+    rmfd_probe_cache_store (SYSFS_PATH, VID, PID, DEVNUM, entry);
+    rmfd_probe_cache_entry_free (entry);
+
+    cached = rmfd_probe_cache_lookup (SYSFS_PATH, VID, PID, DEVNUM);
+    g_assert (cached != NULL);
+    g_assert_cmpstr (cached->control_port, ==, "cdc-wdm0");
+    g_assert_cmpstr (cached->data_port, ==, "wwan0");
+    g_assert (cached->llp_is_raw_ip);
+    g_assert (!cached->llp_on_open);
+    g_assert (cached->qmap);
+    g_assert_cmpuint (cached->service_versions->len, ==, 2);
+    version = &g_array_index (cached->service_versions, RmfdProbeCacheServiceVersion, 1);
+    g_assert_cmpuint (version->service, ==, 3);
+    g_assert_cmpuint (version->major, ==, 1);
+    g_assert_cmpuint (version->minor, ==, 25);
+
+    /* Same boot, same device number */
+    g_assert (cached->data_format_valid);
+    rmfd_probe_cache_entry_free (cached);
+
+    g_unlink (RMFD_PROBE_CACHE_FILE_PATH);
+}
+
+static void
+test_lookup_other_device (void)
+{
+    RmfdProbeCacheEntry *entry;
+
+    entry = common_entry_new ();
+    rmfd_probe_cache_store (SYSFS_PATH, VID, PID, DEVNUM, entry);
+    rmfd_probe_cache_entry_free (entry);
+
+    g_assert (rmfd_probe_cache_lookup (SYSFS_PATH, VID, PID + 1, DEVNUM) == NULL);
+    g_assert (rmfd_probe_cache_lookup (SYSFS_PATH "/1-2.1", VID, PID, DEVNUM) == NULL);
+
+    g_unlink (RMFD_PROBE_CACHE_FILE_PATH);
+}
+
+static void
+test_lookup_reset (void)
+{
+    RmfdProbeCacheEntry *entry;
+
+    entry = common_entry_new ();
+    rmfd_probe_cache_store (SYSFS_PATH, VID, PID, DEVNUM, entry);
+    rmfd_probe_cache_entry_free (entry);
+
+    /* A re-enumerated device keeps the ports, but not the data format */
+    entry = rmfd_probe_cache_lookup (SYSFS_PATH, VID, PID, DEVNUM + 1);
+    g_assert (entry != NULL);
+    g_assert_cmpstr (entry->control_port, ==, "cdc-wdm0");
+    g_assert (!entry->data_format_valid);
+    rmfd_probe_cache_entry_free (entry);
+
+    g_unlink (RMFD_PROBE_CACHE_FILE_PATH);
+}
+
+static void
+test_lookup_without_qmap (void)
+{
+    RmfdProbeCacheEntry *entry;
+    gchar               *boot_id = NULL;
+    gchar               *contents;
+
+    /* Entries stored before QMAP was supported */
+    g_assert (g_file_get_contents ("/proc/sys/kernel/random/boot_id", &boot_id, NULL, NULL));
+    contents = g_strdup_printf ("[" SYSFS_PATH "]\n"
+                                "vid=%u\n"
+                                "pid=%u\n"
+                                "devnum=%u\n"
+                                "boot-id=%s\n"
+                                "control-port=cdc-wdm0\n"
+                                "data-port=wwan0\n"
+                                "llp=raw-ip\n"
+                                "llp-on-open=false\n",
+                                VID, PID, DEVNUM, g_strstrip (boot_id));
+    common_write (contents);
+    g_free (contents);
+    g_free (boot_id);
+
+    entry = rmfd_probe_cache_lookup (SYSFS_PATH, VID, PID, DEVNUM);
+    g_assert (entry != NULL);
+    g_assert (entry->llp_is_raw_ip);
+    g_assert (!entry->qmap);
+    g_assert (!entry->data_format_valid);
+    rmfd_probe_cache_entry_free (entry);
+
+    g_unlink (RMFD_PROBE_CACHE_FILE_PATH);
+}
+
+static void
+test_lookup_invalid (void)
+{
+    common_write ("[" SYSFS_PATH "]\n"
+                  "vid=4505\n"
+                  "pid=36977\n"
+                  "control-port=cdc-wdm0\n");
+
+    g_test_expect_message (G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "invalid probe cache entry*");
+    g_assert (rmfd_probe_cache_lookup (SYSFS_PATH, VID, PID, DEVNUM) == NULL);
+    g_test_assert_expected_messages ();
+
+    g_unlink (RMFD_PROBE_CACHE_FILE_PATH);
+}
+
+static void
+test_invalidate (void)
+{
+    RmfdProbeCacheEntry *entry;
+
+    entry = common_entry_new ();
+    rmfd_probe_cache_store (SYSFS_PATH, VID, PID, DEVNUM, entry);
+    rmfd_probe_cache_store (SYSFS_PATH "/1-2.1", VID, PID, DEVNUM, entry);
+    rmfd_probe_cache_entry_free (entry);
+
+    rmfd_probe_cache_invalidate (SYSFS_PATH);
+    g_assert (rmfd_probe_cache_lookup (SYSFS_PATH, VID, PID, DEVNUM) == NULL);
+
+    entry = rmfd_probe_cache_lookup (SYSFS_PATH "/1-2.1", VID, PID, DEVNUM);
+    g_assert (entry != NULL);
+    rmfd_probe_cache_entry_free (entry);
+
+    g_unlink (RMFD_PROBE_CACHE_FILE_PATH);
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/rmfd/probe-cache/store-lookup",         test_store_lookup);
+    g_test_add_func ("/rmfd/probe-cache/lookup/other-device",  test_lookup_other_device);
+    g_test_add_func ("/rmfd/probe-cache/lookup/reset",         test_lookup_reset);
+    g_test_add_func ("/rmfd/probe-cache/lookup/without-qmap",  test_lookup_without_qmap);
+    g_test_add_func ("/rmfd/probe-cache/lookup/invalid",       test_lookup_invalid);
+    g_test_add_func ("/rmfd/probe-cache/invalidate",           test_invalidate);
+
+    return g_test_run ();
+}
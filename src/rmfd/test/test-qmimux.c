@@ -0,0 +1,158 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd qmimux tests
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <rmfd-qmimux.h>
+#include <rmfd-error.h>
+#include <rmfd-error-types.h>
+
+GQuark
+rmfd_error_quark (void)
+{
+    return g_quark_from_static_string ("rmfd_error_quark");
+}
+
+/* A fake sysfs tree, with the paths given at build time */
+static void
+common_create (const gchar *dirname,
+               const gchar *filename,
+               const gchar *contents)
+{
+    gchar  *path;
+    GError *error = NULL;
+
+    g_assert_cmpint (g_mkdir_with_parents (dirname, 0755), ==, 0);
+    if (filename) {
+        path = g_build_filename (dirname, filename, NULL);
+        g_file_set_contents (path, contents, -1, &error);
+        g_assert_no_error (error);
+        g_free (path);
+    }
+}
+
+static gchar *
+common_read (const gchar *filename)
+{
+    gchar  *contents = NULL;
+    GError *error = NULL;
+
+    g_file_get_contents (filename, &contents, NULL, &error);
+    g_assert_no_error (error);
+    return contents;
+}
+
+static void
+test_interface_number (void)
+{
+    GError *error = NULL;
+    guint   interface_number = 0;
+
+    common_create (SYSFS_USBMISC_PATH "/cdc-wdm0/device", "bInterfaceNumber", "0a\n");
+    g_assert (rmfd_qmimux_get_interface_number ("cdc-wdm0", &interface_number, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (interface_number, ==, 10);
+
+    g_assert (!rmfd_qmimux_get_interface_number ("cdc-wdm1", &interface_number, &error));
+    g_assert (error != NULL);
+    g_error_free (error);
+}
+
+static void
+test_add_del_link (void)
+{
+    GError *error = NULL;
+    gchar  *contents;
+
+    common_create (SYSFS_NET_PATH "/wwan0/qmi", "add_mux", "");
+    common_create (SYSFS_NET_PATH "/wwan0/qmi", "del_mux", "");
+
+    g_assert (rmfd_qmimux_add_link ("wwan0", RMFD_QMIMUX_ID_FIRST + 1, &error));
+    g_assert_no_error (error);
+    contents = common_read (SYSFS_NET_PATH "/wwan0/qmi/add_mux");
+    g_assert_cmpstr (contents, ==, "0x81");
+    g_free (contents);
+
+    g_assert (rmfd_qmimux_del_link ("wwan0", RMFD_QMIMUX_ID_FIRST + 1, &error));
+    g_assert_no_error (error);
+    contents = common_read (SYSFS_NET_PATH "/wwan0/qmi/del_mux");
+    g_assert_cmpstr (contents, ==, "0x81");
+    g_free (contents);
+}
+
+static void
+test_add_link_unsupported (void)
+{
+    GError *error = NULL;
+
+    /* A qmi_wwan driver without mux support */
+    common_create (SYSFS_NET_PATH "/wwan1", NULL, NULL);
+    g_assert (!rmfd_qmimux_add_link ("wwan1", RMFD_QMIMUX_ID_FIRST, &error));
+    g_assert_error (error, RMFD_ERROR, RMFD_ERROR_NOT_SUPPORTED);
+    g_error_free (error);
+}
+
+static void
+test_find_link (void)
+{
+    gchar *link;
+
+    common_create (SYSFS_NET_PATH "/wwan2/upper_qmimux0", NULL, NULL);
+    common_create (SYSFS_NET_PATH "/wwan2/upper_qmimux1", NULL, NULL);
+    common_create (SYSFS_NET_PATH "/qmimux0/qmap", "mux_id", "128\n");
+    common_create (SYSFS_NET_PATH "/qmimux1/qmap", "mux_id", "129\n");
+
+    link = rmfd_qmimux_find_link ("wwan2", RMFD_QMIMUX_ID_FIRST + 1);
+    g_assert_cmpstr (link, ==, "qmimux1");
+    g_free (link);
+
+    g_assert (rmfd_qmimux_find_link ("wwan2", RMFD_QMIMUX_ID_FIRST + 2) == NULL);
+    g_assert (rmfd_qmimux_find_link ("wwan3", RMFD_QMIMUX_ID_FIRST) == NULL);
+}
+
+static void
+test_setup_master_unknown (void)
+{
+    GError *error = NULL;
+
+    /* The master is configured through the real network stack */
+    g_assert (!rmfd_qmimux_setup_master ("rmfd-test-none", 1500, &error));
+    g_assert_error (error, RMFD_ERROR, RMFD_ERROR_UNKNOWN);
+    g_error_free (error);
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/rmfd/qmimux/interface-number",        test_interface_number);
+    g_test_add_func ("/rmfd/qmimux/add-del-link",            test_add_del_link);
+    g_test_add_func ("/rmfd/qmimux/add-link/unsupported",    test_add_link_unsupported);
+    g_test_add_func ("/rmfd/qmimux/find-link",               test_find_link);
+    g_test_add_func ("/rmfd/qmimux/setup-master/unknown",    test_setup_master_unknown);
+
+    return g_test_run ();
+}
@@ -0,0 +1,148 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd registration state tests
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <rmfd-registration-state.h>
+#include <rmfd-writer.h>
+
+static void
+common_test (gboolean writer_thread)
+{
+    RmfdRegistrationState state = { 0 };
+    RmfdRegistrationState loaded = { 0 };
+
+    g_strlcpy (state.iccid, "8934071100276980483", sizeof (state.iccid));
+    state.mcc                    = 214;
+    state.mnc                    = 7;
+    state.mnc_includes_pcs_digit = TRUE; /* 007, not 07 */
+    state.radio_interface        = 8; /* lte */
+
+    if (writer_thread)
+        rmfd_writer_setup ();
+    rmfd_registration_state_save (&state);
+    /* Waits for the pending write */
+    rmfd_writer_teardown ();
+
+    g_assert (rmfd_registration_state_load (&loaded));
+    g_assert_cmpstr  (loaded.iccid, ==, "8934071100276980483");
+    g_assert_cmpuint (loaded.mcc, ==, 214);
+    g_assert_cmpuint (loaded.mnc, ==, 7);
+    g_assert (loaded.mnc_includes_pcs_digit);
+    g_assert_cmpuint (loaded.radio_interface, ==, 8);
+
+    g_unlink (RMFD_REGISTRATION_STATE_FILE_PATH);
+}
+
+static void
+test_save_load (void)
+{
+    common_test (FALSE);
+}
+
+static void
+test_save_load_writer_thread (void)
+{
+    common_test (TRUE);
+}
+
+static void
+test_load_none (void)
+{
+    RmfdRegistrationState loaded = { 0 };
+
+    g_unlink (RMFD_REGISTRATION_STATE_FILE_PATH);
+    g_assert (!rmfd_registration_state_load (&loaded));
+}
+
+static void
+test_load_no_card (void)
+{
+    RmfdRegistrationState  loaded = { 0 };
+    GError                *error = NULL;
+
+    /* Not tied to any card, so it can't be targeted */
+    g_file_set_contents (RMFD_REGISTRATION_STATE_FILE_PATH,
+                         "[registration]\n"
+                         "mcc=214\n"
+                         "mnc=7\n",
+                         -1, &error);
+    g_assert_no_error (error);
+
+    g_assert (!rmfd_registration_state_load (&loaded));
+
+    g_unlink (RMFD_REGISTRATION_STATE_FILE_PATH);
+}
+
+static void
+test_load_invalid (void)
+{
+    RmfdRegistrationState  loaded = { 0 };
+    GError                *error = NULL;
+
+    g_file_set_contents (RMFD_REGISTRATION_STATE_FILE_PATH,
+                         "[registration]\n"
+                         "iccid=8934071100276980483\n"
+                         "mcc=214\n"
+                         "mnc=100\n",
+                         -1, &error);
+    g_assert_no_error (error);
+
+    g_test_expect_message (G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "invalid registration state");
+    g_assert (!rmfd_registration_state_load (&loaded));
+    g_test_assert_expected_messages ();
+
+    g_unlink (RMFD_REGISTRATION_STATE_FILE_PATH);
+}
+
+static void
+test_clear (void)
+{
+    RmfdRegistrationState state = { 0 };
+    RmfdRegistrationState loaded = { 0 };
+
+    g_strlcpy (state.iccid, "8934071100276980483", sizeof (state.iccid));
+    state.mcc = 214;
+    state.mnc = 7;
+
+    rmfd_registration_state_save (&state);
+    rmfd_registration_state_clear ();
+    g_assert (!rmfd_registration_state_load (&loaded));
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/rmfd/registration-state/save-load",               test_save_load);
+    g_test_add_func ("/rmfd/registration-state/save-load/writer-thread", test_save_load_writer_thread);
+    g_test_add_func ("/rmfd/registration-state/load/none",               test_load_none);
+    g_test_add_func ("/rmfd/registration-state/load/no-card",            test_load_no_card);
+    g_test_add_func ("/rmfd/registration-state/load/invalid",            test_load_invalid);
+    g_test_add_func ("/rmfd/registration-state/clear",                   test_clear);
+
+    return g_test_run ();
+}
@@ -0,0 +1,160 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd session state tests
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <rmfd-session-state.h>
+#include <rmfd-writer.h>
+
+static void
+test_save_load (void)
+{
+    RmfdSessionState *state;
+    RmfdSessionState *loaded;
+
+    state = rmfd_session_state_new ();
+    state->control_port       = g_strdup ("cdc-wdm0");
+    state->data_port          = g_strdup ("wwan0");
+    state->wds_cid            = 12;
+    state->packet_data_handle = 0x8a2b3c4d;
+    state->sim_slot           = 2;
+    state->ip                 = g_strdup ("10.0.0.2");
+    state->subnet             = g_strdup ("255.255.255.252");
+    state->gw                 = g_strdup ("10.0.0.1");
+    state->dns1               = g_strdup ("8.8.8.8");
+    state->mtu                = 1430;
+    state->stats[1].valid             = TRUE;
+    state->stats[1].start_time        = 1577836800;
+    state->stats[1].start_system_time = 1577836805;
+    rmfd_session_state_save (state);
+    rmfd_session_state_free (state);
+
+    loaded = rmfd_session_state_load ();
+    g_assert (loaded != NULL);
+    g_assert_cmpstr (loaded->control_port, ==, "cdc-wdm0");
+    g_assert_cmpstr (loaded->data_port, ==, "wwan0");
+    g_assert_cmpuint (loaded->wds_cid, ==, 12);
+    g_assert_cmpuint (loaded->packet_data_handle, ==, 0x8a2b3c4d);
+    g_assert_cmpuint (loaded->sim_slot, ==, 2);
+    g_assert_cmpstr (loaded->ip, ==, "10.0.0.2");
+    g_assert_cmpstr (loaded->subnet, ==, "255.255.255.252");
+    g_assert_cmpstr (loaded->gw, ==, "10.0.0.1");
+    g_assert_cmpstr (loaded->dns1, ==, "8.8.8.8");
+    g_assert (loaded->dns2 == NULL);
+    g_assert_cmpuint (loaded->mtu, ==, 1430);
+    g_assert (!loaded->stats[0].valid);
+    g_assert (loaded->stats[1].valid);
+    g_assert_cmpint (loaded->stats[1].start_time, ==, 1577836800);
+    g_assert_cmpint (loaded->stats[1].start_system_time, ==, 1577836805);
+    rmfd_session_state_free (loaded);
+
+    rmfd_session_state_clear ();
+}
+
+static void
+test_clear (void)
+{
+    RmfdSessionState *state;
+
+    state = rmfd_session_state_new ();
+    state->control_port       = g_strdup ("cdc-wdm0");
+    state->data_port          = g_strdup ("wwan0");
+    state->wds_cid            = 1;
+    state->packet_data_handle = 1;
+    rmfd_session_state_save (state);
+    rmfd_session_state_free (state);
+
+    rmfd_session_state_clear ();
+    g_assert (!g_file_test (RMFD_SESSION_STATE_FILE_PATH, G_FILE_TEST_EXISTS));
+    g_assert (rmfd_session_state_load () == NULL);
+
+    /* Clearing twice is fine */
+    rmfd_session_state_clear ();
+}
+
+static void
+test_writer_thread (void)
+{
+    RmfdSessionState *state;
+    RmfdSessionState *loaded;
+
+    state = rmfd_session_state_new ();
+    state->control_port       = g_strdup ("cdc-wdm0");
+    state->data_port          = g_strdup ("wwan0");
+    state->wds_cid            = 1;
+    state->packet_data_handle = 1;
+
+    /* Saves and clears are run in order */
+    rmfd_writer_setup ();
+    rmfd_session_state_save (state);
+    rmfd_session_state_clear ();
+    rmfd_session_state_save (state);
+    rmfd_writer_teardown ();
+    rmfd_session_state_free (state);
+
+    loaded = rmfd_session_state_load ();
+    g_assert (loaded != NULL);
+    g_assert_cmpstr (loaded->control_port, ==, "cdc-wdm0");
+    rmfd_session_state_free (loaded);
+
+    rmfd_writer_setup ();
+    rmfd_session_state_clear ();
+    rmfd_writer_teardown ();
+    g_assert (!g_file_test (RMFD_SESSION_STATE_FILE_PATH, G_FILE_TEST_EXISTS));
+}
+
+static void
+test_load_invalid (void)
+{
+    GError *error = NULL;
+
+    /* No packet data handle, the session can't be recovered */
+    g_file_set_contents (RMFD_SESSION_STATE_FILE_PATH,
+                         "[session]\n"
+                         "control-port=cdc-wdm0\n"
+                         "data-port=wwan0\n"
+                         "wds-cid=12\n",
+                         -1, &error);
+    g_assert_no_error (error);
+
+    g_test_expect_message (G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "invalid session state");
+    g_assert (rmfd_session_state_load () == NULL);
+    g_test_assert_expected_messages ();
+
+    rmfd_session_state_clear ();
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/rmfd/session-state/save-load",     test_save_load);
+    g_test_add_func ("/rmfd/session-state/clear",         test_clear);
+    g_test_add_func ("/rmfd/session-state/writer-thread", test_writer_thread);
+    g_test_add_func ("/rmfd/session-state/load/invalid",  test_load_invalid);
+
+    return g_test_run ();
+}
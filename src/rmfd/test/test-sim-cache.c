@@ -0,0 +1,146 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd SIM cache tests
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include <rmfd-sim-cache.h>
+#include <rmfd-writer.h>
+
+static const guint8 iccid_data[]  = { 0x98, 0x94, 0x01, 0x10, 0x32, 0x54, 0x76, 0x98, 0x10, 0xf2 };
+static const guint8 imsi_data[]   = { 0x08, 0x29, 0x14, 0x70, 0x10, 0x32, 0x54, 0x76, 0x98 };
+static const guint8 ad_data[]     = { 0x00, 0x00, 0x00, 0x02 };
+
+typedef struct {
+    GMainLoop  *loop;
+    GHashTable *files;
+} LookupContext;
+
+static GArray *
+common_array_new (const guint8 *data,
+                  guint         len)
+{
+    GArray *array;
+
+    array = g_array_sized_new (FALSE, FALSE, sizeof (guint8), len);
+    g_array_append_vals (array, data, len);
+    return array;
+}
+
+static void
+lookup_ready (GObject       *source,
+              GAsyncResult  *res,
+              LookupContext *ctx)
+{
+    ctx->files = rmfd_sim_cache_lookup_finish (res);
+    g_main_loop_quit (ctx->loop);
+}
+
+/* The result is always given in the main context of the caller */
+static GHashTable *
+common_lookup (const GArray *iccid)
+{
+    LookupContext ctx;
+
+    ctx.loop  = g_main_loop_new (NULL, FALSE);
+    ctx.files = NULL;
+    rmfd_sim_cache_lookup (iccid, (GAsyncReadyCallback) lookup_ready, &ctx);
+    g_main_loop_run (ctx.loop);
+    g_main_loop_unref (ctx.loop);
+    return ctx.files;
+}
+
+static void
+common_test (gboolean writer_thread)
+{
+    GArray     *iccid;
+    GArray     *imsi;
+    GArray     *ad;
+    GHashTable *files;
+    GArray     *cached;
+    GStatBuf    st;
+
+    iccid = common_array_new (iccid_data, G_N_ELEMENTS (iccid_data));
+    imsi  = common_array_new (imsi_data, G_N_ELEMENTS (imsi_data));
+    ad    = common_array_new (ad_data, G_N_ELEMENTS (ad_data));
+
+    if (writer_thread)
+        rmfd_writer_setup ();
+
+    g_assert (common_lookup (iccid) == NULL);
+
+    /* Lookups are run after the stores pushed before */
+    rmfd_sim_cache_store (iccid, "EFimsi", imsi);
+    rmfd_sim_cache_store (iccid, "EFad", ad);
+    files = common_lookup (iccid);
+    g_assert (files != NULL);
+    g_assert_cmpuint (g_hash_table_size (files), ==, 2);
+    cached = g_hash_table_lookup (files, "EFimsi");
+    g_assert (cached != NULL);
+    g_assert_cmpuint (cached->len, ==, imsi->len);
+    g_assert (memcmp (cached->data, imsi->data, imsi->len) == 0);
+    g_hash_table_unref (files);
+
+    /* And after the removals */
+    rmfd_sim_cache_remove (iccid);
+    g_assert (common_lookup (iccid) == NULL);
+
+    rmfd_writer_teardown ();
+
+    /* Not readable by others */
+    rmfd_sim_cache_store (iccid, "EFad", ad);
+    g_assert_cmpint (g_stat (RMFD_SIM_CACHE_FILE_PATH, &st), ==, 0);
+    g_assert_cmpuint (st.st_mode & 0777, ==, 0600);
+
+    g_unlink (RMFD_SIM_CACHE_FILE_PATH);
+    g_array_unref (ad);
+    g_array_unref (imsi);
+    g_array_unref (iccid);
+}
+
+static void
+test_store_lookup_remove (void)
+{
+    common_test (FALSE);
+}
+
+static void
+test_store_lookup_remove_writer_thread (void)
+{
+    common_test (TRUE);
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/rmfd/sim-cache/store-lookup-remove",               test_store_lookup_remove);
+    g_test_add_func ("/rmfd/sim-cache/store-lookup-remove/writer-thread", test_store_lookup_remove_writer_thread);
+
+    return g_test_run ();
+}
@@ -32,6 +32,7 @@
 
 #include <rmfd-stats.h>
 #include <rmfd-syslog.h>
+#include <rmfd-writer.h>
 
 void
 rmfd_syslog (gint type, const gchar *fmt, ...)
@@ -335,6 +336,56 @@ test_unix_multiple_partial_last_invalid (void)
     common_test (contents, expected_contents, 2015, 3, 3 * 329880, 3 * 80021);
 }
 
+static void
+test_writer_records (void)
+{
+    RmfdStatsContext *ctx;
+    gchar            *path  = NULL;
+    GError           *error = NULL;
+    gint              handle;
+    gchar            *contents = NULL;
+    gchar           **lines;
+    GDateTime        *start;
+    GDateTime        *end;
+
+    handle = g_file_open_tmp ("rmfd-stats-XXXXXX", &path, &error);
+    g_assert_no_error (error);
+    g_assert (handle > 0);
+    close (handle);
+
+    /* Loading, records and monthly stats all go through the writer thread */
+    rmfd_writer_setup ();
+    ctx = rmfd_stats_setup (path, "test");
+    start = g_date_time_new_from_unix_utc (1426860384);
+    end   = g_date_time_new_from_unix_utc (1426860415);
+    rmfd_stats_record (ctx, RMFD_STATS_RECORD_TYPE_START,   start, 0,      0,     "lte", -80, 214, 3, 1140, 10774738);
+    rmfd_stats_record (ctx, RMFD_STATS_RECORD_TYPE_PARTIAL, end,   1000,   200,   "lte", -80, 214, 3, 1140, 10774738);
+    rmfd_stats_record (ctx, RMFD_STATS_RECORD_TYPE_FINAL,   end,   329880, 80021, "lte", -80, 214, 3, 1140, 10774738);
+    g_date_time_unref (start);
+    g_date_time_unref (end);
+    rmfd_writer_teardown ();
+
+    g_assert_cmpuint (2015, ==, rmfd_stats_get_year  (ctx));
+    g_assert_cmpuint (3,    ==, rmfd_stats_get_month (ctx));
+    g_assert_cmpuint (329880, ==, rmfd_stats_get_rx_bytes (ctx));
+    g_assert_cmpuint (80021,  ==, rmfd_stats_get_tx_bytes (ctx));
+
+    g_assert (g_file_get_contents (path, &contents, NULL, &error));
+    g_assert_no_error (error);
+    lines = g_strsplit_set (contents, "\n", -1);
+    g_assert (lines[0] && lines[0][0] == 'S');
+    g_assert (lines[1] && lines[1][0] == 'P');
+    g_assert (lines[2] && lines[2][0] == 'F');
+    g_assert (lines[3] && lines[3][0] == '\0');
+    g_strfreev (lines);
+    g_free (contents);
+
+    rmfd_stats_teardown (ctx);
+
+    g_unlink (path);
+    g_free (path);
+}
+
 int main (int argc, char **argv)
 {
     g_test_init (&argc, &argv, NULL);
@@ -351,5 +402,7 @@ int main (int argc, char **argv)
     g_test_add_func ("/librmfd-stats/unix/multiple/partial",                 test_unix_multiple_partial);
     g_test_add_func ("/librmfd-stats/unix/multiple/partial/last-invalid",    test_unix_multiple_partial_last_invalid);
 
+    g_test_add_func ("/librmfd-stats/writer/records",                        test_writer_records);
+
     return g_test_run ();
 }
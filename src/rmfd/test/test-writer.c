@@ -0,0 +1,151 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ * rmfd writer tests
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2020 Safran Passenger Innovations
+ *
+ * Author: Aleksander Morgado <aleksander@aleksander.es>
+ */
+
+#include <glib.h>
+
+#include <rmfd-writer.h>
+
+typedef struct {
+    GThread *thread;
+    GArray  *order;
+    guint    destroyed;
+} Context;
+
+typedef struct {
+    Context *ctx;
+    guint    id;
+} Job;
+
+static Job *
+job_new (Context *ctx,
+         guint    id)
+{
+    Job *job;
+
+    job = g_new0 (Job, 1);
+    job->ctx = ctx;
+    job->id  = id;
+    return job;
+}
+
+static void
+job_free (Job *job)
+{
+    job->ctx->destroyed++;
+    g_free (job);
+}
+
+static void
+job_run (Job *job)
+{
+    /* Only accessed by one thread at a time: either the writer or the main
+     * thread before setup and after teardown */
+    job->ctx->thread = g_thread_self ();
+    g_array_append_val (job->ctx->order, job->id);
+}
+
+static void
+job_run_nested (Job *job)
+{
+    job_run (job);
+    rmfd_writer_push ((RmfdWriterFunc) job_run, job_new (job->ctx, job->id + 1), (GDestroyNotify) job_free);
+    job_run (job);
+}
+
+static void
+test_no_thread (void)
+{
+    Context ctx = { 0 };
+
+    ctx.order = g_array_new (FALSE, FALSE, sizeof (guint));
+
+    /* Without writer thread, jobs are run right away */
+    rmfd_writer_push ((RmfdWriterFunc) job_run, job_new (&ctx, 1), (GDestroyNotify) job_free);
+    g_assert (ctx.thread == g_thread_self ());
+    g_assert_cmpuint (ctx.order->len, ==, 1);
+    g_assert_cmpuint (ctx.destroyed, ==, 1);
+
+    /* Nothing to tear down */
+    rmfd_writer_teardown ();
+
+    g_array_unref (ctx.order);
+}
+
+static void
+test_order (void)
+{
+    Context ctx = { 0 };
+    guint   i;
+
+    ctx.order = g_array_new (FALSE, FALSE, sizeof (guint));
+
+    rmfd_writer_setup ();
+    for (i = 0; i < 100; i++)
+        rmfd_writer_push ((RmfdWriterFunc) job_run, job_new (&ctx, i), (GDestroyNotify) job_free);
+
+    /* Pending jobs are all run before the thread exits */
+    rmfd_writer_teardown ();
+
+    g_assert (ctx.thread != NULL);
+    g_assert (ctx.thread != g_thread_self ());
+    g_assert_cmpuint (ctx.order->len, ==, 100);
+    for (i = 0; i < 100; i++)
+        g_assert_cmpuint (g_array_index (ctx.order, guint, i), ==, i);
+    g_assert_cmpuint (ctx.destroyed, ==, 100);
+
+    g_array_unref (ctx.order);
+}
+
+static void
+test_nested (void)
+{
+    Context ctx = { 0 };
+
+    ctx.order = g_array_new (FALSE, FALSE, sizeof (guint));
+
+    rmfd_writer_setup ();
+    rmfd_writer_push ((RmfdWriterFunc) job_run_nested, job_new (&ctx, 1), (GDestroyNotify) job_free);
+    rmfd_writer_teardown ();
+
+    /* The nested job is run right away, not queued */
+    g_assert_cmpuint (ctx.order->len, ==, 3);
+    g_assert_cmpuint (g_array_index (ctx.order, guint, 0), ==, 1);
+    g_assert_cmpuint (g_array_index (ctx.order, guint, 1), ==, 2);
+    g_assert_cmpuint (g_array_index (ctx.order, guint, 2), ==, 1);
+    g_assert_cmpuint (ctx.destroyed, ==, 2);
+
+    g_array_unref (ctx.order);
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/rmfd/writer/no-thread", test_no_thread);
+    g_test_add_func ("/rmfd/writer/order",     test_order);
+    g_test_add_func ("/rmfd/writer/nested",    test_nested);
+
+    return g_test_run ();
+}